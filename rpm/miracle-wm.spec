@@ -15,6 +15,8 @@ BuildRequires:  pkgconfig(yaml-cpp)
 BuildRequires:  pkgconfig(libevdev)
 BuildRequires:  cmake(nlohmann_json) >= 3.2.0
 BuildRequires:  pkgconfig(libnotify)
+BuildRequires:  pkgconfig(liburing)
+BuildRequires:  pkgconfig(freetype2)
 BuildRequires:  cmake(gtest)
 BuildRequires:  libxkbcommon-devel
 BuildRequires:  desktop-file-utils
@@ -46,6 +48,7 @@ desktop-file-validate %{buildroot}%{_datadir}/wayland-sessions/miracle-wm.deskto
 %files
 %{_bindir}/miracle-wm
 %{_bindir}/miracle-wm-sensible-terminal
+%{_bindir}/miracle-wm-dump-log
 %{_datarootdir}/wayland-sessions/miracle-wm.desktop
 %license LICENSE
 
@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "animator.h"
 #include "miracle_config.h"
+#include <algorithm>
 #include <chrono>
 #include <mir/server_action_queue.h>
 #define MIR_LOG_COMPONENT "animator"
@@ -47,6 +48,7 @@ Animation::Animation(
 
 Animation& Animation::operator=(miracle::Animation const& other)
 {
+    id = other.id;
     handle = other.handle;
     definition = other.definition;
     from = other.from;
@@ -57,6 +59,9 @@ Animation& Animation::operator=(miracle::Animation const& other)
 
 namespace
 {
+/// Settling a swipe never takes less than this, however fast the fingers were moving
+float const min_settle_seconds = 0.08f;
+
 float ease_out_bounce(AnimationDefinition const& defintion, float x)
 {
     if (x < 1 / defintion.d1)
@@ -311,6 +316,7 @@ AnimationHandle Animator::register_animateable()
 void Animator::append(miracle::Animation&& animation)
 {
     std::lock_guard<std::mutex> lock(processing_lock);
+    animation.set_id(next_animation_id++);
     animation.get_callback()(animation.init());
     queued_animations.push_back(animation);
     cv.notify_one();
@@ -320,11 +326,13 @@ void Animator::window_move(
     AnimationHandle handle,
     mir::geometry::Rectangle const& from,
     mir::geometry::Rectangle const& to,
-    std::function<void(AnimationStepResult const&)> const& callback)
+    std::function<void(AnimationStepResult const&)> const& callback,
+    std::string const& output_name)
 {
     // If animations aren't enabled, let's give them the position that
     // they want to go to immediately and don't bother animating anything.
-    if (!config->are_animations_enabled())
+    auto definition = get_definition(AnimateableEvent::window_move, output_name);
+    if (!definition)
     {
         callback(
             { handle,
@@ -335,21 +343,28 @@ void Animator::window_move(
         return;
     }
 
+    // Simple animations only move the window, so that it is never resampled at another size
+    auto start = from;
+    if (config->get_power_profile(output_name).simple_animations)
+        start.size = to.size;
+
     append(Animation(
         handle,
-        config->get_animation_definitions()[(int)AnimateableEvent::window_move],
-        from,
+        definition.value(),
+        start,
         to,
         callback));
 }
 
 void Animator::window_open(
     AnimationHandle handle,
-    std::function<void(AnimationStepResult const&)> const& callback)
+    std::function<void(AnimationStepResult const&)> const& callback,
+    std::string const& output_name)
 {
     // If animations aren't enabled, let's give them the position that
     // they want to go to immediately and don't bother animating anything.
-    if (!config->are_animations_enabled())
+    auto definition = get_definition(AnimateableEvent::window_open, output_name);
+    if (!definition)
     {
         callback({ handle, true });
         return;
@@ -357,7 +372,7 @@ void Animator::window_open(
 
     append(Animation(
         handle,
-        config->get_animation_definitions()[(int)AnimateableEvent::window_open],
+        definition.value(),
         std::nullopt,
         std::nullopt,
         callback));
@@ -367,9 +382,11 @@ void Animator::workspace_move_to(
     AnimationHandle handle,
     int x_offset,
     std::function<void(AnimationStepResult const&)> const& from_callback,
-    std::function<void(AnimationStepResult const&)> const& to_callback)
+    std::function<void(AnimationStepResult const&)> const& to_callback,
+    std::string const& output_name)
 {
-    if (!config->are_animations_enabled())
+    auto definition = get_definition(AnimateableEvent::window_workspace_hide, output_name);
+    if (!definition)
     {
         from_callback({ handle, true });
         to_callback({ handle, true });
@@ -390,25 +407,72 @@ void Animator::workspace_move_to(
         mir::geometry::Size { 0, 0 });
 
     append(Animation(handle,
-        config->get_animation_definitions()[(int)AnimateableEvent::window_workspace_hide],
+        definition.value(),
         from_start,
         from_end,
         from_callback));
     append(Animation(handle,
-        config->get_animation_definitions()[(int)AnimateableEvent::window_workspace_hide],
+        definition.value(),
         to_start,
         to_end,
         to_callback));
     cv.notify_one();
 }
 
-namespace
+void Animator::workspace_settle(
+    AnimationHandle handle,
+    int from_x,
+    int to_x,
+    float velocity,
+    std::function<void(AnimationStepResult const&)> const& callback,
+    std::string const& output_name)
 {
-struct PendingUpdateData
+    auto scaled = get_definition(AnimateableEvent::window_workspace_show, output_name);
+    if (!scaled || from_x == to_x)
+    {
+        callback({ handle, true, glm::vec2(to_x, 0), std::nullopt, glm::mat4(1.f) });
+        return;
+    }
+
+    // An ease out cubic starts at three times its average speed, so we choose the
+    // duration that makes the first frames match the speed of the fingers
+    auto definition = scaled.value();
+    definition.type = AnimationType::slide;
+    definition.function = EaseFunction::ease_out_cubic;
+    float const max_seconds = std::max(definition.duration_seconds, min_settle_seconds);
+    float const distance = static_cast<float>(to_x - from_x);
+    if (velocity * distance > 0)
+        definition.duration_seconds = std::clamp(3.f * distance / velocity, min_settle_seconds, max_seconds);
+    else
+        definition.duration_seconds = max_seconds;
+
+    append(Animation(
+        handle,
+        definition,
+        mir::geometry::Rectangle(mir::geometry::Point { from_x, 0 }, mir::geometry::Size { 0, 0 }),
+        mir::geometry::Rectangle(mir::geometry::Point { to_x, 0 }, mir::geometry::Size { 0, 0 }),
+        callback));
+}
+
+std::optional<AnimationDefinition> Animator::get_definition(AnimateableEvent event, std::string const& output_name) const
 {
-    AnimationStepResult result;
-    std::function<void(miracle::AnimationStepResult const&)> callback;
-};
+    if (!config->are_animations_enabled())
+        return std::nullopt;
+
+    auto const profile = config->get_power_profile(output_name);
+    if (!profile.animations)
+        return std::nullopt;
+
+    auto definition = config->get_animation_definitions()[(int)event];
+    if (profile.simple_animations
+        && (definition.type == AnimationType::grow || definition.type == AnimationType::shrink))
+        return std::nullopt;
+
+    definition.duration_seconds *= profile.animation_duration_scale;
+    if (definition.duration_seconds <= 0)
+        return std::nullopt;
+
+    return definition;
 }
 
 void Animator::run()
@@ -439,12 +503,18 @@ void Animator::run()
             lag -= timestep;
             step();
         }
+
+        // Animations advance on a fixed timestep, but the power profile decides how often we wake
+        // to advance them. Results of steps that run back to back replace one another before the
+        // main loop applies them, so a lower frame rate means fewer frames.
+        auto const frame_rate = std::max(config->get_power_profile().animation_frame_rate, 1);
+        std::this_thread::sleep_until(time_start + std::chrono::nanoseconds(1s) / frame_rate);
     }
 }
 
 void Animator::step()
 {
-    std::vector<PendingUpdateData> update_data;
+    std::vector<std::pair<uint64_t, PendingUpdate>> update_data;
     {
         std::lock_guard<std::mutex> lock(processing_lock);
         for (auto it = queued_animations.begin(); it != queued_animations.end();)
@@ -452,7 +522,7 @@ void Animator::step()
             auto& item = *it;
             auto result = item.step();
 
-            update_data.push_back({ result, item.get_callback() });
+            update_data.push_back({ item.get_id(), { result, item.get_callback() } });
             if (result.is_complete)
                 it = queued_animations.erase(it);
             else
@@ -460,14 +530,39 @@ void Animator::step()
         }
     }
 
-    server_action_queue->enqueue(this, [&, update_data]()
+    if (update_data.empty())
+        return;
+
+    bool should_queue = false;
+    {
+        // Newer results replace older ones that the main loop has yet to apply. A completed
+        // animation is no longer stepped, so its final result stays until it is applied.
+        std::lock_guard<std::mutex> lock(pending_lock);
+        for (auto& [id, update] : update_data)
+            pending_updates.insert_or_assign(id, std::move(update));
+
+        should_queue = !is_update_queued;
+        is_update_queued = true;
+    }
+
+    if (should_queue)
+        server_action_queue->enqueue(this, [this]() { apply_pending_updates(); });
+}
+
+void Animator::apply_pending_updates()
+{
+    std::map<uint64_t, PendingUpdate> updates;
     {
-        if (!running)
-            return;
+        std::lock_guard<std::mutex> lock(pending_lock);
+        updates.swap(pending_updates);
+        is_update_queued = false;
+    }
+
+    if (!running)
+        return;
 
-        for (auto const& update_item : update_data)
-            update_item.callback(update_item.result);
-    });
+    for (auto const& [id, update] : updates)
+        update.callback(update.result);
 }
 
 void Animator::stop()
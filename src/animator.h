@@ -22,9 +22,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <condition_variable>
 #include <functional>
 #include <glm/glm.hpp>
+#include <map>
 #include <mir/geometry/rectangle.h>
 #include <mutex>
 #include <optional>
+#include <string>
 #include <thread>
 
 namespace mir
@@ -68,7 +70,12 @@ public:
     AnimationStepResult step();
     [[nodiscard]] std::function<void(AnimationStepResult const&)> const& get_callback() const { return callback; }
 
+    /// Identifies this animation among all others, even those sharing its handle
+    [[nodiscard]] uint64_t get_id() const { return id; }
+    void set_id(uint64_t in) { id = in; }
+
 private:
+    uint64_t id = 0;
     AnimationHandle handle;
     AnimationDefinition definition;
     std::optional<mir::geometry::Rectangle> from;
@@ -91,21 +98,37 @@ public:
     /// able to be animated.
     AnimationHandle register_animateable();
 
+    // The methods below take the name of the output that the animation plays on, so that
+    // the power profile of that output decides whether and how quickly it animates.
+
     void window_move(
         AnimationHandle handle,
         mir::geometry::Rectangle const& from,
         mir::geometry::Rectangle const& to,
-        std::function<void(AnimationStepResult const&)> const& callback);
+        std::function<void(AnimationStepResult const&)> const& callback,
+        std::string const& output_name = "");
 
     void window_open(
         AnimationHandle handle,
-        std::function<void(AnimationStepResult const&)> const& callback);
+        std::function<void(AnimationStepResult const&)> const& callback,
+        std::string const& output_name = "");
 
     void workspace_move_to(
         AnimationHandle handle,
         int x_offset, // The offset in X from which the "to" callback transform begins if it is a slide
         std::function<void(AnimationStepResult const&)> const& from_callback,
-        std::function<void(AnimationStepResult const&)> const& to_callback);
+        std::function<void(AnimationStepResult const&)> const& to_callback,
+        std::string const& output_name = "");
+
+    /// Settles a workspace swipe that was tracked by hand. The x position runs from from_x
+    /// to to_x and starts out at the velocity of the fingers, in pixels per second.
+    void workspace_settle(
+        AnimationHandle handle,
+        int from_x,
+        int to_x,
+        float velocity,
+        std::function<void(AnimationStepResult const&)> const& callback,
+        std::string const& output_name = "");
 
     void start();
     void stop();
@@ -114,7 +137,18 @@ public:
     static constexpr float timestep_seconds = 0.016;
 
 private:
+    struct PendingUpdate
+    {
+        AnimationStepResult result;
+        std::function<void(AnimationStepResult const&)> callback;
+    };
+
     void run();
+    void apply_pending_updates();
+
+    /// The definition of the event as scaled by the power profile of the output, or
+    /// std::nullopt if the output should not animate at all
+    std::optional<AnimationDefinition> get_definition(AnimateableEvent event, std::string const& output_name) const;
 
     void append(Animation&&);
     bool running = false;
@@ -125,6 +159,15 @@ private:
     std::mutex processing_lock;
     std::condition_variable cv;
     AnimationHandle next_handle = 1;
+    uint64_t next_animation_id = 1;
+
+    /// The newest unapplied result of each animation, keyed by animation id so that they are
+    /// applied in the order that the animations were started. At most one action that applies
+    /// these is queued on the main loop at a time, so a busy main loop skips stale frames
+    /// rather than replaying them back to back.
+    std::map<uint64_t, PendingUpdate> pending_updates;
+    bool is_update_queued = false;
+    std::mutex pending_lock;
 };
 
 } // miracle
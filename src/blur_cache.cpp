@@ -0,0 +1,100 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "blur_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace miracle;
+
+namespace
+{
+/// The blur never reaches further than this, however strong it is configured to be
+int const max_blur_margin = 256;
+}
+
+std::size_t miracle::hash_combine(std::size_t seed, std::size_t value)
+{
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+int miracle::get_blur_margin(int passes, float offset)
+{
+    // Each pass samples at the offset in texels of a target that is half as large as the last,
+    // and the reach doubles again on the way back up
+    auto const reach = std::ceil(offset * static_cast<float>(1 << std::max(passes, 0)) * 2.f);
+    return std::clamp(static_cast<int>(reach), 0, max_blur_margin);
+}
+
+void BlurCache::begin_frame(long long in)
+{
+    frameno = in;
+    drawn.clear();
+}
+
+void BlurCache::add_drawn(mir::geometry::Rectangle const& area, std::size_t signature)
+{
+    drawn.push_back({ area, signature });
+}
+
+std::size_t BlurCache::signature_beneath(mir::geometry::Rectangle const& region, std::size_t salt) const
+{
+    auto result = hash_combine(salt, region.top_left.x.as_int());
+    result = hash_combine(result, region.top_left.y.as_int());
+    result = hash_combine(result, region.size.width.as_int());
+    result = hash_combine(result, region.size.height.as_int());
+
+    // Drawing order matters, as later content covers earlier content
+    for (auto const& item : drawn)
+    {
+        if (item.area.overlaps(region))
+            result = hash_combine(result, item.signature);
+    }
+
+    return result;
+}
+
+bool BlurCache::needs_update(void const* key, std::size_t signature)
+{
+    auto [it, inserted] = entries.try_emplace(key, Entry { signature, frameno });
+    it->second.last_used = frameno;
+    if (inserted)
+        return true;
+
+    if (it->second.signature == signature)
+        return false;
+
+    it->second.signature = signature;
+    return true;
+}
+
+std::vector<void const*> BlurCache::evict_unused_since(long long since)
+{
+    std::vector<void const*> evicted;
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+        if (it->second.last_used < since)
+        {
+            evicted.push_back(it->first);
+            it = entries.erase(it);
+        }
+        else
+            ++it;
+    }
+    return evicted;
+}
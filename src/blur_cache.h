@@ -0,0 +1,87 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_BLUR_CACHE_H
+#define MIRACLEWM_BLUR_CACHE_H
+
+#include <cstddef>
+#include <mir/geometry/rectangle.h>
+#include <unordered_map>
+#include <vector>
+
+namespace miracle
+{
+
+/// Mixes a value into a running hash
+std::size_t hash_combine(std::size_t seed, std::size_t value);
+
+/// How far outside of a window the blur reaches for content, in pixels, so that
+/// the edges of the window are blurred with what lies beyond them
+int get_blur_margin(int passes, float offset);
+
+/// Decides when the blurred content beneath a window has to be computed again.
+///
+/// Everything that the renderer draws in a frame is recorded along with a signature
+/// that changes whenever its appearance does, e.g. when its surface posts a frame or
+/// when it moves. The content beneath a window is the combination of everything drawn
+/// before the window that overlaps it, so the blur is only computed again when one of
+/// those changes. What the window itself draws, and anything drawn above it, never
+/// invalidates the blur beneath it.
+class BlurCache
+{
+public:
+    /// Forgets what was drawn in the previous frame
+    void begin_frame(long long frameno);
+
+    /// Records something that was drawn in this frame
+    void add_drawn(mir::geometry::Rectangle const& area, std::size_t signature);
+
+    /// Combines the signatures of everything drawn so far this frame that overlaps the region
+    /// @param salt describes how the region is blurred, e.g. where it is and how many passes it takes
+    [[nodiscard]] std::size_t signature_beneath(mir::geometry::Rectangle const& region, std::size_t salt) const;
+
+    /// Marks the key as used in this frame
+    /// @returns true if the blur for the key was computed from different content
+    bool needs_update(void const* key, std::size_t signature);
+
+    /// Drops the keys that have not been used since the provided frame
+    /// @returns the keys that were dropped, so that their resources can be released
+    std::vector<void const*> evict_unused_since(long long frameno);
+
+    [[nodiscard]] std::size_t size() const { return entries.size(); }
+
+private:
+    struct Drawn
+    {
+        mir::geometry::Rectangle area;
+        std::size_t signature;
+    };
+
+    struct Entry
+    {
+        std::size_t signature;
+        long long last_used;
+    };
+
+    long long frameno = 0;
+    std::vector<Drawn> drawn;
+    std::unordered_map<void const*, Entry> entries;
+};
+
+} // miracle
+
+#endif // MIRACLEWM_BLUR_CACHE_H
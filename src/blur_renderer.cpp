@@ -0,0 +1,413 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "blur_renderer"
+
+#include "blur_renderer.h"
+
+#include <algorithm>
+#include <functional>
+#include <mir/log.h>
+#include <stdexcept>
+
+using namespace miracle;
+namespace geom = mir::geometry;
+
+namespace
+{
+const GLchar* const vertex_shader_src = R"(
+attribute vec2 position;
+varying vec2 v_texcoord;
+void main() {
+   v_texcoord = position * 0.5 + 0.5;
+   gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+// Samples the centre and the four diagonals of the source, which is twice the size of the target
+const GLchar* const down_fragment_shader_src = R"(
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+uniform sampler2D tex;
+uniform vec2 half_pixel;
+uniform float offset;
+varying vec2 v_texcoord;
+void main() {
+    vec2 o = half_pixel * offset;
+    vec4 sum = texture2D(tex, v_texcoord) * 4.0;
+    sum += texture2D(tex, v_texcoord - o);
+    sum += texture2D(tex, v_texcoord + o);
+    sum += texture2D(tex, v_texcoord + vec2(o.x, -o.y));
+    sum += texture2D(tex, v_texcoord - vec2(o.x, -o.y));
+    gl_FragColor = sum / 8.0;
+}
+)";
+
+// Samples a ring around the target texel from the source, which is half the size of the target
+const GLchar* const up_fragment_shader_src = R"(
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+uniform sampler2D tex;
+uniform vec2 half_pixel;
+uniform float offset;
+varying vec2 v_texcoord;
+void main() {
+    vec2 o = half_pixel * offset;
+    vec4 sum = texture2D(tex, v_texcoord + vec2(-o.x * 2.0, 0.0));
+    sum += texture2D(tex, v_texcoord + vec2(-o.x, o.y)) * 2.0;
+    sum += texture2D(tex, v_texcoord + vec2(0.0, o.y * 2.0));
+    sum += texture2D(tex, v_texcoord + vec2(o.x, o.y)) * 2.0;
+    sum += texture2D(tex, v_texcoord + vec2(o.x * 2.0, 0.0));
+    sum += texture2D(tex, v_texcoord + vec2(o.x, -o.y)) * 2.0;
+    sum += texture2D(tex, v_texcoord + vec2(0.0, -o.y * 2.0));
+    sum += texture2D(tex, v_texcoord + vec2(-o.x, -o.y)) * 2.0;
+    gl_FragColor = sum / 12.0;
+}
+)";
+
+// Draws the blur into the shape of the window, with its corners rounded in the same way as the
+// decoration shader does. The shape is measured in pixels from the lower left of the capture.
+const GLchar* const composite_fragment_shader_src = R"(
+#ifdef GL_ES
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+#endif
+
+uniform sampler2D tex;
+uniform vec2 size;
+uniform vec2 shape_origin;
+uniform vec2 shape_size;
+uniform float radius;
+varying vec2 v_texcoord;
+
+float rounded_box(vec2 p, vec2 b, float r) {
+    vec2 q = abs(p) - b + r;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - r;
+}
+
+void main() {
+    vec2 half_shape = shape_size * 0.5;
+    vec2 p = v_texcoord * size - shape_origin - half_shape;
+    float coverage = clamp(0.5 - rounded_box(p, half_shape, min(radius, min(half_shape.x, half_shape.y))), 0.0, 1.0);
+    gl_FragColor = texture2D(tex, v_texcoord) * coverage;
+}
+)";
+
+GLfloat const quad_vertices[] = {
+    -1.f, -1.f,
+    1.f, -1.f,
+    -1.f, 1.f,
+    1.f, 1.f
+};
+
+GLuint compile_shader(GLenum type, GLchar const* src)
+{
+    GLuint id = glCreateShader(type);
+    if (!id)
+        throw std::runtime_error("Failed to create blur shader");
+
+    glShaderSource(id, 1, &src, NULL);
+    glCompileShader(id);
+    GLint ok;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        GLchar log[1024] = "(No log info)";
+        glGetShaderInfoLog(id, sizeof log, NULL, log);
+        glDeleteShader(id);
+        throw std::runtime_error(std::string("Blur shader compile failed: ") + log);
+    }
+    return id;
+}
+
+GLuint link_program(GLchar const* fragment_shader_src)
+{
+    GLuint const vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_src);
+    GLuint fragment_shader;
+    try
+    {
+        fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_src);
+    }
+    catch (...)
+    {
+        glDeleteShader(vertex_shader);
+        throw;
+    }
+
+    GLuint const program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+
+    // The shaders are only marked for deletion until the program that they are linked into goes away
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint ok;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        GLchar log[1024] = "(No log info)";
+        glGetProgramInfoLog(program, sizeof log, NULL, log);
+        glDeleteProgram(program);
+        throw std::runtime_error(std::string("Linking blur shader failed: ") + log);
+    }
+    return program;
+}
+}
+
+BlurRenderer::BlurRenderer() = default;
+
+BlurRenderer::~BlurRenderer()
+{
+    // Released while the output's context is current, see Renderer::~Renderer
+    for (auto& [_, blur] : blurs)
+        release(blur);
+    for (auto const* pass : { &down, &up, &composite })
+    {
+        if (pass->program)
+            glDeleteProgram(pass->program);
+    }
+    if (framebuffer)
+        glDeleteFramebuffers(1, &framebuffer);
+}
+
+void BlurRenderer::begin_frame(long long frameno, geom::Size const& size)
+{
+    cache.begin_frame(frameno);
+    framebuffer_size = size;
+}
+
+void BlurRenderer::add_drawn(geom::Rectangle const& area, std::size_t signature)
+{
+    cache.add_drawn(area, signature);
+}
+
+bool BlurRenderer::draw(
+    void const* key,
+    geom::Rectangle const& area,
+    geom::Rectangle capture,
+    geom::Rectangle shape,
+    float radius,
+    int passes,
+    float offset)
+{
+    capture = capture.intersection_with(geom::Rectangle { geom::Point { 0, 0 }, framebuffer_size });
+    shape = shape.intersection_with(capture);
+    if (shape.size.width.as_int() <= 0 || shape.size.height.as_int() <= 0)
+        return false;
+
+    if (!ensure_gl_resources())
+        return false;
+
+    // The blur depends on where it is taken from as well as on what is there
+    auto salt = hash_combine(std::hash<int> {}(passes), std::hash<float> {}(offset));
+    salt = hash_combine(salt, capture.top_left.x.as_int());
+    salt = hash_combine(salt, capture.top_left.y.as_int());
+    salt = hash_combine(salt, capture.size.width.as_int());
+    salt = hash_combine(salt, capture.size.height.as_int());
+    auto& blur = blurs[key];
+    bool const updated = cache.needs_update(key, cache.signature_beneath(area, salt)) || blur.levels.empty();
+
+    GLint previous_framebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous_framebuffer);
+    GLint previous_viewport[4];
+    glGetIntegerv(GL_VIEWPORT, previous_viewport);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_STENCIL_TEST);
+    glActiveTexture(GL_TEXTURE0);
+
+    if (updated)
+    {
+        allocate(blur, capture.size, passes);
+        glBindFramebuffer(GL_FRAMEBUFFER, previous_framebuffer);
+        if (failed)
+        {
+            blurs.erase(key);
+            return false;
+        }
+
+        // The framebuffer that is being drawn is still bound, so the capture is copied straight out of it
+        glBindTexture(GL_TEXTURE_2D, blur.levels[0].texture);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+            capture.top_left.x.as_int(), capture.top_left.y.as_int(),
+            capture.size.width.as_int(), capture.size.height.as_int());
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        compute(blur, offset);
+        glBindFramebuffer(GL_FRAMEBUFFER, previous_framebuffer);
+    }
+
+    glViewport(capture.top_left.x.as_int(), capture.top_left.y.as_int(),
+        capture.size.width.as_int(), capture.size.height.as_int());
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(shape.top_left.x.as_int(), shape.top_left.y.as_int(),
+        shape.size.width.as_int(), shape.size.height.as_int());
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    glUseProgram(composite.program);
+    glUniform1i(composite.tex_uniform, 0);
+    glUniform2f(composite.size_uniform, capture.size.width.as_int(), capture.size.height.as_int());
+    glUniform2f(composite.shape_origin_uniform,
+        shape.top_left.x.as_int() - capture.top_left.x.as_int(),
+        shape.top_left.y.as_int() - capture.top_left.y.as_int());
+    glUniform2f(composite.shape_size_uniform, shape.size.width.as_int(), shape.size.height.as_int());
+    glUniform1f(composite.radius_uniform, radius);
+    glBindTexture(GL_TEXTURE_2D, blur.levels[0].texture);
+    draw_quad(composite);
+
+    glDisable(GL_SCISSOR_TEST);
+    glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+    return updated;
+}
+
+void BlurRenderer::evict_unused_since(long long frameno)
+{
+    for (auto const* key : cache.evict_unused_since(frameno))
+    {
+        auto it = blurs.find(key);
+        if (it == blurs.end())
+            continue;
+
+        release(it->second);
+        blurs.erase(it);
+    }
+}
+
+bool BlurRenderer::ensure_gl_resources()
+{
+    if (failed)
+        return false;
+    if (framebuffer)
+        return true;
+
+    auto const make_pass = [](GLchar const* fragment_shader_src)
+    {
+        Pass pass;
+        pass.program = link_program(fragment_shader_src);
+        pass.position_attr = glGetAttribLocation(pass.program, "position");
+        pass.tex_uniform = glGetUniformLocation(pass.program, "tex");
+        pass.half_pixel_uniform = glGetUniformLocation(pass.program, "half_pixel");
+        pass.offset_uniform = glGetUniformLocation(pass.program, "offset");
+        pass.size_uniform = glGetUniformLocation(pass.program, "size");
+        pass.shape_origin_uniform = glGetUniformLocation(pass.program, "shape_origin");
+        pass.shape_size_uniform = glGetUniformLocation(pass.program, "shape_size");
+        pass.radius_uniform = glGetUniformLocation(pass.program, "radius");
+        return pass;
+    };
+
+    try
+    {
+        down = make_pass(down_fragment_shader_src);
+        up = make_pass(up_fragment_shader_src);
+        composite = make_pass(composite_fragment_shader_src);
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_error("Blur is disabled: %s", e.what());
+        failed = true;
+        return false;
+    }
+
+    // A texture cannot hold channels that the framebuffer it is copied from does not have
+    GLint alpha_bits = 0;
+    glGetIntegerv(GL_ALPHA_BITS, &alpha_bits);
+    format = alpha_bits > 0 ? GL_RGBA : GL_RGB;
+
+    glGenFramebuffers(1, &framebuffer);
+    return true;
+}
+
+void BlurRenderer::allocate(Blur& blur, geom::Size const& size, int passes)
+{
+    if (blur.levels.size() == static_cast<std::size_t>(passes) + 1 && blur.levels[0].size == size)
+        return;
+
+    release(blur);
+    for (int i = 0; i <= passes; i++)
+    {
+        Level level;
+        level.size = geom::Size {
+            std::max(size.width.as_int() >> i, 1),
+            std::max(size.height.as_int() >> i, 1)
+        };
+        glGenTextures(1, &level.texture);
+        glBindTexture(GL_TEXTURE_2D, level.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, level.size.width.as_int(), level.size.height.as_int(),
+            0, format, GL_UNSIGNED_BYTE, nullptr);
+        blur.levels.push_back(level);
+    }
+
+    // Not every driver can render into every format, which we only find out by trying
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blur.levels[0].texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        mir::log_error("Blur is disabled: unable to render into a blur texture");
+        failed = true;
+        release(blur);
+    }
+}
+
+void BlurRenderer::release(Blur& blur)
+{
+    for (auto const& level : blur.levels)
+        glDeleteTextures(1, &level.texture);
+    blur.levels.clear();
+}
+
+void BlurRenderer::compute(Blur& blur, float offset)
+{
+    glDisable(GL_BLEND);
+    auto const render = [&](Pass const& pass, Level const& from, Level const& to)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, to.texture, 0);
+        glViewport(0, 0, to.size.width.as_int(), to.size.height.as_int());
+        glUseProgram(pass.program);
+        glUniform1i(pass.tex_uniform, 0);
+        glUniform2f(pass.half_pixel_uniform, 0.5f / to.size.width.as_int(), 0.5f / to.size.height.as_int());
+        glUniform1f(pass.offset_uniform, offset);
+        glBindTexture(GL_TEXTURE_2D, from.texture);
+        draw_quad(pass);
+    };
+
+    auto& levels = blur.levels;
+    for (std::size_t i = 1; i < levels.size(); i++)
+        render(down, levels[i - 1], levels[i]);
+    for (std::size_t i = levels.size() - 1; i > 0; i--)
+        render(up, levels[i], levels[i - 1]);
+}
+
+void BlurRenderer::draw_quad(Pass const& pass)
+{
+    glEnableVertexAttribArray(pass.position_attr);
+    glVertexAttribPointer(pass.position_attr, 2, GL_FLOAT, GL_FALSE, 0, quad_vertices);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(pass.position_attr);
+}
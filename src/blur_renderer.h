@@ -0,0 +1,118 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_BLUR_RENDERER_H
+#define MIRACLEWM_BLUR_RENDERER_H
+
+#include "blur_cache.h"
+#include <GLES2/gl2.h>
+#include <mir/geometry/rectangle.h>
+#include <unordered_map>
+#include <vector>
+
+namespace miracle
+{
+
+/// Blurs the content beneath windows with a dual Kawase filter. The content is copied out
+/// of the framebuffer, halved in resolution on every pass on the way down and doubled again
+/// on the way up, so each pass samples a handful of texels from a small target.
+///
+/// The blur of each window is kept until the content beneath it changes, as decided by the
+/// BlurCache. Drawing a kept blur costs a single textured quad.
+///
+/// All methods must be called on the rendering thread with a current GL context.
+class BlurRenderer
+{
+public:
+    BlurRenderer();
+    ~BlurRenderer();
+
+    /// Forgets what was drawn in the previous frame
+    /// @param framebuffer_size the size of the framebuffer that is drawn into, which bounds the blur
+    void begin_frame(long long frameno, mir::geometry::Size const& framebuffer_size);
+
+    /// Records something that was drawn in this frame, see BlurCache::add_drawn
+    void add_drawn(mir::geometry::Rectangle const& area, std::size_t signature);
+
+    /// Draws the blurred content of the bound framebuffer within the shape. Framebuffer
+    /// rectangles are measured from the lower left corner, as with glScissor.
+    /// @param key identifies the window whose blur is kept between frames
+    /// @param area what the blur covers on screen, which decides what is beneath it
+    /// @param capture the part of the framebuffer that is blurred
+    /// @param shape the part of the framebuffer that the blur is drawn into
+    /// @param radius rounds the corners of the shape
+    /// @returns true if the content beneath had to be blurred again
+    bool draw(
+        void const* key,
+        mir::geometry::Rectangle const& area,
+        mir::geometry::Rectangle capture,
+        mir::geometry::Rectangle shape,
+        float radius,
+        int passes,
+        float offset);
+
+    /// Releases the blurs that have not been drawn since the provided frame
+    void evict_unused_since(long long frameno);
+
+private:
+    struct Level
+    {
+        GLuint texture = 0;
+        mir::geometry::Size size;
+    };
+
+    struct Blur
+    {
+        /// The first level holds the result, at the size of the capture
+        std::vector<Level> levels;
+    };
+
+    struct Pass
+    {
+        GLuint program = 0;
+        GLint position_attr = -1;
+        GLint tex_uniform = -1;
+        GLint half_pixel_uniform = -1;
+        GLint offset_uniform = -1;
+        GLint size_uniform = -1;
+        GLint shape_origin_uniform = -1;
+        GLint shape_size_uniform = -1;
+        GLint radius_uniform = -1;
+    };
+
+    bool ensure_gl_resources();
+    void allocate(Blur& blur, mir::geometry::Size const& size, int passes);
+    void release(Blur& blur);
+    void compute(Blur& blur, float offset);
+    void draw_quad(Pass const& pass);
+
+    BlurCache cache;
+    std::unordered_map<void const*, Blur> blurs;
+    mir::geometry::Size framebuffer_size;
+
+    /// Set when the driver cannot render into our textures, so that blur is not attempted again
+    bool failed = false;
+    GLenum format = GL_RGBA;
+    GLuint framebuffer = 0;
+    Pass down;
+    Pass up;
+    Pass composite;
+};
+
+} // miracle
+
+#endif // MIRACLEWM_BLUR_RENDERER_H
@@ -0,0 +1,166 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "commit_rate_governor"
+
+#include "commit_rate_governor.h"
+#include "miracle_config.h"
+#include "output_content.h"
+#include "window_helpers.h"
+#include "window_metadata.h"
+
+#include <atomic>
+#include <mir/log.h>
+#include <mir/scene/null_surface_observer.h>
+#include <mir/scene/surface.h>
+#include <miral/window_info.h>
+
+using namespace miracle;
+
+/// Counts frames posted by a surface. This is notified from the compositor
+/// threads, so it only touches an atomic.
+class CommitRateGovernor::CommitCounter : public mir::scene::NullSurfaceObserver
+{
+public:
+    void frame_posted(mir::scene::Surface const*, mir::geometry::Rectangle const&) override
+    {
+        commits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint32_t consume() { return commits.exchange(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> commits = 0;
+};
+
+CommitRateGovernor::CommitRateGovernor(miral::WindowManagerTools const& tools, std::shared_ptr<MiracleConfig> const& config) :
+    tools { tools },
+    config { config },
+    last_evaluation { std::chrono::steady_clock::now() }
+{
+}
+
+CommitRateGovernor::~CommitRateGovernor()
+{
+    for (auto& [_, entry] : entries)
+    {
+        auto surface = entry.window.operator std::shared_ptr<mir::scene::Surface>();
+        if (surface)
+            surface->unregister_interest(*entry.counter);
+    }
+}
+
+void CommitRateGovernor::add(miral::Window const& window)
+{
+    auto surface = window.operator std::shared_ptr<mir::scene::Surface>();
+    if (!surface)
+        return;
+
+    auto counter = std::make_shared<CommitCounter>();
+    surface->register_interest(counter);
+    entries.insert(std::pair(surface.get(), Entry { window, counter }));
+}
+
+void CommitRateGovernor::remove(miral::Window const& window)
+{
+    auto surface = window.operator std::shared_ptr<mir::scene::Surface>();
+    auto it = entries.find(surface.get());
+    if (it == entries.end())
+        return;
+
+    if (surface)
+        surface->unregister_interest(*it->second.counter);
+    bool const was_offender = it->second.times_over_limit > 0;
+    entries.erase(it);
+    if (was_offender)
+        publish_offenders();
+}
+
+void CommitRateGovernor::evaluate()
+{
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration<double>(now - last_evaluation).count();
+    last_evaluation = now;
+    if (elapsed <= 0)
+        return;
+
+    for (auto& [_, entry] : entries)
+    {
+        entry.commits_per_second = entry.counter->consume() / elapsed;
+
+        auto& info = tools.info_for(entry.window);
+        entry.application_id = info.application_id();
+        entry.is_hidden = info.state() == mir_window_state_hidden;
+
+        entry.limit_per_second = fallback_refresh_rate;
+        std::string output_name;
+        auto metadata = window_helpers::get_metadata(info);
+        if (metadata && metadata->get_output())
+        {
+            auto& output = metadata->get_output()->get_output();
+            output_name = output.name();
+            if (output.refresh_rate() > 0)
+                entry.limit_per_second = output.refresh_rate();
+        }
+        entry.limit_per_second *= config->get_power_profile(output_name).client_commit_rate_scale;
+
+        // Hidden surfaces are not being presented, so any amount of drawing is wasted
+        bool const is_over_limit = entry.is_hidden
+            ? entry.commits_per_second > 0
+            : entry.commits_per_second > entry.limit_per_second * tolerance;
+
+        if (is_over_limit && !entry.is_over_limit)
+        {
+            entry.times_over_limit++;
+            if (!entry.is_hidden)
+                mir::log_info("%s is committing %.1f times per second, output refreshes at %.1f",
+                    entry.application_id.c_str(),
+                    entry.commits_per_second,
+                    entry.limit_per_second);
+        }
+        entry.is_over_limit = is_over_limit;
+    }
+
+    publish_offenders();
+}
+
+std::vector<CommitRateGovernor::Diagnostics> CommitRateGovernor::get_offenders() const
+{
+    std::lock_guard lock(offenders_mutex);
+    return offenders;
+}
+
+void CommitRateGovernor::publish_offenders()
+{
+    std::vector<Diagnostics> result;
+    for (auto const& [_, entry] : entries)
+    {
+        if (entry.times_over_limit == 0)
+            continue;
+
+        result.push_back({ entry.window,
+            entry.application_id,
+            entry.commits_per_second,
+            entry.limit_per_second,
+            entry.is_hidden,
+            entry.is_over_limit,
+            entry.times_over_limit });
+    }
+
+    std::lock_guard lock(offenders_mutex);
+    offenders = std::move(result);
+}
@@ -0,0 +1,109 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_COMMIT_RATE_GOVERNOR_H
+#define MIRACLEWM_COMMIT_RATE_GOVERNOR_H
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <miral/window.h>
+#include <miral/window_manager_tools.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mir::scene
+{
+class Surface;
+}
+
+namespace miracle
+{
+class MiracleConfig;
+
+/// Tracks how often each surface commits new buffers, and reports the surfaces that commit
+/// faster than their output can refresh or that keep committing while they are hidden.
+/// Surfaces are keyed in the same way as the SurfaceTracker. The power profile of each
+/// output scales the rate that its surfaces are allowed.
+///
+/// The governor does not change the visibility of a surface. Mir sets it whenever the surface
+/// is composited, so an occluded visible surface would be exposed again on the next frame, and
+/// Mir already tells the clients of surfaces that are not composited that they are occluded.
+class CommitRateGovernor
+{
+public:
+    struct Diagnostics
+    {
+        miral::Window window;
+        std::string application_id;
+        double commits_per_second;
+        double limit_per_second;
+        bool is_hidden;
+        bool is_over_limit;
+        uint32_t times_over_limit;
+    };
+
+    CommitRateGovernor(miral::WindowManagerTools const& tools, std::shared_ptr<MiracleConfig> const& config);
+    ~CommitRateGovernor();
+
+    void add(miral::Window const&);
+    void remove(miral::Window const&);
+
+    /// Samples the commit rate of every tracked surface since the last evaluation.
+    /// Must be called with the window manager lock held.
+    void evaluate();
+
+    /// Lists every surface that has gone over its limit at least once, as of the last evaluation.
+    /// Unlike the rest of the governor, this may be called from any thread.
+    [[nodiscard]] std::vector<Diagnostics> get_offenders() const;
+
+    /// Commits allowed above the refresh rate before a surface is over its limit
+    static constexpr double tolerance = 1.1;
+
+    /// Used when the output of a window does not report a refresh rate
+    static constexpr double fallback_refresh_rate = 60.0;
+
+private:
+    class CommitCounter;
+    struct Entry
+    {
+        miral::Window window;
+        std::shared_ptr<CommitCounter> counter;
+        std::string application_id;
+        double commits_per_second = 0;
+        double limit_per_second = fallback_refresh_rate;
+        bool is_hidden = false;
+        bool is_over_limit = false;
+        uint32_t times_over_limit = 0;
+    };
+
+    miral::WindowManagerTools tools;
+    std::shared_ptr<MiracleConfig> config;
+    std::map<mir::scene::Surface const*, Entry> entries;
+    std::chrono::steady_clock::time_point last_evaluation;
+
+    /// Copied out of the entries under the window manager lock, so that readers never see them change
+    mutable std::mutex offenders_mutex;
+    std::vector<Diagnostics> offenders;
+
+    void publish_offenders();
+};
+
+} // miracle
+
+#endif // MIRACLEWM_COMMIT_RATE_GOVERNOR_H
@@ -0,0 +1,97 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "font_face.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <algorithm>
+#include <stdexcept>
+
+using namespace miracle;
+
+FontFace::FontFace(std::string const& path) :
+    path { path }
+{
+    if (FT_Init_FreeType(&library))
+        throw std::runtime_error("Unable to initialize FreeType");
+
+    if (FT_New_Face(library, path.c_str(), 0, &face))
+    {
+        FT_Done_FreeType(library);
+        throw std::runtime_error("Unable to load font: " + path);
+    }
+}
+
+FontFace::~FontFace()
+{
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+}
+
+std::optional<RasterizedGlyph> FontFace::rasterize(char32_t codepoint, int pixel_size)
+{
+    if (!set_size(pixel_size))
+        return std::nullopt;
+
+    auto const index = FT_Get_Char_Index(face, codepoint);
+    if (index == 0)
+        return std::nullopt;
+
+    if (FT_Load_Glyph(face, index, FT_LOAD_RENDER))
+        return std::nullopt;
+
+    auto const* slot = face->glyph;
+    auto const& bitmap = slot->bitmap;
+    if (bitmap.pixel_mode != FT_PIXEL_MODE_GRAY && bitmap.rows > 0)
+        return std::nullopt;
+
+    RasterizedGlyph glyph;
+    glyph.width = static_cast<int>(bitmap.width);
+    glyph.height = static_cast<int>(bitmap.rows);
+    glyph.bearing_x = slot->bitmap_left;
+    glyph.bearing_y = slot->bitmap_top;
+    glyph.advance = static_cast<float>(slot->advance.x) / 64.f;
+    glyph.coverage.resize(static_cast<size_t>(glyph.width) * glyph.height);
+    for (int row = 0; row < glyph.height; row++)
+    {
+        auto const* source = bitmap.buffer + row * bitmap.pitch;
+        std::copy(source, source + glyph.width, glyph.coverage.begin() + row * glyph.width);
+    }
+
+    return glyph;
+}
+
+std::pair<int, int> FontFace::get_vertical_extents(int pixel_size)
+{
+    if (!set_size(pixel_size))
+        return { pixel_size, 0 };
+
+    auto const& metrics = face->size->metrics;
+    return { static_cast<int>(metrics.ascender >> 6), static_cast<int>(-metrics.descender >> 6) };
+}
+
+bool FontFace::set_size(int pixel_size)
+{
+    if (pixel_size == current_pixel_size)
+        return true;
+
+    if (FT_Set_Pixel_Sizes(face, 0, pixel_size))
+        return false;
+
+    current_pixel_size = pixel_size;
+    return true;
+}
@@ -0,0 +1,62 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_FONT_FACE_H
+#define MIRACLEWM_FONT_FACE_H
+
+#include "glyph_atlas.h"
+#include <optional>
+#include <string>
+
+typedef struct FT_LibraryRec_* FT_Library;
+typedef struct FT_FaceRec_* FT_Face;
+
+namespace miracle
+{
+
+/// A font file loaded through FreeType
+class FontFace
+{
+public:
+    /// @throws std::runtime_error if the font cannot be loaded
+    explicit FontFace(std::string const& path);
+    ~FontFace();
+
+    FontFace(FontFace const&) = delete;
+    FontFace& operator=(FontFace const&) = delete;
+
+    /// Rasterizes a single glyph into an 8-bit coverage bitmap.
+    /// Returns nullopt if the font has no glyph for the codepoint.
+    std::optional<RasterizedGlyph> rasterize(char32_t codepoint, int pixel_size);
+
+    /// The distance from the baseline to the top and bottom of the tallest glyphs, in pixels
+    std::pair<int, int> get_vertical_extents(int pixel_size);
+
+    [[nodiscard]] std::string const& get_path() const { return path; }
+
+private:
+    bool set_size(int pixel_size);
+
+    std::string path;
+    FT_Library library = nullptr;
+    FT_Face face = nullptr;
+    int current_pixel_size = 0;
+};
+
+}
+
+#endif // MIRACLEWM_FONT_FACE_H
@@ -0,0 +1,159 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "glyph_atlas.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace miracle;
+
+namespace
+{
+/// Space left around each glyph so that filtering never bleeds into a neighbor
+int const padding = 1;
+
+/// Size of the fully covered block in the top-left corner of the atlas
+int const solid_size = 2;
+
+uint64_t make_key(char32_t codepoint, int pixel_size)
+{
+    return (static_cast<uint64_t>(pixel_size) << 32) | static_cast<uint64_t>(codepoint);
+}
+}
+
+GlyphAtlas::GlyphAtlas(int width, int height, Rasterizer rasterizer) :
+    width { width },
+    height { height },
+    rasterizer { std::move(rasterizer) },
+    pixels(static_cast<size_t>(width) * height, 0)
+{
+    clear();
+}
+
+AtlasGlyph const* GlyphAtlas::get(char32_t codepoint, int pixel_size)
+{
+    auto const key = make_key(codepoint, pixel_size);
+    if (auto it = glyphs.find(key); it != glyphs.end())
+        return it->second ? &it->second.value() : nullptr;
+
+    auto rasterized = rasterizer(codepoint, pixel_size);
+    if (!rasterized)
+    {
+        // Remember that the font has no such glyph so that we do not ask again
+        glyphs[key] = std::nullopt;
+        return nullptr;
+    }
+
+    rasterized_count++;
+    AtlasGlyph glyph;
+    glyph.width = rasterized->width;
+    glyph.height = rasterized->height;
+    glyph.bearing_x = rasterized->bearing_x;
+    glyph.bearing_y = rasterized->bearing_y;
+    glyph.advance = rasterized->advance;
+
+    // Whitespace takes up room in the layout but none in the atlas
+    if (glyph.width > 0 && glyph.height > 0)
+    {
+        auto position = allocate(glyph.width, glyph.height);
+        if (!position)
+        {
+            full = true;
+            return nullptr;
+        }
+
+        auto const [x, y] = position.value();
+        for (int row = 0; row < glyph.height; row++)
+        {
+            std::memcpy(
+                &pixels[static_cast<size_t>(y + row) * width + x],
+                &rasterized->coverage[static_cast<size_t>(row) * glyph.width],
+                glyph.width);
+        }
+        mark_dirty(y, y + glyph.height);
+
+        glyph.u0 = static_cast<float>(x) / width;
+        glyph.v0 = static_cast<float>(y) / height;
+        glyph.u1 = static_cast<float>(x + glyph.width) / width;
+        glyph.v1 = static_cast<float>(y + glyph.height) / height;
+    }
+
+    return &(glyphs[key] = glyph).value();
+}
+
+void GlyphAtlas::clear()
+{
+    std::fill(pixels.begin(), pixels.end(), 0);
+    for (int y = 0; y < solid_size; y++)
+        std::fill_n(&pixels[static_cast<size_t>(y) * width], solid_size, 255);
+
+    shelves.clear();
+    shelves.push_back({ 0, solid_size + padding, solid_size + padding });
+    glyphs.clear();
+    full = false;
+    generation++;
+    mark_dirty(0, height);
+}
+
+std::optional<std::pair<int, int>> GlyphAtlas::consume_dirty_rows()
+{
+    auto result = dirty_rows;
+    dirty_rows.reset();
+    return result;
+}
+
+float GlyphAtlas::get_solid_u() const
+{
+    return static_cast<float>(solid_size) / 2.f / width;
+}
+
+float GlyphAtlas::get_solid_v() const
+{
+    return static_cast<float>(solid_size) / 2.f / height;
+}
+
+std::optional<std::pair<int, int>> GlyphAtlas::allocate(int w, int h)
+{
+    if (w + padding > width)
+        return std::nullopt;
+
+    for (auto& shelf : shelves)
+    {
+        if (shelf.height >= h + padding && shelf.x + w + padding <= width)
+        {
+            std::pair<int, int> position { shelf.x, shelf.y };
+            shelf.x += w + padding;
+            return position;
+        }
+    }
+
+    auto const& last = shelves.back();
+    int const y = last.y + last.height;
+    if (y + h + padding > height)
+        return std::nullopt;
+
+    shelves.push_back({ y, h + padding, w + padding });
+    return std::pair<int, int> { 0, y };
+}
+
+void GlyphAtlas::mark_dirty(int first_row, int last_row)
+{
+    if (dirty_rows)
+        dirty_rows = { std::min(dirty_rows->first, first_row), std::max(dirty_rows->second, last_row) };
+    else
+        dirty_rows = { first_row, last_row };
+}
@@ -0,0 +1,126 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_GLYPH_ATLAS_H
+#define MIRACLEWM_GLYPH_ATLAS_H
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace miracle
+{
+
+/// A glyph as it comes out of the font, before it is packed into the atlas
+struct RasterizedGlyph
+{
+    int width = 0;
+    int height = 0;
+
+    /// Offset from the pen position to the left edge of the bitmap
+    int bearing_x = 0;
+
+    /// Offset from the baseline up to the top edge of the bitmap
+    int bearing_y = 0;
+
+    /// How far the pen moves after this glyph
+    float advance = 0;
+
+    /// width * height coverage values, row by row
+    std::vector<uint8_t> coverage;
+};
+
+/// A glyph that lives in the atlas, addressed by normalized texture coordinates
+struct AtlasGlyph
+{
+    float u0 = 0, v0 = 0, u1 = 0, v1 = 0;
+    int width = 0;
+    int height = 0;
+    int bearing_x = 0;
+    int bearing_y = 0;
+    float advance = 0;
+};
+
+/// A single-channel texture that holds every glyph that has been drawn so far. A glyph is
+/// rasterized the first time that it is requested at a given size and reused from then on.
+///
+/// The atlas only manages memory on the CPU. Whoever owns the GL texture uploads the rows
+/// reported by consume_dirty_rows.
+class GlyphAtlas
+{
+public:
+    using Rasterizer = std::function<std::optional<RasterizedGlyph>(char32_t codepoint, int pixel_size)>;
+
+    GlyphAtlas(int width, int height, Rasterizer rasterizer);
+
+    /// Returns the glyph, rasterizing it if this is the first time that it has been requested
+    /// at this size. Returns nullptr if the font cannot draw it or the atlas is full.
+    AtlasGlyph const* get(char32_t codepoint, int pixel_size);
+
+    /// Forgets every glyph. Anything that was laid out against the previous contents
+    /// must be laid out again, which can be detected through get_generation.
+    void clear();
+
+    /// Whether a glyph was turned away because the atlas ran out of space
+    [[nodiscard]] bool is_full() const { return full; }
+
+    /// Incremented on every clear
+    [[nodiscard]] uint64_t get_generation() const { return generation; }
+
+    /// The range of rows [first, last) that changed since the last call, if any
+    std::optional<std::pair<int, int>> consume_dirty_rows();
+
+    [[nodiscard]] int get_width() const { return width; }
+    [[nodiscard]] int get_height() const { return height; }
+    [[nodiscard]] uint8_t const* get_pixels() const { return pixels.data(); }
+
+    /// Texture coordinates of a fully covered texel, so that solid rectangles can be
+    /// drawn in the same batch as the text
+    [[nodiscard]] float get_solid_u() const;
+    [[nodiscard]] float get_solid_v() const;
+
+    /// The number of glyphs that were rasterized since the atlas was created
+    [[nodiscard]] size_t get_rasterized_count() const { return rasterized_count; }
+
+private:
+    struct Shelf
+    {
+        int y;
+        int height;
+        int x;
+    };
+
+    std::optional<std::pair<int, int>> allocate(int w, int h);
+    void mark_dirty(int first_row, int last_row);
+
+    int width;
+    int height;
+    Rasterizer rasterizer;
+    std::vector<uint8_t> pixels;
+    std::vector<Shelf> shelves;
+    std::unordered_map<uint64_t, std::optional<AtlasGlyph>> glyphs;
+    std::optional<std::pair<int, int>> dirty_rows;
+    uint64_t generation = 0;
+    size_t rasterized_count = 0;
+    bool full = false;
+};
+
+}
+
+#endif // MIRACLEWM_GLYPH_ATLAS_H
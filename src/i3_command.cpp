@@ -32,12 +32,14 @@ const char* INSTANCE_STRING = "instance";
 const char* WINDOW_ROLE_STRING = "window_role";
 const char* MACHINE_STRING = "machine";
 const char* ID_STRING = "id";
+const char* CON_ID_STRING = "con_id";
 const char* TITLE_STRING = "title";
 const char* URGENT_STRING = "urgent";
 const char* WORKSPACE_STRING = "workspace";
 const char* ALL_STRING = "all";
 const char* FLOATING_STRING = "floating";
 const char* TILING_STRING = "tiling";
+const char* APP_ID_STRING = "app_id";
 
 inline bool try_parse_i3_scope(
     std::string_view const& view,
@@ -93,12 +95,16 @@ std::vector<I3Scope> I3Scope::parse(std::string_view const& view, int& ptr)
             next.type = I3ScopeType::window_role;
         else if (try_parse_i3_scope(view, ptr, MACHINE_STRING, true))
             next.type = I3ScopeType::machine;
+        else if (try_parse_i3_scope(view, ptr, CON_ID_STRING, true))
+            next.type = I3ScopeType::con_id;
         else if (try_parse_i3_scope(view, ptr, ID_STRING, true))
             next.type = I3ScopeType::id;
         else if (try_parse_i3_scope(view, ptr, INSTANCE_STRING, true))
             next.type = I3ScopeType::instance;
         else if (try_parse_i3_scope(view, ptr, TITLE_STRING, true))
             next.type = I3ScopeType::title;
+        else if (try_parse_i3_scope(view, ptr, APP_ID_STRING, true))
+            next.type = I3ScopeType::app_id;
         else if (try_parse_i3_scope(view, ptr, URGENT_STRING, true))
             next.type = I3ScopeType::urgent;
         else if (try_parse_i3_scope(view, ptr, WORKSPACE_STRING, true))
@@ -176,7 +182,19 @@ bool I3ScopedCommandList::meets_criteria(miral::Window const& window, miral::Win
             auto const& name = window_info.name();
             if (!re.match(name))
                 return false;
+            break;
+        }
+        case I3ScopeType::app_id:
+        {
+            jp::Regex re(criteria.regex.value());
+            if (!re.match(window_info.application_id()))
+                return false;
+            break;
         }
+        case I3ScopeType::con_id:
+            if (std::to_string(window_helpers::get_container_id(window)) != criteria.regex.value())
+                return false;
+            break;
         default:
             break;
         }
@@ -260,15 +278,23 @@ std::vector<I3ScopedCommandList> I3ScopedCommandList::parse(std::string_view con
                         next_command.type = I3CommandType::i3_bar;
                     else if (equals(command_token.data(), "gaps"))
                         next_command.type = I3CommandType::gaps;
+                    else if (equals(command_token.data(), "append_layout"))
+                        next_command.type = I3CommandType::append_layout;
+                    else if (equals(command_token.data(), "power_profile"))
+                        next_command.type = I3CommandType::power_profile;
+                    else if (equals(command_token.data(), "blur"))
+                        next_command.type = I3CommandType::blur;
+                    else if (equals(command_token.data(), "opacity"))
+                        next_command.type = I3CommandType::opacity;
                     else
                     {
                         mir::log_error("Invalid i3 command type: %s", command_token.data());
                         continue;
                     }
                 }
-                else
+                else if (!command_token.empty())
                 {
-                    next_command.arguments.emplace_back(command_token.data());
+                    next_command.arguments.emplace_back(command_token.begin(), command_token.end());
                 }
             }
 
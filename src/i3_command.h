@@ -49,7 +49,11 @@ enum class I3CommandType
     scratchpad,
     nop,
     i3_bar,
-    gaps
+    gaps,
+    append_layout,
+    power_profile,
+    blur,
+    opacity
 };
 
 enum class I3ScopeType
@@ -66,6 +70,7 @@ enum class I3ScopeType
     floating_from,
     tiling,
     tiling_from,
+    app_id,
 
     /// TODO: X11-only
     class_,
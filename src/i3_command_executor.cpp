@@ -16,14 +16,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
 #include "i3_command_executor.h"
+#include "layout_description.h"
 #include "leaf_node.h"
 #include "parent_node.h"
 #include "policy.h"
+#include "shm_log.h"
+#include "tiling_window_tree.h"
 #include "window_helpers.h"
+#include "workspace_manager.h"
 
 #define MIR_LOG_COMPONENT "miracle"
+#include "miracle_log.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
 #include <mir/log.h>
+#include <mir/scene/surface.h>
 #include <miral/application_info.h>
+#include <sstream>
 
 using namespace miracle;
 
@@ -41,11 +51,36 @@ void I3CommandExecutor::process(miracle::I3ScopedCommandList const& command_list
 {
     for (auto const& command : command_list.commands)
     {
+        MIRACLE_LOG_DEBUG("Processing i3 command %d with %zu arguments", static_cast<int>(command.type), command.arguments.size());
         switch (command.type)
         {
         case I3CommandType::focus:
             process_focus(command, command_list);
             break;
+        case I3CommandType::workspace:
+            process_workspace(command, command_list);
+            break;
+        case I3CommandType::append_layout:
+            process_append_layout(command, command_list);
+            break;
+        case I3CommandType::power_profile:
+            process_power_profile(command, command_list);
+            break;
+        case I3CommandType::blur:
+            process_blur(command, command_list);
+            break;
+        case I3CommandType::opacity:
+            process_opacity(command, command_list);
+            break;
+        case I3CommandType::shm_log:
+            process_shm_log(command, command_list);
+            break;
+        case I3CommandType::move:
+            process_move(command, command_list);
+            break;
+        case I3CommandType::scratchpad:
+            process_scratchpad(command, command_list);
+            break;
         default:
             break;
         }
@@ -71,12 +106,35 @@ miral::Window I3CommandExecutor::get_window_meeting_criteria(I3ScopedCommandList
     return result;
 }
 
+std::vector<miral::Window> I3CommandExecutor::get_target_windows(I3ScopedCommandList const& command_list)
+{
+    std::vector<miral::Window> windows;
+    if (command_list.scope.empty())
+    {
+        if (auto active_window = tools.active_window())
+            windows.push_back(active_window);
+        return windows;
+    }
+
+    tools.find_application([&](miral::ApplicationInfo const& info)
+    {
+        for (auto const& window : info.windows())
+        {
+            if (command_list.meets_criteria(window, tools))
+                windows.push_back(window);
+        }
+
+        return false;
+    });
+    return windows;
+}
+
 void I3CommandExecutor::process_focus(I3Command const& command, I3ScopedCommandList const& command_list)
 {
     auto active_output = policy.get_active_output();
     if (!active_output)
     {
-        mir::log_warning("Trying to process I3 focus command, but output is not set");
+        MIRACLE_LOG_WARNING("Trying to process I3 focus command, but output is not set");
         return;
     }
 
@@ -85,7 +143,7 @@ void I3CommandExecutor::process_focus(I3Command const& command, I3ScopedCommandL
     {
         if (command_list.scope.empty())
         {
-            mir::log_warning("Focus command expected scope but none was provided");
+            MIRACLE_LOG_WARNING("Focus command expected scope but none was provided");
             return;
         }
 
@@ -101,7 +159,7 @@ void I3CommandExecutor::process_focus(I3Command const& command, I3ScopedCommandL
     {
         if (command_list.scope.empty())
         {
-            mir::log_warning("Focus 'workspace' command expected scope but none was provided");
+            MIRACLE_LOG_WARNING("Focus 'workspace' command expected scope but none was provided");
             return;
         }
 
@@ -119,9 +177,9 @@ void I3CommandExecutor::process_focus(I3Command const& command, I3ScopedCommandL
     else if (arg == "down")
         active_output->select(Direction::down);
     else if (arg == "parent")
-        mir::log_warning("'focus parent' is not supported, see https://github.com/mattkae/miracle-wm/issues/117"); // TODO
+        MIRACLE_LOG_WARNING("'focus parent' is not supported, see https://github.com/mattkae/miracle-wm/issues/117"); // TODO
     else if (arg == "child")
-        mir::log_warning("'focus child' is not supported, see https://github.com/mattkae/miracle-wm/issues/117"); // TODO
+        MIRACLE_LOG_WARNING("'focus child' is not supported, see https://github.com/mattkae/miracle-wm/issues/117"); // TODO
     else if (arg == "prev")
     {
         auto active_window = tools.active_window();
@@ -134,7 +192,7 @@ void I3CommandExecutor::process_focus(I3Command const& command, I3ScopedCommandL
 
         if (metadata->get_type() != WindowType::tiled)
         {
-            mir::log_warning("Cannot focus prev when a tiling window is not selected");
+            MIRACLE_LOG_WARNING("Cannot focus prev when a tiling window is not selected");
             return;
         }
 
@@ -144,7 +202,8 @@ void I3CommandExecutor::process_focus(I3Command const& command, I3ScopedCommandL
         if (index != 0)
         {
             auto node_to_select = parent->get_nth_window(index - 1);
-            active_output->select_window(node_to_select->get_window());
+            if (node_to_select && !node_to_select->is_placeholder())
+                active_output->select_window(node_to_select->get_window());
         }
     }
     else if (arg == "next")
@@ -159,7 +218,7 @@ void I3CommandExecutor::process_focus(I3Command const& command, I3ScopedCommandL
 
         if (metadata->get_type() != WindowType::tiled)
         {
-            mir::log_warning("Cannot focus prev when a tiling window is not selected");
+            MIRACLE_LOG_WARNING("Cannot focus prev when a tiling window is not selected");
             return;
         }
 
@@ -169,15 +228,291 @@ void I3CommandExecutor::process_focus(I3Command const& command, I3ScopedCommandL
         if (index != parent->num_nodes() - 1)
         {
             auto node_to_select = parent->get_nth_window(index + 1);
-            active_output->select_window(node_to_select->get_window());
+            if (node_to_select && !node_to_select->is_placeholder())
+                active_output->select_window(node_to_select->get_window());
         }
     }
     else if (arg == "floating")
-        mir::log_warning("'focus floating' is not supported, see https://github.com/mattkae/miracle-wm/issues/117"); // TODO
+        MIRACLE_LOG_WARNING("'focus floating' is not supported, see https://github.com/mattkae/miracle-wm/issues/117"); // TODO
     else if (arg == "tiling")
-        mir::log_warning("'focus tiling' is not supported, see https://github.com/mattkae/miracle-wm/issues/117"); // TODO
+        MIRACLE_LOG_WARNING("'focus tiling' is not supported, see https://github.com/mattkae/miracle-wm/issues/117"); // TODO
     else if (arg == "mode_toggle")
-        mir::log_warning("'focus mode_toggle' is not supported, see https://github.com/mattkae/miracle-wm/issues/117"); // TODO
+        MIRACLE_LOG_WARNING("'focus mode_toggle' is not supported, see https://github.com/mattkae/miracle-wm/issues/117"); // TODO
     else if (arg == "output")
-        mir::log_warning("'focus output' is not supported, see https://github.com/canonical/mir/issues/3357"); // TODO
-}
\ No newline at end of file
+        MIRACLE_LOG_WARNING("'focus output' is not supported, see https://github.com/canonical/mir/issues/3357"); // TODO
+}
+
+void I3CommandExecutor::process_workspace(I3Command const& command, I3ScopedCommandList const& command_list)
+{
+    auto active_output = policy.get_active_output();
+    if (!active_output)
+    {
+        MIRACLE_LOG_WARNING("Trying to process I3 workspace command, but output is not set");
+        return;
+    }
+
+    // https://i3wm.org/docs/userguide.html#_changing_named_workspaces_moving_to_workspaces
+    std::string const* name = nullptr;
+    for (auto const& arg : command.arguments)
+    {
+        if (arg == "number" || arg.starts_with("--"))
+            continue;
+
+        name = &arg;
+        break;
+    }
+
+    if (name == nullptr)
+    {
+        MIRACLE_LOG_WARNING("Workspace command expected a workspace but none was provided");
+        return;
+    }
+
+    int workspace;
+    try
+    {
+        workspace = std::stoi(*name);
+    }
+    catch (std::exception const&)
+    {
+        MIRACLE_LOG_WARNING("'workspace %s' is not supported, only numbered workspaces are", name->c_str());
+        return;
+    }
+
+    // Workspaces are keyed by their number key, so i3's workspace 10 is the one on the 0 key
+    if (workspace == WorkspaceManager::NUM_WORKSPACES)
+        workspace = 0;
+
+    if (workspace < 0 || workspace >= WorkspaceManager::NUM_WORKSPACES)
+    {
+        MIRACLE_LOG_WARNING("Workspace %d is out of range", workspace);
+        return;
+    }
+
+    workspace_manager.request_workspace(active_output, workspace);
+}
+
+void I3CommandExecutor::process_append_layout(I3Command const& command, I3ScopedCommandList const&)
+{
+    auto active_output = policy.get_active_output();
+    if (!active_output)
+    {
+        MIRACLE_LOG_WARNING("Trying to process I3 append_layout command, but output is not set");
+        return;
+    }
+
+    // https://i3wm.org/docs/layout-saving.html
+    if (command.arguments.empty())
+    {
+        MIRACLE_LOG_WARNING("append_layout command expected a file but none was provided");
+        return;
+    }
+
+    // The command was split on spaces, but the path may contain them
+    std::string path;
+    for (auto const& arg : command.arguments)
+    {
+        if (!path.empty())
+            path += ' ';
+        path += arg;
+    }
+
+    if (path.starts_with("~/"))
+    {
+        if (auto home = getenv("HOME"))
+            path = std::string(home) + path.substr(1);
+    }
+
+    std::ifstream file(path);
+    if (!file)
+    {
+        MIRACLE_LOG_WARNING("Unable to open layout file: %s", path.c_str());
+        return;
+    }
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+    auto layout = LayoutDescription::parse(contents.str());
+    if (layout.empty())
+    {
+        MIRACLE_LOG_WARNING("Layout file has nothing to append: %s", path.c_str());
+        return;
+    }
+
+    active_output->get_active_tree()->append_layout(layout);
+}
+
+void I3CommandExecutor::process_power_profile(I3Command const& command, I3ScopedCommandList const&)
+{
+    // power_profile <name|auto> [output <output-name>]
+    if (command.arguments.empty())
+    {
+        MIRACLE_LOG_WARNING("power_profile command expected a profile but none was provided");
+        return;
+    }
+
+    auto const& name = command.arguments[0];
+    std::optional<std::string> output_name;
+    if (command.arguments.size() == 3 && command.arguments[1] == "output")
+        output_name = command.arguments[2];
+    else if (command.arguments.size() != 1)
+    {
+        MIRACLE_LOG_WARNING("power_profile command expected 'power_profile <name> [output <output>]'");
+        return;
+    }
+
+    if (!policy.get_config()->select_power_profile(name, output_name))
+        MIRACLE_LOG_WARNING("power_profile command: unknown profile %s", name.c_str());
+}
+
+void I3CommandExecutor::process_blur(I3Command const& command, I3ScopedCommandList const& command_list)
+{
+    // blur enable|disable|toggle, applied to the windows meeting the criteria or else to the active window
+    if (command.arguments.size() != 1)
+    {
+        MIRACLE_LOG_WARNING("blur command expected 'blur enable|disable|toggle'");
+        return;
+    }
+
+    auto const& arg = command.arguments[0];
+    if (arg != "enable" && arg != "disable" && arg != "toggle")
+    {
+        MIRACLE_LOG_WARNING("blur command: unknown argument %s", arg.c_str());
+        return;
+    }
+
+    auto const app_ids = policy.get_config()->get_blur_config().app_ids;
+    for (auto const& window : get_target_windows(command_list))
+    {
+        auto metadata = window_helpers::get_metadata(window, tools);
+        if (!metadata)
+            continue;
+
+        if (arg == "enable")
+            metadata->set_blur_choice(BlurChoice::enabled);
+        else if (arg == "disable")
+            metadata->set_blur_choice(BlurChoice::disabled);
+        else
+        {
+            auto const choice = metadata->get_blur_choice();
+            auto const& application_id = tools.info_for(window).application_id();
+            bool const is_blurred = choice == BlurChoice::enabled
+                || (choice == BlurChoice::from_config
+                    && std::find(app_ids.begin(), app_ids.end(), application_id) != app_ids.end());
+            metadata->set_blur_choice(is_blurred ? BlurChoice::disabled : BlurChoice::enabled);
+        }
+    }
+}
+
+void I3CommandExecutor::process_opacity(I3Command const& command, I3ScopedCommandList const& command_list)
+{
+    // opacity [set|plus|minus] <value>, applied to the windows meeting the criteria or else to the active window
+    if (command.arguments.empty() || command.arguments.size() > 2)
+    {
+        MIRACLE_LOG_WARNING("opacity command expected 'opacity [set|plus|minus] <value>'");
+        return;
+    }
+
+    std::string const operation = command.arguments.size() == 2 ? command.arguments[0] : "set";
+    if (operation != "set" && operation != "plus" && operation != "minus")
+    {
+        MIRACLE_LOG_WARNING("opacity command: unknown operation %s", operation.c_str());
+        return;
+    }
+
+    float value;
+    try
+    {
+        value = std::stof(command.arguments.back());
+    }
+    catch (std::exception const&)
+    {
+        MIRACLE_LOG_WARNING("opacity command: invalid value %s", command.arguments.back().c_str());
+        return;
+    }
+
+    auto const opacity_config = policy.get_config()->get_opacity_config();
+    for (auto const& window : get_target_windows(command_list))
+    {
+        auto metadata = window_helpers::get_metadata(window, tools);
+        if (!metadata)
+            continue;
+
+        auto const current = metadata->get_opacity().value_or(
+            opacity_config.get_opacity(tools.info_for(window).application_id()));
+        auto opacity = value;
+        if (operation == "plus")
+            opacity = current + value;
+        else if (operation == "minus")
+            opacity = current - value;
+        metadata->set_opacity(std::clamp(opacity, 0.f, 1.f));
+
+        // The renderer reads the opacity when the window is next drawn, so the window has to be drawn again
+        auto surface = window.operator std::shared_ptr<mir::scene::Surface>();
+        if (surface)
+            surface->set_alpha(surface->alpha());
+    }
+}
+
+void I3CommandExecutor::process_shm_log(I3Command const& command, I3ScopedCommandList const&)
+{
+    // shm_log on|off|toggle|<size>, as in i3. The ring is allocated when the compositor starts, so
+    // a size only turns the log on, or off when it is 0.
+    if (command.arguments.size() != 1)
+    {
+        MIRACLE_LOG_WARNING("shm_log command expected 'shm_log on|off|toggle|<size>'");
+        return;
+    }
+
+    auto& log = ShmLog::instance();
+    auto const& arg = command.arguments[0];
+    if (arg == "on")
+        log.set_enabled(true);
+    else if (arg == "off")
+        log.set_enabled(false);
+    else if (arg == "toggle")
+        log.set_enabled(!log.is_enabled());
+    else
+    {
+        char* end = nullptr;
+        auto const size = std::strtoull(arg.c_str(), &end, 10);
+        if (arg.empty() || *end != '\0')
+        {
+            MIRACLE_LOG_WARNING("shm_log command: unknown argument %s", arg.c_str());
+            return;
+        }
+
+        if (size > 0 && size != log.get_size())
+            mir::log_info("shm_log command: the log keeps its size of %zu bytes", log.get_size());
+        log.set_enabled(size > 0);
+    }
+
+    mir::log_info("The shared memory log is %s", log.is_enabled() ? "on" : "off");
+}
+
+void I3CommandExecutor::process_move(I3Command const& command, I3ScopedCommandList const& command_list)
+{
+    // Only 'move [to] scratchpad' is supported, applied to the windows meeting the criteria or else to the active window
+    auto const& arguments = command.arguments;
+    bool const is_scratchpad = (arguments.size() == 1 && arguments[0] == "scratchpad")
+        || (arguments.size() == 2 && arguments[0] == "to" && arguments[1] == "scratchpad");
+    if (!is_scratchpad)
+    {
+        MIRACLE_LOG_WARNING("move command: only 'move scratchpad' is supported");
+        return;
+    }
+
+    for (auto const& window : get_target_windows(command_list))
+        policy.move_to_scratchpad(window);
+}
+
+void I3CommandExecutor::process_scratchpad(I3Command const& command, I3ScopedCommandList const&)
+{
+    if (command.arguments.size() != 1 || command.arguments[0] != "show")
+    {
+        MIRACLE_LOG_WARNING("scratchpad command expected 'scratchpad show'");
+        return;
+    }
+
+    policy.toggle_scratchpad();
+}
@@ -41,7 +41,18 @@ private:
     miral::WindowManagerTools tools;
 
     miral::Window get_window_meeting_criteria(I3ScopedCommandList const&);
+
+    /// The windows meeting the criteria, or else the active window when there are none
+    std::vector<miral::Window> get_target_windows(I3ScopedCommandList const&);
     void process_focus(I3Command const&, I3ScopedCommandList const&);
+    void process_workspace(I3Command const&, I3ScopedCommandList const&);
+    void process_append_layout(I3Command const&, I3ScopedCommandList const&);
+    void process_power_profile(I3Command const&, I3ScopedCommandList const&);
+    void process_blur(I3Command const&, I3ScopedCommandList const&);
+    void process_opacity(I3Command const&, I3ScopedCommandList const&);
+    void process_shm_log(I3Command const&, I3ScopedCommandList const&);
+    void process_move(I3Command const&, I3ScopedCommandList const&);
+    void process_scratchpad(I3Command const&, I3ScopedCommandList const&);
 };
 
 } // miracle
@@ -0,0 +1,69 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "inactive_dim.h"
+
+#include <algorithm>
+
+using namespace miracle;
+
+InactiveDim::Sample InactiveDim::sample(
+    void const* key,
+    float target,
+    std::chrono::duration<float> duration,
+    Clock::time_point now,
+    long long frameno)
+{
+    auto [it, inserted] = entries.try_emplace(key, Entry { target, target, now, frameno });
+    auto& entry = it->second;
+    entry.last_used = frameno;
+
+    if (entry.to != target)
+    {
+        // Focus may change again before the last change has finished easing
+        entry.from = get_value(entry, get_progress(entry, duration, now));
+        entry.to = target;
+        entry.started = now;
+    }
+
+    auto const progress = get_progress(entry, duration, now);
+    return { get_value(entry, progress), progress < 1.f };
+}
+
+void InactiveDim::evict_unused_since(long long frameno)
+{
+    std::erase_if(entries, [frameno](auto const& pair)
+    {
+        return pair.second.last_used < frameno;
+    });
+}
+
+float InactiveDim::get_progress(Entry const& entry, std::chrono::duration<float> duration, Clock::time_point now)
+{
+    if (duration.count() <= 0.f || entry.from == entry.to)
+        return 1.f;
+
+    auto const elapsed = std::chrono::duration<float>(now - entry.started);
+    return std::clamp(elapsed / duration, 0.f, 1.f);
+}
+
+float InactiveDim::get_value(Entry const& entry, float progress)
+{
+    // Ease out, so that the window reacts to the focus change straight away
+    auto const eased = 1.f - (1.f - progress) * (1.f - progress);
+    return entry.from + (entry.to - entry.from) * eased;
+}
@@ -0,0 +1,77 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_INACTIVE_DIM_H
+#define MIRACLEWM_INACTIVE_DIM_H
+
+#include <chrono>
+#include <cstddef>
+#include <unordered_map>
+
+namespace miracle
+{
+
+/// Eases the dim factor of each window towards its target when focus changes.
+///
+/// This is state of the renderer rather than of the window: a focus change only
+/// changes the uniform that each window is drawn with, so the windows themselves
+/// are never modified and no extra draws are needed.
+class InactiveDim
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Sample
+    {
+        float dim;
+
+        /// Whether the dim factor is still on its way to its target, which needs another frame
+        bool is_animating;
+    };
+
+    /// Samples the dim factor of the key at the provided time. A key that has not been seen
+    /// before starts at its target, while a key whose target changed eases from where it was.
+    Sample sample(
+        void const* key,
+        float target,
+        std::chrono::duration<float> duration,
+        Clock::time_point now,
+        long long frameno);
+
+    /// Drops the keys that have not been sampled since the provided frame
+    void evict_unused_since(long long frameno);
+
+    [[nodiscard]] std::size_t size() const { return entries.size(); }
+
+private:
+    struct Entry
+    {
+        float from;
+        float to;
+        Clock::time_point started;
+        long long last_used;
+    };
+
+    static float get_progress(Entry const&, std::chrono::duration<float> duration, Clock::time_point now);
+    static float get_value(Entry const&, float progress);
+
+    std::unordered_map<void const*, Entry> entries;
+};
+
+} // miracle
+
+#endif // MIRACLEWM_INACTIVE_DIM_H
@@ -19,13 +19,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "ipc.h"
 #include "i3_command_executor.h"
+#include "miracle_log.h"
 #include "output_content.h"
 #include "policy.h"
 
+#include <algorithm>
+#include <chrono>
 #include <fcntl.h>
+#include <limits>
 #include <mir/log.h>
 #include <nlohmann/json.hpp>
-#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
@@ -33,9 +36,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 using json = nlohmann::json;
 using namespace miracle;
 
-static const char ipc_magic[] = { 'i', '3', '-', 'i', 'p', 'c' };
-
-#define IPC_HEADER_SIZE (sizeof(ipc_magic) + 8)
 #define event_mask(ev) (1 << (ev & 0x7F))
 
 namespace
@@ -68,6 +68,37 @@ struct sockaddr_un* ipc_user_sockaddr()
     return ipc_sockaddr;
 }
 
+/// Clients that fall this far behind on reading are disconnected
+size_t const max_outgoing_size = 4e6;
+
+/// Upper bound on the number of windows that a single search request can return
+size_t const max_search_results = 1000;
+
+/// Upper bound on the number of applications that a single render cost request can return
+size_t const max_render_cost_results = 1000;
+
+char const* render_cost_source_name(RenderCostSource source)
+{
+    switch (source)
+    {
+    case RenderCostSource::gpu_timer:
+        return "gpu_timer";
+    case RenderCostSource::cpu_submit:
+        return "cpu_submit";
+    }
+    return "unknown";
+}
+
+double to_milliseconds(std::chrono::nanoseconds time)
+{
+    return std::chrono::duration<double, std::milli>(time).count();
+}
+
+std::shared_ptr<std::string const> make_message(IpcCommandType command_type, std::string const& payload)
+{
+    return std::make_shared<std::string const>(IpcFrameReader::encode(command_type, payload));
+}
+
 json workspace_to_json(std::shared_ptr<OutputContent> const& screen, int key)
 {
     bool is_focused = screen->get_active_workspace_num() == key;
@@ -93,7 +124,8 @@ json workspace_to_json(std::shared_ptr<OutputContent> const& screen, int key)
 
 json outputs_to_json(std::vector<std::shared_ptr<OutputContent>> const& outputs)
 {
-    json outputs_json;
+    json outputs_json = json::array();
+    geom::Rectangle root_area;
     for (auto const& output : outputs)
     {
         json workspaces;
@@ -102,8 +134,18 @@ json outputs_to_json(std::vector<std::shared_ptr<OutputContent>> const& outputs)
             workspaces.push_back(workspace_to_json(output, workspace->get_workspace()));
         }
 
-        auto area = outputs[0]->get_area();
-        auto miral_output = output->get_output();
+        auto area = output->get_area();
+        if (outputs_json.empty())
+            root_area = area;
+        else
+        {
+            auto left = std::min(root_area.left(), area.left());
+            auto top = std::min(root_area.top(), area.top());
+            auto right = std::max(root_area.right(), area.right());
+            auto bottom = std::max(root_area.bottom(), area.bottom());
+            root_area = geom::Rectangle(geom::Point(left, top), geom::Size(right.as_int() - left.as_int(), bottom.as_int() - top.as_int()));
+        }
+        auto const& miral_output = output->get_output();
         outputs_json.push_back({
             { "id",     miral_output.id()    },
             { "name",   miral_output.name()  },
@@ -118,7 +160,7 @@ json outputs_to_json(std::vector<std::shared_ptr<OutputContent>> const& outputs)
         });
     }
 
-    auto area = outputs[0]->get_area();
+    auto const& area = root_area;
     json root = {
         { "id",    0                                                                                                                                                        },
         { "name",  "root"                                                                                                                                                   },
@@ -133,11 +175,11 @@ json outputs_to_json(std::vector<std::shared_ptr<OutputContent>> const& outputs)
 Ipc::Ipc(miral::MirRunner& runner,
     miracle::WorkspaceManager& workspace_manager,
     Policy& policy,
-    std::shared_ptr<mir::ServerActionQueue> const& queue,
+    Scheduler& scheduler,
     I3CommandExecutor& executor) :
     workspace_manager { workspace_manager },
     policy { policy },
-    queue { queue },
+    scheduler { scheduler },
     executor { executor }
 {
     auto ipc_socket_raw = socket(AF_UNIX, SOCK_STREAM, 0);
@@ -182,6 +224,32 @@ Ipc::Ipc(miral::MirRunner& runner,
     setenv("I3SOCK", ipc_sockaddr->sun_path, 1);
     setenv("SWAYSOCK", ipc_sockaddr->sun_path, 1);
 
+    ring = IpcRing::create({ [this](int fd, char const* data, size_t size)
+    {
+        handle_received(fd, data, size);
+    },
+        [this](int fd, size_t written)
+    {
+        handle_sent(fd, written);
+    },
+        [this](int fd, int error)
+    {
+        if (auto client = find_client(fd))
+        {
+            if (error)
+                mir::log_error("IPC client socket failed: %s", strerror(error));
+            disconnect(*client);
+        }
+    } });
+    if (ring)
+    {
+        mir::log_info("IPC clients are served through io_uring");
+        ring_handle = runner.register_fd_handler(ring->get_fd(), [this](int)
+        {
+            ring->process();
+        });
+    }
+
     ipc_socket = mir::Fd { ipc_socket_raw };
     socket_handle = runner.register_fd_handler(ipc_socket, [&](int fd)
     {
@@ -209,67 +277,20 @@ Ipc::Ipc(miral::MirRunner& runner,
         }
 
         auto mir_fd = mir::Fd { client_fd };
-        clients.push_back({ mir_fd,
-            runner.register_fd_handler(mir_fd, [this](int fd)
+        if (ring)
         {
-            auto& client = get_client(fd);
-
-            int read_available;
-            if (ioctl(client.client_fd, FIONREAD, &read_available) == -1)
-            {
-                mir::log_error("Unable to read IPC socket buffer size");
-                disconnect(client);
-                return;
-            }
-
-            if (client.pending_read_length > 0)
-            {
-                if ((uint32_t)read_available >= client.pending_read_length)
-                {
-                    // Reset pending values.
-                    uint32_t pending_length = client.pending_read_length;
-                    IpcCommandType pending_type = client.pending_type;
-                    client.pending_read_length = 0;
-                    handle_command(client, pending_length, pending_type);
-                }
-                return;
-            }
-
-            if (read_available < (int)IPC_HEADER_SIZE)
-            {
-                return;
-            }
-
-            uint8_t buf[IPC_HEADER_SIZE];
-            // Should be fully available, because read_available >= IPC_HEADER_SIZE
-            ssize_t received = recv(client.client_fd, buf, IPC_HEADER_SIZE, 0);
-            if (received == -1)
-            {
-                mir::log_error("Unable to receive header from IPC client");
-                disconnect(client);
-                return;
-            }
-
-            if (memcmp(buf, ipc_magic, sizeof(ipc_magic)) != 0)
-            {
-                mir::log_error("IPC header check failed");
-                disconnect(client);
-                return;
-            }
-
-            memcpy(&client.pending_read_length, buf + sizeof(ipc_magic), sizeof(uint32_t));
-            memcpy(&client.pending_type, buf + sizeof(ipc_magic) + sizeof(uint32_t), sizeof(uint32_t));
-            mir::log_debug("Received request from IPC client: %d", (int)client.pending_type);
-
-            if (read_available - received >= (long)client.pending_read_length)
+            clients.push_back({ mir_fd });
+            ring->add(mir_fd);
+            ring->submit();
+        }
+        else
+        {
+            clients.push_back({ mir_fd,
+                runner.register_fd_handler(mir_fd, [this](int fd)
             {
-                // Reset pending values.
-                uint32_t pending_length = client.pending_read_length;
-                IpcCommandType pending_type = client.pending_type;
-                client.pending_read_length = 0;
-                handle_command(client, pending_length, pending_type);
-            }
-        }) });
+                handle_readable(fd);
+            }) });
+        }
     });
 }
 
@@ -281,16 +302,7 @@ void Ipc::on_created(std::shared_ptr<OutputContent> const& info, int key)
         { "current", workspace_to_json(info, key) }
     };
 
-    auto serialized_value = to_string(j);
-    for (auto& client : clients)
-    {
-        if ((client.subscribed_events & event_mask(IPC_EVENT_WORKSPACE)) == 0)
-        {
-            continue;
-        }
-
-        send_reply(client, IPC_EVENT_WORKSPACE, serialized_value);
-    }
+    broadcast_later(IPC_EVENT_WORKSPACE, std::move(j));
 }
 
 void Ipc::on_removed(std::shared_ptr<OutputContent> const& screen, int key)
@@ -300,16 +312,7 @@ void Ipc::on_removed(std::shared_ptr<OutputContent> const& screen, int key)
         { "current", workspace_to_json(screen, key) }
     };
 
-    auto serialized_value = to_string(j);
-    for (auto& client : clients)
-    {
-        if ((client.subscribed_events & event_mask(IPC_EVENT_WORKSPACE)) == 0)
-        {
-            continue;
-        }
-
-        send_reply(client, IPC_EVENT_WORKSPACE, serialized_value);
-    }
+    broadcast_later(IPC_EVENT_WORKSPACE, std::move(j));
 }
 
 void Ipc::on_focused(
@@ -328,27 +331,119 @@ void Ipc::on_focused(
     else
         j["old"] = nullptr;
 
-    auto serialized_value = to_string(j);
+    broadcast_later(IPC_EVENT_WORKSPACE, std::move(j));
+}
+
+void Ipc::broadcast_later(IpcCommandType event_type, json event)
+{
+    // The event is captured now so that it reflects the state at the time it happened,
+    // but serializing and writing it to every subscriber is deferred until the compositor is idle.
+    scheduler.post(TaskPriority::idle, [this, event_type, event = std::move(event)]()
+    {
+        bool has_subscribers = false;
+        for (auto const& client : clients)
+        {
+            if (client.subscribed_events & event_mask(event_type))
+            {
+                has_subscribers = true;
+                break;
+            }
+        }
+
+        if (!has_subscribers)
+            return;
+
+        // The message is serialized once and shared by every subscriber
+        auto message = make_message(event_type, to_string(event));
+        std::vector<int> subscribers;
+        for (auto const& client : clients)
+        {
+            if (client.subscribed_events & event_mask(event_type))
+                subscribers.push_back(client.client_fd);
+        }
+
+        for (auto fd : subscribers)
+        {
+            if (auto client = find_client(fd))
+                queue_message(*client, message);
+        }
+
+        if (ring)
+            ring->submit();
+    });
+}
+
+Ipc::IpcClient* Ipc::find_client(int fd)
+{
     for (auto& client : clients)
     {
-        if ((client.subscribed_events & event_mask(IPC_EVENT_WORKSPACE)) == 0)
+        if (client.client_fd == fd)
+            return &client;
+    }
+
+    return nullptr;
+}
+
+void Ipc::handle_readable(int fd)
+{
+    char buffer[4096];
+    while (true)
+    {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received > 0)
         {
+            handle_received(fd, buffer, received);
             continue;
         }
 
-        send_reply(client, IPC_EVENT_WORKSPACE, serialized_value);
+        if (received == -1 && errno == EINTR)
+            continue;
+
+        if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+
+        if (auto client = find_client(fd))
+        {
+            if (received == -1)
+                mir::log_error("Unable to receive from IPC client");
+            disconnect(*client);
+        }
+        return;
     }
 }
 
-Ipc::IpcClient& Ipc::get_client(int fd)
+void Ipc::handle_received(int fd, char const* data, size_t size)
 {
-    for (auto& client : clients)
+    auto client = find_client(fd);
+    if (!client)
+        return;
+
+    client->reader.append(data, size);
+    while (auto frame = client->reader.next())
     {
-        if (client.client_fd == fd)
-            return client;
+        auto const payload_type = static_cast<IpcCommandType>(frame->type);
+        MIRACLE_LOG_DEBUG("Received request from IPC client: %d", (int)payload_type);
+        handle_command(*client, payload_type, frame->payload);
+
+        // Handling the command may have disconnected the client
+        client = find_client(fd);
+        if (!client)
+            return;
     }
 
-    throw std::runtime_error("Could not find IPC client");
+    switch (client->reader.get_error())
+    {
+    case IpcFrameReader::Error::none:
+        break;
+    case IpcFrameReader::Error::bad_magic:
+        mir::log_error("IPC header check failed");
+        disconnect(*client);
+        break;
+    case IpcFrameReader::Error::payload_too_big:
+        mir::log_error("IPC payload too big, disconnecting client");
+        disconnect(*client);
+        break;
+    }
 }
 
 void Ipc::disconnect(Ipc::IpcClient& client)
@@ -359,6 +454,8 @@ void Ipc::disconnect(Ipc::IpcClient& client)
     });
     if (it != clients.end())
     {
+        if (ring)
+            ring->remove(client.client_fd);
         shutdown(client.client_fd, SHUT_RDWR);
         mir::log_info("Disconnected client: %d", (int)client.client_fd);
         clients.erase(it);
@@ -369,35 +466,13 @@ void Ipc::disconnect(Ipc::IpcClient& client)
     }
 }
 
-void Ipc::handle_command(miracle::Ipc::IpcClient& client, uint32_t payload_length, miracle::IpcCommandType payload_type)
+void Ipc::handle_command(miracle::Ipc::IpcClient& client, miracle::IpcCommandType payload_type, std::string const& payload)
 {
-    char* buf = (char*)malloc(payload_length + 1);
-    if (!buf)
-    {
-        mir::log_error("Unable to allocate IPC payload");
-        disconnect(client);
-        return;
-    }
-
-    if (payload_length > 0)
-    {
-        // Payload should be fully available
-        ssize_t received = recv(client.client_fd, buf, payload_length, 0);
-        if (received == -1)
-        {
-            mir::log_error("Unable to receive payload from IPC client");
-            disconnect(client);
-            free(buf);
-            return;
-        }
-    }
-    buf[payload_length] = '\0';
-
     switch (payload_type)
     {
     case IPC_COMMAND:
     {
-        auto result = parse_i3_command(std::string_view(buf));
+        auto result = parse_i3_command(std::string_view(payload));
         if (result)
         {
             const std::string msg = "[{\"success\": true}]";
@@ -425,11 +500,11 @@ void Ipc::handle_command(miracle::Ipc::IpcClient& client, uint32_t payload_lengt
     }
     case IPC_SUBSCRIBE:
     {
-        json j = json::parse(buf);
+        json j = json::parse(payload);
         for (auto const& i : j)
         {
             std::string event_type = i.template get<std::string>();
-            mir::log_debug("Received subscription request from IPC client for event: %s", event_type.c_str());
+            MIRACLE_LOG_DEBUG("Received subscription request from IPC client for event: %s", event_type.c_str());
             if (event_type == "workspace")
             {
                 client.subscribed_events |= event_mask(IPC_EVENT_WORKSPACE);
@@ -468,6 +543,115 @@ void Ipc::handle_command(miracle::Ipc::IpcClient& client, uint32_t payload_lengt
         send_reply(client, payload_type, json_string);
         return;
     }
+    case IPC_GET_CLIENT_DIAGNOSTICS:
+    {
+        json offenders = json::array();
+        for (auto const& offender : policy.get_commit_rate_governor().get_offenders())
+        {
+            offenders.push_back({
+                { "app_id",             offender.application_id   },
+                { "commits_per_second", offender.commits_per_second },
+                { "limit_per_second",   offender.limit_per_second },
+                { "hidden",             offender.is_hidden        },
+                { "over_limit",         offender.is_over_limit    },
+                { "times_over_limit",   offender.times_over_limit }
+            });
+        }
+
+        json j = { { "commit_rate_offenders", offenders } };
+        send_reply(client, payload_type, to_string(j));
+        return;
+    }
+    case IPC_SEARCH_WINDOWS:
+    {
+        // The payload is {"query": "...", "limit": N}. Each match carries the container id
+        // that a follow-up command can use, e.g. [con_id="N"] focus
+        std::string query;
+        size_t limit = 10;
+        try
+        {
+            auto const request = json::parse(payload);
+            query = request.value("query", "");
+            limit = std::min(request.value("limit", limit), max_search_results);
+        }
+        catch (json::exception const& e)
+        {
+            mir::log_warning("Invalid window search request: %s", e.what());
+            send_reply(client, payload_type, R"({"success": false, "parse_error": true})");
+            return;
+        }
+
+        json matches = json::array();
+        for (auto const& match : policy.get_window_search_index().search(query, limit))
+        {
+            matches.push_back({
+                { "id",     match.id     },
+                { "name",   match.title  },
+                { "app_id", match.app_id },
+                { "score",  match.score  }
+            });
+        }
+
+        json j = { { "success", true }, { "matches", matches } };
+        send_reply(client, payload_type, to_string(j));
+        return;
+    }
+    case IPC_GET_RENDER_COSTS:
+    {
+        // The payload is optional, e.g. {"enable": true, "limit": N}. Enabling starts a fresh
+        // measurement, so the reply lists what each application has cost since then
+        auto& tracker = policy.get_render_cost_tracker();
+        size_t limit = 20;
+        if (!payload.empty())
+        {
+            try
+            {
+                auto const request = json::parse(payload);
+                if (request.contains("enable"))
+                    tracker.set_enabled(request["enable"].get<bool>());
+                limit = std::min(request.value("limit", limit), max_render_cost_results);
+            }
+            catch (json::exception const& e)
+            {
+                mir::log_warning("Invalid render cost request: %s", e.what());
+                send_reply(client, payload_type, R"({"success": false, "parse_error": true})");
+                return;
+            }
+        }
+
+        auto const costs = tracker.ranked(std::numeric_limits<size_t>::max());
+        std::chrono::nanoseconds total { 0 };
+        for (auto const& cost : costs)
+            total += cost.total_time();
+
+        json windows = json::array();
+        for (size_t i = 0; i < std::min(limit, costs.size()); i++)
+        {
+            auto const& cost = costs[i];
+            windows.push_back({
+                { "app_id",      cost.application_id                    },
+                { "source",      render_cost_source_name(cost.source)   },
+                { "draws",       cost.draws                             },
+                { "total_ms",    to_milliseconds(cost.total_time())     },
+                { "surface_ms",  to_milliseconds(cost.surface_time)     },
+                { "outline_ms",  to_milliseconds(cost.outline_time)     },
+                { "blur_ms",     to_milliseconds(cost.blur_time)        },
+                { "blur_updates", cost.blur_updates                     },
+                { "blur_reuses", cost.blur_reuses                       },
+                { "max_draw_ms", to_milliseconds(cost.max_draw_time)    },
+                { "share",       total.count() ? (double)cost.total_time().count() / total.count() : 0.0 }
+            });
+        }
+
+        json j = {
+            { "success",    true                                        },
+            { "enabled",    tracker.is_enabled()                        },
+            { "elapsed_ms", to_milliseconds(tracker.get_elapsed())      },
+            { "windows",    windows                                     }
+        };
+        send_reply(client, payload_type, to_string(j));
+        return;
+    }
     default:
         mir::log_warning("Unknown payload type: %d", payload_type);
         disconnect(client);
@@ -477,42 +661,41 @@ void Ipc::handle_command(miracle::Ipc::IpcClient& client, uint32_t payload_lengt
 
 void Ipc::send_reply(miracle::Ipc::IpcClient& client, miracle::IpcCommandType command_type, const std::string& payload)
 {
-    const uint32_t payload_length = payload.size();
-    char data[IPC_HEADER_SIZE];
-
-    memcpy(data, ipc_magic, sizeof(ipc_magic));
-    memcpy(data + sizeof(ipc_magic), &payload_length, sizeof(payload_length));
-    memcpy(data + sizeof(ipc_magic) + sizeof(payload_length), &command_type, sizeof(command_type));
+    queue_message(client, make_message(command_type, payload));
+}
 
-    auto new_buffer_size = client.buffer.size();
-    while (client.write_buffer_len + IPC_HEADER_SIZE + payload_length >= new_buffer_size)
+void Ipc::queue_message(miracle::Ipc::IpcClient& client, std::shared_ptr<std::string const> const& message)
+{
+    if (client.outgoing_size + message->size() > max_outgoing_size)
     {
-        if (new_buffer_size == 0)
-            new_buffer_size = 1;
-        new_buffer_size *= 2;
-    }
-
-    if (new_buffer_size > 4e6)
-    { // 4 MB
-        mir::log_error("Client write buffer too big (%zu), disconnecting client", client.buffer.size());
+        mir::log_error("Client write buffer too big (%zu), disconnecting client", client.outgoing_size);
         disconnect(client);
         return;
     }
 
-    client.buffer.resize(new_buffer_size);
-
-    memcpy(client.buffer.data() + client.write_buffer_len, data, IPC_HEADER_SIZE);
-    client.write_buffer_len += IPC_HEADER_SIZE;
-    memcpy(client.buffer.data() + client.write_buffer_len, payload.c_str(), payload_length);
-    client.write_buffer_len += payload_length;
-    handle_writeable(client);
+    client.outgoing.push_back({ message });
+    client.outgoing_size += message->size();
+    flush(client);
 }
 
-void Ipc::handle_writeable(miracle::Ipc::IpcClient& client)
+void Ipc::flush(miracle::Ipc::IpcClient& client)
 {
-    while (client.write_buffer_len > 0)
+    if (ring)
     {
-        ssize_t written = write(client.client_fd, client.buffer.data(), client.write_buffer_len);
+        // One send is outstanding at a time so that messages cannot be reordered
+        if (!client.is_sending && !client.outgoing.empty())
+        {
+            auto const& front = client.outgoing.front();
+            ring->send(client.client_fd, front.data, front.offset);
+            client.is_sending = true;
+        }
+        return;
+    }
+
+    while (!client.outgoing.empty())
+    {
+        auto& front = client.outgoing.front();
+        ssize_t written = write(client.client_fd, front.data->data() + front.offset, front.data->size() - front.offset);
         if (written == -1 && errno == EAGAIN)
         {
             return;
@@ -524,11 +707,26 @@ void Ipc::handle_writeable(miracle::Ipc::IpcClient& client)
             return;
         }
 
-        memmove(client.buffer.data(), client.buffer.data() + written, client.write_buffer_len - written);
-        client.write_buffer_len -= written;
+        front.offset += written;
+        client.outgoing_size -= written;
+        if (front.offset == front.data->size())
+            client.outgoing.pop_front();
     }
+}
+
+void Ipc::handle_sent(int fd, size_t written)
+{
+    auto client = find_client(fd);
+    if (!client || client->outgoing.empty())
+        return;
 
-    client.write_buffer_len = 0;
+    client->is_sending = false;
+    auto& front = client->outgoing.front();
+    front.offset += written;
+    client->outgoing_size -= written;
+    if (front.offset == front.data->size())
+        client->outgoing.pop_front();
+    flush(*client);
 }
 
 namespace
@@ -547,7 +745,7 @@ bool Ipc::parse_i3_command(std::string_view const& command)
         pending_commands = I3ScopedCommandList::parse(command);
     }
 
-    queue->enqueue(this, [&]()
+    scheduler.post(TaskPriority::immediate, [&]()
     {
         size_t num_processed = 0;
         {
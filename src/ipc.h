@@ -20,11 +20,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "i3_command.h"
 #include "i3_command_executor.h"
+#include "ipc_frame_reader.h"
+#include "ipc_ring.h"
+#include "scheduler.h"
 #include "workspace_manager.h"
 #include "workspace_observer.h"
 #include <mir/fd.h>
-#include <mir/server_action_queue.h>
 #include <miral/runner.h>
+#include <deque>
+#include <nlohmann/json.hpp>
 #include <shared_mutex>
 #include <vector>
 
@@ -57,6 +61,11 @@ enum IpcCommandType
     IPC_GET_INPUTS = 100,
     IPC_GET_SEATS = 101,
 
+    // miracle-specific command types
+    IPC_GET_CLIENT_DIAGNOSTICS = 200,
+    IPC_SEARCH_WINDOWS = 201,
+    IPC_GET_RENDER_COSTS = 202,
+
     // Events sent from sway to clients. Events have the highest bits set.
     IPC_EVENT_WORKSPACE = ((1 << 31) | 0),
     IPC_EVENT_OUTPUT = ((1 << 31) | 1),
@@ -82,7 +91,7 @@ public:
     Ipc(miral::MirRunner& runner,
         WorkspaceManager&,
         Policy& policy,
-        std::shared_ptr<mir::ServerActionQueue> const&,
+        Scheduler&,
         I3CommandExecutor&);
 
     void on_created(std::shared_ptr<OutputContent> const& info, int key) override;
@@ -90,14 +99,23 @@ public:
     void on_focused(std::shared_ptr<OutputContent> const& previous, int, std::shared_ptr<OutputContent> const& current, int) override;
 
 private:
+    struct OutgoingMessage
+    {
+        /// The header and payload. Broadcasts share one message between every subscriber.
+        std::shared_ptr<std::string const> data;
+        size_t offset = 0;
+    };
+
     struct IpcClient
     {
         mir::Fd client_fd;
+
+        /// Only set when we read from the client ourselves rather than through the ring
         std::unique_ptr<miral::FdHandle> handle;
-        uint32_t pending_read_length = 0;
-        IpcCommandType pending_type;
-        std::vector<char> buffer;
-        int write_buffer_len = 0;
+        IpcFrameReader reader;
+        std::deque<OutgoingMessage> outgoing;
+        size_t outgoing_size = 0;
+        bool is_sending = false;
         int subscribed_events = 0;
     };
 
@@ -109,14 +127,26 @@ private:
     std::vector<IpcClient> clients;
     std::vector<I3ScopedCommandList> pending_commands;
     mutable std::shared_mutex pending_commands_mutex;
-    std::shared_ptr<mir::ServerActionQueue> queue;
+    Scheduler& scheduler;
     I3CommandExecutor& executor;
 
+    /// Performs client I/O when io_uring is available, otherwise we read and write each socket directly
+    std::unique_ptr<IpcRing> ring;
+    std::unique_ptr<miral::FdHandle> ring_handle;
+
     void disconnect(IpcClient& client);
-    IpcClient& get_client(int fd);
-    void handle_command(IpcClient& client, uint32_t payload_length, IpcCommandType payload_type);
+    IpcClient* find_client(int fd);
+    void handle_readable(int fd);
+    void handle_received(int fd, char const* data, size_t size);
+    void handle_sent(int fd, size_t written);
+    void handle_command(IpcClient& client, IpcCommandType payload_type, std::string const& payload);
     void send_reply(IpcClient& client, IpcCommandType command_type, std::string const& payload);
-    void handle_writeable(IpcClient& client);
+
+    /// Queues the message for the client. When using the ring, the send is only submitted with
+    /// the next call to IpcRing::submit, so that every send for an event goes out together.
+    void queue_message(IpcClient& client, std::shared_ptr<std::string const> const& message);
+    void flush(IpcClient& client);
+    void broadcast_later(IpcCommandType event_type, nlohmann::json event);
     bool parse_i3_command(std::string_view const& command);
 };
 }
@@ -0,0 +1,74 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "ipc_frame_reader.h"
+
+#include <cstring>
+
+using namespace miracle;
+
+std::string IpcFrameReader::encode(uint32_t type, std::string const& payload)
+{
+    uint32_t const payload_length = payload.size();
+    std::string message(header_size + payload.size(), '\0');
+    memcpy(message.data(), magic, sizeof(magic));
+    memcpy(message.data() + sizeof(magic), &payload_length, sizeof(payload_length));
+    memcpy(message.data() + sizeof(magic) + sizeof(payload_length), &type, sizeof(type));
+    memcpy(message.data() + header_size, payload.data(), payload.size());
+    return message;
+}
+
+void IpcFrameReader::append(char const* data, std::size_t size)
+{
+    if (error != Error::none)
+        return;
+
+    // Messages that were already taken are dropped here rather than after each one
+    buffer.erase(buffer.begin(), buffer.begin() + consumed);
+    consumed = 0;
+    buffer.insert(buffer.end(), data, data + size);
+}
+
+std::optional<IpcFrameReader::Frame> IpcFrameReader::next()
+{
+    if (error != Error::none || buffered() < header_size)
+        return std::nullopt;
+
+    char const* header = buffer.data() + consumed;
+    if (memcmp(header, magic, sizeof(magic)) != 0)
+    {
+        error = Error::bad_magic;
+        return std::nullopt;
+    }
+
+    uint32_t payload_length;
+    uint32_t type;
+    memcpy(&payload_length, header + sizeof(magic), sizeof(uint32_t));
+    memcpy(&type, header + sizeof(magic) + sizeof(uint32_t), sizeof(uint32_t));
+    if (payload_length > max_payload_length)
+    {
+        error = Error::payload_too_big;
+        return std::nullopt;
+    }
+
+    if (buffered() - header_size < payload_length)
+        return std::nullopt;
+
+    Frame frame { type, std::string(header + header_size, payload_length) };
+    consumed += header_size + payload_length;
+    return frame;
+}
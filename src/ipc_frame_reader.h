@@ -0,0 +1,78 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_IPC_FRAME_READER_H
+#define MIRACLEWM_IPC_FRAME_READER_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace miracle
+{
+
+/// Splits the bytes received from an IPC client into i3 messages. Each message is the
+/// "i3-ipc" magic, a 32-bit payload length, a 32-bit type and then the payload, so a read
+/// may hold part of a message or several of them.
+class IpcFrameReader
+{
+public:
+    enum class Error
+    {
+        none,
+        bad_magic,
+        payload_too_big
+    };
+
+    struct Frame
+    {
+        uint32_t type;
+        std::string payload;
+    };
+
+    static constexpr char magic[] = { 'i', '3', '-', 'i', 'p', 'c' };
+    static constexpr std::size_t header_size = sizeof(magic) + 2 * sizeof(uint32_t);
+
+    /// Requests larger than this are refused
+    static constexpr uint32_t max_payload_length = 1 << 20;
+
+    /// Builds a message with the header for the payload
+    static std::string encode(uint32_t type, std::string const& payload);
+
+    /// Adds data read from the client after whatever is still buffered
+    void append(char const* data, std::size_t size);
+
+    /// Takes the next complete message out of the buffer.
+    /// @returns nothing if the message is incomplete or the stream is broken, see get_error()
+    std::optional<Frame> next();
+
+    /// Once set, the stream cannot be recovered and the client should be disconnected
+    [[nodiscard]] Error get_error() const { return error; }
+
+    /// The number of bytes waiting to be read as messages
+    [[nodiscard]] std::size_t buffered() const { return buffer.size() - consumed; }
+
+private:
+    std::vector<char> buffer;
+    std::size_t consumed = 0;
+    Error error = Error::none;
+};
+
+} // miracle
+
+#endif // MIRACLEWM_IPC_FRAME_READER_H
@@ -0,0 +1,394 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "ipc_ring"
+
+#include "ipc_ring.h"
+
+#ifdef MIRACLE_WM_HAVE_IO_URING
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <liburing.h>
+#include <mir/log.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#endif
+
+using namespace miracle;
+
+#ifdef MIRACLE_WM_HAVE_IO_URING
+namespace
+{
+enum class Operation : uint64_t
+{
+    receive = 1,
+    send = 2,
+    cancel = 3
+};
+
+uint64_t encode(Operation operation, int fd)
+{
+    return (static_cast<uint64_t>(operation) << 32) | static_cast<uint32_t>(fd);
+}
+
+Operation decode_operation(uint64_t user_data)
+{
+    return static_cast<Operation>(user_data >> 32);
+}
+
+int decode_fd(uint64_t user_data)
+{
+    return static_cast<int>(user_data & 0xFFFFFFFF);
+}
+
+unsigned int const queue_depth = 256;
+
+/// Receives land in buffers that the kernel picks from this group. The count must be a power of two.
+unsigned int const buffer_count = 64;
+unsigned int const buffer_size = 4096;
+int const buffer_group = 0;
+
+class UringIpcRing : public IpcRing
+{
+public:
+    explicit UringIpcRing(Handlers const& handlers) :
+        handlers { handlers }
+    {
+    }
+
+    ~UringIpcRing() override
+    {
+        if (buffer_ring)
+            io_uring_free_buf_ring(&ring, buffer_ring, buffer_count, buffer_group);
+        if (is_initialized)
+            io_uring_queue_exit(&ring);
+    }
+
+    bool initialize()
+    {
+        int result = io_uring_queue_init(queue_depth, &ring, 0);
+        if (result < 0)
+        {
+            mir::log_info("io_uring is unavailable: %s", strerror(-result));
+            return false;
+        }
+        is_initialized = true;
+
+        buffers.resize(buffer_count * buffer_size);
+        buffer_ring = io_uring_setup_buf_ring(&ring, buffer_count, buffer_group, 0, &result);
+        if (!buffer_ring)
+        {
+            mir::log_info("io_uring does not support provided buffer rings: %s", strerror(-result));
+            return false;
+        }
+
+        for (unsigned int id = 0; id < buffer_count; id++)
+            io_uring_buf_ring_add(buffer_ring, buffers.data() + id * buffer_size, buffer_size, id, io_uring_buf_ring_mask(buffer_count), id);
+        io_uring_buf_ring_advance(buffer_ring, buffer_count);
+
+        if (!probe_multishot_receive())
+        {
+            mir::log_info("io_uring does not support multishot receives");
+            return false;
+        }
+
+        event_fd = mir::Fd { eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) };
+        if (event_fd < 0 || io_uring_register_eventfd(&ring, event_fd) < 0)
+        {
+            mir::log_info("Unable to register an eventfd with io_uring");
+            return false;
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] mir::Fd get_fd() const override
+    {
+        return event_fd;
+    }
+
+    void add(mir::Fd const& fd) override
+    {
+        connections[fd] = Connection { fd, false, false, nullptr };
+        arm_receive(fd);
+    }
+
+    void remove(int fd) override
+    {
+        auto it = connections.find(fd);
+        if (it == connections.end() || it->second.is_closing)
+            return;
+
+        it->second.is_closing = true;
+        if (it->second.is_receiving || it->second.sending)
+        {
+            prepare([fd](io_uring_sqe* sqe)
+            {
+                io_uring_prep_cancel_fd(sqe, fd, IORING_ASYNC_CANCEL_ALL);
+                io_uring_sqe_set_data64(sqe, encode(Operation::cancel, fd));
+            });
+        }
+
+        release_if_done(fd);
+    }
+
+    void send(int fd, std::shared_ptr<std::string const> const& message, size_t offset) override
+    {
+        auto it = connections.find(fd);
+        if (it == connections.end() || it->second.is_closing || it->second.sending)
+            return;
+
+        prepare([fd, message, offset](io_uring_sqe* sqe)
+        {
+            io_uring_prep_send(sqe, fd, message->data() + offset, message->size() - offset, MSG_NOSIGNAL);
+            io_uring_sqe_set_data64(sqe, encode(Operation::send, fd));
+        });
+        it->second.sending = message;
+    }
+
+    void submit() override
+    {
+        if (io_uring_sq_ready(&ring) > 0)
+            io_uring_submit(&ring);
+
+        // The submission made room for the operations that found the queue full
+        while (!overflow.empty())
+        {
+            auto sqe = io_uring_get_sqe(&ring);
+            if (!sqe)
+                break;
+
+            overflow.front()(sqe);
+            overflow.pop_front();
+        }
+
+        if (io_uring_sq_ready(&ring) > 0)
+            io_uring_submit(&ring);
+    }
+
+    void process() override
+    {
+        eventfd_t count;
+        eventfd_read(event_fd, &count);
+
+        // Handlers may queue more work, so each completion is copied out and marked as seen first
+        io_uring_cqe* cqe;
+        while (io_uring_peek_cqe(&ring, &cqe) == 0)
+        {
+            auto const completion = *cqe;
+            io_uring_cqe_seen(&ring, cqe);
+            handle(completion);
+        }
+
+        submit();
+    }
+
+private:
+    struct Connection
+    {
+        mir::Fd fd;
+        bool is_receiving = false;
+        bool is_closing = false;
+
+        /// The message being sent, which must outlive the send
+        std::shared_ptr<std::string const> sending;
+    };
+
+    Handlers handlers;
+    io_uring ring {};
+    bool is_initialized = false;
+    io_uring_buf_ring* buffer_ring = nullptr;
+    std::vector<char> buffers;
+    mir::Fd event_fd;
+    std::unordered_map<int, Connection> connections;
+
+    /// Operations that could not get a submission queue entry, in the order they were made.
+    /// They are prepared on the next submit() so that nothing is dropped when the queue is full.
+    std::deque<std::function<void(io_uring_sqe*)>> overflow;
+
+    /// Fills in a submission queue entry with the operation, now if one is free and otherwise later
+    void prepare(std::function<void(io_uring_sqe*)> const& operation)
+    {
+        // Once something is waiting, later operations wait behind it so that a cancel cannot
+        // overtake the receive or send that it cancels
+        if (overflow.empty())
+        {
+            auto sqe = io_uring_get_sqe(&ring);
+            if (!sqe)
+            {
+                // The submission queue is full, so we make room. This fails while the kernel is
+                // unable to take more work, e.g. when the completion queue has overflowed.
+                io_uring_submit(&ring);
+                sqe = io_uring_get_sqe(&ring);
+            }
+
+            if (sqe)
+            {
+                operation(sqe);
+                return;
+            }
+        }
+
+        overflow.push_back(operation);
+    }
+
+    void arm_receive(int fd)
+    {
+        prepare([fd](io_uring_sqe* sqe)
+        {
+            io_uring_prep_recv_multishot(sqe, fd, nullptr, 0, 0);
+            sqe->flags |= IOSQE_BUFFER_SELECT;
+            sqe->buf_group = buffer_group;
+            io_uring_sqe_set_data64(sqe, encode(Operation::receive, fd));
+        });
+
+        if (auto it = connections.find(fd); it != connections.end())
+            it->second.is_receiving = true;
+    }
+
+    void recycle(io_uring_cqe const& cqe)
+    {
+        if (!(cqe.flags & IORING_CQE_F_BUFFER))
+            return;
+
+        auto const id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+        io_uring_buf_ring_add(buffer_ring, buffers.data() + id * buffer_size, buffer_size, id, io_uring_buf_ring_mask(buffer_count), 0);
+        io_uring_buf_ring_advance(buffer_ring, 1);
+    }
+
+    void release_if_done(int fd)
+    {
+        auto it = connections.find(fd);
+        if (it != connections.end() && it->second.is_closing && !it->second.is_receiving && !it->second.sending)
+            connections.erase(it);
+    }
+
+    void handle(io_uring_cqe const& cqe)
+    {
+        auto const fd = decode_fd(cqe.user_data);
+        switch (decode_operation(cqe.user_data))
+        {
+        case Operation::receive:
+        {
+            if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER))
+            {
+                auto it = connections.find(fd);
+                if (it != connections.end() && !it->second.is_closing)
+                {
+                    auto const id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+                    handlers.on_received(fd, buffers.data() + id * buffer_size, cqe.res);
+                }
+            }
+            recycle(cqe);
+
+            if (cqe.flags & IORING_CQE_F_MORE)
+                break;
+
+            // The receive has finished, either because the client hung up or because the kernel
+            // stopped it, e.g. when it ran out of buffers.
+            auto it = connections.find(fd);
+            if (it == connections.end())
+                break;
+
+            it->second.is_receiving = false;
+            if (it->second.is_closing)
+                release_if_done(fd);
+            else if (cqe.res > 0 || cqe.res == -ENOBUFS)
+                arm_receive(fd);
+            else
+                handlers.on_closed(fd, cqe.res < 0 ? -cqe.res : 0);
+            break;
+        }
+        case Operation::send:
+        {
+            auto it = connections.find(fd);
+            if (it == connections.end())
+                break;
+
+            it->second.sending.reset();
+            if (it->second.is_closing)
+                release_if_done(fd);
+            else if (cqe.res < 0)
+                handlers.on_closed(fd, -cqe.res);
+            else
+                handlers.on_sent(fd, cqe.res);
+            break;
+        }
+        case Operation::cancel:
+            break;
+        }
+    }
+
+    /// Multishot receives need Linux 6.0, so we check that one works before relying on it
+    bool probe_multishot_receive()
+    {
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) < 0)
+            return false;
+
+        mir::Fd reader { sockets[0] };
+        mir::Fd writer { sockets[1] };
+        arm_receive(reader);
+        io_uring_submit(&ring);
+
+        char const byte = 0;
+        if (::write(writer, &byte, 1) != 1)
+            shutdown(reader, SHUT_RDWR);
+
+        // Once the first receive arrives, we hang up so that nothing refers to the sockets afterwards
+        bool is_supported = false;
+        bool is_first = true;
+        bool has_more = true;
+        while (has_more)
+        {
+            io_uring_cqe* cqe;
+            if (io_uring_wait_cqe(&ring, &cqe) < 0)
+                return false;
+
+            auto const completion = *cqe;
+            io_uring_cqe_seen(&ring, cqe);
+            recycle(completion);
+
+            if (is_first)
+                is_supported = completion.res == 1 && (completion.flags & IORING_CQE_F_MORE);
+            is_first = false;
+            has_more = completion.flags & IORING_CQE_F_MORE;
+            if (has_more)
+                shutdown(reader, SHUT_RDWR);
+        }
+
+        return is_supported;
+    }
+};
+}
+#endif
+
+std::unique_ptr<IpcRing> IpcRing::create(Handlers const& handlers)
+{
+#ifdef MIRACLE_WM_HAVE_IO_URING
+    auto ring = std::make_unique<UringIpcRing>(handlers);
+    if (ring->initialize())
+        return ring;
+#else
+    (void)handlers;
+#endif
+    return nullptr;
+}
@@ -0,0 +1,79 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_IPC_RING_H
+#define MIRACLEWM_IPC_RING_H
+
+#include <functional>
+#include <memory>
+#include <mir/fd.h>
+#include <string>
+
+namespace miracle
+{
+
+/// Performs socket I/O for IPC clients through io_uring. Every client keeps a multishot
+/// receive armed, so incoming data arrives without a wakeup and read per client, and the
+/// sends queued while handling an event go to the kernel in a single submission.
+///
+/// Completions are signalled on an eventfd, which the owner polls on its main loop and
+/// then calls process().
+class IpcRing
+{
+public:
+    struct Handlers
+    {
+        /// Data arrived from the client
+        std::function<void(int fd, char const* data, size_t size)> on_received;
+
+        /// Part or all of the last send to the client was written
+        std::function<void(int fd, size_t written)> on_sent;
+
+        /// The client hung up (error is 0) or its socket failed
+        std::function<void(int fd, int error)> on_closed;
+    };
+
+    /// @returns nullptr if io_uring is unavailable, either because we were built without
+    /// liburing or because the kernel does not support what we need
+    static std::unique_ptr<IpcRing> create(Handlers const& handlers);
+
+    virtual ~IpcRing() = default;
+
+    /// The eventfd that becomes readable when completions are waiting
+    [[nodiscard]] virtual mir::Fd get_fd() const = 0;
+
+    /// Starts receiving from the client
+    virtual void add(mir::Fd const& fd) = 0;
+
+    /// Stops receiving from the client. The ring keeps the socket open until the kernel has
+    /// released it, so that the fd cannot be reused while completions are outstanding.
+    virtual void remove(int fd) = 0;
+
+    /// Queues a send of the message from the offset onwards. Only one send may be outstanding
+    /// per client. The message is kept alive until the send completes.
+    virtual void send(int fd, std::shared_ptr<std::string const> const& message, size_t offset) = 0;
+
+    /// Submits everything that has been queued since the last submission
+    virtual void submit() = 0;
+
+    /// Handles every waiting completion and then submits whatever the handlers queued
+    virtual void process() = 0;
+};
+
+}
+
+#endif // MIRACLEWM_IPC_RING_H
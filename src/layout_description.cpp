@@ -0,0 +1,270 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "layout_description"
+
+#include "layout_description.h"
+#include "jpcre2.h"
+#include <mir/log.h>
+#include <nlohmann/json.hpp>
+#include <sstream>
+
+using json = nlohmann::json;
+using namespace miracle;
+
+namespace
+{
+typedef jpcre2::select<char> jp;
+
+bool matches_regex(std::optional<jp::Regex>& regex, std::string const& value)
+{
+    if (!regex)
+        return true;
+
+    return regex->match(value);
+}
+
+/// i3-save-tree comments out the criteria that the user is expected to choose between
+std::string strip_comments(std::string const& text)
+{
+    std::istringstream stream(text);
+    std::string result;
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        auto first = line.find_first_not_of(" \t");
+        if (first != std::string::npos && line.compare(first, 2, "//") == 0)
+            continue;
+
+        result += line;
+        result += '\n';
+    }
+    return result;
+}
+
+/// Splits the text into its top level JSON values, as several containers may follow one another
+std::optional<std::vector<std::string>> split_top_level(std::string const& text)
+{
+    std::vector<std::string> values;
+    int depth = 0;
+    bool in_string = false;
+    bool escaped = false;
+    size_t start = 0;
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        char const c = text[i];
+        if (in_string)
+        {
+            if (escaped)
+                escaped = false;
+            else if (c == '\\')
+                escaped = true;
+            else if (c == '"')
+                in_string = false;
+            continue;
+        }
+
+        switch (c)
+        {
+        case '"':
+            in_string = true;
+            break;
+        case '{':
+        case '[':
+            if (depth++ == 0)
+                start = i;
+            break;
+        case '}':
+        case ']':
+            if (--depth == 0)
+                values.push_back(text.substr(start, i - start + 1));
+            else if (depth < 0)
+                return std::nullopt;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (depth != 0 || in_string)
+        return std::nullopt;
+
+    return values;
+}
+
+std::vector<LayoutDescription> parse_nodes(json const& nodes);
+
+std::optional<LayoutDescription> parse_node(json const& node)
+{
+    if (!node.is_object())
+    {
+        mir::log_warning("Skipping layout node that is not an object");
+        return std::nullopt;
+    }
+
+    if (node.value("type", "con") == "floating_con")
+    {
+        mir::log_warning("Skipping floating container: only tiled placeholders are supported");
+        return std::nullopt;
+    }
+
+    LayoutDescription description;
+    auto const layout = node.value("layout", "splith");
+    if (layout == "stacked" || layout == "tabbed")
+        mir::log_warning("Layout '%s' is not supported, a split will be used instead", layout.c_str());
+    description.direction = layout == "splitv" || layout == "stacked"
+        ? NodeLayoutDirection::vertical
+        : NodeLayoutDirection::horizontal;
+
+    // A weight of zero marks the node as unsized until its siblings are known
+    description.weight = node.contains("percent") && node["percent"].is_number()
+        ? std::max(node["percent"].get<double>(), 0.0)
+        : 0.0;
+
+    if (node.contains("nodes"))
+        description.nodes = parse_nodes(node["nodes"]);
+
+    if (description.is_placeholder() && node.contains("swallows") && node["swallows"].is_array())
+    {
+        for (auto const& item : node["swallows"])
+        {
+            if (!item.is_object())
+                continue;
+
+            std::optional<std::string> app_id;
+            std::optional<std::string> title;
+            for (auto const& [key, value] : item.items())
+            {
+                if (!value.is_string())
+                    continue;
+
+                // On Wayland the app_id takes the place of the X11 class
+                if (key == "app_id" || key == "class")
+                    app_id = value.get<std::string>();
+                else if (key == "title")
+                    title = value.get<std::string>();
+                else
+                    mir::log_warning("Swallow criteria '%s' is not supported", key.c_str());
+            }
+
+            if (app_id || title)
+                description.swallows.emplace_back(app_id, title);
+        }
+    }
+
+    if (description.is_placeholder() && description.swallows.empty())
+    {
+        mir::log_warning("Skipping layout node that has neither children nor swallow criteria");
+        return std::nullopt;
+    }
+
+    return description;
+}
+
+std::vector<LayoutDescription> parse_nodes(json const& nodes)
+{
+    std::vector<LayoutDescription> result;
+    if (!nodes.is_array())
+        return result;
+
+    for (auto const& node : nodes)
+    {
+        if (auto description = parse_node(node))
+            result.push_back(std::move(description.value()));
+    }
+
+    // As in i3, nodes without a percentage share whatever their siblings have left
+    double assigned = 0;
+    size_t unassigned = 0;
+    for (auto const& description : result)
+    {
+        if (description.weight > 0)
+            assigned += description.weight;
+        else
+            unassigned++;
+    }
+
+    if (unassigned > 0)
+    {
+        double share = assigned < 1.0
+            ? (1.0 - assigned) / static_cast<double>(unassigned)
+            : assigned / static_cast<double>(result.size() - unassigned);
+        for (auto& description : result)
+        {
+            if (description.weight <= 0)
+                description.weight = share;
+        }
+    }
+
+    return result;
+}
+}
+
+struct LayoutSwallowCriteria::CompiledRegexes
+{
+    std::optional<jp::Regex> app_id;
+    std::optional<jp::Regex> title;
+};
+
+LayoutSwallowCriteria::LayoutSwallowCriteria(std::optional<std::string> in_app_id, std::optional<std::string> in_title) :
+    app_id { std::move(in_app_id) },
+    title { std::move(in_title) },
+    regexes { std::make_shared<CompiledRegexes>() }
+{
+    if (app_id)
+        regexes->app_id.emplace(app_id.value());
+    if (title)
+        regexes->title.emplace(title.value());
+}
+
+bool LayoutSwallowCriteria::matches(std::string const& in_app_id, std::string const& in_title) const
+{
+    return matches_regex(regexes->app_id, in_app_id) && matches_regex(regexes->title, in_title);
+}
+
+std::vector<LayoutDescription> LayoutDescription::parse(std::string const& text)
+{
+    auto values = split_top_level(strip_comments(text));
+    if (!values)
+    {
+        mir::log_error("Unable to parse layout: unbalanced brackets");
+        return {};
+    }
+
+    try
+    {
+        json nodes = json::array();
+        for (auto const& value : values.value())
+        {
+            auto parsed = json::parse(value);
+            if (parsed.is_array())
+            {
+                for (auto const& item : parsed)
+                    nodes.push_back(item);
+            }
+            else
+                nodes.push_back(parsed);
+        }
+
+        return parse_nodes(nodes);
+    }
+    catch (json::exception const& e)
+    {
+        mir::log_error("Unable to parse layout: %s", e.what());
+        return {};
+    }
+}
@@ -0,0 +1,71 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_LAYOUT_DESCRIPTION_H
+#define MIRACLEWM_LAYOUT_DESCRIPTION_H
+
+#include "node_common.h"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace miracle
+{
+
+/// Describes the windows that a placeholder may swallow. Each value is a regex
+/// that must match for the criteria to be met. The regexes are compiled once, when
+/// the criteria are created, as they are checked against every new window.
+struct LayoutSwallowCriteria
+{
+    LayoutSwallowCriteria(std::optional<std::string> app_id, std::optional<std::string> title);
+
+    std::optional<std::string> app_id;
+    std::optional<std::string> title;
+
+    [[nodiscard]] bool matches(std::string const& app_id, std::string const& title) const;
+
+private:
+    struct CompiledRegexes;
+    std::shared_ptr<CompiledRegexes> regexes;
+};
+
+/// A declarative description of a container and its children, as read by append_layout.
+/// Leaves are placeholders that swallow matching windows when they open.
+struct LayoutDescription
+{
+    NodeLayoutDirection direction = NodeLayoutDirection::horizontal;
+
+    /// The share of the parent that this node takes, relative to its siblings
+    double weight = 1.0;
+
+    /// A placeholder swallows a window that meets any one of these
+    std::vector<LayoutSwallowCriteria> swallows;
+    std::vector<LayoutDescription> nodes;
+
+    [[nodiscard]] bool is_placeholder() const { return nodes.empty(); }
+
+    /// Parses a layout in the format of i3's append_layout. The text may hold a single container,
+    /// an array of containers or several containers one after another, as written by i3-save-tree.
+    /// Placeholders that could never swallow a window are dropped.
+    /// @returns The top level containers, or nothing if the text is malformed
+    static std::vector<LayoutDescription> parse(std::string const&);
+};
+
+}
+
+#endif // MIRACLEWM_LAYOUT_DESCRIPTION_H
@@ -0,0 +1,155 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "layout_solver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace miracle
+{
+
+namespace
+{
+/// Shares the space in proportion to the weights. Remainders from rounding go to the first items.
+std::vector<int> share_proportionally(int available, std::vector<double> const& weights)
+{
+    std::vector<int> result(weights.size(), 0);
+    if (weights.empty())
+        return result;
+
+    double total_weight = std::accumulate(weights.begin(), weights.end(), 0.0);
+    int used = 0;
+    for (size_t i = 0; i < weights.size(); i++)
+    {
+        result[i] = total_weight > 0
+            ? static_cast<int>(std::floor(available * weights[i] / total_weight))
+            : available / static_cast<int>(weights.size());
+        used += result[i];
+    }
+
+    for (size_t i = 0; used < available; i = (i + 1) % result.size(), used++)
+        result[i]++;
+
+    return result;
+}
+}
+
+std::vector<int> solve_layout(int available, std::vector<LayoutConstraint> const& constraints)
+{
+    auto const count = constraints.size();
+    if (count == 0)
+        return {};
+
+    long long total_min = 0;
+    long long total_max = 0;
+    for (auto const& constraint : constraints)
+    {
+        total_min += std::max(constraint.min, 0);
+        total_max += std::max(constraint.max, constraint.min);
+    }
+
+    if (total_min >= available)
+    {
+        std::vector<double> weights;
+        for (auto const& constraint : constraints)
+            weights.push_back(std::max(constraint.min, 1));
+        return share_proportionally(available, weights);
+    }
+
+    if (total_max <= available)
+    {
+        std::vector<int> result;
+        for (auto const& constraint : constraints)
+            result.push_back(std::max(constraint.max, constraint.min));
+
+        auto surplus = share_proportionally(available - static_cast<int>(total_max), std::vector<double>(count, 1.0));
+        for (size_t i = 0; i < count; i++)
+            result[i] += surplus[i];
+        return result;
+    }
+
+    // The constraints are satisfiable, so pin violators to their bounds until the
+    // proportional share of the remaining items fits within their ranges.
+    std::vector<double> sizes(count, 0);
+    std::vector<bool> is_frozen(count, false);
+    double remaining = available;
+    size_t num_frozen = 0;
+    while (num_frozen < count)
+    {
+        double total_weight = 0;
+        for (size_t i = 0; i < count; i++)
+            if (!is_frozen[i])
+                total_weight += std::max(constraints[i].preferred, 1);
+
+        double violation = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (is_frozen[i])
+                continue;
+
+            auto share = remaining * std::max(constraints[i].preferred, 1) / total_weight;
+            auto clamped = std::clamp<double>(share, constraints[i].min, std::max(constraints[i].max, constraints[i].min));
+            sizes[i] = clamped;
+            violation += clamped - share;
+        }
+
+        // A positive violation means that minimums took more space than was shared, so those
+        // items are settled. A negative violation means that the maximums gave space back.
+        bool froze_any = false;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (is_frozen[i])
+                continue;
+
+            bool at_min = sizes[i] <= constraints[i].min;
+            bool at_max = sizes[i] >= std::max(constraints[i].max, constraints[i].min);
+            if (violation == 0 || (violation > 0 && at_min) || (violation < 0 && at_max))
+            {
+                is_frozen[i] = true;
+                remaining -= sizes[i];
+                num_frozen++;
+                froze_any = true;
+            }
+        }
+
+        if (!froze_any)
+            break;
+    }
+
+    // Round down and hand out the pixels lost to rounding to the items with room to grow
+    std::vector<int> result(count);
+    int used = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        result[i] = static_cast<int>(std::floor(sizes[i]));
+        used += result[i];
+    }
+
+    for (size_t i = 0; i < count && used < available; i++)
+    {
+        auto room = std::max(constraints[i].max, constraints[i].min) - result[i];
+        auto extra = std::min(room, available - used);
+        result[i] += extra;
+        used += extra;
+    }
+
+    return result;
+}
+
+}
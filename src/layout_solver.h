@@ -0,0 +1,50 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_LAYOUT_SOLVER_H
+#define MIRACLEWM_LAYOUT_SOLVER_H
+
+#include <vector>
+
+namespace miracle
+{
+
+/// The size constraints of a single item along one axis of a lane.
+struct LayoutConstraint
+{
+    /// The size that the item would like to have, relative to the other items.
+    int preferred;
+    int min;
+    int max;
+};
+
+/// Distributes the available space along one axis between the items in a single pass.
+///
+/// Space is shared in proportion to each item's preferred size. Items that would fall
+/// outside of their [min, max] range are pinned to that bound and the remainder is
+/// shared among the rest. The result always sums to the available space.
+///
+/// Overflow policy:
+///  - If the minimums do not fit, every item is shrunk in proportion to its minimum.
+///  - If the maximums do not fill the space, the surplus is shared evenly beyond the maximums.
+/// In both cases the node is expected to configure its window within [min, max] and clip it
+/// to the tile, so the client is never asked for a size it would reject.
+std::vector<int> solve_layout(int available, std::vector<LayoutConstraint> const& constraints);
+
+}
+
+#endif // MIRACLEWM_LAYOUT_SOLVER_H
@@ -19,7 +19,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "mir_toolkit/common.h"
 #include "miracle_config.h"
 #include "parent_node.h"
+#include "window_metadata.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 using namespace miracle;
 
@@ -40,6 +43,20 @@ LeafNode::LeafNode(
 void LeafNode::associate_to_window(miral::Window const& in_window)
 {
     window = in_window;
+    swallows.clear();
+}
+
+void LeafNode::set_swallow_criteria(std::vector<LayoutSwallowCriteria> const& criteria)
+{
+    swallows = criteria;
+}
+
+bool LeafNode::can_swallow(std::string const& app_id, std::string const& title) const
+{
+    return std::any_of(swallows.begin(), swallows.end(), [&](LayoutSwallowCriteria const& criteria)
+    {
+        return criteria.matches(app_id, title);
+    });
 }
 
 geom::Rectangle LeafNode::get_logical_area() const
@@ -86,6 +103,11 @@ geom::Rectangle LeafNode::get_visible_area() const
         height -= half_gap_y;
     }
 
+    // The title bar is drawn by the renderer in the space above the window
+    int const title_bar_height = std::min(config->get_title_bar_height(), std::max(height, 0));
+    y += title_bar_height;
+    height -= title_bar_height;
+
     return {
         geom::Point { x,     y      },
         geom::Size { width, height }
@@ -94,30 +116,94 @@ geom::Rectangle LeafNode::get_visible_area() const
 
 void LeafNode::constrain()
 {
+    // Placeholders have nothing to clip
+    if (!window)
+        return;
+
     if (node_interface.is_fullscreen(window))
         node_interface.noclip(window);
     else
         node_interface.clip(window, get_visible_area());
 }
 
+namespace
+{
+/// Tiles never shrink below this, even if the client would allow it
+size_t const minimum_tile_size = 50;
+
+size_t add_gaps(int client_size, int gaps)
+{
+    if (client_size >= std::numeric_limits<int>::max() - gaps)
+        return std::numeric_limits<int>::max();
+    return static_cast<size_t>(std::max(client_size, 0) + gaps);
+}
+}
+
 size_t LeafNode::get_min_width() const
 {
-    return 50;
+    if (!window)
+        return minimum_tile_size;
+
+    auto gaps = logical_area.size.width.as_int() - get_visible_area().size.width.as_int();
+    return std::max(minimum_tile_size, add_gaps(node_interface.get_min_size(window).width.as_int(), gaps));
 }
 
 size_t LeafNode::get_min_height() const
 {
-    return 50;
+    if (!window)
+        return minimum_tile_size;
+
+    auto gaps = logical_area.size.height.as_int() - get_visible_area().size.height.as_int();
+    return std::max(minimum_tile_size, add_gaps(node_interface.get_min_size(window).height.as_int(), gaps));
+}
+
+size_t LeafNode::get_max_width() const
+{
+    if (!window)
+        return std::numeric_limits<int>::max();
+
+    auto gaps = logical_area.size.width.as_int() - get_visible_area().size.width.as_int();
+    return std::max(get_min_width(), add_gaps(node_interface.get_max_size(window).width.as_int(), gaps));
+}
+
+size_t LeafNode::get_max_height() const
+{
+    if (!window)
+        return std::numeric_limits<int>::max();
+
+    auto gaps = logical_area.size.height.as_int() - get_visible_area().size.height.as_int();
+    return std::max(get_min_height(), add_gaps(node_interface.get_max_size(window).height.as_int(), gaps));
+}
+
+geom::Rectangle LeafNode::get_configured_area() const
+{
+    auto area = get_visible_area();
+    if (!window)
+        return area;
+
+    auto min_size = node_interface.get_min_size(window);
+    auto max_size = node_interface.get_max_size(window);
+    area.size = geom::Size {
+        std::clamp(area.size.width.as_int(), min_size.width.as_int(), std::max(min_size.width.as_int(), max_size.width.as_int())),
+        std::clamp(area.size.height.as_int(), min_size.height.as_int(), std::max(min_size.height.as_int(), max_size.height.as_int()))
+    };
+    return area;
 }
 
 void LeafNode::show()
 {
+    if (!window)
+        return;
+
     next_state = before_shown_state;
     before_shown_state.reset();
 }
 
 void LeafNode::hide()
 {
+    if (!window)
+        return;
+
     before_shown_state = node_interface.get_state(window);
     next_state = mir_window_state_hidden;
 }
@@ -132,7 +218,7 @@ void LeafNode::toggle_fullscreen()
 
 bool LeafNode::is_fullscreen() const
 {
-    return node_interface.get_state(window) == mir_window_state_maximized;
+    return window && node_interface.get_state(window) == mir_window_state_maximized;
 }
 
 void LeafNode::commit_changes()
@@ -146,12 +232,12 @@ void LeafNode::commit_changes()
 
     if (next_logical_area)
     {
-        auto previous = get_visible_area();
+        auto previous = get_configured_area();
         logical_area = next_logical_area.value();
         next_logical_area.reset();
-        if (!node_interface.is_fullscreen(window))
+        if (metadata && !node_interface.is_fullscreen(window))
         {
-            node_interface.set_rectangle(window, previous, get_visible_area());
+            node_interface.set_rectangle(metadata->shared_from_this(), previous, get_configured_area());
             constrain();
         }
     }
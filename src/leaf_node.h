@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_LEAF_NODE_H
 #define MIRACLEWM_LEAF_NODE_H
 
+#include "layout_description.h"
 #include "node.h"
 #include "node_common.h"
 #include "tiling_interface.h"
@@ -32,6 +33,7 @@ namespace miracle
 
 class MiracleConfig;
 class TilingWindowTree;
+class WindowMetadata;
 
 class LeafNodeInterface
 {
@@ -49,6 +51,17 @@ public:
         std::shared_ptr<ParentNode> const& parent);
 
     void associate_to_window(miral::Window const&);
+
+    /// Set by the WindowMetadata when the two are associated. The metadata owns the node,
+    /// so this pointer is cleared before the metadata is destroyed.
+    void associate_to_metadata(WindowMetadata* in) { metadata = in; }
+    [[nodiscard]] WindowMetadata* get_metadata() const { return metadata; }
+
+    /// Turns this node into a placeholder that holds its tile until a window meeting
+    /// any of the criteria opens. The criteria are dropped once a window is associated.
+    void set_swallow_criteria(std::vector<LayoutSwallowCriteria> const&);
+    [[nodiscard]] bool is_placeholder() const { return !swallows.empty(); }
+    [[nodiscard]] bool can_swallow(std::string const& app_id, std::string const& title) const;
     [[nodiscard]] geom::Rectangle get_logical_area() const override;
     [[nodiscard]] geom::Rectangle get_visible_area() const;
     void set_logical_area(geom::Rectangle const& target_rect) override;
@@ -60,6 +73,13 @@ public:
     void constrain() override;
     size_t get_min_width() const override;
     size_t get_min_height() const override;
+    size_t get_max_width() const override;
+    size_t get_max_height() const override;
+
+    /// The area that the window is configured to. This is the visible area, but
+    /// sized within the client's min/max constraints. The window is clipped to
+    /// the visible area if the two differ.
+    [[nodiscard]] geom::Rectangle get_configured_area() const;
     [[nodiscard]] TilingWindowTree* get_tree() const { return tree; }
     [[nodiscard]] miral::Window& get_window() { return window; }
     void commit_changes() override;
@@ -71,6 +91,8 @@ private:
     std::shared_ptr<MiracleConfig> config;
     TilingWindowTree* tree;
     miral::Window window;
+    WindowMetadata* metadata = nullptr;
+    std::vector<LayoutSwallowCriteria> swallows;
     std::optional<MirWindowState> before_shown_state;
     std::optional<MirWindowState> next_state;
     NodeLayoutDirection tentative_direction = NodeLayoutDirection::none;
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "miracle_config.h"
 #include "miracle_gl_config.h"
 #include "policy.h"
+#include "render_cost_tracker.h"
 #include "renderer.h"
 #include "surface_tracker.h"
 
@@ -68,6 +69,7 @@ int main(int argc, char const* argv[])
     ExternalClientLauncher external_client_launcher;
     miracle::AutoRestartingLauncher auto_restarting_launcher(runner, external_client_launcher);
     miracle::SurfaceTracker surface_tracker;
+    miracle::RenderCostTracker render_costs;
     auto config = std::make_shared<miracle::MiracleConfig>(runner);
     for (auto const& env : config->get_env_variables())
     {
@@ -80,7 +82,7 @@ int main(int argc, char const* argv[])
     {
         options = new WindowManagerOptions {
             add_window_manager_policy<miracle::Policy>(
-                "tiling", external_client_launcher, runner, config, surface_tracker, server)
+                "tiling", external_client_launcher, runner, config, surface_tracker, render_costs, server)
         };
         (*options)(server);
     });
@@ -119,7 +121,7 @@ int main(int argc, char const* argv[])
     }),
             CustomRenderer([&](std::unique_ptr<mir::graphics::gl::OutputSurface> x, std::shared_ptr<mir::graphics::GLRenderingProvider> y)
     {
-        return std::make_unique<miracle::Renderer>(std::move(y), std::move(x), config, surface_tracker);
+        return std::make_unique<miracle::Renderer>(std::move(y), std::move(x), config, surface_tracker, render_costs);
     }),
             miroil::OpenGLContext(new miracle::GLConfig()) });
 }
@@ -21,7 +21,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "miracle_config.h"
 #include "yaml-cpp/node/node.h"
 #include "yaml-cpp/yaml.h"
+#include <algorithm>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <glib-2.0/glib.h>
 #include <libevdev-1.0/libevdev/libevdev.h>
@@ -131,6 +133,99 @@ T try_parse_enum(YAML::Node const& root, const char* key, std::function<T(std::s
     }
     return result;
 }
+
+bool is_drop_in_file(std::string const& name)
+{
+    // Skip hidden files so that editor swap files and partially written files are ignored
+    if (name.empty() || name[0] == '.')
+        return false;
+
+    auto const extension = std::filesystem::path(name).extension();
+    return extension == ".yaml" || extension == ".yml";
+}
+
+std::optional<YAML::Node> load_file(std::string const& path)
+{
+    try
+    {
+        auto node = YAML::LoadFile(path);
+        if (node.IsMap())
+            return node;
+
+        if (node.IsDefined() && !node.IsNull())
+            mir::log_error("%s: expected a map at the top level", path.c_str());
+        return YAML::Node(YAML::NodeType::Map);
+    }
+    catch (YAML::Exception const& e)
+    {
+        mir::log_error("Unable to parse %s: %s", path.c_str(), e.msg.c_str());
+        return std::nullopt;
+    }
+}
+
+void merge_into(YAML::Node& merged, YAML::Node const& file)
+{
+    for (auto const& entry : file)
+    {
+        auto const key = entry.first.as<std::string>();
+        auto existing = merged[key];
+        if (existing && existing.IsSequence() && entry.second.IsSequence())
+        {
+            for (auto const& item : entry.second)
+                existing.push_back(YAML::Clone(item));
+        }
+        else
+            merged[key] = YAML::Clone(entry.second);
+    }
+}
+
+uint32_t section_for_key(std::string const& key)
+{
+    if (key == "action_key" || key == "default_action_overrides" || key == "custom_actions")
+        return config_section_key_commands;
+    else if (key == "inner_gaps" || key == "outer_gaps")
+        return config_section_gaps;
+    else if (key == "startup_apps")
+        return config_section_startup_apps;
+    else if (key == "terminal" || key == "terminal_pool")
+        return config_section_terminal;
+    else if (key == "resize_jump")
+        return config_section_resize;
+    else if (key == "environment_variables")
+        return config_section_environment;
+    else if (key == "border")
+        return config_section_border;
+    else if (key == "animations" || key == "enable_animations")
+        return config_section_animations;
+    else if (key == "power")
+        return config_section_power;
+    else if (key == "title_bar")
+        return config_section_title_bar;
+    else if (key == "blur")
+        return config_section_blur;
+    else if (key == "dim" || key == "opacity")
+        return config_section_opacity;
+    return config_section_none;
+}
+
+/// Determines which sections differ between two versions of the same file
+uint32_t diff_sections(YAML::Node const& previous, YAML::Node const& next)
+{
+    uint32_t sections = config_section_none;
+    auto const compare = [&](YAML::Node const& from, YAML::Node const& to)
+    {
+        for (auto const& entry : from)
+        {
+            auto const key = entry.first.as<std::string>();
+            auto const other = to[key];
+            if (!other || YAML::Dump(entry.second) != YAML::Dump(other))
+                sections |= section_for_key(key);
+        }
+    };
+    compare(previous, next);
+    compare(next, previous);
+    return sections;
+}
 }
 
 MiracleConfig::MiracleConfig(miral::MirRunner& runner) :
@@ -140,12 +235,14 @@ MiracleConfig::MiracleConfig(miral::MirRunner& runner) :
     config_path_stream << g_get_user_config_dir();
     config_path_stream << "/miracle-wm.yaml";
     config_path = config_path_stream.str();
+    drop_in_path = std::filesystem::path(config_path).replace_extension(".d").string();
 
     mir::log_info("Configuration file path is: %s", config_path.c_str());
 
     {
         std::fstream file(config_path, std::ios::out | std::ios::in | std::ios::app);
     }
+    create_drop_in_directory();
 
     _load();
     _watch(runner);
@@ -153,37 +250,135 @@ MiracleConfig::MiracleConfig(miral::MirRunner& runner) :
 
 MiracleConfig::MiracleConfig(miral::MirRunner& runner, std::string const& path) :
     runner { runner },
-    config_path { path }
+    config_path { path },
+    drop_in_path { std::filesystem::path(path).replace_extension(".d").string() }
 {
     {
         std::fstream file(config_path, std::ios::out | std::ios::in | std::ios::app);
     }
+    create_drop_in_directory();
 
     mir::log_info("Configuration file path is: %s", config_path.c_str());
     _load();
     _watch(runner);
 }
 
+void MiracleConfig::create_drop_in_directory()
+{
+    std::error_code ec;
+    std::filesystem::create_directories(drop_in_path, ec);
+    if (ec)
+        mir::log_warning("Unable to create the configuration directory %s: %s", drop_in_path.c_str(), ec.message().c_str());
+    else
+        mir::log_info("Configuration directory is: %s", drop_in_path.c_str());
+}
+
 void MiracleConfig::_load()
 {
     std::lock_guard<std::mutex> lock(mutex);
 
-    // Reset all
+    mir::log_info("Configuration is loading...");
+    main_file = load_file(config_path).value_or(YAML::Node(YAML::NodeType::Map));
+
+    drop_in_files.clear();
+    std::error_code ec;
+    for (auto const& entry : std::filesystem::directory_iterator(drop_in_path, ec))
+    {
+        auto const name = entry.path().filename().string();
+        if (!is_drop_in_file(name))
+            continue;
+
+        drop_in_files[name] = load_file(entry.path().string()).value_or(YAML::Node(YAML::NodeType::Map));
+    }
+
+    _apply(config_section_all);
+}
+
+void MiracleConfig::reload_file(std::string const& name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Only the file that changed is parsed again. The others are merged from the cache.
+    bool const is_main_file = name.empty();
+    auto const path = is_main_file ? config_path : drop_in_path + "/" + name;
+    // Assigning a YAML::Node shares it rather than copying it, so the cached file is cloned
+    // before the cache is overwritten below
+    YAML::Node previous(YAML::NodeType::Map);
+    if (is_main_file)
+        previous = YAML::Clone(main_file);
+    else if (auto it = drop_in_files.find(name); it != drop_in_files.end())
+        previous = YAML::Clone(it->second);
+
+    YAML::Node next(YAML::NodeType::Map);
+    if (std::filesystem::exists(path))
+    {
+        auto loaded = load_file(path);
+        if (!loaded)
+        {
+            mir::log_warning("Keeping the previous contents of %s", path.c_str());
+            return;
+        }
+        next = loaded.value();
+    }
+
+    if (is_main_file)
+        main_file = next;
+    else if (std::filesystem::exists(path))
+        drop_in_files[name] = next;
+    else
+        drop_in_files.erase(name);
+
+    auto const sections = diff_sections(previous, next);
+    if (sections == config_section_none)
+        return;
+
+    mir::log_info("Configuration file %s changed", path.c_str());
+    _apply(sections);
+    pending_sections |= sections;
+}
+
+void MiracleConfig::_apply(uint32_t sections)
+{
+    // Drop-in files are applied in lexical order after the main file. Later files replace
+    // the values of earlier ones, except for lists, which are appended.
+    YAML::Node config(YAML::NodeType::Map);
+    merge_into(config, main_file);
+    for (auto const& [name, file] : drop_in_files)
+        merge_into(config, file);
+
+    if (sections & config_section_key_commands)
+        read_key_commands(config);
+    if (sections & config_section_gaps)
+        read_gaps(config);
+    if (sections & config_section_startup_apps)
+        read_startup_apps(config);
+    if (sections & config_section_terminal)
+        read_terminal(config);
+    if (sections & config_section_resize)
+        read_resize_jump(config);
+    if (sections & config_section_environment)
+        read_environment_variables(config);
+    if (sections & config_section_border)
+        read_border(config);
+    if (sections & config_section_animations)
+        read_animation_definitions(config);
+    if (sections & config_section_power)
+        read_power(config);
+    if (sections & config_section_title_bar)
+        read_title_bar(config);
+    if (sections & config_section_blur)
+        read_blur(config);
+    if (sections & config_section_opacity)
+        read_opacity(config);
+}
+
+void MiracleConfig::read_key_commands(YAML::Node const& config)
+{
     primary_modifier = mir_input_event_modifier_meta;
-    custom_key_commands = {};
-    inner_gaps_x = 10;
-    inner_gaps_y = 10;
-    outer_gaps_x = 10;
-    outer_gaps_y = 10;
-    startup_apps = {};
-    terminal = wrap_command("miracle-wm-sensible-terminal");
-    desired_terminal = "";
-    resize_jump = 50;
-    border_config = { 0, glm::vec4(0), glm::vec4(0) };
+    custom_key_commands.clear();
+    for (auto& list : key_commands)
+        list.clear();
 
-    // Load the new configuration
-    mir::log_info("Configuration is loading...");
-    YAML::Node config = YAML::LoadFile(config_path);
     if (config["action_key"])
     {
         auto const stringified_action_key = config["action_key"].as<std::string>();
@@ -194,15 +389,11 @@ void MiracleConfig::_load()
             primary_modifier = parse_modifier(stringified_action_key);
     }
 
-    if (config["default_action_overrides"])
+    auto const default_action_overrides = config["default_action_overrides"];
+    if (default_action_overrides && !default_action_overrides.IsSequence())
+        mir::log_error("default_action_overrides: value must be an array");
+    else if (default_action_overrides)
     {
-        auto const default_action_overrides = config["default_action_overrides"];
-        if (!default_action_overrides.IsSequence())
-        {
-            mir::log_error("default_action_overrides: value must be an array");
-            return;
-        }
-
         for (auto i = 0; i < default_action_overrides.size(); i++)
         {
             auto sub_node = default_action_overrides[i];
@@ -322,6 +513,10 @@ void MiracleConfig::_load()
                 key_command = DefaultKeyCommand::ToggleFloating;
             else if (name == "toggle_pinned_to_workspace")
                 key_command = DefaultKeyCommand::TogglePinnedToWorkspace;
+            else if (name == "move_to_scratchpad")
+                key_command = DefaultKeyCommand::MoveToScratchpad;
+            else if (name == "toggle_scratchpad")
+                key_command = DefaultKeyCommand::ToggleScratchpad;
             else
             {
                 mir::log_error("default_action_overrides: Unknown key command override: %s", name.c_str());
@@ -494,7 +689,13 @@ void MiracleConfig::_load()
          KEY_SPACE },
         { MirKeyboardAction ::mir_keyboard_action_down,
          miracle_input_event_modifier_default | mir_input_event_modifier_shift,
-         KEY_P     }
+         KEY_P     },
+        { MirKeyboardAction ::mir_keyboard_action_down,
+         miracle_input_event_modifier_default | mir_input_event_modifier_shift,
+         KEY_MINUS },
+        { MirKeyboardAction ::mir_keyboard_action_down,
+         miracle_input_event_modifier_default,
+         KEY_MINUS }
     };
     for (int i = 0; i < DefaultKeyCommand::MAX; i++)
     {
@@ -614,8 +815,15 @@ void MiracleConfig::_load()
                 command });
         }
     }
+}
+
+void MiracleConfig::read_gaps(YAML::Node const& config)
+{
+    inner_gaps_x = 10;
+    inner_gaps_y = 10;
+    outer_gaps_x = 10;
+    outer_gaps_y = 10;
 
-    // Gap sizes
     if (config["inner_gaps"])
     {
         int new_inner_gaps_x = inner_gaps_x;
@@ -654,8 +862,12 @@ void MiracleConfig::_load()
             mir::log_error("Unable to parse outer_gaps: %s", e.msg.c_str());
         }
     }
+}
+
+void MiracleConfig::read_startup_apps(YAML::Node const& config)
+{
+    startup_apps.clear();
 
-    // Startup Apps
     if (config["startup_apps"])
     {
         if (!config["startup_apps"].IsSequence())
@@ -690,8 +902,13 @@ void MiracleConfig::_load()
             }
         }
     }
+}
+
+void MiracleConfig::read_terminal(YAML::Node const& config)
+{
+    terminal = wrap_command("miracle-wm-sensible-terminal");
+    desired_terminal = "";
 
-    // Terminal
     if (config["terminal"])
     {
         try
@@ -710,7 +927,28 @@ void MiracleConfig::_load()
         terminal.reset();
     }
 
-    // Resizing
+    terminal_pool_size = 0;
+    if (config["terminal_pool"])
+    {
+        try
+        {
+            auto const size = config["terminal_pool"].as<int>();
+            if (size < 0 || size > max_terminal_pool_size)
+                mir::log_error("terminal_pool must be between 0 and %d: %d", max_terminal_pool_size, size);
+            else
+                terminal_pool_size = size;
+        }
+        catch (YAML::BadConversion const& e)
+        {
+            mir::log_error("Unable to parse terminal_pool: %s", e.msg.c_str());
+        }
+    }
+}
+
+void MiracleConfig::read_resize_jump(YAML::Node const& config)
+{
+    resize_jump = 50;
+
     if (config["resize_jump"])
     {
         try
@@ -722,8 +960,12 @@ void MiracleConfig::_load()
             mir::log_error("Unable to parse resize_jump: %s", e.msg.c_str());
         }
     }
+}
+
+void MiracleConfig::read_environment_variables(YAML::Node const& config)
+{
+    environment_variables.clear();
 
-    // Environment variables
     if (config["environment_variables"])
     {
         if (!config["environment_variables"].IsSequence())
@@ -759,6 +1001,11 @@ void MiracleConfig::_load()
             }
         }
     }
+}
+
+void MiracleConfig::read_border(YAML::Node const& config)
+{
+    border_config = { 0, glm::vec4(0), glm::vec4(0) };
 
     if (config["border"])
     {
@@ -774,9 +1021,30 @@ void MiracleConfig::_load()
         {
             mir::log_error("Unable to parse border: %s", e.msg.c_str());
         }
-    }
 
-    read_animation_definitions(config);
+        try
+        {
+            auto border = config["border"];
+            if (border["radius"])
+                border_config.radius = std::max(border["radius"].as<int>(), 0);
+
+            if (auto shadow = border["shadow"])
+            {
+                if (shadow["size"])
+                    border_config.shadow.size = std::max(shadow["size"].as<int>(), 0);
+                if (shadow["offset_x"])
+                    border_config.shadow.offset.x = shadow["offset_x"].as<float>();
+                if (shadow["offset_y"])
+                    border_config.shadow.offset.y = shadow["offset_y"].as<float>();
+                if (shadow["color"])
+                    border_config.shadow.color = parse_color(shadow["color"]);
+            }
+        }
+        catch (YAML::BadConversion const& e)
+        {
+            mir::log_error("Unable to parse border decorations: %s", e.msg.c_str());
+        }
+    }
 }
 
 void MiracleConfig::read_animation_definitions(YAML::Node const& root)
@@ -853,46 +1121,238 @@ void MiracleConfig::read_animation_definitions(YAML::Node const& root)
 
     animation_defintions = parsed;
 
+    animations_enabled = true;
     if (root["enable_animations"])
         try_parse_value(root, "enable_animations", animations_enabled);
 }
 
+void MiracleConfig::read_power(YAML::Node const& root)
+{
+    std::vector<PowerProfile> profiles;
+    std::string default_profile = PowerProfiles::balanced;
+    std::optional<std::string> battery_profile;
+    std::string software_profile = PowerProfiles::software;
+    std::map<std::string, std::string> output_profiles;
+    std::optional<std::string> supply_path;
+
+    if (root["power"])
+    {
+        auto const power = root["power"];
+        try_parse_value(power, "profile", default_profile);
+
+        std::string value;
+        if (try_parse_value(power, "battery_profile", value))
+            battery_profile = value;
+        if (try_parse_value(power, "power_supply", value))
+            supply_path = value;
+        try_parse_value(power, "software_profile", software_profile);
+
+        if (power["profiles"] && !power["profiles"].IsSequence())
+            mir::log_error("power: profiles must be an array");
+        else if (power["profiles"])
+        {
+            for (auto const& node : power["profiles"])
+            {
+                PowerProfile profile;
+                if (!try_parse_value(node, "name", profile.name))
+                {
+                    mir::log_error("power: profile is missing a 'name'");
+                    continue;
+                }
+
+                try_parse_value(node, "animations", profile.animations);
+                try_parse_value(node, "animation_duration_scale", profile.animation_duration_scale);
+                try_parse_value(node, "animation_frame_rate", profile.animation_frame_rate);
+                try_parse_value(node, "simple_animations", profile.simple_animations);
+                try_parse_value(node, "borders", profile.borders);
+                try_parse_value(node, "blur", profile.blur);
+                try_parse_value(node, "client_commit_rate_scale", profile.client_commit_rate_scale);
+                profile.animation_duration_scale = std::max(profile.animation_duration_scale, 0.f);
+                profile.animation_frame_rate = std::clamp(profile.animation_frame_rate, 1, 1000);
+                profile.client_commit_rate_scale = std::max(profile.client_commit_rate_scale, 0.0);
+                profiles.push_back(profile);
+            }
+        }
+
+        if (power["outputs"] && !power["outputs"].IsSequence())
+            mir::log_error("power: outputs must be an array");
+        else if (power["outputs"])
+        {
+            for (auto const& node : power["outputs"])
+            {
+                std::string output_name;
+                std::string profile;
+                if (!try_parse_value(node, "output", output_name) || !try_parse_value(node, "profile", profile))
+                {
+                    mir::log_error("power: each output requires an 'output' and a 'profile'");
+                    continue;
+                }
+
+                output_profiles[output_name] = profile;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(power_mutex);
+    power_profiles.configure(profiles, default_profile, battery_profile, output_profiles, software_profile);
+    power_supply_path = supply_path;
+}
+
+void MiracleConfig::read_title_bar(YAML::Node const& root)
+{
+    TitleBarConfig parsed;
+    if (root["title_bar"])
+    {
+        auto const title_bar = root["title_bar"];
+        try_parse_value(title_bar, "enabled", parsed.enabled);
+        try_parse_value(title_bar, "height", parsed.height);
+        try_parse_value(title_bar, "font", parsed.font);
+        try_parse_value(title_bar, "font_size", parsed.font_size);
+        parsed.height = std::max(parsed.height, 0);
+        parsed.font_size = std::clamp(parsed.font_size, 1, 256);
+
+        try
+        {
+            if (title_bar["color"])
+                parsed.color = parse_color(title_bar["color"]);
+            if (title_bar["focus_color"])
+                parsed.focus_color = parse_color(title_bar["focus_color"]);
+            if (title_bar["text_color"])
+                parsed.text_color = parse_color(title_bar["text_color"]);
+        }
+        catch (YAML::BadConversion const& e)
+        {
+            mir::log_error("Unable to parse title_bar colors: %s", e.msg.c_str());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(title_bar_mutex);
+    title_bar_config = parsed;
+}
+
+void MiracleConfig::read_blur(YAML::Node const& root)
+{
+    BlurConfig parsed;
+    if (root["blur"])
+    {
+        auto const blur = root["blur"];
+        try_parse_value(blur, "passes", parsed.passes);
+        try_parse_value(blur, "offset", parsed.offset);
+        parsed.passes = std::clamp(parsed.passes, 1, max_blur_passes);
+        parsed.offset = std::clamp(parsed.offset, 0.5f, 16.f);
+
+        if (blur["app_ids"] && !blur["app_ids"].IsSequence())
+            mir::log_error("blur: app_ids must be an array");
+        else if (blur["app_ids"])
+        {
+            for (auto const& app_id : blur["app_ids"])
+            {
+                try
+                {
+                    parsed.app_ids.push_back(app_id.as<std::string>());
+                }
+                catch (YAML::BadConversion const& e)
+                {
+                    mir::log_error("Unable to parse blur app_id: %s", e.msg.c_str());
+                }
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(blur_mutex);
+    blur_config = parsed;
+}
+
+void MiracleConfig::read_opacity(YAML::Node const& root)
+{
+    OpacityConfig parsed;
+    if (root["dim"])
+    {
+        auto const dim = root["dim"];
+        try_parse_value(dim, "inactive", parsed.inactive_dim);
+        try_parse_value(dim, "duration", parsed.dim_duration_seconds);
+        parsed.inactive_dim = std::clamp(parsed.inactive_dim, 0.f, 1.f);
+        parsed.dim_duration_seconds = std::max(parsed.dim_duration_seconds, 0.f);
+    }
+
+    if (root["opacity"] && !root["opacity"].IsSequence())
+        mir::log_error("opacity must be an array");
+    else if (root["opacity"])
+    {
+        for (auto const& node : root["opacity"])
+        {
+            OpacityRule rule;
+            if (!try_parse_value(node, "app_id", rule.app_id))
+            {
+                mir::log_error("opacity: rule is missing an 'app_id'");
+                continue;
+            }
+
+            if (!try_parse_value(node, "opacity", rule.opacity))
+            {
+                mir::log_error("opacity: rule for %s is missing an 'opacity'", rule.app_id.c_str());
+                continue;
+            }
+
+            rule.opacity = std::clamp(rule.opacity, 0.f, 1.f);
+            parsed.rules.push_back(rule);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(opacity_mutex);
+    opacity_config = parsed;
+}
+
 void MiracleConfig::_watch(miral::MirRunner& runner)
 {
     inotify_fd = mir::Fd { inotify_init() };
-    file_watch = inotify_add_watch(inotify_fd, config_path.c_str(), IN_MODIFY);
+
+    // Editors and configuration management tools usually write a temporary file and rename it
+    // into place, which replaces the file that a watch on the file itself would be following.
+    // The directories are watched instead.
+    auto config_directory = std::filesystem::path(config_path).parent_path();
+    if (config_directory.empty())
+        config_directory = ".";
+    auto const config_name = std::filesystem::path(config_path).filename().string();
+    file_watch = inotify_add_watch(inotify_fd, config_directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
     if (file_watch < 0)
         mir::fatal_error("Unable to watch the config file");
 
-    watch_handle = runner.register_fd_handler(inotify_fd, [&](int file_fd)
-    {
-        union
-        {
-            inotify_event event;
-            char buffer[sizeof(inotify_event) + NAME_MAX + 1];
-        } inotify_buffer;
+    drop_in_watch = inotify_add_watch(inotify_fd, drop_in_path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE);
+    if (drop_in_watch < 0)
+        mir::log_warning("Unable to watch the configuration directory: %s", drop_in_path.c_str());
 
-        if (read(inotify_fd, &inotify_buffer, sizeof(inotify_buffer)) < static_cast<ssize_t>(sizeof(inotify_event)))
+    watch_handle = runner.register_fd_handler(inotify_fd, [this, config_name](int file_fd)
+    {
+        alignas(inotify_event) char buffer[sizeof(inotify_event) * 16 + NAME_MAX + 1];
+        auto const length = read(inotify_fd, buffer, sizeof(buffer));
+        if (length < static_cast<ssize_t>(sizeof(inotify_event)))
             return;
 
-        if (inotify_buffer.event.mask & (IN_MODIFY))
+        for (char* ptr = buffer; ptr < buffer + length;)
         {
-            _load();
-            has_changes = true;
+            auto const* event = reinterpret_cast<inotify_event const*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            if (event->wd == file_watch && event->len > 0 && config_name == event->name)
+                reload_file("");
+            else if (event->wd == drop_in_watch && event->len > 0 && is_drop_in_file(event->name))
+                reload_file(event->name);
         }
     });
 }
 
 void MiracleConfig::try_process_change()
 {
-    std::lock_guard<std::mutex> lock(mutex);
-    if (!has_changes)
+    if (!pending_sections)
         return;
 
-    has_changes = false;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto const sections = pending_sections.exchange(config_section_none);
     for (auto const& on_change : on_change_listeners)
     {
-        on_change.listener(*this);
+        if (on_change.sections & sections)
+            on_change.listener(*this);
     }
 }
 
@@ -1016,7 +1476,8 @@ const std::vector<StartupApp>& MiracleConfig::get_startup_apps() const
     return startup_apps;
 }
 
-int MiracleConfig::register_listener(std::function<void(miracle::MiracleConfig&)> const& func, int priority)
+int MiracleConfig::register_listener(
+    std::function<void(miracle::MiracleConfig&)> const& func, int priority, uint32_t sections)
 {
     int handle = next_listener_handle++;
 
@@ -1024,12 +1485,12 @@ int MiracleConfig::register_listener(std::function<void(miracle::MiracleConfig&)
     {
         if (it->priority >= priority)
         {
-            on_change_listeners.insert(it, { func, priority, handle });
+            on_change_listeners.insert(it, { func, priority, handle, sections });
             return handle;
         }
     }
 
-    on_change_listeners.push_back({ func, priority, handle });
+    on_change_listeners.push_back({ func, priority, handle, sections });
     return handle;
 }
 
@@ -1061,6 +1522,11 @@ std::optional<std::string> const& MiracleConfig::get_terminal_command() const
     return terminal;
 }
 
+int MiracleConfig::get_terminal_pool_size() const
+{
+    return terminal_pool_size;
+}
+
 int MiracleConfig::get_resize_jump() const
 {
     return resize_jump;
@@ -1076,6 +1542,41 @@ BorderConfig const& MiracleConfig::get_border_config() const
     return border_config;
 }
 
+TitleBarConfig MiracleConfig::get_title_bar_config() const
+{
+    std::lock_guard<std::mutex> lock(title_bar_mutex);
+    return title_bar_config;
+}
+
+BlurConfig MiracleConfig::get_blur_config() const
+{
+    std::lock_guard<std::mutex> lock(blur_mutex);
+    return blur_config;
+}
+
+OpacityConfig MiracleConfig::get_opacity_config() const
+{
+    std::lock_guard<std::mutex> lock(opacity_mutex);
+    return opacity_config;
+}
+
+float OpacityConfig::get_opacity(std::string const& application_id) const
+{
+    for (auto const& rule : rules)
+    {
+        if (rule.app_id == application_id)
+            return rule.opacity;
+    }
+
+    return 1.f;
+}
+
+int MiracleConfig::get_title_bar_height() const
+{
+    std::lock_guard<std::mutex> lock(title_bar_mutex);
+    return title_bar_config.enabled ? title_bar_config.height : 0;
+}
+
 std::array<AnimationDefinition, (int)AnimateableEvent::max> const& MiracleConfig::get_animation_definitions() const
 {
     return animation_defintions;
@@ -1085,3 +1586,51 @@ bool MiracleConfig::are_animations_enabled() const
 {
     return animations_enabled;
 }
+
+PowerProfile MiracleConfig::get_power_profile(std::string const& output_name) const
+{
+    std::lock_guard<std::mutex> lock(power_mutex);
+    return power_profiles.resolve(output_name);
+}
+
+bool MiracleConfig::select_power_profile(std::string const& name, std::optional<std::string> const& output_name)
+{
+    {
+        std::lock_guard<std::mutex> lock(power_mutex);
+        if (!power_profiles.select(name, output_name))
+            return false;
+    }
+
+    pending_sections |= config_section_power;
+    return true;
+}
+
+void MiracleConfig::set_on_battery(bool on_battery)
+{
+    {
+        std::lock_guard<std::mutex> lock(power_mutex);
+        if (!power_profiles.set_on_battery(on_battery))
+            return;
+    }
+
+    mir::log_info("Running on %s power", on_battery ? "battery" : "mains");
+    pending_sections |= config_section_power;
+}
+
+void MiracleConfig::set_software_rendering(bool software_rendering)
+{
+    {
+        std::lock_guard<std::mutex> lock(power_mutex);
+        if (!power_profiles.set_software_rendering(software_rendering))
+            return;
+    }
+
+    mir::log_info("Rendering %s", software_rendering ? "in software" : "on the GPU");
+    pending_sections |= config_section_power;
+}
+
+std::optional<std::string> MiracleConfig::get_power_supply_path() const
+{
+    std::lock_guard<std::mutex> lock(power_mutex);
+    return power_supply_path;
+}
@@ -19,10 +19,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIRACLEWM_MIRACLE_CONFIG_H
 
 #include "animation_defintion.h"
+#include "power_profile.h"
 #include <atomic>
+#include <cstdint>
 #include <functional>
 #include <glm/glm.hpp>
 #include <linux/input.h>
+#include <map>
 #include <memory>
 #include <mir/fd.h>
 #include <miral/toolkit_event.h>
@@ -31,10 +34,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <string>
 #include <vector>
 
-namespace YAML
-{
-class Node;
-}
+#include <yaml-cpp/node/node.h>
 
 namespace miral
 {
@@ -83,6 +83,8 @@ enum DefaultKeyCommand
     MoveToWorkspace0,
     ToggleFloating,
     TogglePinnedToWorkspace,
+    MoveToScratchpad,
+    ToggleScratchpad,
     MAX
 };
 
@@ -112,11 +114,85 @@ struct EnvironmentVariable
     std::string value;
 };
 
+/// Sections of the configuration that are read, and reported as changed, independently
+enum ConfigSection : uint32_t
+{
+    config_section_none = 0,
+    config_section_key_commands = 1 << 0,
+    config_section_gaps = 1 << 1,
+    config_section_startup_apps = 1 << 2,
+    config_section_terminal = 1 << 3,
+    config_section_resize = 1 << 4,
+    config_section_environment = 1 << 5,
+    config_section_border = 1 << 6,
+    config_section_animations = 1 << 7,
+    config_section_power = 1 << 8,
+    config_section_title_bar = 1 << 9,
+    config_section_blur = 1 << 10,
+    config_section_opacity = 1 << 11,
+    config_section_all = 0xFFFFFFFF
+};
+
+struct ShadowConfig
+{
+    /// How far the shadow is blurred, as the standard deviation in pixels. Zero disables shadows.
+    int size = 0;
+    glm::vec2 offset = glm::vec2(0);
+    glm::vec4 color = glm::vec4(0, 0, 0, 0.5f);
+};
+
 struct BorderConfig
 {
     int size;
     glm::vec4 focus_color;
     glm::vec4 color;
+
+    /// Rounds the corners of windows and of their borders
+    int radius = 0;
+    ShadowConfig shadow;
+};
+
+struct TitleBarConfig
+{
+    bool enabled = false;
+    int height = 22;
+    std::string font = "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+    int font_size = 13;
+    glm::vec4 color = { 0.2f, 0.2f, 0.2f, 1.f };
+    glm::vec4 focus_color = { 0.3f, 0.35f, 0.45f, 1.f };
+    glm::vec4 text_color = { 1.f, 1.f, 1.f, 1.f };
+};
+
+struct BlurConfig
+{
+    /// Halvings of the resolution that the content beneath a window is blurred at
+    int passes = 3;
+
+    /// How far apart, in texels of each pass, the blur samples
+    float offset = 2.f;
+
+    /// Applications whose windows blur the content beneath them
+    std::vector<std::string> app_ids;
+};
+
+struct OpacityRule
+{
+    std::string app_id;
+    float opacity = 1.f;
+};
+
+struct OpacityConfig
+{
+    /// How far the windows that are not focused are darkened, from 0 to 1
+    float inactive_dim = 0.f;
+
+    /// How long the dimming takes to follow a change of focus
+    float dim_duration_seconds = 0.15f;
+
+    std::vector<OpacityRule> rules;
+
+    /// The opacity that the rules give to the windows of an application
+    [[nodiscard]] float get_opacity(std::string const& application_id) const;
 };
 
 class MiracleConfig
@@ -133,38 +209,92 @@ public:
     [[nodiscard]] int get_outer_gaps_y() const;
     [[nodiscard]] std::vector<StartupApp> const& get_startup_apps() const;
     [[nodiscard]] std::optional<std::string> const& get_terminal_command() const;
+
+    /// The number of terminals that are kept launched and hidden so that the terminal key shows one
+    /// immediately. Zero disables the pool.
+    [[nodiscard]] int get_terminal_pool_size() const;
     [[nodiscard]] int get_resize_jump() const;
     [[nodiscard]] std::vector<EnvironmentVariable> const& get_env_variables() const;
     [[nodiscard]] BorderConfig const& get_border_config() const;
+    [[nodiscard]] TitleBarConfig get_title_bar_config() const;
+    [[nodiscard]] BlurConfig get_blur_config() const;
+    [[nodiscard]] OpacityConfig get_opacity_config() const;
+
+    /// The space reserved above each tiled window for its title bar, which is zero when title bars are disabled
+    [[nodiscard]] int get_title_bar_height() const;
     [[nodiscard]] std::array<AnimationDefinition, (int)AnimateableEvent::max> const& get_animation_definitions() const;
     [[nodiscard]] bool are_animations_enabled() const;
 
+    /// The power profile that applies to the output, or to the compositor as a whole when no output is given
+    [[nodiscard]] PowerProfile get_power_profile(std::string const& output_name = "") const;
+
+    /// Selects a power profile at runtime, either globally or for a single output. Selecting
+    /// "auto" returns to the configured profile.
+    /// @returns false if there is no profile with that name
+    bool select_power_profile(std::string const& name, std::optional<std::string> const& output_name = std::nullopt);
+
+    /// Advises us of whether the machine is running on battery
+    void set_on_battery(bool on_battery);
+
+    /// Advises us of whether the renderer rasterizes on the CPU. This is called from the compositor thread.
+    void set_software_rendering(bool software_rendering);
+
+    /// The sysfs attribute that reports whether the machine is on mains power, if any
+    [[nodiscard]] std::optional<std::string> get_power_supply_path() const;
+
     /// Register a listener on configuration change. A lower "priority" number signifies that the
-    /// listener should be triggered earlier. A higher priority means later
-    int register_listener(std::function<void(miracle::MiracleConfig&)> const&, int priority = 5);
+    /// listener should be triggered earlier. A higher priority means later. The listener is only
+    /// triggered when one of the provided ConfigSection flags has changed.
+    int register_listener(
+        std::function<void(miracle::MiracleConfig&)> const&,
+        int priority = 5,
+        uint32_t sections = config_section_all);
     void unregister_listener(int handle);
     void try_process_change();
 
+    /// Parses a single file again and applies the sections that it changed. Listeners to those
+    /// sections are notified on the next call to try_process_change. This is called when the
+    /// file watcher sees a file change. An empty name refers to the main configuration file.
+    void reload_file(std::string const& name);
+
 private:
     struct ChangeListener
     {
         std::function<void(miracle::MiracleConfig&)> listener;
         int priority;
         int handle;
+        uint32_t sections;
     };
 
     static uint parse_modifier(std::string const& stringified_action_key);
+    void create_drop_in_directory();
     void _load();
+    void _apply(uint32_t sections);
     void _watch(miral::MirRunner& runner);
+    void read_key_commands(YAML::Node const&);
+    void read_gaps(YAML::Node const&);
+    void read_startup_apps(YAML::Node const&);
+    void read_terminal(YAML::Node const&);
+    void read_resize_jump(YAML::Node const&);
+    void read_environment_variables(YAML::Node const&);
+    void read_border(YAML::Node const&);
     void read_animation_definitions(YAML::Node const&);
+    void read_power(YAML::Node const&);
+    void read_title_bar(YAML::Node const&);
+    void read_blur(YAML::Node const&);
+    void read_opacity(YAML::Node const&);
 
     miral::MirRunner& runner;
     int next_listener_handle = 0;
     std::vector<ChangeListener> on_change_listeners;
     std::string config_path;
+    std::string drop_in_path;
+    YAML::Node main_file;
+    std::map<std::string, YAML::Node> drop_in_files;
     mir::Fd inotify_fd;
     std::unique_ptr<miral::FdHandle> watch_handle;
-    int file_watch = 0;
+    int file_watch = -1;
+    int drop_in_watch = -1;
     std::mutex mutex;
 
     static const uint miracle_input_event_modifier_default = 1 << 18;
@@ -178,12 +308,27 @@ private:
     std::vector<StartupApp> startup_apps;
     std::optional<std::string> terminal = "miracle-wm-sensible-terminal";
     std::string desired_terminal = "";
+    static int const max_terminal_pool_size = 8;
+    int terminal_pool_size = 0;
     int resize_jump = 50;
     std::vector<EnvironmentVariable> environment_variables;
     BorderConfig border_config;
-    std::atomic<bool> has_changes = false;
+    std::atomic<uint32_t> pending_sections = config_section_none;
     bool animations_enabled = true;
     std::array<AnimationDefinition, (int)AnimateableEvent::max> animation_defintions;
+
+    /// Guards the power profiles, which are read from the animator and render threads and
+    /// may be selected at runtime
+    mutable std::mutex power_mutex;
+    PowerProfiles power_profiles;
+    std::optional<std::string> power_supply_path;
+    mutable std::mutex title_bar_mutex;
+    TitleBarConfig title_bar_config;
+    static int const max_blur_passes = 6;
+    mutable std::mutex blur_mutex;
+    BlurConfig blur_config;
+    mutable std::mutex opacity_mutex;
+    OpacityConfig opacity_config;
 };
 }
 
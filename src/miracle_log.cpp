@@ -0,0 +1,85 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "miracle_log"
+
+#include "miracle_log.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+using namespace miracle::log;
+
+namespace
+{
+/// Call sites that have suppressed at least one message. Sites remove themselves
+/// when they are destroyed.
+std::mutex registry_mutex;
+std::vector<CallSite*> registry;
+}
+
+CallSite::CallSite(char const* file, int line, unsigned int burst, std::chrono::milliseconds period) :
+    file { file },
+    line { line },
+    burst { burst },
+    period { std::chrono::duration_cast<Clock::duration>(period).count() }
+{
+}
+
+CallSite::~CallSite()
+{
+    if (!is_registered.load(std::memory_order_relaxed))
+        return;
+
+    std::lock_guard lock(registry_mutex);
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+}
+
+bool CallSite::should_emit()
+{
+    auto const now = Clock::now().time_since_epoch().count();
+    auto start = window_start.load(std::memory_order_relaxed);
+    if (now - start >= period && window_start.compare_exchange_strong(start, now, std::memory_order_relaxed))
+        emitted_in_window.store(0, std::memory_order_relaxed);
+
+    if (emitted_in_window.fetch_add(1, std::memory_order_relaxed) < burst)
+        return true;
+
+    suppressed.fetch_add(1, std::memory_order_relaxed);
+    if (!is_registered.exchange(true, std::memory_order_relaxed))
+    {
+        std::lock_guard lock(registry_mutex);
+        registry.push_back(this);
+    }
+    return false;
+}
+
+unsigned int CallSite::take_suppressed()
+{
+    return suppressed.exchange(0, std::memory_order_relaxed);
+}
+
+void miracle::log::report_suppressed()
+{
+    std::lock_guard lock(registry_mutex);
+    for (auto site : registry)
+    {
+        auto const count = site->take_suppressed();
+        if (count > 0)
+            mir::log_info("Suppressed %u messages from %s:%d", count, site->file, site->line);
+    }
+}
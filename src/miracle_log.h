@@ -0,0 +1,130 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_MIRACLE_LOG_H
+#define MIRACLEWM_MIRACLE_LOG_H
+
+#include "shm_log.h"
+
+#include <atomic>
+#include <chrono>
+#include <mir/log.h>
+
+/// The least severe message that is printed. Printing anything less severe is removed at compile
+/// time, but the message is still recorded in the shared memory log. Override with -DMIRACLE_LOG_MAX_SEVERITY=<n>.
+#ifndef MIRACLE_LOG_MAX_SEVERITY
+#ifdef NDEBUG
+#define MIRACLE_LOG_MAX_SEVERITY 3 // mir::logging::Severity::informational
+#else
+#define MIRACLE_LOG_MAX_SEVERITY 4 // mir::logging::Severity::debug
+#endif
+#endif
+
+namespace miracle::log
+{
+
+/// Rate limits the messages logged from a single call site. At most @p burst messages
+/// are emitted per @p period and the rest are counted. Checking whether a message may
+/// be emitted only touches atomics, so it is safe on the input path and across threads.
+class CallSite
+{
+public:
+    CallSite(
+        char const* file,
+        int line,
+        unsigned int burst = 5,
+        std::chrono::milliseconds period = std::chrono::seconds(1));
+    ~CallSite();
+
+    CallSite(CallSite const&) = delete;
+    CallSite& operator=(CallSite const&) = delete;
+
+    /// @returns true if the message should be formatted and emitted
+    bool should_emit();
+
+    /// @returns the number of messages suppressed since the last call
+    unsigned int take_suppressed();
+
+    char const* const file;
+    int const line;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    unsigned int const burst;
+    Clock::rep const period;
+    std::atomic<Clock::rep> window_start = 0;
+    std::atomic<unsigned int> emitted_in_window = 0;
+    std::atomic<unsigned int> suppressed = 0;
+    std::atomic<bool> is_registered = false;
+};
+
+/// Logs how many messages each call site suppressed since the last report.
+/// This is expected to be called periodically from the main loop.
+void report_suppressed();
+
+/// Checks the severity and the call site's rate limit.
+/// @returns true if a message from the call site should be printed now
+template <mir::logging::Severity severity>
+bool should_print(CallSite& site)
+{
+    if constexpr (static_cast<int>(severity) <= MIRACLE_LOG_MAX_SEVERITY)
+        return site.should_emit();
+    else
+        return false;
+}
+
+/// Records the message in the shared memory log, and prints it if @p print is set
+template <mir::logging::Severity severity, typename... Args>
+void write(bool print, char const* component, char const* format, Args const&... args)
+{
+    ShmLog::instance().write(static_cast<int>(severity), component, format, args...);
+    if constexpr (static_cast<int>(severity) <= MIRACLE_LOG_MAX_SEVERITY)
+    {
+        if (!print)
+            return;
+
+        if constexpr (sizeof...(args) == 0)
+            ::mir::log(severity, component, "%s", format);
+        else
+            ::mir::log(severity, component, format, args...);
+    }
+}
+
+}
+
+/// Logs a printf-style message at the provided mir::logging::Severity, limited per call site.
+/// Every message is recorded in the shared memory log while it is enabled, even when it is not
+/// printed. The arguments are evaluated at most once, and not at all when the message is neither
+/// printed nor recorded.
+#define MIRACLE_LOG(severity, ...)                                                               \
+    do                                                                                           \
+    {                                                                                            \
+        static ::miracle::log::CallSite miracle_log_site { __FILE__, __LINE__ };                 \
+        bool const miracle_log_print = ::miracle::log::should_print<severity>(miracle_log_site); \
+        if (miracle_log_print || ::miracle::ShmLog::instance().is_enabled())                     \
+            ::miracle::log::write<severity>(miracle_log_print, MIR_LOG_COMPONENT, __VA_ARGS__);  \
+        if (false) /* Only checks the format against the arguments */                            \
+            ::mir::log(severity, MIR_LOG_COMPONENT, __VA_ARGS__);                                \
+    } while (0)
+
+#define MIRACLE_LOG_ERROR(...) MIRACLE_LOG(::mir::logging::Severity::error, __VA_ARGS__)
+#define MIRACLE_LOG_WARNING(...) MIRACLE_LOG(::mir::logging::Severity::warning, __VA_ARGS__)
+#define MIRACLE_LOG_INFO(...) MIRACLE_LOG(::mir::logging::Severity::informational, __VA_ARGS__)
+#define MIRACLE_LOG_DEBUG(...) MIRACLE_LOG(::mir::logging::Severity::debug, __VA_ARGS__)
+
+#endif // MIRACLEWM_MIRACLE_LOG_H
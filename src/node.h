@@ -53,6 +53,8 @@ public:
     virtual void set_parent(std::shared_ptr<ParentNode> const&) = 0;
     virtual size_t get_min_height() const = 0;
     virtual size_t get_min_width() const = 0;
+    virtual size_t get_max_height() const = 0;
+    virtual size_t get_max_width() const = 0;
     bool is_leaf();
     bool is_lane();
     [[nodiscard]] std::weak_ptr<ParentNode> get_parent() const;
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "output_content.h"
 #include "window_helpers.h"
 #include "workspace_manager.h"
+#include <algorithm>
 #include <glm/gtx/transform.hpp>
 #include <mir/log.h>
 #include <mir/scene/surface.h>
@@ -95,14 +96,14 @@ std::shared_ptr<WindowMetadata> OutputContent::advise_new_window(miral::WindowIn
     {
     case WindowType::tiled:
     {
-        auto node = get_active_tree()->advise_new_window(window_info);
         metadata = std::make_shared<WindowMetadata>(WindowType::tiled, window_info.window(), get_active_workspace());
-        metadata->associate_to_node(node);
+        get_active_tree()->advise_new_window(window_info, metadata);
         break;
     }
     case WindowType::floating:
     {
         floating_window_manager.advise_new_window(window_info);
+        window_helpers::set_layer(window_info.window(), StackingLayer::floating, tools);
         break;
     }
     case WindowType::other:
@@ -110,6 +111,14 @@ std::shared_ptr<WindowMetadata> OutputContent::advise_new_window(miral::WindowIn
         {
             tools.select_active_window(window_info.window());
         }
+
+        // Dialogs must stay with their parent, which may live in a higher layer
+        if (window_info.parent() && tools.info_for(window_info.parent()).depth_layer() != window_info.depth_layer())
+        {
+            miral::WindowSpecification spec;
+            spec.depth_layer() = tools.info_for(window_info.parent()).depth_layer();
+            tools.modify_window(window_info.window(), spec);
+        }
         metadata = std::make_shared<WindowMetadata>(WindowType::other, window_info.window());
         break;
     default:
@@ -121,8 +130,6 @@ std::shared_ptr<WindowMetadata> OutputContent::advise_new_window(miral::WindowIn
     {
         miral::WindowSpecification spec;
         spec.userdata() = metadata;
-        spec.min_width() = mir::geometry::Width(0);
-        spec.min_height() = mir::geometry::Height(0);
         tools.modify_window(window_info.window(), spec);
         return metadata;
     }
@@ -139,7 +146,7 @@ void OutputContent::handle_window_ready(miral::WindowInfo& window_info, std::sha
     {
     case WindowType::tiled:
     {
-        metadata->get_tiling_node()->get_tree()->handle_window_ready(window_info);
+        metadata->get_tiling_node()->get_tree()->handle_window_ready(window_info, metadata->get_tiling_node());
         break;
     }
     case WindowType::floating:
@@ -158,7 +165,7 @@ void OutputContent::advise_focus_gained(const std::shared_ptr<miracle::WindowMet
     {
     case WindowType::tiled:
     {
-        metadata->get_tiling_node()->get_tree()->advise_focus_gained(metadata->get_window());
+        metadata->get_tiling_node()->get_tree()->advise_focus_gained(metadata->get_tiling_node());
         break;
     }
     case WindowType::floating:
@@ -176,7 +183,7 @@ void OutputContent::advise_focus_lost(const std::shared_ptr<miracle::WindowMetad
     {
     case WindowType::tiled:
     {
-        metadata->get_tiling_node()->get_tree()->advise_focus_lost(metadata->get_window());
+        metadata->get_tiling_node()->get_tree()->advise_focus_lost(metadata->get_tiling_node());
         break;
     }
     case WindowType::floating:
@@ -194,7 +201,7 @@ void OutputContent::advise_delete_window(const std::shared_ptr<miracle::WindowMe
     {
     case WindowType::tiled:
     {
-        metadata->get_tiling_node()->get_tree()->advise_delete_window(metadata->get_window());
+        metadata->get_tiling_node()->get_tree()->advise_delete_window(metadata->get_tiling_node());
         break;
     }
     case WindowType::floating:
@@ -275,6 +282,10 @@ void OutputContent::advise_state_change(const std::shared_ptr<miracle::WindowMet
             break;
 
         floating_window_manager.advise_state_change(tools.info_for(metadata->get_window()), state);
+        window_helpers::set_layer(
+            metadata->get_window(),
+            state == mir_window_state_fullscreen ? StackingLayer::fullscreen : StackingLayer::floating,
+            tools);
         break;
     default:
         mir::log_error("Unsupported window type: %d", (int)metadata->get_type());
@@ -296,13 +307,18 @@ void OutputContent::handle_modify_window(const std::shared_ptr<miracle::WindowMe
         {
             auto tree = metadata->get_tiling_node()->get_tree();
             if (window_helpers::is_window_fullscreen(modifications.state().value()))
-                tree->advise_fullscreen_window(metadata->get_window());
+                tree->advise_fullscreen_window(metadata->get_tiling_node());
             else if (modifications.state().value() == mir_window_state_restored)
-                tree->advise_restored_window(metadata->get_window());
-            tree->constrain(metadata->get_window());
+                tree->advise_restored_window(metadata->get_tiling_node());
+            tree->constrain(metadata->get_tiling_node());
         }
 
         tools.modify_window(metadata->get_window(), modifications);
+
+        // The solver reads size constraints from the window info, so it can only run once they are applied
+        if (modifications.min_width().is_set() || modifications.min_height().is_set()
+            || modifications.max_width().is_set() || modifications.max_height().is_set())
+            metadata->get_tiling_node()->get_tree()->advise_constraints_changed();
         break;
     }
     case WindowType::floating:
@@ -345,7 +361,7 @@ OutputContent::confirm_placement_on_display(
     case WindowType::tiled:
     {
         metadata->get_tiling_node()->get_tree()->confirm_placement_on_display(
-            metadata->get_window(), new_state, modified_placement);
+            metadata->get_tiling_node(), new_state, modified_placement);
         break;
     }
     case WindowType::floating:
@@ -430,72 +446,50 @@ bool OutputContent::advise_workspace_active(int key)
         }
     }
 
-    // TODO: Handle pinned windows
-    // TODO This is an abuse of the sliding animation system, but it at least proves a point. "Slide"
-    //  means different things in different contexts, so it seems.
-    auto travel_distance = active_workspace > key ? (-area.size.width.as_int()) : area.size.width.as_int();
-    animator.workspace_move_to(animation_handle,
-        travel_distance,
-        [from = from, this](AnimationStepResult const& asr)
+    // A swipe that settles onto this workspace has already brought it on screen and slides it into place itself
+    bool const is_swipe_target = workspace_swipe && workspace_swipe->is_settling && workspace_swipe->to == to;
+    if (!is_swipe_target)
     {
-        if (!from)
-            return;
-
-        if (asr.is_complete)
+        // TODO: Handle pinned windows
+        // TODO This is an abuse of the sliding animation system, but it at least proves a point. "Slide"
+        //  means different things in different contexts, so it seems.
+        auto travel_distance = active_workspace > key ? (-area.size.width.as_int()) : area.size.width.as_int();
+        animator.workspace_move_to(animation_handle,
+            travel_distance,
+            [from = from, this](AnimationStepResult const& asr)
         {
-            from->hide();
-            return;
-        }
+            if (!from)
+                return;
 
-        if (!asr.position)
-            return;
+            if (asr.is_complete)
+            {
+                from->hide();
+                return;
+            }
 
-        AnimationStepResult other;
-        other.transform = glm::translate(glm::vec3(asr.position->x, asr.position->y, 0));
-        from->set_transform(other.transform.value());
+            if (!asr.position)
+                return;
 
-        // TODO: Ugh, sad. I am forced to set the surface transform so that the surface is rerendered
-        from->for_each_window([&](std::shared_ptr<WindowMetadata> const& metadata)
+            set_workspace_transform(*from, glm::translate(glm::vec3(asr.position->x, asr.position->y, 0)));
+        },
+            [to = to, from = from, this](AnimationStepResult const& asr)
         {
-            auto& window = metadata->get_window();
-            auto surface = window.operator std::shared_ptr<mir::scene::Surface>();
-            if (surface)
+            if (asr.is_complete)
             {
-                surface->set_clip_area(std::nullopt);
-                surface->set_transformation(glm::mat4(1.f));
+                to->set_transform(glm::mat4(1.f));
+                return;
             }
-        });
-    },
-        [to = to, from = from, this](AnimationStepResult const& asr)
-    {
-        if (asr.is_complete)
-        {
-            to->set_transform(glm::mat4(1.f));
-            return;
-        }
 
-        if (!asr.position)
-            return;
+            if (!asr.position)
+                return;
 
-        AnimationStepResult other;
-        other.transform = glm::translate(glm::vec3(asr.position->x, asr.position->y, 0));
-        to->set_transform(other.transform.value());
+            set_workspace_transform(*to, glm::translate(glm::vec3(asr.position->x, asr.position->y, 0)));
+        },
+            output.name());
 
-        // TODO: Ugh, sad. I am forced to set the surface transform so that the surface is rerendered
-        to->for_each_window([&](std::shared_ptr<WindowMetadata> const& metadata)
-        {
-            auto& window = metadata->get_window();
-            auto surface = window.operator std::shared_ptr<mir::scene::Surface>();
-            surface->clip_area() = std::nullopt;
-            if (surface)
-            {
-                surface->set_clip_area(std::nullopt);
-                surface->set_transformation(glm::mat4(1.f));
-            }
-        });
-    });
+        to->show({});
+    }
 
-    to->show({});
     active_workspace = key;
 
     // Important: Delete the workspace only after we have shown the new one because we may want
@@ -510,37 +504,196 @@ bool OutputContent::advise_workspace_active(int key)
     return true;
 }
 
+void OutputContent::set_workspace_transform(WorkspaceContent& workspace, glm::mat4 const& transform)
+{
+    workspace.set_transform(transform);
+
+    // TODO: Ugh, sad. I am forced to set the surface transform so that the surface is rerendered
+    workspace.for_each_window([&](std::shared_ptr<WindowMetadata> const& metadata)
+    {
+        auto& window = metadata->get_window();
+        auto surface = window.operator std::shared_ptr<mir::scene::Surface>();
+        if (surface)
+        {
+            surface->set_clip_area(std::nullopt);
+            surface->set_transformation(glm::mat4(1.f));
+        }
+    });
+}
+
+std::shared_ptr<WorkspaceContent> OutputContent::find_neighboring_workspace(int direction) const
+{
+    // Workspace 0 lives on the 0 key, so it sits after 9 rather than before 1
+    auto const order = [](int key) { return key == 0 ? 10 : key; };
+    auto const active_order = order(active_workspace);
+
+    std::shared_ptr<WorkspaceContent> result = nullptr;
+    for (auto const& workspace : workspaces)
+    {
+        auto const workspace_order = order(workspace->get_workspace());
+        if ((workspace_order - active_order) * direction <= 0)
+            continue;
+
+        if (!result || (workspace_order - order(result->get_workspace())) * direction < 0)
+            result = workspace;
+    }
+
+    return result;
+}
+
+void OutputContent::update_workspace_swipe(float offset)
+{
+    if (workspace_swipe && workspace_swipe->is_settling)
+        return;
+
+    if (!workspace_swipe)
+    {
+        auto it = std::find_if(workspaces.begin(), workspaces.end(), [&](auto const& workspace)
+        {
+            return workspace->get_workspace() == active_workspace;
+        });
+        if (it == workspaces.end())
+            return;
+
+        workspace_swipe = WorkspaceSwipe { *it };
+    }
+
+    auto& swipe = workspace_swipe.value();
+    auto const width = area.size.width.as_int();
+
+    // Fingers travelling left pull in the next workspace from the right, and vice versa
+    auto neighbor = find_neighboring_workspace(offset < 0 ? 1 : -1);
+    if (neighbor != swipe.to)
+    {
+        if (swipe.to)
+            swipe.to->hide();
+
+        swipe.to = neighbor;
+        swipe.to_x = offset < 0 ? width : -width;
+        if (swipe.to)
+        {
+            set_workspace_transform(*swipe.to, glm::translate(glm::vec3(offset + swipe.to_x, 0, 0)));
+            swipe.to->show({});
+        }
+    }
+
+    auto const x = swipe.to ? offset : offset * swipe_resistance;
+    set_workspace_transform(*swipe.from, glm::translate(glm::vec3(x, 0, 0)));
+    if (swipe.to)
+        set_workspace_transform(*swipe.to, glm::translate(glm::vec3(x + swipe.to_x, 0, 0)));
+}
+
+void OutputContent::end_workspace_swipe(float offset, float velocity)
+{
+    if (!workspace_swipe || workspace_swipe->is_settling)
+        return;
+
+    // Dragging past the middle switches, and so does a quick flick towards the neighbor
+    auto const& swipe = workspace_swipe.value();
+    bool const should_switch = swipe.to
+        && (std::abs(offset) > area.size.width.as_int() / 2.f
+            || (std::abs(velocity) > swipe_fling_velocity && velocity * offset > 0));
+    settle_workspace_swipe(swipe.to ? offset : offset * swipe_resistance, velocity, should_switch);
+}
+
+void OutputContent::cancel_workspace_swipe(float offset)
+{
+    if (!workspace_swipe || workspace_swipe->is_settling)
+        return;
+
+    settle_workspace_swipe(workspace_swipe->to ? offset : offset * swipe_resistance, 0, false);
+}
+
+void OutputContent::settle_workspace_swipe(float x, float velocity, bool should_switch)
+{
+    workspace_swipe->is_settling = true;
+    auto const from = workspace_swipe->from;
+    auto const to = workspace_swipe->to;
+    auto const to_x = workspace_swipe->to_x;
+
+    // Focus moves first so that the workspace change does not start its own slide
+    if (should_switch)
+        workspace_manager.request_focus(to->get_workspace());
+
+    animator.workspace_settle(
+        animation_handle,
+        static_cast<int>(x),
+        should_switch ? -to_x : 0,
+        velocity,
+        [this, from, to, to_x, should_switch](AnimationStepResult const& asr)
+    {
+        if (asr.is_complete)
+        {
+            if (should_switch)
+            {
+                from->hide();
+                set_workspace_transform(*to, glm::mat4(1.f));
+            }
+            else
+            {
+                if (to)
+                    to->hide();
+                set_workspace_transform(*from, glm::mat4(1.f));
+            }
+
+            workspace_swipe.reset();
+            return;
+        }
+
+        if (!asr.position)
+            return;
+
+        set_workspace_transform(*from, glm::translate(glm::vec3(asr.position->x, 0, 0)));
+        if (to)
+            set_workspace_transform(*to, glm::translate(glm::vec3(asr.position->x + to_x, 0, 0)));
+    },
+        output.name());
+}
+
 void OutputContent::advise_application_zone_create(miral::Zone const& application_zone)
 {
     if (application_zone.extents().contains(area))
     {
         application_zone_list.push_back(application_zone);
-        for (auto& workspace : workspaces)
-            workspace->get_tree()->recalculate_root_node_area();
+        recalculate_workspace_areas();
     }
 }
 
 void OutputContent::advise_application_zone_update(miral::Zone const& updated, miral::Zone const& original)
 {
-    for (auto& zone : application_zone_list)
-        if (zone == original)
-        {
-            zone = updated;
-            for (auto& workspace : workspaces)
-                workspace->get_tree()->recalculate_root_node_area();
-            break;
-        }
+    auto it = std::find(application_zone_list.begin(), application_zone_list.end(), original);
+    if (it != application_zone_list.end())
+    {
+        if (updated.extents().contains(area))
+            *it = updated;
+        else
+            application_zone_list.erase(it);
+        recalculate_workspace_areas();
+    }
+    else if (updated.extents().contains(area))
+    {
+        application_zone_list.push_back(updated);
+        recalculate_workspace_areas();
+    }
 }
 
 void OutputContent::advise_application_zone_delete(miral::Zone const& application_zone)
 {
-    if (std::remove(application_zone_list.begin(), application_zone_list.end(), application_zone) != application_zone_list.end())
+    auto it = std::remove(application_zone_list.begin(), application_zone_list.end(), application_zone);
+    if (it != application_zone_list.end())
     {
-        for (auto& workspace : workspaces)
-            workspace->get_tree()->recalculate_root_node_area();
+        application_zone_list.erase(it, application_zone_list.end());
+        recalculate_workspace_areas();
     }
 }
 
+void OutputContent::recalculate_workspace_areas()
+{
+    // Hidden trees defer the recalculation until they are shown again
+    for (auto& workspace : workspaces)
+        workspace->get_tree()->recalculate_root_node_area();
+}
+
 bool OutputContent::point_is_in_output(int x, int y)
 {
     return area.contains(geom::Point(x, y));
@@ -615,13 +768,37 @@ std::vector<miral::Window> OutputContent::collect_all_windows() const
         workspace->get_tree()->foreach_node([&](auto const& node)
         {
             auto leaf_node = Node::as_leaf(node);
-            if (leaf_node)
+            if (leaf_node && !leaf_node->is_placeholder())
                 windows.push_back(leaf_node->get_window());
         });
     }
     return windows;
 }
 
+miral::Window OutputContent::find_fullscreen_window()
+{
+    // This is checked after every window management transaction, so it must not throw
+    // while the output is still waiting for its first workspace
+    auto it = std::find_if(workspaces.begin(), workspaces.end(), [&](auto const& workspace)
+    {
+        return workspace->get_workspace() == active_workspace;
+    });
+    if (it == workspaces.end())
+        return {};
+
+    auto const& workspace = *it;
+    if (auto node = workspace->get_tree()->get_fullscreen_node())
+        return node->get_window();
+
+    for (auto const& window : workspace->get_floating_windows())
+    {
+        if (window_helpers::is_window_fullscreen(tools.info_for(window).state()))
+            return window;
+    }
+
+    return {};
+}
+
 void OutputContent::request_toggle_active_float()
 {
     if (tools.active_window() == Window())
@@ -648,7 +825,7 @@ void OutputContent::request_toggle_active_float()
             return;
         }
 
-        tree->advise_delete_window(active_window);
+        tree->advise_delete_window(metadata->get_tiling_node());
 
         auto& prev_info = tools.info_for(active_window);
         WindowSpecification prev_spec = window_helpers::copy_from(prev_info);
@@ -687,9 +864,9 @@ miral::Window OutputContent::find_window_on_active_workspace_matching_predicate(
     std::function<bool(miral::Window const&)> const& f) const
 {
     auto workspace = get_active_workspace();
-    workspace->get_tree()->find_node([&](std::shared_ptr<Node> const& node)
+    auto const found = workspace->get_tree()->find_node([&](std::shared_ptr<Node> const& node)
     {
-        if (auto leaf_node = Node::as_leaf(node))
+        if (auto leaf_node = Node::as_leaf(node); leaf_node && !leaf_node->is_placeholder())
         {
             if (f(leaf_node->get_window()))
                 return true;
@@ -697,6 +874,9 @@ miral::Window OutputContent::find_window_on_active_workspace_matching_predicate(
         return false;
     });
 
+    if (auto leaf_node = Node::as_leaf(found))
+        return leaf_node->get_window();
+
     for (auto const& floating : workspace->get_floating_windows())
     {
         if (f(floating))
@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <memory>
 #include <miral/minimal_window_manager.h>
 #include <miral/output.h>
+#include <optional>
 
 namespace miracle
 {
@@ -108,6 +109,24 @@ public:
     void set_is_active(bool new_is_active) { is_active_ = new_is_active; }
     miral::Window get_active_window() { return active_window; }
 
+    /// Finds the fullscreen window on the active workspace, if any
+    miral::Window find_fullscreen_window();
+
+    /// The window that has the output to itself. Everything else on the output is suspended.
+    [[nodiscard]] miral::Window const& get_fullscreen_window() const { return fullscreen_window; }
+    void set_fullscreen_window(miral::Window const& window) { fullscreen_window = window; }
+
+    /// Drags the active workspace and its neighbor along with a touch swipe. The offset is how far
+    /// the fingers have travelled horizontally since the swipe began.
+    void update_workspace_swipe(float offset);
+
+    /// Releases the swipe. It settles on the neighbor if the fingers travelled past the middle of
+    /// the output or flicked towards it, and back on the active workspace otherwise.
+    void end_workspace_swipe(float offset, float velocity);
+
+    /// Settles the swipe back on the active workspace.
+    void cancel_workspace_swipe(float offset);
+
 private:
     miral::Output output;
     WorkspaceManager& workspace_manager;
@@ -122,7 +141,32 @@ private:
     std::vector<miral::Zone> application_zone_list;
     bool is_active_ = false;
     miral::Window active_window;
+    miral::Window fullscreen_window;
     AnimationHandle animation_handle;
+
+    struct WorkspaceSwipe
+    {
+        std::shared_ptr<WorkspaceContent> from;
+
+        /// The neighbor being pulled on screen, or null when there is none in that direction
+        std::shared_ptr<WorkspaceContent> to = nullptr;
+
+        /// Where the neighbor sits relative to the active workspace
+        int to_x = 0;
+        bool is_settling = false;
+    };
+
+    /// How much of the fingers' travel moves the workspace when there is no neighbor to swipe to
+    static constexpr float swipe_resistance = 0.3f;
+
+    /// Speed, in pixels per second, above which releasing the fingers switches workspace regardless of distance
+    static constexpr float swipe_fling_velocity = 500.f;
+    std::optional<WorkspaceSwipe> workspace_swipe;
+
+    void recalculate_workspace_areas();
+    void set_workspace_transform(WorkspaceContent&, glm::mat4 const&);
+    [[nodiscard]] std::shared_ptr<WorkspaceContent> find_neighboring_workspace(int direction) const;
+    void settle_workspace_swipe(float x, float velocity, bool should_switch);
 };
 
 }
@@ -0,0 +1,189 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "output_index.h"
+
+#include <algorithm>
+
+using namespace miracle;
+
+void OutputIndex::insert(int id, geom::Rectangle const& area)
+{
+    auto it = std::find_if(entries.begin(), entries.end(), [&](Entry const& entry) { return entry.id == id; });
+    if (it != entries.end())
+        it->area = area;
+    else
+        entries.push_back({ id, area });
+    rebuild();
+}
+
+void OutputIndex::update(int id, geom::Rectangle const& area)
+{
+    insert(id, area);
+}
+
+void OutputIndex::erase(int id)
+{
+    auto it = std::remove_if(entries.begin(), entries.end(), [&](Entry const& entry) { return entry.id == id; });
+    if (it == entries.end())
+        return;
+
+    entries.erase(it, entries.end());
+    rebuild();
+}
+
+void OutputIndex::clear()
+{
+    entries.clear();
+    rebuild();
+}
+
+std::optional<int> OutputIndex::find_at(geom::Point const& point) const
+{
+    if (last_hit != no_entry && entries[last_hit].area.contains(point))
+        return entries[last_hit].id;
+
+    auto column = column_of(point.x.as_int());
+    auto row = row_of(point.y.as_int());
+    if (column < 0 || row < 0)
+        return std::nullopt;
+
+    auto index = cells[row * (column_edges.size() - 1) + column];
+    if (index == no_entry)
+        return std::nullopt;
+
+    last_hit = index;
+    return entries[index].id;
+}
+
+std::vector<int> OutputIndex::find_intersecting(geom::Rectangle const& rectangle) const
+{
+    std::vector<int> result;
+    if (entries.empty() || rectangle.size.width.as_int() <= 0 || rectangle.size.height.as_int() <= 0)
+        return result;
+
+    // Clamp the rectangle to the grid so that partially overlapping rectangles still match
+    auto left = std::max(rectangle.top_left.x.as_int(), column_edges.front());
+    auto top = std::max(rectangle.top_left.y.as_int(), row_edges.front());
+    auto right = std::min(rectangle.right().as_int(), column_edges.back());
+    auto bottom = std::min(rectangle.bottom().as_int(), row_edges.back());
+    if (left >= right || top >= bottom)
+        return result;
+
+    auto first_column = column_of(left);
+    auto last_column = column_of(right - 1);
+    auto first_row = row_of(top);
+    auto last_row = row_of(bottom - 1);
+
+    std::vector<bool> seen(entries.size(), false);
+    for (auto row = first_row; row <= last_row; row++)
+    {
+        for (auto column = first_column; column <= last_column; column++)
+        {
+            auto index = cells[row * (column_edges.size() - 1) + column];
+            if (index == no_entry || seen[index])
+                continue;
+
+            seen[index] = true;
+            result.push_back(entries[index].id);
+        }
+    }
+
+    // Overlapping outputs (e.g. mirrored displays) only own the cells of the first match,
+    // so we fall back to checking the remaining entries directly.
+    if (has_overlaps)
+    {
+        for (std::size_t i = 0; i < entries.size(); i++)
+        {
+            if (!seen[i] && entries[i].area.overlaps(rectangle))
+                result.push_back(entries[i].id);
+        }
+    }
+
+    return result;
+}
+
+void OutputIndex::rebuild()
+{
+    last_hit = no_entry;
+    has_overlaps = false;
+    column_edges.clear();
+    row_edges.clear();
+    cells.clear();
+    if (entries.empty())
+        return;
+
+    for (auto const& entry : entries)
+    {
+        column_edges.push_back(entry.area.left().as_int());
+        column_edges.push_back(entry.area.right().as_int());
+        row_edges.push_back(entry.area.top().as_int());
+        row_edges.push_back(entry.area.bottom().as_int());
+    }
+
+    auto sort_unique = [](std::vector<int>& edges)
+    {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    };
+    sort_unique(column_edges);
+    sort_unique(row_edges);
+
+    auto num_columns = column_edges.size() - 1;
+    auto num_rows = row_edges.size() - 1;
+    cells.resize(num_columns * num_rows, no_entry);
+    for (std::size_t i = 0; i < entries.size(); i++)
+    {
+        auto const& area = entries[i].area;
+        if (area.size.width.as_int() <= 0 || area.size.height.as_int() <= 0)
+            continue;
+
+        auto first_column = column_of(area.left().as_int());
+        auto last_column = column_of(area.right().as_int() - 1);
+        auto first_row = row_of(area.top().as_int());
+        auto last_row = row_of(area.bottom().as_int() - 1);
+        for (auto row = first_row; row <= last_row; row++)
+        {
+            for (auto column = first_column; column <= last_column; column++)
+            {
+                auto& cell = cells[row * num_columns + column];
+                if (cell == no_entry)
+                    cell = static_cast<int>(i);
+                else
+                    has_overlaps = true;
+            }
+        }
+    }
+}
+
+int OutputIndex::column_of(int x) const
+{
+    if (column_edges.size() < 2 || x < column_edges.front() || x >= column_edges.back())
+        return -1;
+
+    auto it = std::upper_bound(column_edges.begin(), column_edges.end(), x);
+    return static_cast<int>(it - column_edges.begin()) - 1;
+}
+
+int OutputIndex::row_of(int y) const
+{
+    if (row_edges.size() < 2 || y < row_edges.front() || y >= row_edges.back())
+        return -1;
+
+    auto it = std::upper_bound(row_edges.begin(), row_edges.end(), y);
+    return static_cast<int>(it - row_edges.begin()) - 1;
+}
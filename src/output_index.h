@@ -0,0 +1,78 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_OUTPUT_INDEX_H
+#define MIRACLEWM_OUTPUT_INDEX_H
+
+#include <mir/geometry/point.h>
+#include <mir/geometry/rectangle.h>
+#include <optional>
+#include <vector>
+
+namespace geom = mir::geometry;
+
+namespace miracle
+{
+
+/// Spatial index over the output layout. Outputs are identified by their
+/// miral id. Lookups by point resolve through a grid built from the edges
+/// of every output, so the cost does not grow with the number of outputs
+/// on large video walls. The grid is only rebuilt when the layout changes.
+class OutputIndex
+{
+public:
+    void insert(int id, geom::Rectangle const& area);
+    void update(int id, geom::Rectangle const& area);
+    void erase(int id);
+    void clear();
+
+    /// Returns the id of the output containing the point, if any.
+    [[nodiscard]] std::optional<int> find_at(geom::Point const& point) const;
+
+    /// Returns the ids of every output that intersects the rectangle.
+    [[nodiscard]] std::vector<int> find_intersecting(geom::Rectangle const& rectangle) const;
+
+    [[nodiscard]] std::size_t size() const { return entries.size(); }
+
+private:
+    struct Entry
+    {
+        int id;
+        geom::Rectangle area;
+    };
+
+    static constexpr int no_entry = -1;
+
+    void rebuild();
+    [[nodiscard]] int column_of(int x) const;
+    [[nodiscard]] int row_of(int y) const;
+
+    std::vector<Entry> entries;
+    std::vector<int> column_edges;
+    std::vector<int> row_edges;
+
+    /// Index into entries for each grid cell, or no_entry
+    std::vector<int> cells;
+    bool has_overlaps = false;
+
+    /// The pointer tends to stay on the same output, so we check it first
+    mutable int last_hit = no_entry;
+};
+
+} // miracle
+
+#endif // MIRACLEWM_OUTPUT_INDEX_H
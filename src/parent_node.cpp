@@ -16,15 +16,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
 #include "parent_node.h"
+#include "layout_solver.h"
 #include "leaf_node.h"
 #include "miracle_config.h"
 #include "node.h"
+#include "window_metadata.h"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 using namespace miracle;
 
 namespace
 {
+int to_int(size_t value)
+{
+    return static_cast<int>(std::min(value, static_cast<size_t>(std::numeric_limits<int>::max())));
+}
+
 struct InsertNodeInternalResult
 {
     int size;
@@ -200,7 +209,8 @@ std::shared_ptr<LeafNode> ParentNode::create_space_for_window(int pending_index)
     return pending_node;
 }
 
-std::shared_ptr<LeafNode> ParentNode::confirm_window(miral::Window const& window)
+std::shared_ptr<LeafNode> ParentNode::confirm_window(
+    miral::Window const& window, std::shared_ptr<WindowMetadata> const& metadata)
 {
     if (pending_node == nullptr)
     {
@@ -210,11 +220,66 @@ std::shared_ptr<LeafNode> ParentNode::confirm_window(miral::Window const& window
 
     auto retval = pending_node;
     pending_node->associate_to_window(window);
+    metadata->associate_to_node(pending_node);
+
+    // Now that we know the constraints of the new window, we can lay the lane out again
+    set_logical_area(logical_area);
     commit_changes();
     pending_node = nullptr;
     return retval;
 }
 
+void ParentNode::claim_placeholder(std::shared_ptr<LeafNode> const& placeholder)
+{
+    if (get_index_of_node(placeholder) < 0)
+    {
+        mir::fatal_error("Attempting to claim a placeholder with an incorrect parent");
+        return;
+    }
+
+    pending_node = placeholder;
+}
+
+void ParentNode::append_layout(std::vector<LayoutDescription> const& descriptions)
+{
+    if (descriptions.empty())
+        return;
+
+    // The new nodes take an even share of the lane between them, split by weight. Their
+    // sizes only need to be right relative to one another, as the solver lays them out below.
+    bool const is_horizontal = direction == NodeLayoutDirection::horizontal;
+    auto const area = get_logical_area();
+    int const main_axis = is_horizontal ? area.size.width.as_int() : area.size.height.as_int();
+    double const share = static_cast<double>(main_axis * descriptions.size()) / static_cast<double>(sub_nodes.size() + descriptions.size());
+    double total_weight = 0;
+    for (auto const& description : descriptions)
+        total_weight += description.weight;
+
+    for (auto const& description : descriptions)
+    {
+        int size = std::max(1, static_cast<int>(share * description.weight / total_weight));
+        geom::Rectangle rect = is_horizontal
+            ? geom::Rectangle { area.top_left, geom::Size { size, area.size.height.as_int() } }
+            : geom::Rectangle { area.top_left, geom::Size { area.size.width.as_int(), size } };
+
+        if (description.is_placeholder())
+        {
+            auto leaf = std::make_shared<LeafNode>(node_interface, rect, config, tree, as_lane(shared_from_this()));
+            leaf->set_swallow_criteria(description.swallows);
+            sub_nodes.push_back(leaf);
+        }
+        else
+        {
+            auto lane = std::make_shared<ParentNode>(node_interface, rect, config, tree, as_lane(shared_from_this()));
+            lane->set_direction(description.direction);
+            lane->append_layout(description.nodes);
+            sub_nodes.push_back(lane);
+        }
+    }
+
+    set_logical_area(logical_area);
+}
+
 void ParentNode::graft_existing(std::shared_ptr<Node> const& node, int index)
 {
     auto rectangle = create_space(index);
@@ -250,98 +315,44 @@ void ParentNode::set_logical_area(const geom::Rectangle& target_rect)
     // We are setting the size of the lane, but each window might have an idea of how
     // its own height relates to the lane (e.g. I take up 300px of 900px lane while my
     // neighbor takes up the remaining 600px, horizontally).
-    // We need to look at the target dimension and scale everyone relative to that.
+    // We need to look at the target dimension and scale everyone relative to that,
+    // while keeping each node within its min/max constraints.
     // However, the "non-main-axis" dimension will be consistent across each node.
-    auto current_logical_area = get_logical_area();
     logical_area = target_rect;
     auto target_placement_area = get_logical_area();
-    std::vector<geom::Rectangle> pending_size_updates;
-    if (direction == NodeLayoutDirection::horizontal)
+    bool const is_horizontal = direction == NodeLayoutDirection::horizontal;
+    std::vector<LayoutConstraint> constraints;
+    constraints.reserve(sub_nodes.size());
+    for (auto const& item : sub_nodes)
     {
-        int total_width = 0;
-        for (size_t idx = 0; idx < sub_nodes.size(); idx++)
-        {
-            auto item = sub_nodes[idx];
-            auto item_rect = item->get_logical_area();
-            double percent_width_taken = (double)item_rect.size.width.as_int() / (double)current_logical_area.size.width.as_int();
-            int new_width = (int)ceil((double)target_placement_area.size.width.as_int() * percent_width_taken);
-
-            geom::Rectangle new_item_rect;
-            new_item_rect.size = geom::Size {
-                geom::Width { new_width },
-                target_placement_area.size.height
-            };
-            if (idx == 0)
-            {
-                new_item_rect.top_left = geom::Point {
-                    target_placement_area.top_left.x,
-                    target_placement_area.top_left.y
-                };
-            }
-            else
-            {
-                auto const& prev_rect = pending_size_updates[idx - 1];
-                new_item_rect.top_left = geom::Point {
-                    geom::X { prev_rect.top_left.x.as_int() + prev_rect.size.width.as_int() },
-                    target_placement_area.top_left.y
-                };
-            }
-
-            pending_size_updates.push_back(new_item_rect);
-            total_width += new_width;
-        }
-
-        if (!pending_size_updates.empty())
-        {
-            int leftover_width = target_placement_area.size.width.as_int() - total_width;
-            pending_size_updates.back().size.width = geom::Width { pending_size_updates.back().size.width.as_int() + leftover_width };
-        }
+        auto item_rect = item->get_logical_area();
+        if (is_horizontal)
+            constraints.push_back({ item_rect.size.width.as_int(), to_int(item->get_min_width()), to_int(item->get_max_width()) });
+        else
+            constraints.push_back({ item_rect.size.height.as_int(), to_int(item->get_min_height()), to_int(item->get_max_height()) });
     }
-    else
+
+    auto sizes = solve_layout(
+        is_horizontal ? target_placement_area.size.width.as_int() : target_placement_area.size.height.as_int(),
+        constraints);
+
+    int position = is_horizontal ? target_placement_area.top_left.x.as_int() : target_placement_area.top_left.y.as_int();
+    for (size_t i = 0; i < sub_nodes.size(); i++)
     {
-        int total_height = 0;
-        for (size_t idx = 0; idx < sub_nodes.size(); idx++)
+        geom::Rectangle new_item_rect;
+        if (is_horizontal)
         {
-            auto item = sub_nodes[idx];
-            auto item_rect = item->get_logical_area();
-            double percent_height_taken = static_cast<double>(item_rect.size.height.as_int()) / current_logical_area.size.height.as_int();
-            int new_height = (int)floor((double)target_placement_area.size.height.as_int() * percent_height_taken);
-
-            geom::Rectangle new_item_rect;
-            new_item_rect.size = geom::Size {
-                target_placement_area.size.width,
-                geom::Height { new_height },
-            };
-            if (idx == 0)
-            {
-                new_item_rect.top_left = geom::Point {
-                    target_placement_area.top_left.x,
-                    target_placement_area.top_left.y
-                };
-            }
-            else
-            {
-                auto const& prev_rect = pending_size_updates[idx - 1];
-                new_item_rect.top_left = geom::Point {
-                    target_placement_area.top_left.x,
-                    geom::Y { prev_rect.top_left.y.as_int() + prev_rect.size.height.as_int() },
-                };
-            }
-
-            pending_size_updates.push_back(new_item_rect);
-            total_height += new_height;
+            new_item_rect.top_left = geom::Point { geom::X { position }, target_placement_area.top_left.y };
+            new_item_rect.size = geom::Size { geom::Width { sizes[i] }, target_placement_area.size.height };
         }
-
-        if (!pending_size_updates.empty())
+        else
         {
-            int leftover_height = target_placement_area.size.height.as_int() - total_height;
-            pending_size_updates.back().size.height = geom::Height { pending_size_updates.back().size.height.as_int() + leftover_height };
+            new_item_rect.top_left = geom::Point { target_placement_area.top_left.x, geom::Y { position } };
+            new_item_rect.size = geom::Size { target_placement_area.size.width, geom::Height { sizes[i] } };
         }
-    }
 
-    for (size_t i = 0; i < sub_nodes.size(); i++)
-    {
-        sub_nodes[i]->set_logical_area(pending_size_updates[i]);
+        sub_nodes[i]->set_logical_area(new_item_rect);
+        position += sizes[i];
     }
 }
 
@@ -458,9 +469,15 @@ void ParentNode::constrain()
 
 size_t ParentNode::get_min_width() const
 {
+    // Along the main axis the nodes sit side by side, while across it they share the same size
     size_t size = 0;
     for (auto const& node : sub_nodes)
-        size += node->get_min_width();
+    {
+        if (direction == NodeLayoutDirection::horizontal)
+            size += node->get_min_width();
+        else
+            size = std::max(size, node->get_min_width());
+    }
     return size;
 }
 
@@ -468,10 +485,47 @@ size_t ParentNode::get_min_height() const
 {
     size_t size = 0;
     for (auto const& node : sub_nodes)
-        size += node->get_min_height();
+    {
+        if (direction == NodeLayoutDirection::vertical)
+            size += node->get_min_height();
+        else
+            size = std::max(size, node->get_min_height());
+    }
     return size;
 }
 
+size_t ParentNode::get_max_width() const
+{
+    if (sub_nodes.empty())
+        return std::numeric_limits<int>::max();
+
+    size_t size = 0;
+    for (auto const& node : sub_nodes)
+    {
+        if (direction == NodeLayoutDirection::horizontal)
+            size += node->get_max_width();
+        else
+            size = std::max(size, node->get_max_width());
+    }
+    return std::min(size, static_cast<size_t>(std::numeric_limits<int>::max()));
+}
+
+size_t ParentNode::get_max_height() const
+{
+    if (sub_nodes.empty())
+        return std::numeric_limits<int>::max();
+
+    size_t size = 0;
+    for (auto const& node : sub_nodes)
+    {
+        if (direction == NodeLayoutDirection::vertical)
+            size += node->get_max_height();
+        else
+            size = std::max(size, node->get_max_height());
+    }
+    return std::min(size, static_cast<size_t>(std::numeric_limits<int>::max()));
+}
+
 void ParentNode::set_parent(std::shared_ptr<ParentNode> const& in_parent)
 {
     parent = in_parent;
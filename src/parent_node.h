@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_PARENT_NODE_H
 #define MIRACLEWM_PARENT_NODE_H
 
+#include "layout_description.h"
 #include "node.h"
 #include "node_common.h"
 #include "tiling_interface.h"
@@ -43,7 +44,14 @@ public:
     geom::Rectangle get_logical_area() const override;
     size_t num_nodes() const;
     std::shared_ptr<LeafNode> create_space_for_window(int index = -1);
-    std::shared_ptr<LeafNode> confirm_window(miral::Window const&);
+    std::shared_ptr<LeafNode> confirm_window(miral::Window const&, std::shared_ptr<WindowMetadata> const&);
+
+    /// Reserves a placeholder in this lane for the next window, in place of create_space_for_window.
+    void claim_placeholder(std::shared_ptr<LeafNode> const&);
+
+    /// Builds the described containers and placeholders at the end of this lane and lays
+    /// the lane out once. The caller is expected to commit the changes.
+    void append_layout(std::vector<LayoutDescription> const&);
     void graft_existing(std::shared_ptr<Node> const& node, int index);
     void convert_to_lane(std::shared_ptr<LeafNode> const&);
     void set_logical_area(geom::Rectangle const& target_rect) override;
@@ -61,6 +69,8 @@ public:
     void constrain() override;
     size_t get_min_width() const override;
     size_t get_min_height() const override;
+    size_t get_max_width() const override;
+    size_t get_max_height() const override;
     void set_parent(std::shared_ptr<ParentNode> const&) override;
 
 private:
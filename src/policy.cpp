@@ -20,16 +20,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIR_LOG_COMPONENT "miracle"
 
 #include "miracle_config.h"
+#include "miracle_log.h"
 #include "policy.h"
+#include "stacking_layer.h"
 #include "window_helpers.h"
 #include "workspace_manager.h"
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <limits>
 #include <mir/geometry/rectangle.h>
 #include <mir/log.h>
+#include <mir/main_loop.h>
+#include <mir/scene/surface.h>
 #include <mir/server.h>
+#include <mir/time/alarm.h>
 #include <mir_toolkit/events/enums.h>
+#include <miral/application.h>
 #include <miral/application_info.h>
 #include <miral/runner.h>
 #include <miral/toolkit_event.h>
@@ -41,6 +49,14 @@ using namespace miracle;
 namespace
 {
 const int MODIFIER_MASK = mir_input_event_modifier_alt | mir_input_event_modifier_shift | mir_input_event_modifier_sym | mir_input_event_modifier_ctrl | mir_input_event_modifier_meta;
+
+/// Pooled and scratchpad windows are shown and hidden by their own bookkeeping, so they are never suspended
+bool is_suspendable(WindowMetadata const& metadata)
+{
+    return metadata.get_type() == WindowType::tiled
+        || metadata.get_type() == WindowType::floating
+        || metadata.get_type() == WindowType::other;
+}
 }
 
 Policy::Policy(
@@ -49,6 +65,7 @@ Policy::Policy(
     miral::MirRunner& runner,
     std::shared_ptr<MiracleConfig> const& config,
     SurfaceTracker& surface_tracker,
+    RenderCostTracker& render_costs,
     mir::Server const& server) :
     window_manager_tools { tools },
     floating_window_manager(tools, config->get_input_event_modifier()),
@@ -62,22 +79,118 @@ Policy::Policy(
 { return get_active_output(); }) },
     i3_command_executor(*this, workspace_manager, tools),
     surface_tracker { surface_tracker },
-    ipc { std::make_shared<Ipc>(runner, workspace_manager, *this, server.the_main_loop(), i3_command_executor) },
+    render_costs { render_costs },
+    scheduler { server.the_main_loop() },
+    ipc { std::make_shared<Ipc>(runner, workspace_manager, *this, scheduler, i3_command_executor) },
     animator(server.the_main_loop(), config),
-    node_interface(tools, animator)
+    node_interface(tools, animator),
+    commit_rate_governor(tools, config),
+    terminal_pool([this]() -> std::optional<pid_t>
+{
+    auto const& terminal_command = this->config->get_terminal_command();
+    if (!terminal_command)
+        return std::nullopt;
+
+    auto const pid = this->external_client_launcher.launch({ terminal_command.value() });
+    if (pid <= 0)
+        return std::nullopt;
+    return pid;
+})
 {
     animator.start();
+    commit_rate_alarm = server.the_main_loop()->create_alarm([this]()
+    {
+        scheduler.post(TaskPriority::idle, [this]()
+        {
+            window_manager_tools.invoke_under_lock([this]()
+            {
+                commit_rate_governor.evaluate();
+            });
+        });
+        commit_rate_alarm->reschedule_in(std::chrono::seconds(1));
+    });
+    commit_rate_alarm->reschedule_in(std::chrono::seconds(1));
+    log_report_alarm = server.the_main_loop()->create_alarm([this]()
+    {
+        scheduler.post(TaskPriority::idle, &miracle::log::report_suppressed);
+        log_report_alarm->reschedule_in(std::chrono::seconds(10));
+    });
+    log_report_alarm->reschedule_in(std::chrono::seconds(10));
+    power_supply_alarm = server.the_main_loop()->create_alarm([this]()
+    {
+        scheduler.post(TaskPriority::idle, [this]() { poll_power_supply(); });
+        power_supply_alarm->reschedule_in(std::chrono::seconds(5));
+    });
+    poll_power_supply();
+    power_supply_alarm->reschedule_in(std::chrono::seconds(5));
+    terminal_pool.set_capacity(config->get_terminal_pool_size());
+    terminal_pool_command = config->get_terminal_command();
+    terminal_pool_config_handle = config->register_listener([this](auto&)
+    {
+        scheduler.post(TaskPriority::idle, [this]()
+        {
+            window_manager_tools.invoke_under_lock([this]()
+            {
+                update_terminal_pool_capacity();
+            });
+        });
+    },
+        5,
+        config_section_terminal);
+    surface_tracker.set_frame_request_handler([this]()
+    {
+        scheduler.post(TaskPriority::immediate, [this]()
+        {
+            window_manager_tools.invoke_under_lock([this]() { damage_requested_frames(); });
+        });
+    });
     workspace_observer_registrar.register_interest(ipc);
     WindowToolsAccessor::get_instance().set_tools(tools);
 }
 
 Policy::~Policy()
 {
+    surface_tracker.set_frame_request_handler({});
+    config->unregister_listener(terminal_pool_config_handle);
     workspace_observer_registrar.unregister_interest(*ipc);
 }
 
+void Policy::damage_requested_frames()
+{
+    // Mir composites again whenever a surface changes and offers no other way to ask for a frame.
+    // Setting the alpha again changes nothing but is reported to the scene as a change. This happens
+    // under the lock, so it cannot undo an alpha that the policy sets at the same time.
+    for (auto const& window : surface_tracker.take_frame_requests())
+    {
+        std::shared_ptr<mir::scene::Surface> const surface = window;
+        if (surface)
+            surface->set_alpha(surface->alpha());
+    }
+}
+
+void Policy::poll_power_supply()
+{
+    auto const path = config->get_power_supply_path();
+    if (!path)
+        return;
+
+    std::ifstream file(path.value());
+    std::string contents;
+    if (!file || !std::getline(file, contents))
+    {
+        MIRACLE_LOG_WARNING("Unable to read the power supply at %s", path->c_str());
+        return;
+    }
+
+    if (auto on_battery = PowerProfiles::parse_is_on_battery(contents))
+        config->set_on_battery(on_battery.value());
+    else
+        MIRACLE_LOG_WARNING("Unable to understand the power supply at %s: %s", path->c_str(), contents.c_str());
+}
+
 bool Policy::handle_keyboard_event(MirKeyboardEvent const* event)
 {
+    scheduler.advise_activity();
     auto const action = miral::toolkit::mir_keyboard_event_action(event);
     auto const scan_code = miral::toolkit::mir_keyboard_event_scan_code(event);
     auto const modifiers = miral::toolkit::mir_keyboard_event_modifiers(event) & MODIFIER_MASK;
@@ -97,6 +210,9 @@ bool Policy::handle_keyboard_event(MirKeyboardEvent const* event)
     {
     case Terminal:
     {
+        if (try_show_pooled_terminal())
+            return true;
+
         auto terminal_command = config->get_terminal_command();
         if (terminal_command)
             external_client_launcher.launch({ terminal_command.value() });
@@ -147,9 +263,15 @@ bool Policy::handle_keyboard_event(MirKeyboardEvent const* event)
             return true;
         return false;
     case QuitActiveWindow:
-        if (active_output)
+    {
+        // Scratchpad windows are outside of every output, which would close the window beneath instead
+        auto const active_window = window_manager_tools.active_window();
+        if (active_window && scratchpad.contains(window_helpers::get_container_id(active_window)))
+            window_manager_tools.ask_client_to_close(active_window);
+        else if (active_output)
             active_output->close_active_window();
         return true;
+    }
     case QuitCompositor:
         runner.stop();
         return true;
@@ -245,6 +367,13 @@ bool Policy::handle_keyboard_event(MirKeyboardEvent const* event)
         if (active_output)
             active_output->toggle_pinned_to_workspace();
         return true;
+    case MoveToScratchpad:
+        if (auto const active_window = window_manager_tools.active_window())
+            move_to_scratchpad(active_window);
+        return true;
+    case ToggleScratchpad:
+        toggle_scratchpad();
+        return true;
     default:
         std::cerr << "Unknown key_command: " << key_command << std::endl;
         break;
@@ -254,12 +383,15 @@ bool Policy::handle_keyboard_event(MirKeyboardEvent const* event)
 
 bool Policy::handle_pointer_event(MirPointerEvent const* event)
 {
+    scheduler.advise_activity();
     auto x = miral::toolkit::mir_pointer_event_axis_value(event, MirPointerAxis::mir_pointer_axis_x);
     auto y = miral::toolkit::mir_pointer_event_axis_value(event, MirPointerAxis::mir_pointer_axis_y);
 
-    for (auto const& output : output_list)
+    auto output_id = output_index.find_at(geom::Point(static_cast<int>(x), static_cast<int>(y)));
+    if (output_id)
     {
-        if (output->point_is_in_output(static_cast<int>(x), static_cast<int>(y)))
+        auto output = find_output(output_id.value());
+        if (output)
         {
             if (active_output != output)
             {
@@ -274,7 +406,6 @@ bool Policy::handle_pointer_event(MirPointerEvent const* event)
             {
                 active_output->select_window_from_point(static_cast<int>(x), static_cast<int>(y));
             }
-            break;
         }
     }
 
@@ -288,6 +419,17 @@ auto Policy::place_new_window(
     const miral::ApplicationInfo& app_info,
     const miral::WindowSpecification& requested_specification) -> miral::WindowSpecification
 {
+    scheduler.advise_activity();
+    if (terminal_pool.is_pending(miral::pid_of(app_info.application())))
+    {
+        // The first window of a pool terminal stays hidden until the terminal key claims it
+        auto new_spec = requested_specification;
+        new_spec.state() = mir_window_state_hidden;
+        pending_output.reset();
+        pending_type = WindowType::pooled;
+        return new_spec;
+    }
+
     if (!active_output)
     {
         mir::log_warning("place_new_window: no output available");
@@ -302,6 +444,14 @@ auto Policy::place_new_window(
 
 void Policy::advise_new_window(miral::WindowInfo const& window_info)
 {
+    MIRACLE_LOG_DEBUG("New window from %s", window_info.application_id().c_str());
+    if (pending_type == WindowType::pooled)
+    {
+        pending_type = WindowType::none;
+        advise_new_pooled_terminal(window_info);
+        return;
+    }
+
     auto shared_output = pending_output.lock();
     if (!shared_output)
     {
@@ -328,15 +478,237 @@ void Policy::advise_new_window(miral::WindowInfo const& window_info)
     }
 
     auto metadata = shared_output->advise_new_window(window_info, pending_type);
+    pending_type = WindowType::none;
+    pending_output.reset();
+    track_window(metadata);
+}
+
+void Policy::track_window(std::shared_ptr<WindowMetadata> const& metadata)
+{
+    auto const& window = metadata->get_window();
+    auto const& window_info = window_manager_tools.info_for(window);
 
     // Associate to an animation handle
     metadata->set_animation_handle(animator.register_animateable());
-    node_interface.open(window_info.window());
+    node_interface.open(metadata);
 
-    pending_type = WindowType::none;
-    pending_output.reset();
+    surface_tracker.add(window);
+    commit_rate_governor.add(window);
+    window_search_index.update(
+        window_helpers::get_container_id(window),
+        window_info.name(),
+        window_info.application_id());
+
+    if (is_behind_fullscreen_window(metadata))
+        set_suspended(metadata, true);
+}
+
+void Policy::advise_new_pooled_terminal(miral::WindowInfo const& window_info)
+{
+    auto const pid = miral::pid_of(window_info.window().application());
+    auto metadata = std::make_shared<WindowMetadata>(WindowType::pooled, window_info.window());
+    miral::WindowSpecification spec;
+    spec.userdata() = metadata;
+    window_manager_tools.modify_window(window_info.window(), spec);
+
+    terminal_pool.advise_ready(pid);
+    pooled_terminals.emplace(pid, window_info.window());
+}
+
+bool Policy::try_show_pooled_terminal()
+{
+    if (!active_output || active_output->get_active_workspace_num() < 0)
+        return false;
+
+    while (auto pid = terminal_pool.take())
+    {
+        auto it = pooled_terminals.find(pid.value());
+        if (it == pooled_terminals.end())
+            continue;
+
+        auto window = it->second;
+        pooled_terminals.erase(it);
+
+        // The window must be restored before it can be given a tile
+        miral::WindowSpecification spec;
+        spec.state() = mir_window_state_restored;
+        window_manager_tools.modify_window(window, spec);
+        active_output->add_immediately(window);
+
+        auto metadata = window_helpers::get_metadata(window, window_manager_tools);
+        if (metadata)
+            track_window(metadata);
+        window_manager_tools.select_active_window(window);
+        schedule_terminal_pool_fill();
+        return true;
+    }
+
+    schedule_terminal_pool_fill();
+    return false;
+}
+
+void Policy::update_terminal_pool_capacity()
+{
+    for (auto const pid : terminal_pool.set_capacity(config->get_terminal_pool_size()))
+    {
+        auto it = pooled_terminals.find(pid);
+        if (it == pooled_terminals.end())
+            continue;
+
+        window_manager_tools.ask_client_to_close(it->second);
+        pooled_terminals.erase(it);
+    }
+
+    if (config->get_terminal_command() != terminal_pool_command)
+    {
+        terminal_pool_command = config->get_terminal_command();
+        terminal_pool.enable();
+    }
+
+    terminal_pool.fill();
+}
+
+void Policy::schedule_terminal_pool_fill()
+{
+    if (terminal_pool.get_capacity() == 0 || terminal_pool.is_disabled())
+        return;
+
+    scheduler.post(TaskPriority::idle, [this]()
+    {
+        window_manager_tools.invoke_under_lock([this]()
+        {
+            terminal_pool.fill();
+        });
+    });
+}
+
+bool Policy::move_to_scratchpad(miral::Window const& window)
+{
+    auto metadata = window_helpers::get_metadata(window, window_manager_tools);
+    if (!metadata)
+    {
+        mir::log_error("move_to_scratchpad: metadata is not provided");
+        return false;
+    }
+
+    if (metadata->get_type() != WindowType::tiled && metadata->get_type() != WindowType::floating)
+    {
+        MIRACLE_LOG_WARNING("Cannot move window of type %d to the scratchpad", static_cast<int>(metadata->get_type()));
+        return false;
+    }
+
+    if (window_helpers::is_window_fullscreen(window_manager_tools.info_for(window).state()))
+    {
+        MIRACLE_LOG_WARNING("Unmaximize the window to move it to the scratchpad");
+        return false;
+    }
+
+    // This is the only time that the window leaves a workspace. Showing and hiding it never touches one.
+    if (metadata->get_output())
+        metadata->get_output()->advise_delete_window(metadata);
+
+    auto scratchpad_metadata = std::make_shared<WindowMetadata>(WindowType::scratchpad, window);
+    scratchpad_metadata->set_animation_handle(metadata->get_animation_handle());
+    scratchpad_metadata->set_blur_choice(metadata->get_blur_choice());
+    if (auto const opacity = metadata->get_opacity())
+        scratchpad_metadata->set_opacity(opacity.value());
+
+    miral::WindowSpecification spec;
+    spec.userdata() = scratchpad_metadata;
+    window_manager_tools.modify_window(window, spec);
+    window_helpers::set_layer(window, StackingLayer::floating, window_manager_tools);
+
+    auto const id = window_helpers::get_container_id(window);
+    scratchpad.add(id);
+    scratchpad_windows.emplace(id, window);
+    set_scratchpad_window_shown(window, false);
+    focus_instead_of_scratchpad_window(window);
+    MIRACLE_LOG_DEBUG("Moved window of %s to the scratchpad", window_manager_tools.info_for(window).application_id().c_str());
+    return true;
+}
+
+bool Policy::toggle_scratchpad()
+{
+    std::optional<Scratchpad::Id> focused;
+    if (auto const active_window = window_manager_tools.active_window())
+        focused = window_helpers::get_container_id(active_window);
+
+    auto const toggle = scratchpad.toggle(focused);
+    auto const it = scratchpad_windows.find(toggle.id);
+    if (toggle.action == Scratchpad::Toggle::Action::none || it == scratchpad_windows.end())
+        return false;
+
+    auto const window = it->second;
+    switch (toggle.action)
+    {
+    case Scratchpad::Toggle::Action::show:
+        if (active_output)
+        {
+            // A window that is already on the active output keeps its place, so that showing it
+            // is only a change of visibility. Otherwise it is moved, which does not resize it.
+            auto const& area = active_output->get_area();
+            window_manager_tools.info_for(window).clip_area(area);
+            if (!area.contains(geom::Rectangle { window.top_left(), window.size() }))
+            {
+                miral::WindowSpecification spec;
+                spec.top_left() = geom::Point {
+                    area.top_left.x.as_int() + (area.size.width.as_int() - window.size().width.as_int()) / 2,
+                    area.top_left.y.as_int() + (area.size.height.as_int() - window.size().height.as_int()) / 2
+                };
+                window_manager_tools.modify_window(window, spec);
+            }
+        }
+
+        set_scratchpad_window_shown(window, true);
+        window_manager_tools.raise_tree(window);
+        window_manager_tools.select_active_window(window);
+        break;
+    case Scratchpad::Toggle::Action::focus:
+        window_manager_tools.raise_tree(window);
+        window_manager_tools.select_active_window(window);
+        break;
+    case Scratchpad::Toggle::Action::hide:
+        set_scratchpad_window_shown(window, false);
+        focus_instead_of_scratchpad_window(window);
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+void Policy::set_scratchpad_window_shown(miral::Window const& window, bool shown)
+{
+    std::shared_ptr<mir::scene::Surface> const surface = window;
+    if (!surface)
+        return;
 
-    surface_tracker.add(window_info.window());
+    if (shown)
+        surface->show();
+    else
+        surface->hide();
+}
+
+void Policy::focus_instead_of_scratchpad_window(miral::Window const& window)
+{
+    if (window_manager_tools.active_window() != window)
+        return;
+
+    miral::Window next;
+    if (active_output)
+    {
+        next = active_output->get_active_window();
+        if (!next || scratchpad.contains(window_helpers::get_container_id(next)))
+        {
+            next = active_output->find_window_on_active_workspace_matching_predicate([](miral::Window const&)
+            {
+                return true;
+            });
+        }
+    }
+
+    window_manager_tools.select_active_window(next);
 }
 
 void Policy::handle_window_ready(miral::WindowInfo& window_info)
@@ -354,6 +726,8 @@ void Policy::handle_window_ready(miral::WindowInfo& window_info)
 
 void Policy::advise_focus_gained(const miral::WindowInfo& window_info)
 {
+    MIRACLE_LOG_DEBUG("Window of %s gained focus", window_info.application_id().c_str());
+    scheduler.advise_activity();
     auto metadata = window_helpers::get_metadata(window_info);
     if (!metadata)
     {
@@ -361,6 +735,21 @@ void Policy::advise_focus_gained(const miral::WindowInfo& window_info)
         return;
     }
 
+    if (metadata->get_type() == WindowType::scratchpad
+        && !scratchpad.is_shown(window_helpers::get_container_id(window_info.window())))
+    {
+        // Only the surface of a hidden scratchpad window is hidden, so Mir may still hand it focus
+        auto window = window_info.window();
+        scheduler.post(TaskPriority::immediate, [this, window]()
+        {
+            window_manager_tools.invoke_under_lock([this, &window]()
+            {
+                focus_instead_of_scratchpad_window(window);
+            });
+        });
+        return;
+    }
+
     if (metadata->get_output())
         metadata->get_output()->advise_focus_gained(metadata);
     else
@@ -382,6 +771,8 @@ void Policy::advise_focus_lost(const miral::WindowInfo& window_info)
 
 void Policy::advise_delete_window(const miral::WindowInfo& window_info)
 {
+    MIRACLE_LOG_DEBUG("Window of %s was deleted", window_info.application_id().c_str());
+    scheduler.advise_activity();
     for (auto it = orphaned_window_list.begin(); it != orphaned_window_list.end();)
     {
         if (*it == window_info.window())
@@ -400,10 +791,24 @@ void Policy::advise_delete_window(const miral::WindowInfo& window_info)
         return;
     }
 
+    if (metadata->get_type() == WindowType::pooled)
+    {
+        auto const pid = miral::pid_of(window_info.window().application());
+        terminal_pool.remove(pid);
+        pooled_terminals.erase(pid);
+        return;
+    }
+
+    auto const id = window_helpers::get_container_id(window_info.window());
+    if (scratchpad.remove(id))
+        scratchpad_windows.erase(id);
+
     if (metadata->get_output())
         metadata->get_output()->advise_delete_window(metadata);
 
     surface_tracker.remove(window_info.window());
+    commit_rate_governor.remove(window_info.window());
+    window_search_index.remove(window_helpers::get_container_id(window_info.window()));
 }
 
 void Policy::advise_move_to(miral::WindowInfo const& window_info, geom::Point top_left)
@@ -426,6 +831,8 @@ void Policy::advise_output_create(miral::Output const& output)
         floating_window_manager, config, node_interface, animator);
     workspace_manager.request_first_available_workspace(new_tree);
     output_list.push_back(new_tree);
+    output_by_id[output.id()] = new_tree;
+    output_index.insert(output.id(), output.extents());
     if (active_output == nullptr)
         active_output = new_tree;
 
@@ -438,18 +845,21 @@ void Policy::advise_output_create(miral::Output const& output)
         }
         orphaned_window_list.clear();
     }
+
+    schedule_terminal_pool_fill();
 }
 
 void Policy::advise_output_update(miral::Output const& updated, miral::Output const& original)
 {
-    for (auto& output : output_list)
+    auto output = find_output(original.id());
+    if (!output)
     {
-        if (output->get_output().is_same_output(original))
-        {
-            output->update_area(updated.extents());
-            break;
-        }
+        mir::log_warning("advise_output_update: unknown output %d", original.id());
+        return;
     }
+
+    output_index.update(original.id(), updated.extents());
+    output->update_area(updated.extents());
 }
 
 void Policy::advise_output_delete(miral::Output const& output)
@@ -460,6 +870,8 @@ void Policy::advise_output_delete(miral::Output const& output)
         if (other_output->get_output().is_same_output(output))
         {
             output_list.erase(it);
+            output_by_id.erase(other_output->get_output().id());
+            output_index.erase(other_output->get_output().id());
             if (output_list.empty())
             {
                 // All nodes should become orphaned
@@ -490,6 +902,7 @@ void Policy::handle_modify_window(
     miral::WindowInfo& window_info,
     const miral::WindowSpecification& modifications)
 {
+    scheduler.advise_activity();
     auto metadata = window_helpers::get_metadata(window_info);
     if (!metadata)
     {
@@ -497,10 +910,28 @@ void Policy::handle_modify_window(
         return;
     }
 
+    if (metadata->get_type() == WindowType::pooled)
+    {
+        // A pool terminal stays hidden until it is claimed, whatever state it asks for
+        auto hidden_modifications = modifications;
+        if (hidden_modifications.state().is_set())
+            hidden_modifications.state() = mir_window_state_hidden;
+        window_manager_tools.modify_window(metadata->get_window(), hidden_modifications);
+        return;
+    }
+
     if (metadata->get_output())
         metadata->get_output()->handle_modify_window(metadata, modifications);
     else
         window_manager_tools.modify_window(metadata->get_window(), modifications);
+
+    if (modifications.name().is_set() || modifications.application_id().is_set())
+    {
+        window_search_index.update(
+            window_helpers::get_container_id(window_info.window()),
+            modifications.name().is_set() ? modifications.name().value() : window_info.name(),
+            modifications.application_id().is_set() ? modifications.application_id().value() : window_info.application_id());
+    }
 }
 
 void Policy::handle_raise_window(miral::WindowInfo& window_info)
@@ -537,7 +968,58 @@ Policy::confirm_placement_on_display(
 
 bool Policy::handle_touch_event(const MirTouchEvent* event)
 {
-    return false;
+    scheduler.advise_activity();
+
+    auto const count = miral::toolkit::mir_touch_event_point_count(event);
+    std::vector<TouchPoint> points;
+    points.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        points.push_back({ miral::toolkit::mir_touch_event_id(event, i),
+            miral::toolkit::mir_touch_event_action(event, i) == mir_touch_action_up,
+            miral::toolkit::mir_touch_event_axis_value(event, i, mir_touch_axis_x),
+            miral::toolkit::mir_touch_event_axis_value(event, i, mir_touch_axis_y) });
+    }
+
+    auto const time = std::chrono::nanoseconds(miral::toolkit::mir_input_event_get_event_time(
+        miral::toolkit::mir_touch_event_input_event(event)));
+    auto const update = swipe_tracker.handle(points, time);
+    switch (update.type)
+    {
+    case SwipeGestureTracker::Update::Type::begin:
+    {
+        // The swipe drives the workspaces of the output that the fingers landed on
+        float x = 0, y = 0;
+        for (auto const& point : points)
+        {
+            x += point.x / points.size();
+            y += point.y / points.size();
+        }
+
+        auto output_id = output_index.find_at(geom::Point(static_cast<int>(x), static_cast<int>(y)));
+        auto output = output_id ? find_output(output_id.value()) : nullptr;
+        swipe_output = output ? output : active_output;
+        [[fallthrough]];
+    }
+    case SwipeGestureTracker::Update::Type::move:
+        if (auto output = swipe_output.lock())
+            output->update_workspace_swipe(update.offset);
+        break;
+    case SwipeGestureTracker::Update::Type::end:
+        if (auto output = swipe_output.lock())
+            output->end_workspace_swipe(update.offset, update.velocity);
+        swipe_output.reset();
+        break;
+    case SwipeGestureTracker::Update::Type::cancel:
+        if (auto output = swipe_output.lock())
+            output->cancel_workspace_swipe(update.offset);
+        swipe_output.reset();
+        break;
+    default:
+        break;
+    }
+
+    return update.consumed;
 }
 
 void Policy::handle_request_move(miral::WindowInfo& window_info, const MirInputEvent* input_event)
@@ -578,24 +1060,140 @@ mir::geometry::Rectangle Policy::confirm_inherited_move(
 
 void Policy::advise_application_zone_create(miral::Zone const& application_zone)
 {
-    for (auto const& output : output_list)
-    {
+    for (auto const& output : outputs_affected_by(application_zone.extents()))
         output->advise_application_zone_create(application_zone);
-    }
 }
 
 void Policy::advise_application_zone_update(miral::Zone const& updated, miral::Zone const& original)
 {
-    for (auto const& output : output_list)
+    auto affected = outputs_affected_by(original.extents());
+    for (auto const& output : outputs_affected_by(updated.extents()))
     {
-        output->advise_application_zone_update(updated, original);
+        if (std::find(affected.begin(), affected.end(), output) == affected.end())
+            affected.push_back(output);
     }
+
+    for (auto const& output : affected)
+        output->advise_application_zone_update(updated, original);
 }
 
 void Policy::advise_application_zone_delete(miral::Zone const& application_zone)
 {
+    for (auto const& output : outputs_affected_by(application_zone.extents()))
+        output->advise_application_zone_delete(application_zone);
+}
+
+std::shared_ptr<OutputContent> Policy::find_output(int id) const
+{
+    auto it = output_by_id.find(id);
+    if (it == output_by_id.end())
+        return nullptr;
+
+    return it->second;
+}
+
+std::vector<std::shared_ptr<OutputContent>> Policy::outputs_affected_by(geom::Rectangle const& extents) const
+{
+    std::vector<std::shared_ptr<OutputContent>> result;
+    for (auto id : output_index.find_intersecting(extents))
+    {
+        auto output = find_output(id);
+        if (output)
+            result.push_back(output);
+    }
+    return result;
+}
+
+void Policy::advise_end()
+{
+    update_fullscreen_mode();
+}
+
+void Policy::update_fullscreen_mode()
+{
+    bool has_changes = false;
     for (auto const& output : output_list)
     {
-        output->advise_application_zone_delete(application_zone);
+        auto const fullscreen_window = output->find_fullscreen_window();
+        if (fullscreen_window == output->get_fullscreen_window())
+            continue;
+
+        output->set_fullscreen_window(fullscreen_window);
+        has_changes = true;
+    }
+
+    if (!has_changes)
+        return;
+
+    // Windows may have moved between outputs since they were suspended, so everything is checked again.
+    // This includes the dialogs and menus that are not in any workspace.
+    window_manager_tools.for_each_application([&](miral::ApplicationInfo& info)
+    {
+        for (auto const& window : info.windows())
+        {
+            auto metadata = window_helpers::get_metadata(window, window_manager_tools);
+            if (metadata && is_suspendable(*metadata))
+                set_suspended(metadata, is_behind_fullscreen_window(metadata));
+        }
+    });
+}
+
+bool Policy::is_behind_fullscreen_window(std::shared_ptr<WindowMetadata> const& metadata)
+{
+    if (!is_suspendable(*metadata))
+        return false;
+
+    // Overlay surfaces are drawn above fullscreen windows, while panels in the fullscreen layer are hidden
+    auto const& info = window_manager_tools.info_for(metadata->get_window());
+    if (info.depth_layer() > to_depth_layer(StackingLayer::fullscreen))
+        return false;
+
+    // Dialogs and menus are not in a workspace, so they are on the output of the window that they belong to
+    auto const& window = metadata->get_window();
+    OutputContent* output = nullptr;
+    for (auto ancestor = window; ancestor && !output; ancestor = window_manager_tools.info_for(ancestor).parent())
+    {
+        if (auto ancestor_metadata = window_helpers::get_metadata(ancestor, window_manager_tools))
+            output = ancestor_metadata->get_output();
     }
+
+    std::shared_ptr<OutputContent> found_output;
+    if (!output)
+    {
+        if (auto const output_id = output_index.find_at(window.top_left()))
+            found_output = find_output(output_id.value());
+        output = found_output.get();
+    }
+
+    if (!output || !output->get_fullscreen_window())
+        return false;
+
+    // The fullscreen window's own dialogs and menus are drawn above it
+    for (auto ancestor = window; ancestor; ancestor = window_manager_tools.info_for(ancestor).parent())
+    {
+        if (ancestor == output->get_fullscreen_window())
+            return false;
+    }
+
+    return true;
+}
+
+void Policy::set_suspended(std::shared_ptr<WindowMetadata> const& metadata, bool suspended)
+{
+    if (!metadata)
+        return;
+
+    metadata->set_is_suspended(suspended);
+
+    // Mir does not composite a hidden surface, so it tells the client that it is occluded. Windows
+    // in hidden workspaces are left to miral, which shows them again with their workspace, and they
+    // are checked again once their workspace has been shown.
+    std::shared_ptr<mir::scene::Surface> const surface = metadata->get_window();
+    if (!surface || window_manager_tools.info_for(metadata->get_window()).state() == mir_window_state_hidden)
+        return;
+
+    if (suspended)
+        surface->hide();
+    else
+        surface->show();
 }
@@ -19,13 +19,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIRACLE_POLICY_H
 
 #include "animator.h"
+#include "commit_rate_governor.h"
 #include "i3_command_executor.h"
 #include "ipc.h"
 #include "miracle_config.h"
 #include "output_content.h"
+#include "output_index.h"
+#include "render_cost_tracker.h"
+#include "scheduler.h"
+#include "scratchpad.h"
 #include "surface_tracker.h"
+#include "swipe_gesture.h"
+#include "terminal_pool.h"
 #include "window_manager_tools_tiling_interface.h"
 #include "window_metadata.h"
+#include "window_search_index.h"
 #include "workspace_manager.h"
 
 #include <memory>
@@ -35,6 +43,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <miral/output.h>
 #include <miral/window_management_policy.h>
 #include <miral/window_manager_tools.h>
+#include <unordered_map>
 #include <vector>
 
 namespace miral
@@ -42,6 +51,11 @@ namespace miral
 class MirRunner;
 }
 
+namespace mir::time
+{
+class Alarm;
+}
+
 namespace miracle
 {
 
@@ -54,6 +68,7 @@ public:
         miral::MirRunner&,
         std::shared_ptr<MiracleConfig> const&,
         SurfaceTracker&,
+        RenderCostTracker&,
         mir::Server const&);
     ~Policy() override;
 
@@ -96,13 +111,28 @@ public:
     void advise_application_zone_create(miral::Zone const& application_zone) override;
     void advise_application_zone_update(miral::Zone const& updated, miral::Zone const& original) override;
     void advise_application_zone_delete(miral::Zone const& application_zone) override;
+    void advise_end() override;
 
     std::shared_ptr<OutputContent> const& get_active_output() { return active_output; }
     std::vector<std::shared_ptr<OutputContent>> const& get_output_list() { return output_list; }
+    CommitRateGovernor const& get_commit_rate_governor() const { return commit_rate_governor; }
+    std::shared_ptr<MiracleConfig> const& get_config() const { return config; }
+    WindowSearchIndex const& get_window_search_index() const { return window_search_index; }
+    RenderCostTracker& get_render_cost_tracker() { return render_costs; }
+
+    /// Takes the window out of its workspace and holds it hidden in the scratchpad
+    /// @returns false if the window cannot be moved to the scratchpad
+    bool move_to_scratchpad(miral::Window const& window);
+
+    /// Shows, focuses or hides a scratchpad window on the active output, as 'scratchpad show' does
+    /// @returns false if the scratchpad is empty
+    bool toggle_scratchpad();
 
 private:
     std::shared_ptr<OutputContent> active_output;
     std::vector<std::shared_ptr<OutputContent>> output_list;
+    std::unordered_map<int, std::shared_ptr<OutputContent>> output_by_id;
+    OutputIndex output_index;
     std::weak_ptr<OutputContent> pending_output;
     WindowType pending_type;
     std::vector<Window> orphaned_window_list;
@@ -113,11 +143,77 @@ private:
     std::shared_ptr<MiracleConfig> config;
     WorkspaceObserverRegistrar workspace_observer_registrar;
     WorkspaceManager workspace_manager;
+    Scheduler scheduler;
     std::shared_ptr<Ipc> ipc;
     Animator animator;
     WindowManagerToolsTilingInterface node_interface;
     I3CommandExecutor i3_command_executor;
     SurfaceTracker& surface_tracker;
+    RenderCostTracker& render_costs;
+    CommitRateGovernor commit_rate_governor;
+    std::unique_ptr<mir::time::Alarm> commit_rate_alarm;
+    std::unique_ptr<mir::time::Alarm> log_report_alarm;
+    std::unique_ptr<mir::time::Alarm> power_supply_alarm;
+    SwipeGestureTracker swipe_tracker;
+    WindowSearchIndex window_search_index;
+    TerminalPool terminal_pool;
+    int terminal_pool_config_handle = 0;
+
+    /// The command that the pool launches, so that a disabled pool is enabled again when it changes
+    std::optional<std::string> terminal_pool_command;
+
+    /// Hidden pool terminals by the pid that launched them
+    std::unordered_map<pid_t, miral::Window> pooled_terminals;
+
+    Scratchpad scratchpad;
+
+    /// Windows in the scratchpad by their container id
+    std::unordered_map<Scratchpad::Id, miral::Window> scratchpad_windows;
+
+    /// The output whose workspaces follow the current swipe
+    std::weak_ptr<OutputContent> swipe_output;
+
+    std::shared_ptr<OutputContent> find_output(int id) const;
+
+    /// Registers a window that has just been placed on an output with everything that follows it
+    void track_window(std::shared_ptr<WindowMetadata> const& metadata);
+
+    /// Holds the first window of a pool terminal hidden and outside of any workspace
+    void advise_new_pooled_terminal(miral::WindowInfo const& window_info);
+
+    /// Tiles a hidden pool terminal on the active workspace and focuses it
+    /// @returns false if no pool terminal is ready
+    bool try_show_pooled_terminal();
+
+    /// Resizes the pool to the configured size, closing any terminals that no longer fit
+    void update_terminal_pool_capacity();
+
+    /// Tops the pool up once the main loop is quiet, so that launching never delays input
+    void schedule_terminal_pool_fill();
+
+    /// Shows or hides a scratchpad window on the surface alone, so that the client is not reconfigured
+    void set_scratchpad_window_shown(miral::Window const& window, bool shown);
+
+    /// Moves focus off a scratchpad window that is no longer shown
+    void focus_instead_of_scratchpad_window(miral::Window const& window);
+
+    /// Reads the configured power supply and tells the configuration whether we are on battery
+    void poll_power_supply();
+
+    /// Damages the surfaces that the renderer asked to draw again
+    void damage_requested_frames();
+
+    /// Suspends everything behind a fullscreen window on each output, and resumes it
+    /// once the output no longer has a fullscreen window
+    void update_fullscreen_mode();
+
+    /// Whether the window is covered by the fullscreen window of its output. The fullscreen
+    /// window's own transient windows, such as its dialogs and menus, are never covered.
+    bool is_behind_fullscreen_window(std::shared_ptr<WindowMetadata> const& metadata);
+    void set_suspended(std::shared_ptr<WindowMetadata> const& metadata, bool suspended);
+
+    /// Collects the outputs that may be affected by a change to the provided zone
+    std::vector<std::shared_ptr<OutputContent>> outputs_affected_by(geom::Rectangle const& extents) const;
 };
 }
 
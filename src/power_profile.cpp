@@ -0,0 +1,188 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "power_profile"
+
+#include "power_profile.h"
+#include <algorithm>
+#include <mir/log.h>
+
+using namespace miracle;
+
+PowerProfiles::PowerProfiles() :
+    profiles { built_in_profiles() }
+{
+}
+
+std::map<std::string, PowerProfile> PowerProfiles::built_in_profiles()
+{
+    PowerProfile low_power_profile {
+        .name = low_power,
+        .animations = false,
+        .animation_frame_rate = 30,
+        .blur = false,
+        .client_commit_rate_scale = 0.5
+    };
+
+    // Blending and resampling cost CPU time on every pixel when rendering in software
+    PowerProfile software_profile {
+        .name = software,
+        .animation_frame_rate = 30,
+        .simple_animations = true,
+        .blur = false
+    };
+
+    return {
+        { balanced,  PowerProfile { .name = balanced } },
+        { low_power, low_power_profile                 },
+        { software,  software_profile                  }
+    };
+}
+
+void PowerProfiles::configure(
+    std::vector<PowerProfile> const& configured_profiles,
+    std::string const& configured_default,
+    std::optional<std::string> const& configured_battery,
+    std::map<std::string, std::string> const& output_profiles,
+    std::string const& configured_software)
+{
+    profiles = built_in_profiles();
+    for (auto const& profile : configured_profiles)
+        profiles[profile.name] = profile;
+
+    default_profile = balanced;
+    if (contains(configured_default))
+        default_profile = configured_default;
+    else
+        mir::log_error("power: unknown profile '%s'", configured_default.c_str());
+
+    battery_profile.reset();
+    if (configured_battery && contains(configured_battery.value()))
+        battery_profile = configured_battery;
+    else if (configured_battery)
+        mir::log_error("power: unknown battery profile '%s'", configured_battery->c_str());
+
+    software_profile = software;
+    if (contains(configured_software))
+        software_profile = configured_software;
+    else
+        mir::log_error("power: unknown software profile '%s'", configured_software.c_str());
+
+    configured_output_profiles.clear();
+    for (auto const& [output_name, profile] : output_profiles)
+    {
+        if (contains(profile))
+            configured_output_profiles[output_name] = profile;
+        else
+            mir::log_error("power: unknown profile '%s' for output %s", profile.c_str(), output_name.c_str());
+    }
+
+    // Runtime choices that refer to profiles which no longer exist fall back to the configuration
+    if (selected_profile && !contains(selected_profile.value()))
+        selected_profile.reset();
+    std::erase_if(selected_output_profiles, [&](auto const& entry) { return !contains(entry.second); });
+}
+
+bool PowerProfiles::contains(std::string const& name) const
+{
+    return profiles.contains(name);
+}
+
+bool PowerProfiles::select(std::string const& name, std::optional<std::string> const& output_name)
+{
+    if (name == automatic)
+    {
+        if (output_name)
+            selected_output_profiles.erase(output_name.value());
+        else
+            selected_profile.reset();
+        return true;
+    }
+
+    if (!contains(name))
+        return false;
+
+    if (output_name)
+        selected_output_profiles[output_name.value()] = name;
+    else
+        selected_profile = name;
+    return true;
+}
+
+bool PowerProfiles::set_on_battery(bool next)
+{
+    if (on_battery == next)
+        return false;
+
+    on_battery = next;
+    return true;
+}
+
+bool PowerProfiles::set_software_rendering(bool next)
+{
+    if (software_rendering == next)
+        return false;
+
+    software_rendering = next;
+    return true;
+}
+
+PowerProfile const& PowerProfiles::resolve(std::string const& output_name) const
+{
+    if (!output_name.empty())
+    {
+        if (auto it = selected_output_profiles.find(output_name); it != selected_output_profiles.end())
+            return find(it->second);
+    }
+
+    if (selected_profile)
+        return find(selected_profile.value());
+
+    if (!output_name.empty())
+    {
+        if (auto it = configured_output_profiles.find(output_name); it != configured_output_profiles.end())
+            return find(it->second);
+    }
+
+    // Rendering in software is a constraint of the machine, so it wins over the battery
+    if (software_rendering)
+        return find(software_profile);
+
+    if (on_battery && battery_profile)
+        return find(battery_profile.value());
+
+    return find(default_profile);
+}
+
+PowerProfile const& PowerProfiles::find(std::string const& name) const
+{
+    if (auto it = profiles.find(name); it != profiles.end())
+        return it->second;
+
+    return profiles.at(balanced);
+}
+
+std::optional<bool> PowerProfiles::parse_is_on_battery(std::string const& contents)
+{
+    auto const end = contents.find_last_not_of(" \n\t");
+    auto const value = end == std::string::npos ? "" : contents.substr(0, end + 1);
+    if (value == "0" || value == "Discharging")
+        return true;
+    if (value == "1" || value == "Charging" || value == "Full" || value == "Not charging")
+        return false;
+    return std::nullopt;
+}
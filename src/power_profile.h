@@ -0,0 +1,118 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_POWER_PROFILE_H
+#define MIRACLEWM_POWER_PROFILE_H
+
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace miracle
+{
+
+/// A named bundle of settings that trade visual polish for power.
+struct PowerProfile
+{
+    std::string name;
+
+    /// Whether windows and workspaces animate at all
+    bool animations = true;
+
+    /// Multiplies the duration of every animation
+    float animation_duration_scale = 1.f;
+
+    /// The most times per second that the animator publishes a frame
+    int animation_frame_rate = 60;
+
+    /// Whether animations only move windows. Animations that would scale a window are skipped,
+    /// so that no frame has to resample a window at another size.
+    bool simple_animations = false;
+
+    /// Whether window borders, rounded corners and shadows are drawn
+    bool borders = true;
+
+    /// Whether windows may blur the content beneath them
+    bool blur = true;
+
+    /// How fast a client may commit, relative to the refresh rate of its output, before it is reported
+    double client_commit_rate_scale = 1.0;
+};
+
+/// Holds the available power profiles and resolves which one applies to the compositor
+/// as a whole or to a single output. A profile selected at runtime wins over the configured
+/// choice, and a profile selected for an output wins over the global one.
+class PowerProfiles
+{
+public:
+    PowerProfiles();
+
+    /// Replaces the configured profiles and choices. The built in profiles stay available
+    /// unless a configured profile shares their name.
+    void configure(
+        std::vector<PowerProfile> const& profiles,
+        std::string const& default_profile,
+        std::optional<std::string> const& battery_profile,
+        std::map<std::string, std::string> const& output_profiles,
+        std::string const& software_profile = software);
+
+    [[nodiscard]] bool contains(std::string const& name) const;
+
+    /// Selects the profile for the whole compositor, or for a single output. Selecting
+    /// "auto" returns to the configured choice.
+    /// @returns false if there is no profile with that name
+    bool select(std::string const& name, std::optional<std::string> const& output_name = std::nullopt);
+
+    /// @returns true if the profiles that apply may have changed
+    bool set_on_battery(bool on_battery);
+
+    /// Advises us that the compositor renders with a driver that rasterizes on the CPU
+    /// @returns true if the profiles that apply may have changed
+    bool set_software_rendering(bool software_rendering);
+
+    /// The profile that applies to the output, or to the compositor as a whole when no output is given
+    [[nodiscard]] PowerProfile const& resolve(std::string const& output_name = "") const;
+
+    /// Reads the contents of a sysfs power supply attribute. Both the "online" attribute of a
+    /// mains supply and the "status" attribute of a battery are understood.
+    /// @returns std::nullopt if the contents could not be understood
+    static std::optional<bool> parse_is_on_battery(std::string const& contents);
+
+    static constexpr char const* balanced = "balanced";
+    static constexpr char const* low_power = "low-power";
+    static constexpr char const* software = "software";
+    static constexpr char const* automatic = "auto";
+
+private:
+    std::map<std::string, PowerProfile> profiles;
+    std::string default_profile = balanced;
+    std::optional<std::string> battery_profile;
+    std::string software_profile = software;
+    std::map<std::string, std::string> configured_output_profiles;
+    std::optional<std::string> selected_profile;
+    std::map<std::string, std::string> selected_output_profiles;
+    bool on_battery = false;
+    bool software_rendering = false;
+
+    static std::map<std::string, PowerProfile> built_in_profiles();
+    [[nodiscard]] PowerProfile const& find(std::string const& name) const;
+};
+
+}
+
+#endif // MIRACLEWM_POWER_PROFILE_H
@@ -0,0 +1,147 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "render_cost_timer"
+
+#include "render_cost_timer.h"
+
+#include <EGL/egl.h>
+#include <cstring>
+#include <mir/log.h>
+
+using namespace miracle;
+
+namespace
+{
+template <typename T>
+T load(char const* name)
+{
+    return reinterpret_cast<T>(eglGetProcAddress(name));
+}
+}
+
+RenderCostTimer::RenderCostTimer(RenderCostTracker& tracker) :
+    tracker { tracker }
+{
+    auto const extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    if (extensions && std::strstr(extensions, "GL_EXT_disjoint_timer_query"))
+    {
+        gen_queries = load<PFNGLGENQUERIESEXTPROC>("glGenQueriesEXT");
+        delete_queries = load<PFNGLDELETEQUERIESEXTPROC>("glDeleteQueriesEXT");
+        begin_query = load<PFNGLBEGINQUERYEXTPROC>("glBeginQueryEXT");
+        end_query = load<PFNGLENDQUERYEXTPROC>("glEndQueryEXT");
+        get_query_object_uiv = load<PFNGLGETQUERYOBJECTUIVEXTPROC>("glGetQueryObjectuivEXT");
+        get_query_object_ui64v = load<PFNGLGETQUERYOBJECTUI64VEXTPROC>("glGetQueryObjectui64vEXT");
+        if (gen_queries && delete_queries && begin_query && end_query && get_query_object_uiv && get_query_object_ui64v)
+            source = RenderCostSource::gpu_timer;
+    }
+
+    if (source == RenderCostSource::gpu_timer)
+        mir::log_info("Render costs are measured with GPU timer queries");
+    else
+        mir::log_info("GPU timer queries are unavailable, render costs are measured as CPU submit time");
+}
+
+RenderCostTimer::~RenderCostTimer()
+{
+    if (!all_queries.empty())
+        delete_queries(static_cast<GLsizei>(all_queries.size()), all_queries.data());
+}
+
+void RenderCostTimer::begin(std::string const& application_id, RenderCostPart part)
+{
+    active = Timing { application_id, part, 0, RenderCostTracker::Clock::now() };
+    if (source != RenderCostSource::gpu_timer)
+        return;
+
+    if (pending.size() >= max_pending_queries)
+    {
+        active.reset();
+        return;
+    }
+
+    if (free_queries.empty())
+    {
+        GLuint query = 0;
+        gen_queries(1, &query);
+        all_queries.push_back(query);
+        free_queries.push_back(query);
+    }
+
+    active->query = free_queries.back();
+    free_queries.pop_back();
+    begin_query(GL_TIME_ELAPSED_EXT, active->query);
+}
+
+void RenderCostTimer::end()
+{
+    if (!active)
+        return;
+
+    if (active->query)
+    {
+        end_query(GL_TIME_ELAPSED_EXT);
+        pending.push_back(std::move(active.value()));
+    }
+    else
+    {
+        tracker.record(
+            active->application_id,
+            active->part,
+            RenderCostTracker::Clock::now() - active->started,
+            RenderCostSource::cpu_submit);
+    }
+
+    active.reset();
+}
+
+void RenderCostTimer::collect()
+{
+    if (pending.empty())
+        return;
+
+    // Queries finish in the order that they were issued, so we stop at the first that has not
+    std::vector<std::pair<Timing, GLuint64>> finished;
+    while (!pending.empty())
+    {
+        GLuint available = GL_FALSE;
+        get_query_object_uiv(pending.front().query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        if (!available)
+            break;
+
+        GLuint64 elapsed = 0;
+        get_query_object_ui64v(pending.front().query, GL_QUERY_RESULT_EXT, &elapsed);
+        free_queries.push_back(pending.front().query);
+        finished.emplace_back(std::move(pending.front()), elapsed);
+        pending.pop_front();
+    }
+
+    // A disjoint event (e.g. a change of GPU clock) makes the results around it meaningless
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint)
+        return;
+
+    for (auto const& [timing, elapsed] : finished)
+    {
+        tracker.record(
+            timing.application_id,
+            timing.part,
+            std::chrono::nanoseconds(elapsed),
+            RenderCostSource::gpu_timer);
+    }
+}
@@ -0,0 +1,82 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_RENDER_COST_TIMER_H
+#define MIRACLEWM_RENDER_COST_TIMER_H
+
+#include "render_cost_tracker.h"
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace miracle
+{
+
+/// Measures the draws of the renderer for the RenderCostTracker. Draws are timed on the
+/// GPU with EXT_disjoint_timer_query where the driver supports it. Query results arrive a
+/// few frames late, so they are collected at the start of each frame. Without timer queries,
+/// the time that the CPU spent submitting the draw is recorded instead.
+///
+/// All methods must be called on the rendering thread with a current GL context.
+class RenderCostTimer
+{
+public:
+    explicit RenderCostTimer(RenderCostTracker& tracker);
+    ~RenderCostTimer();
+
+    /// Starts timing a draw. Timings do not nest, so end must be called before the next begin.
+    void begin(std::string const& application_id, RenderCostPart part);
+    void end();
+
+    /// Records the results of the queries that the GPU has finished
+    void collect();
+
+    [[nodiscard]] RenderCostSource get_source() const { return source; }
+
+    /// Draws are left untimed while this many queries are still waiting for the GPU
+    static constexpr std::size_t max_pending_queries = 1024;
+
+private:
+    struct Timing
+    {
+        std::string application_id;
+        RenderCostPart part;
+        GLuint query = 0;
+        RenderCostTracker::Clock::time_point started;
+    };
+
+    RenderCostTracker& tracker;
+    RenderCostSource source = RenderCostSource::cpu_submit;
+    PFNGLGENQUERIESEXTPROC gen_queries = nullptr;
+    PFNGLDELETEQUERIESEXTPROC delete_queries = nullptr;
+    PFNGLBEGINQUERYEXTPROC begin_query = nullptr;
+    PFNGLENDQUERYEXTPROC end_query = nullptr;
+    PFNGLGETQUERYOBJECTUIVEXTPROC get_query_object_uiv = nullptr;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_object_ui64v = nullptr;
+
+    std::optional<Timing> active;
+    std::deque<Timing> pending;
+    std::vector<GLuint> free_queries;
+    std::vector<GLuint> all_queries;
+};
+
+} // miracle
+
+#endif // MIRACLEWM_RENDER_COST_TIMER_H
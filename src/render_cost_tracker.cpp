@@ -0,0 +1,105 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "render_cost_tracker.h"
+
+#include <algorithm>
+
+using namespace miracle;
+
+void RenderCostTracker::set_enabled(bool in, Clock::time_point now)
+{
+    std::lock_guard lock(mutex);
+    if (in && !enabled)
+    {
+        costs.clear();
+        enabled_at = now;
+    }
+    enabled.store(in, std::memory_order_relaxed);
+}
+
+void RenderCostTracker::record(
+    std::string const& application_id,
+    RenderCostPart part,
+    std::chrono::nanoseconds time,
+    RenderCostSource source)
+{
+    if (!is_enabled())
+        return;
+
+    std::lock_guard lock(mutex);
+    auto& cost = costs[application_id];
+    cost.application_id = application_id;
+    cost.source = source;
+    switch (part)
+    {
+    case RenderCostPart::surface:
+        cost.draws++;
+        cost.surface_time += time;
+        cost.max_draw_time = std::max(cost.max_draw_time, time);
+        break;
+    case RenderCostPart::outline:
+        cost.outline_time += time;
+        break;
+    case RenderCostPart::blur:
+        cost.blur_time += time;
+        break;
+    }
+}
+
+void RenderCostTracker::record_blur(std::string const& application_id, bool updated)
+{
+    if (!is_enabled())
+        return;
+
+    std::lock_guard lock(mutex);
+    auto& cost = costs[application_id];
+    cost.application_id = application_id;
+    if (updated)
+        cost.blur_updates++;
+    else
+        cost.blur_reuses++;
+}
+
+std::vector<RenderCost> RenderCostTracker::ranked(std::size_t limit) const
+{
+    std::vector<RenderCost> result;
+    {
+        std::lock_guard lock(mutex);
+        result.reserve(costs.size());
+        for (auto const& [_, cost] : costs)
+            result.push_back(cost);
+    }
+
+    auto const count = std::min(limit, result.size());
+    std::partial_sort(result.begin(), result.begin() + count, result.end(), [](RenderCost const& a, RenderCost const& b)
+    {
+        if (a.total_time() != b.total_time())
+            return a.total_time() > b.total_time();
+        return a.application_id < b.application_id;
+    });
+    result.resize(count);
+    return result;
+}
+
+std::chrono::nanoseconds RenderCostTracker::get_elapsed(Clock::time_point now) const
+{
+    std::lock_guard lock(mutex);
+    if (!enabled)
+        return std::chrono::nanoseconds { 0 };
+    return now - enabled_at;
+}
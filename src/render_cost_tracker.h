@@ -0,0 +1,109 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_RENDER_COST_TRACKER_H
+#define MIRACLEWM_RENDER_COST_TRACKER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace miracle
+{
+
+/// How the cost of a draw was measured
+enum class RenderCostSource
+{
+    /// The time that the GPU spent on the draw, from a timer query
+    gpu_timer,
+
+    /// The time that the CPU spent submitting the draw, when timer queries are unavailable
+    cpu_submit
+};
+
+/// The part of a window that a draw belongs to
+enum class RenderCostPart
+{
+    surface,
+    outline,
+
+    /// Blurring the content beneath the window and drawing it
+    blur
+};
+
+/// The accumulated cost of drawing the windows of one application
+struct RenderCost
+{
+    std::string application_id;
+    RenderCostSource source = RenderCostSource::cpu_submit;
+    uint64_t draws = 0;
+    std::chrono::nanoseconds surface_time { 0 };
+    std::chrono::nanoseconds outline_time { 0 };
+    std::chrono::nanoseconds blur_time { 0 };
+
+    /// How often the content beneath the windows was blurred again, and how often
+    /// the previous blur could be drawn instead
+    uint64_t blur_updates = 0;
+    uint64_t blur_reuses = 0;
+
+    /// The most expensive single surface draw
+    std::chrono::nanoseconds max_draw_time { 0 };
+
+    [[nodiscard]] std::chrono::nanoseconds total_time() const { return surface_time + outline_time + blur_time; }
+};
+
+/// Attributes render time to applications while debug profiling is enabled. The renderers
+/// of every output record into one tracker from the compositor thread, while the IPC
+/// reads it from the main loop. Recording is a no-op while profiling is disabled.
+class RenderCostTracker
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Enabling profiling starts a fresh measurement
+    void set_enabled(bool enabled, Clock::time_point now = Clock::now());
+    [[nodiscard]] bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    void record(
+        std::string const& application_id,
+        RenderCostPart part,
+        std::chrono::nanoseconds time,
+        RenderCostSource source);
+
+    /// Records whether the blur beneath a window had to be computed again
+    void record_blur(std::string const& application_id, bool updated);
+
+    /// Lists the applications in order of decreasing total cost
+    [[nodiscard]] std::vector<RenderCost> ranked(std::size_t limit) const;
+
+    /// The time since profiling was enabled, or zero when it is disabled
+    [[nodiscard]] std::chrono::nanoseconds get_elapsed(Clock::time_point now = Clock::now()) const;
+
+private:
+    std::atomic<bool> enabled = false;
+    mutable std::mutex mutex;
+    Clock::time_point enabled_at;
+    std::unordered_map<std::string, RenderCost> costs;
+};
+
+} // miracle
+
+#endif // MIRACLEWM_RENDER_COST_TRACKER_H
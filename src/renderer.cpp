@@ -30,9 +30,18 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "mir/graphics/texture.h"
 #include "mir/log.h"
 #include "mir/renderer/gl/gl_surface.h"
+#include "mir/scene/surface.h"
+#include "blur_cache.h"
+#include "blur_renderer.h"
 #include "miracle_config.h"
+#include "output_content.h"
+#include "render_cost_timer.h"
 #include "renderer.h"
+#include "sdf_decoration.h"
+#include "software_rendering.h"
 #include "tessellation_helpers.h"
+#include "text_renderer.h"
+#include "window_helpers.h"
 #include "window_metadata.h"
 
 #define GLM_FORCE_RADIANS
@@ -40,8 +49,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <boost/throw_exception.hpp>
 #include <cmath>
+#include <limits>
 #include <mutex>
 #include <sstream>
 #include <stdexcept>
@@ -107,6 +118,16 @@ struct ProgramData
     GLint screen_to_gl_coords_uniform = -1;
     GLint alpha_uniform = -1;
     GLint outline_color_uniform = -1;
+    GLint half_size_uniform = -1;
+    GLint shape_centre_uniform = -1;
+    GLint radius_uniform = -1;
+    GLint border_width_uniform = -1;
+    GLint border_color_uniform = -1;
+    GLint shadow_color_uniform = -1;
+    GLint shadow_offset_uniform = -1;
+    GLint shadow_sigma_uniform = -1;
+    GLint opaque_content_uniform = -1;
+    GLint dim_uniform = -1;
     mutable long long last_used_frameno = 0;
 
     ProgramData(GLuint program_id)
@@ -129,24 +150,40 @@ struct ProgramData
         screen_to_gl_coords_uniform = glGetUniformLocation(id, "screen_to_gl_coords");
         alpha_uniform = glGetUniformLocation(id, "alpha");
         outline_color_uniform = glGetUniformLocation(id, "outline_color");
+        half_size_uniform = glGetUniformLocation(id, "half_size");
+        shape_centre_uniform = glGetUniformLocation(id, "shape_centre");
+        radius_uniform = glGetUniformLocation(id, "radius");
+        border_width_uniform = glGetUniformLocation(id, "border_width");
+        border_color_uniform = glGetUniformLocation(id, "border_color");
+        shadow_color_uniform = glGetUniformLocation(id, "shadow_color");
+        shadow_offset_uniform = glGetUniformLocation(id, "shadow_offset");
+        shadow_sigma_uniform = glGetUniformLocation(id, "shadow_sigma");
+        opaque_content_uniform = glGetUniformLocation(id, "opaque_content");
+        dim_uniform = glGetUniformLocation(id, "dim");
     }
 };
 
 struct Program : public mir::graphics::gl::Program
 {
 public:
-    Program(ProgramHandle&& opaque_shader, ProgramHandle&& alpha_shader, ProgramHandle&& outline_shader) :
+    Program(
+        ProgramHandle&& opaque_shader,
+        ProgramHandle&& alpha_shader,
+        ProgramHandle&& outline_shader,
+        ProgramHandle&& sdf_shader) :
         opaque_handle(std::move(opaque_shader)),
         alpha_handle(std::move(alpha_shader)),
         outline_handle(std::move(outline_shader)),
+        sdf_handle(std::move(sdf_shader)),
         opaque { opaque_handle },
         alpha { alpha_handle },
-        outline(outline_handle)
+        outline(outline_handle),
+        sdf(sdf_handle)
     {
     }
 
-    ProgramHandle opaque_handle, alpha_handle, outline_handle;
-    ProgramData opaque, alpha, outline;
+    ProgramHandle opaque_handle, alpha_handle, outline_handle, sdf_handle;
+    ProgramData opaque, alpha, outline, sdf;
 };
 
 const GLchar* const vertex_shader_src = R"(
@@ -175,7 +212,8 @@ class Renderer::ProgramFactory : public mir::graphics::gl::ProgramFactory
 public:
     // NOTE: This must be called with a current GL context
     ProgramFactory() :
-        vertex_shader { compile_shader(GL_VERTEX_SHADER, vertex_shader_src) }
+        vertex_shader { compile_shader(GL_VERTEX_SHADER, vertex_shader_src) },
+        sdf_vertex_shader { compile_shader(GL_VERTEX_SHADER, sdf_vertex_shader_src) }
     {
     }
 
@@ -208,8 +246,10 @@ public:
             << fragment_fragment
             << "\n"
             << "varying vec2 v_texcoord;\n"
+               "uniform float dim;\n"
                "void main() {\n"
-               "    gl_FragColor = sample_to_rgba(v_texcoord);\n"
+               "    vec4 color = sample_to_rgba(v_texcoord);\n"
+               "    gl_FragColor = vec4(color.rgb * (1.0 - dim), color.a);\n"
                "}\n";
 
         std::stringstream alpha_fragment;
@@ -224,10 +264,29 @@ public:
             << "\n"
             << "varying vec2 v_texcoord;\n"
                "uniform float alpha;\n"
+               "uniform float dim;\n"
                "void main() {\n"
-               "    gl_FragColor = alpha * sample_to_rgba(v_texcoord);\n"
+               "    vec4 color = sample_to_rgba(v_texcoord);\n"
+               "    gl_FragColor = alpha * vec4(color.rgb * (1.0 - dim), color.a);\n"
                "}\n";
 
+        // Decorated windows need the precision to resolve their edges at any size
+        std::stringstream sdf_fragment;
+        sdf_fragment
+            << extension_fragment
+            << "\n"
+            << "#ifdef GL_ES\n"
+               "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+               "precision highp float;\n"
+               "#else\n"
+               "precision mediump float;\n"
+               "#endif\n"
+               "#endif\n"
+            << "\n"
+            << fragment_fragment
+            << "\n"
+            << sdf_fragment_shader_src;
+
         const GLchar* const outline_shader_src = R"(
 #ifdef GL_ES
 precision mediump float;
@@ -252,8 +311,15 @@ void main() {
         ShaderHandle const outline_shader {
             compile_shader(GL_FRAGMENT_SHADER, outline_shader_src)
         };
+        ShaderHandle const sdf_shader {
+            compile_shader(GL_FRAGMENT_SHADER, sdf_fragment.str().c_str())
+        };
 
-        programs.emplace_back(id, std::make_unique<::Program>(link_shader(vertex_shader, opaque_shader), link_shader(vertex_shader, alpha_shader), link_shader(vertex_shader, outline_shader)));
+        programs.emplace_back(id, std::make_unique<::Program>(
+            link_shader(vertex_shader, opaque_shader),
+            link_shader(vertex_shader, alpha_shader),
+            link_shader(vertex_shader, outline_shader),
+            link_shader(sdf_vertex_shader, sdf_shader)));
 
         return *programs.back().second;
 
@@ -310,6 +376,7 @@ private:
     }
 
     ShaderHandle const vertex_shader;
+    ShaderHandle const sdf_vertex_shader;
     std::vector<std::pair<void const*, std::unique_ptr<::Program>>> programs;
     // GL requires us to synchronise multi-threaded access to the shader APIs.
     std::mutex compilation_mutex;
@@ -317,12 +384,60 @@ private:
 
 namespace
 {
+/// Titles are laid out again if they were not drawn for this many frames, so a window that
+/// leaves the screen for a moment, such as while switching workspaces, keeps its layout
+long long const TEXT_RUN_GRACE_FRAMES = 300;
+
 auto make_output_current(std::unique_ptr<mg::gl::OutputSurface> output) -> std::unique_ptr<mg::gl::OutputSurface>
 {
     output->make_current();
     return output;
 }
 
+/// The bounds of an area of the renderable once the vertex shader has moved it
+geom::Rectangle get_transformed_area(
+    geom::Rectangle const& area,
+    mg::Renderable const& renderable,
+    glm::mat4 const& workspace_transform)
+{
+    auto const& rect = renderable.screen_position();
+    glm::vec4 const centre {
+        rect.top_left.x.as_int() + rect.size.width.as_int() / 2.0f,
+        rect.top_left.y.as_int() + rect.size.height.as_int() / 2.0f,
+        0.f,
+        0.f
+    };
+    auto const transform = renderable.transformation();
+
+    float const left = area.top_left.x.as_int();
+    float const top = area.top_left.y.as_int();
+    float const right = left + area.size.width.as_int();
+    float const bottom = top + area.size.height.as_int();
+    glm::vec2 low { std::numeric_limits<float>::max() };
+    glm::vec2 high { std::numeric_limits<float>::lowest() };
+    for (auto const& corner : { glm::vec4(left, top, 0, 1), glm::vec4(right, top, 0, 1),
+             glm::vec4(left, bottom, 0, 1), glm::vec4(right, bottom, 0, 1) })
+    {
+        auto const position = workspace_transform * ((transform * (corner - centre)) + centre);
+        low = glm::min(low, glm::vec2(position));
+        high = glm::max(high, glm::vec2(position));
+    }
+
+    auto const x = static_cast<int>(std::floor(low.x));
+    auto const y = static_cast<int>(std::floor(low.y));
+    return {
+        geom::Point { x, y },
+        geom::Size { static_cast<int>(std::ceil(high.x)) - x, static_cast<int>(std::ceil(high.y)) - y }
+    };
+}
+
+std::size_t hash_floats(std::size_t seed, float const* values, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+        seed = hash_combine(seed, std::hash<float> {}(values[i]));
+    return seed;
+}
+
 class OutlineRenderable : public mir::graphics::Renderable
 {
 public:
@@ -400,14 +515,16 @@ Renderer::Renderer(
     std::shared_ptr<mir::graphics::GLRenderingProvider> gl_interface,
     std::unique_ptr<mir::graphics::gl::OutputSurface> output,
     std::shared_ptr<MiracleConfig> const& config,
-    SurfaceTracker& surface_tracker) :
+    SurfaceTracker& surface_tracker,
+    RenderCostTracker& render_costs) :
     output_surface { make_output_current(std::move(output)) },
     clear_color { 0.0f, 0.0f, 0.0f, 1.0f },
     program_factory { std::make_unique<ProgramFactory>() },
     display_transform(1),
     gl_interface { std::move(gl_interface) },
     config { config },
-    surface_tracker { surface_tracker }
+    surface_tracker { surface_tracker },
+    render_costs { render_costs }
 {
     // http://directx.com/2014/06/egl-understanding-eglchooseconfig-then-ignoring-it/
     eglBindAPI(EGL_OPENGL_ES_API);
@@ -463,11 +580,24 @@ Renderer::Renderer(
     mir::log_info("GL framebuffer bits: RGBA=%d%d%d%d, depth=%d, stencil=%d",
         rbits, gbits, bbits, abits, dbits, sbits);
 
+    auto const gl_renderer = reinterpret_cast<char const*>(glGetString(GL_RENDERER));
+    is_software = gl_renderer && is_software_renderer(gl_renderer);
+    if (is_software)
+    {
+        mir::log_info("GL renderer rasterizes in software, so the software render path is used");
+        config->set_software_rendering(true);
+    }
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 Renderer::~Renderer()
 {
+    // The members release their GL objects as they are destroyed, which needs the output's context
+    output_surface->make_current();
+    cost_timer.reset();
+    text_renderer.reset();
+    blur_renderer.reset();
 }
 
 void Renderer::tessellate(
@@ -484,17 +614,51 @@ auto Renderer::render(mg::RenderableList const& renderables) const -> std::uniqu
     output_surface->bind();
 
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
-    glClearStencil(0);
-    glStencilMask(0xFF);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    if (is_software)
+    {
+        // The stencil is never used in software, so it is not worth clearing
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    else
+    {
+        glClearStencil(0);
+        glStencilMask(0xFF);
+        glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    }
 
     ++frameno;
+    title_bar_config = config->get_title_bar_config();
+    border_config = config->get_border_config();
+    blur_config = config->get_blur_config();
+    opacity_config = config->get_opacity_config();
+    power_profiles.clear();
+    frame_time = InactiveDim::Clock::now();
+    if (blur_renderer)
+        blur_renderer->begin_frame(frameno, output_surface->size());
+    is_profiling = render_costs.is_enabled();
+    if (is_profiling && !cost_timer)
+        cost_timer = std::make_unique<RenderCostTimer>(render_costs);
+
+    // Results may still arrive after profiling is disabled, and are dropped by the tracker
+    if (cost_timer)
+        cost_timer->collect();
+
     for (auto const& r : renderables)
     {
         draw(*r);
     }
 
+    if (text_renderer)
+    {
+        text_renderer->flush(display_transform, screen_to_gl_coords, frameno);
+        text_renderer->evict_unused_since(frameno - TEXT_RUN_GRACE_FRAMES);
+    }
+
+    if (blur_renderer)
+        blur_renderer->evict_unused_since(frameno);
+    inactive_dim.evict_unused_since(frameno);
+
     auto output = output_surface->commit();
 
     // Report any GL errors after commit, to catch any *during* commit
@@ -508,6 +672,9 @@ void Renderer::draw(mg::Renderable const& renderable, OutlineContext* context) c
 {
     auto surface = renderable.surface_if_any();
     std::shared_ptr<WindowMetadata> userdata = nullptr;
+    std::string title;
+    std::string application_id;
+    bool has_title_bar = false;
     if (surface)
     {
         auto window = surface_tracker.get(surface.value());
@@ -516,42 +683,120 @@ void Renderer::draw(mg::Renderable const& renderable, OutlineContext* context) c
             auto tools = WindowToolsAccessor::get_instance().get_tools();
             auto& info = tools.info_for(window);
             userdata = static_pointer_cast<WindowMetadata>(info.userdata());
+            has_title_bar = title_bar_config.enabled
+                && title_bar_config.height > 0
+                && !window_helpers::is_window_fullscreen(info.state());
+            if (has_title_bar)
+                title = info.name();
+            if (is_profiling || !blur_config.app_ids.empty() || !opacity_config.rules.empty())
+                application_id = info.application_id();
         }
     }
 
+    // Windows behind a fullscreen window cannot be seen, so neither they nor their borders are drawn
+    if (userdata && userdata->is_suspended())
+        return;
+
+    // Opacity and dimming only change the uniforms that the window is drawn with. The window only
+    // takes the alpha program and blending when it is actually translucent.
+    auto alpha = renderable.alpha();
+    float dim = 0.f;
+    if (userdata && !context)
+    {
+        alpha *= userdata->get_opacity().value_or(opacity_config.get_opacity(application_id));
+        dim = get_dim(renderable, *userdata);
+    }
+
     bool needs_outline = userdata && userdata->get_type() == WindowType::tiled;
+
+    // Decorated windows draw their border along with everything else in a single pass
+    SdfDecoration decoration;
+    if (userdata && !context)
+        decoration = get_decoration(*userdata, needs_outline);
+    bool const is_decorated = !decoration.is_plain();
+
+    glm::mat4 workspace_transform(1.f);
+    if (userdata)
+    {
+        if (auto workspace = userdata->get_workspace())
+            workspace_transform = workspace->get_transform();
+    }
+
+    // Tiled windows are stacked below everything else, so their title bars are drawn
+    // in one pass right before the first window that is not tiled
+    if (!needs_outline && !context && text_renderer && text_renderer->has_queued())
+        text_renderer->flush(display_transform, screen_to_gl_coords, frameno);
+
+    // Only a window that can be seen through needs what is beneath it blurred
+    if (userdata && !context && (renderable.shaped() || alpha < 1.0f)
+        && should_blur(*userdata, application_id))
+    {
+        if (is_profiling)
+            cost_timer->begin(application_id, RenderCostPart::blur);
+        auto const updated = draw_blur_behind(renderable, workspace_transform, decoration.radius);
+        if (is_profiling)
+        {
+            cost_timer->end();
+            render_costs.record_blur(application_id, updated);
+        }
+    }
+
+    // The outline is timed by the caller, as its own part of the window
+    if (is_profiling && !context)
+        cost_timer->begin(application_id, RenderCostPart::surface);
+
     auto const texture = gl_interface->as_texture(renderable.buffer());
     auto const clip_area = renderable.clip_area();
-    if (clip_area)
+    if (is_software)
+    {
+        // Every pixel that a primitive covers costs CPU time in software, so each draw is cut down to what
+        // can be seen of it. Nothing is rasterized for a window that is entirely off screen.
+        auto const& position = renderable.screen_position();
+        auto const area = get_transformed_area(
+            clip_area ? position.intersection_with(clip_area.value()) : position,
+            renderable,
+            workspace_transform);
+
+        glEnable(GL_SCISSOR_TEST);
+        auto const clip = to_framebuffer(area.intersection_with(viewport), glm::mat4(1.f));
+        glScissor(
+            clip.top_left.x.as_int(),
+            clip.top_left.y.as_int(),
+            clip.size.width.as_int(),
+            clip.size.height.as_int());
+    }
+    else if (clip_area)
     {
-        glm::mat4 workspace_transform(1.f);
-        if (userdata)
+        // Decorations reach outside of the area that the window is clipped to
+        auto scissor = clip_area.value();
+        if (is_decorated)
         {
-            if (auto workspace = userdata->get_workspace())
-                workspace_transform = workspace->get_transform();
+            auto const extent = static_cast<int>(decoration.get_extent());
+            scissor.top_left = { scissor.top_left.x.as_int() - extent, scissor.top_left.y.as_int() - extent };
+            scissor.size = { scissor.size.width.as_int() + 2 * extent, scissor.size.height.as_int() + 2 * extent };
         }
 
         glEnable(GL_SCISSOR_TEST);
-        // The Y-coordinate is always relative to the top, so we make it relative to the bottom.
-        auto clip_y = viewport.top_left.y.as_int() + viewport.size.height.as_int()
-            - clip_area.value().top_left.y.as_int() - clip_area.value().size.height.as_int();
-        glm::vec4 clip_pos(clip_area.value().top_left.x.as_int(), clip_y, 0, 1);
-        clip_pos = display_transform * workspace_transform * clip_pos;
-
+        auto const clip = to_framebuffer(scissor, workspace_transform);
         glScissor(
-            (int)clip_pos.x - viewport.top_left.x.as_int(),
-            (int)clip_pos.y,
-            clip_area.value().size.width.as_int(),
-            clip_area.value().size.height.as_int());
+            clip.top_left.x.as_int(),
+            clip.top_left.y.as_int(),
+            clip.size.width.as_int(),
+            clip.size.height.as_int());
     }
 
     // Resource: https://stackoverflow.com/questions/48246302/writing-to-the-opengl-stencil-buffer
-    if (context)
+    if (is_software)
+    {
+        // Outlines are drawn around the window instead, so nothing needs to be masked
+        glDisable(GL_STENCIL_TEST);
+    }
+    else if (context)
     {
         glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
         glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
     }
-    else if (needs_outline)
+    else if (needs_outline && !is_decorated)
     {
         glEnable(GL_STENCIL_TEST);
         glStencilFunc(GL_ALWAYS, 1, 0xFF);
@@ -566,15 +811,17 @@ void Renderer::draw(mg::Renderable const& renderable, OutlineContext* context) c
     // All the programs are held by program_factory through its lifetime. Using pointers avoids
     // -Wdangling-reference.
     auto const* const prog =
-        [&](bool alpha) -> ProgramData const*
+        [&](bool is_translucent) -> ProgramData const*
     {
         auto const& family = static_cast<::Program const&>(texture->shader(*program_factory));
         if (context)
             return &family.outline;
-        if (alpha)
+        if (is_decorated)
+            return &family.sdf;
+        if (is_translucent)
             return &family.alpha;
         return &family.opaque;
-    }(renderable.alpha() < 1.0f);
+    }(alpha < 1.0f);
 
     glUseProgram(prog->id);
     if (prog->last_used_frameno != frameno)
@@ -618,7 +865,10 @@ void Renderer::draw(mg::Renderable const& renderable, OutlineContext* context) c
         glm::value_ptr(transform));
 
     if (prog->alpha_uniform >= 0)
-        glUniform1f(prog->alpha_uniform, renderable.alpha());
+        glUniform1f(prog->alpha_uniform, alpha);
+
+    if (prog->dim_uniform >= 0)
+        glUniform1f(prog->dim_uniform, dim);
 
     if (userdata)
     {
@@ -633,6 +883,24 @@ void Renderer::draw(mg::Renderable const& renderable, OutlineContext* context) c
         glUniformMatrix4fv(prog->workspace_transform_uniform, 1, GL_FALSE,
                            glm::value_ptr(glm::mat4(1.f)));
 
+    if (is_decorated)
+    {
+        // The window is rounded where it is visible, which may be less than its whole buffer
+        auto const shape = clip_area ? rect.intersection_with(clip_area.value()) : rect;
+        glUniform2f(prog->half_size_uniform,
+            shape.size.width.as_int() / 2.0f, shape.size.height.as_int() / 2.0f);
+        glUniform2f(prog->shape_centre_uniform,
+            shape.top_left.x.as_int() + shape.size.width.as_int() / 2.0f - centrex,
+            shape.top_left.y.as_int() + shape.size.height.as_int() / 2.0f - centrey);
+        glUniform1f(prog->radius_uniform, decoration.radius);
+        glUniform1f(prog->border_width_uniform, decoration.border_width);
+        glUniform4fv(prog->border_color_uniform, 1, glm::value_ptr(decoration.border_color));
+        glUniform4fv(prog->shadow_color_uniform, 1, glm::value_ptr(decoration.shadow_color));
+        glUniform2fv(prog->shadow_offset_uniform, 1, glm::value_ptr(decoration.shadow_offset));
+        glUniform1f(prog->shadow_sigma_uniform, decoration.shadow_sigma);
+        glUniform1f(prog->opaque_content_uniform, renderable.shaped() ? 0.0f : 1.0f);
+    }
+
     if (context)
     {
         glUniform4f(prog->outline_color_uniform,
@@ -644,7 +912,19 @@ void Renderer::draw(mg::Renderable const& renderable, OutlineContext* context) c
     glEnableVertexAttribArray(prog->texcoord_attr);
 
     primitives.clear();
-    tessellate(primitives, renderable);
+    if (context && is_software)
+    {
+        for (auto const& area : get_border_rectangles(renderable.screen_position(), context->inner))
+            primitives.push_back(mgl::tessellate_rectangle(area));
+    }
+    else
+        tessellate(primitives, renderable);
+    if (is_decorated)
+    {
+        auto const extent = decoration.get_extent();
+        for (auto& primitive : primitives)
+            primitive = expand_rectangle(primitive, extent);
+    }
 
     // if we fail to load the texture, we need to carry on (part of lp:1629275)
     try
@@ -657,12 +937,22 @@ void Renderer::draw(mg::Renderable const& renderable, OutlineContext* context) c
         BlendSeparate client_blend;
 
         // These renderable method names could be better (see LP: #1236224)
-        if (renderable.shaped()) // Client is RGBA:
+        if (is_decorated) // The decoration shader blends everything itself and is premultiplied:
+        {
+            client_blend = { GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                GL_ONE, GL_ONE_MINUS_SRC_ALPHA };
+        }
+        else if (context && is_software && alpha == 1.0f) // A solid outline, which covers whatever is beneath it:
+        {
+            client_blend = { GL_ONE, GL_ZERO,
+                GL_ZERO, GL_ONE };
+        }
+        else if (renderable.shaped()) // Client is RGBA:
         {
             client_blend = { GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
                 GL_ONE, GL_ONE_MINUS_SRC_ALPHA };
         }
-        else if (renderable.alpha() == 1.0f) // RGBX and no window translucency:
+        else if (alpha == 1.0f) // RGBX and no window translucency:
         {
             client_blend = { GL_ONE, GL_ZERO,
                 GL_ZERO, GL_ONE }; // Avoid using src_alpha!
@@ -673,7 +963,7 @@ void Renderer::draw(mg::Renderable const& renderable, OutlineContext* context) c
             // careful and avoid using SRC_ALPHA (LP: #1423462).
             client_blend = { GL_ONE, GL_ONE_MINUS_CONSTANT_ALPHA,
                 GL_ZERO, GL_ONE };
-            glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
+            glBlendColor(0.0f, 0.0f, 0.0f, alpha);
         }
 
         for (auto const& p : primitives)
@@ -713,24 +1003,269 @@ void Renderer::draw(mg::Renderable const& renderable, OutlineContext* context) c
 
     glDisableVertexAttribArray(prog->texcoord_attr);
     glDisableVertexAttribArray(prog->position_attr);
-    if (renderable.clip_area())
+    if (renderable.clip_area() || is_software)
     {
         glDisable(GL_SCISSOR_TEST);
     }
 
+    if (is_profiling && !context)
+        cost_timer->end();
+
     // Next, draw the outline if we have metadata to facilitate it
     if (needs_outline)
     {
-        auto border_config = config->get_border_config();
-        if (border_config.size > 0)
+        if (!is_decorated && border_config.size > 0 && get_power_profile(*userdata).borders)
         {
             bool is_focused = userdata->is_focused();
             auto color = is_focused ? border_config.focus_color : border_config.color;
-            OutlineContext outline_context = { color };
+            OutlineContext outline_context = { color, clip_area ? rect.intersection_with(clip_area.value()) : rect };
             OutlineRenderable outline(renderable, border_config.size, color.a);
+            if (is_profiling)
+                cost_timer->begin(application_id, RenderCostPart::outline);
             draw(outline, &outline_context);
+            if (is_profiling)
+                cost_timer->end();
         }
+
+        if (has_title_bar)
+            queue_title_bar(renderable, *userdata, title);
+    }
+
+    // Anything that is drawn may be beneath a window that blurs it later in the frame
+    if (blur_renderer && !context)
+    {
+        auto area = clip_area ? rect.intersection_with(clip_area.value()) : rect;
+        auto const reach = std::max(static_cast<int>(decoration.get_extent()), needs_outline ? border_config.size : 0);
+        auto const title_bar_height = needs_outline && has_title_bar ? title_bar_config.height : 0;
+        area.top_left = { area.top_left.x.as_int() - reach, area.top_left.y.as_int() - reach - title_bar_height };
+        area.size = { area.size.width.as_int() + 2 * reach, area.size.height.as_int() + 2 * reach + title_bar_height };
+        blur_renderer->add_drawn(
+            get_transformed_area(area, renderable, workspace_transform),
+            get_signature(renderable, userdata.get(), workspace_transform, decoration, alpha, dim, title));
+    }
+}
+
+float Renderer::get_dim(mg::Renderable const& renderable, WindowMetadata& metadata) const
+{
+    bool const can_dim = (metadata.get_type() == WindowType::tiled || metadata.get_type() == WindowType::floating)
+        && !metadata.is_focused();
+    auto const sample = inactive_dim.sample(
+        renderable.id(),
+        can_dim ? opacity_config.inactive_dim : 0.f,
+        std::chrono::duration<float>(opacity_config.dim_duration_seconds),
+        frame_time,
+        frameno);
+
+    // The next step of the easing needs another frame, which nothing in the scene would ask for
+    if (sample.is_animating)
+    {
+        if (auto surface = metadata.get_window().operator std::shared_ptr<mir::scene::Surface>())
+            surface_tracker.request_frame(surface.get());
+    }
+
+    return sample.dim;
+}
+
+PowerProfile const& Renderer::get_power_profile(WindowMetadata const& metadata) const
+{
+    // Taking the profile locks the configuration, so it is only done for the first window of each output
+    auto const output = metadata.get_output();
+    for (auto const& [profile_output, profile] : power_profiles)
+    {
+        if (profile_output == output)
+            return profile;
+    }
+
+    power_profiles.emplace_back(output, config->get_power_profile(output ? output->get_output().name() : ""));
+    return power_profiles.back().second;
+}
+
+bool Renderer::should_blur(WindowMetadata const& metadata, std::string const& application_id) const
+{
+    if (metadata.get_type() != WindowType::tiled && metadata.get_type() != WindowType::floating)
+        return false;
+
+    if (!get_power_profile(metadata).blur)
+        return false;
+
+    switch (metadata.get_blur_choice())
+    {
+    case BlurChoice::enabled:
+        return true;
+    case BlurChoice::disabled:
+        return false;
+    default:
+        return std::find(blur_config.app_ids.begin(), blur_config.app_ids.end(), application_id)
+            != blur_config.app_ids.end();
+    }
+}
+
+bool Renderer::draw_blur_behind(
+    mg::Renderable const& renderable,
+    glm::mat4 const& workspace_transform,
+    float radius) const
+{
+    if (!blur_renderer)
+    {
+        blur_renderer = std::make_unique<BlurRenderer>();
+        blur_renderer->begin_frame(frameno, output_surface->size());
     }
+
+    // The blur reaches beyond the window so that its edges take in what lies around it
+    auto const& rect = renderable.screen_position();
+    auto const clip_area = renderable.clip_area();
+    auto const shape = get_transformed_area(
+        clip_area ? rect.intersection_with(clip_area.value()) : rect,
+        renderable,
+        workspace_transform);
+    auto const margin = get_blur_margin(blur_config.passes, blur_config.offset);
+    geom::Rectangle const area {
+        geom::Point { shape.top_left.x.as_int() - margin, shape.top_left.y.as_int() - margin },
+        geom::Size { shape.size.width.as_int() + 2 * margin, shape.size.height.as_int() + 2 * margin }
+    };
+
+    // Both areas have already been moved along with their workspace
+    glm::mat4 const identity(1.f);
+    return blur_renderer->draw(
+        renderable.id(),
+        area,
+        to_framebuffer(area, identity),
+        to_framebuffer(shape, identity),
+        radius,
+        blur_config.passes,
+        blur_config.offset);
+}
+
+std::size_t Renderer::get_signature(
+    mg::Renderable const& renderable,
+    WindowMetadata const* metadata,
+    glm::mat4 const& workspace_transform,
+    SdfDecoration const& decoration,
+    float alpha,
+    float dim,
+    std::string const& title) const
+{
+    auto signature = std::hash<void const*> {}(renderable.id());
+
+    // Clients reuse their buffers, so the frames posted by a tracked surface tell us more than its buffer does
+    auto const surface = renderable.surface_if_any();
+    if (surface && metadata)
+        signature = hash_combine(signature, surface_tracker.get_content_generation(surface.value()));
+    else if (auto const buffer = renderable.buffer())
+        signature = hash_combine(signature, buffer->id().as_value());
+
+    auto const& rect = renderable.screen_position();
+    auto const clip_area = renderable.clip_area().value_or(rect);
+    for (auto const& area : { rect, clip_area })
+    {
+        signature = hash_combine(signature, area.top_left.x.as_int());
+        signature = hash_combine(signature, area.top_left.y.as_int());
+        signature = hash_combine(signature, area.size.width.as_int());
+        signature = hash_combine(signature, area.size.height.as_int());
+    }
+
+    auto const transform = workspace_transform * renderable.transformation();
+    float const appearance[] = {
+        alpha,
+        dim,
+        renderable.shaped() ? 1.f : 0.f,
+        decoration.radius,
+        decoration.border_width,
+        decoration.border_color.r,
+        decoration.border_color.g,
+        decoration.border_color.b,
+        decoration.border_color.a,
+        decoration.shadow_sigma,
+        metadata && metadata->is_focused() ? 1.f : 0.f
+    };
+    signature = hash_floats(signature, glm::value_ptr(transform), 16);
+    signature = hash_floats(signature, appearance, std::size(appearance));
+    return hash_combine(signature, std::hash<std::string> {}(title));
+}
+
+geom::Rectangle Renderer::to_framebuffer(geom::Rectangle const& area, glm::mat4 const& workspace_transform) const
+{
+    // The Y-coordinate is always relative to the top, so we make it relative to the bottom.
+    auto const y = viewport.top_left.y.as_int() + viewport.size.height.as_int()
+        - area.top_left.y.as_int() - area.size.height.as_int();
+    glm::vec4 position(area.top_left.x.as_int(), y, 0, 1);
+    position = display_transform * workspace_transform * position;
+    return {
+        geom::Point { (int)position.x - viewport.top_left.x.as_int(), (int)position.y },
+        area.size
+    };
+}
+
+SdfDecoration Renderer::get_decoration(WindowMetadata const& metadata, bool has_border) const
+{
+    SdfDecoration decoration;
+    if (metadata.get_type() != WindowType::tiled && metadata.get_type() != WindowType::floating)
+        return decoration;
+
+    // Rounded corners and shadows blend every pixel of the window, which is too costly in software.
+    // Tiled windows keep their outline.
+    if (is_software)
+        return decoration;
+
+    if (!get_power_profile(metadata).borders)
+        return decoration;
+
+    auto const premultiply = [](glm::vec4 const& color)
+    {
+        return glm::vec4(glm::vec3(color) * color.a, color.a);
+    };
+
+    decoration.radius = static_cast<float>(border_config.radius);
+    decoration.shadow_sigma = static_cast<float>(border_config.shadow.size);
+    decoration.shadow_offset = border_config.shadow.offset;
+    decoration.shadow_color = premultiply(border_config.shadow.color);
+    if (has_border && border_config.size > 0)
+    {
+        decoration.border_width = static_cast<float>(border_config.size);
+        decoration.border_color = premultiply(metadata.is_focused() ? border_config.focus_color : border_config.color);
+    }
+    return decoration;
+}
+
+void Renderer::queue_title_bar(
+    mg::Renderable const& renderable,
+    WindowMetadata const& metadata,
+    std::string const& title) const
+{
+    if (!text_renderer)
+        text_renderer = std::make_unique<TextRenderer>();
+
+    // The window is clipped to its tile, which is where the title bar lines up
+    auto const area = renderable.clip_area().value_or(renderable.screen_position());
+    auto const border = get_power_profile(metadata).borders ? border_config.size : 0;
+    geom::Rectangle const bar {
+        geom::Point { area.top_left.x.as_int() - border, area.top_left.y.as_int() - title_bar_config.height },
+        geom::Size { area.size.width.as_int() + 2 * border, title_bar_config.height }
+    };
+
+    // Follow the window through its animations and the workspace through its transitions,
+    // the same way that the vertex shader moves the window itself
+    auto const& rect = renderable.screen_position();
+    glm::vec3 const centre {
+        rect.top_left.x.as_int() + rect.size.width.as_int() / 2.0f,
+        rect.top_left.y.as_int() + rect.size.height.as_int() / 2.0f,
+        0.f
+    };
+    glm::mat4 transform = glm::translate(glm::mat4(1.f), centre)
+        * renderable.transformation()
+        * glm::translate(glm::mat4(1.f), -centre);
+    if (auto const& workspace = metadata.get_workspace())
+        transform = workspace->get_transform() * transform;
+
+    auto const& background = metadata.is_focused() ? title_bar_config.focus_color : title_bar_config.color;
+    text_renderer->queue_title_bar(
+        renderable.surface_if_any().value(),
+        title,
+        bar,
+        transform,
+        background,
+        renderable.alpha(),
+        title_bar_config);
 }
 
 void Renderer::set_viewport(mir::geometry::Rectangle const& rect)
@@ -18,7 +18,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIR_RENDERER_GL_RENDERER_H_
 #define MIR_RENDERER_GL_RENDERER_H_
 
+#include "inactive_dim.h"
+#include "miracle_config.h"
 #include "primitive.h"
+#include "render_cost_tracker.h"
+#include "sdf_decoration.h"
 #include "surface_tracker.h"
 #include <mir/geometry/rectangle.h>
 #include <mir/graphics/buffer_id.h>
@@ -45,7 +49,12 @@ namespace graphics::gl
 
 namespace miracle
 {
+class BlurRenderer;
 class MiracleConfig;
+class OutputContent;
+class RenderCostTimer;
+class TextRenderer;
+class WindowMetadata;
 
 class Renderer : public mir::renderer::Renderer
 {
@@ -53,7 +62,8 @@ public:
     Renderer(std::shared_ptr<mir::graphics::GLRenderingProvider> gl_interface,
         std::unique_ptr<mir::graphics::gl::OutputSurface> output,
         std::shared_ptr<MiracleConfig> const& config,
-        SurfaceTracker& surface_tracker);
+        SurfaceTracker& surface_tracker,
+        RenderCostTracker& render_costs);
     virtual ~Renderer();
 
     // These are called with a valid GL context:
@@ -87,11 +97,58 @@ private:
     struct OutlineContext
     {
         glm::vec4 color;
+
+        /// Where the window was drawn, which the outline must leave alone
+        mir::geometry::Rectangle inner;
     };
     virtual void draw(mir::graphics::Renderable const& renderable, OutlineContext* context = nullptr) const;
+
+    /// Describes the corners, border and shadow of the window for this frame
+    SdfDecoration get_decoration(WindowMetadata const& metadata, bool has_border) const;
+
+    /// The dim factor that the window is drawn with this frame, which eases towards its target when focus changes
+    float get_dim(mir::graphics::Renderable const& renderable, WindowMetadata& metadata) const;
+
+    /// The power profile of the window's output, which is looked up once per output each frame
+    PowerProfile const& get_power_profile(WindowMetadata const& metadata) const;
+
+    /// Whether the window blurs the content beneath it, by its own choice or by the configuration
+    bool should_blur(WindowMetadata const& metadata, std::string const& application_id) const;
+
+    /// Blurs what has been drawn beneath the renderable so far and draws it where the renderable will go
+    /// @returns true if the blur had to be computed again
+    bool draw_blur_behind(
+        mir::graphics::Renderable const& renderable,
+        glm::mat4 const& workspace_transform,
+        float radius) const;
+
+    /// Describes the appearance of the renderable, so that a blur above it can tell when it changed
+    std::size_t get_signature(
+        mir::graphics::Renderable const& renderable,
+        WindowMetadata const* metadata,
+        glm::mat4 const& workspace_transform,
+        SdfDecoration const& decoration,
+        float alpha,
+        float dim,
+        std::string const& title) const;
+
+    /// Converts an area on screen into framebuffer pixels, measured from the lower left as with glScissor
+    mir::geometry::Rectangle to_framebuffer(
+        mir::geometry::Rectangle const& area,
+        glm::mat4 const& workspace_transform) const;
+
+    /// Queues the title bar that sits above the tiled window
+    void queue_title_bar(
+        mir::graphics::Renderable const& renderable,
+        WindowMetadata const& metadata,
+        std::string const& title) const;
     void update_gl_viewport();
 
     std::unique_ptr<mir::graphics::gl::OutputSurface> const output_surface;
+
+    /// Whether the GL driver rasterizes on the CPU, such as llvmpipe. Such a driver pays for every blended
+    /// pixel and stencil operation, so outlines are drawn as rectangles and every draw is scissored.
+    bool is_software = false;
     GLfloat clear_color[4];
     mutable long long frameno = 0;
     class ProgramFactory;
@@ -103,6 +160,31 @@ private:
     std::shared_ptr<mir::graphics::GLRenderingProvider> const gl_interface;
     std::shared_ptr<MiracleConfig> config;
     SurfaceTracker& surface_tracker;
+
+    /// Read once per frame, as these are needed for every tiled window
+    TitleBarConfig mutable title_bar_config;
+    BorderConfig mutable border_config;
+    BlurConfig mutable blur_config;
+    OpacityConfig mutable opacity_config;
+    std::vector<std::pair<OutputContent const*, PowerProfile>> mutable power_profiles;
+    InactiveDim::Clock::time_point mutable frame_time;
+
+    /// Renderer-side, so that a focus change costs no more than the uniforms that it changes
+    InactiveDim mutable inactive_dim;
+
+    /// Created when a window first blurs the content beneath it
+    std::unique_ptr<BlurRenderer> mutable blur_renderer;
+
+    /// Created when title bars are first drawn
+    std::unique_ptr<TextRenderer> mutable text_renderer;
+
+    RenderCostTracker& render_costs;
+
+    /// Read once per frame. While profiling, each draw is timed and attributed to its application.
+    bool mutable is_profiling = false;
+
+    /// Created when profiling is first enabled
+    std::unique_ptr<RenderCostTimer> mutable cost_timer;
 };
 
 }
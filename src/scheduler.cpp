@@ -0,0 +1,134 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "scheduler.h"
+
+#include <algorithm>
+#include <mir/main_loop.h>
+#include <mir/time/alarm.h>
+
+using namespace miracle;
+
+Scheduler::Scheduler(
+    std::shared_ptr<mir::MainLoop> const& main_loop,
+    std::chrono::microseconds idle_budget,
+    std::chrono::microseconds quiet_period,
+    std::chrono::microseconds max_deferral) :
+    main_loop { main_loop },
+    idle_budget { idle_budget },
+    quiet_period { quiet_period },
+    max_deferral { max_deferral },
+    last_activity { Clock::now().time_since_epoch().count() }
+{
+    idle_alarm = main_loop->create_alarm([this]()
+    {
+        drain_idle_tasks();
+    });
+}
+
+Scheduler::~Scheduler()
+{
+    idle_alarm->cancel();
+}
+
+void Scheduler::post(TaskPriority priority, std::function<void()> const& task)
+{
+    switch (priority)
+    {
+    case TaskPriority::immediate:
+        main_loop->enqueue(this, task);
+        break;
+    case TaskPriority::idle:
+    {
+        std::lock_guard lock(idle_mutex);
+        if (idle_tasks.empty())
+            first_queued = Clock::now();
+        idle_tasks.push_back(task);
+        if (!is_idle_drain_scheduled)
+        {
+            is_idle_drain_scheduled = true;
+            schedule_idle_drain(quiet_period);
+        }
+        break;
+    }
+    }
+}
+
+void Scheduler::advise_activity()
+{
+    last_activity.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+std::chrono::microseconds Scheduler::get_idle_delay(
+    std::chrono::microseconds since_activity,
+    std::chrono::microseconds since_queued,
+    std::chrono::microseconds quiet_period,
+    std::chrono::microseconds max_deferral)
+{
+    if (since_activity >= quiet_period || since_queued >= max_deferral)
+        return std::chrono::microseconds(0);
+
+    // Something happened recently, so more events are likely on their way
+    return std::min(quiet_period - since_activity, max_deferral - since_queued);
+}
+
+void Scheduler::schedule_idle_drain(std::chrono::microseconds delay)
+{
+    idle_alarm->reschedule_in(std::chrono::ceil<std::chrono::milliseconds>(delay));
+}
+
+void Scheduler::drain_idle_tasks()
+{
+    auto const start = Clock::now();
+    auto const last = Clock::time_point(Clock::duration(last_activity.load(std::memory_order_relaxed)));
+    auto const since_activity = std::chrono::duration_cast<std::chrono::microseconds>(start - last);
+    {
+        std::lock_guard lock(idle_mutex);
+        auto const since_queued = std::chrono::duration_cast<std::chrono::microseconds>(start - first_queued);
+        auto const delay = get_idle_delay(since_activity, since_queued, quiet_period, max_deferral);
+        if (delay > std::chrono::microseconds(0))
+        {
+            schedule_idle_drain(delay);
+            return;
+        }
+    }
+
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::lock_guard lock(idle_mutex);
+            if (idle_tasks.empty())
+            {
+                is_idle_drain_scheduled = false;
+                return;
+            }
+
+            if (Clock::now() - start >= idle_budget)
+            {
+                // Out of budget: yield to the main loop and pick up where we left off
+                schedule_idle_drain(std::chrono::microseconds(0));
+                return;
+            }
+
+            task = std::move(idle_tasks.front());
+            idle_tasks.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,103 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_SCHEDULER_H
+#define MIRACLEWM_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace mir
+{
+class MainLoop;
+namespace time
+{
+    class Alarm;
+}
+}
+
+namespace miracle
+{
+
+enum class TaskPriority
+{
+    /// Runs on the next iteration of the main loop, ahead of any idle work
+    immediate,
+
+    /// Runs once the main loop is quiet, within a per-iteration time budget
+    idle
+};
+
+/// Prioritizes work that is posted to the main loop. Latency-critical work
+/// (e.g. focus changes) is queued immediately, while bookkeeping (e.g. IPC
+/// event serialization) waits until no input or window management events
+/// have arrived for a short while. Idle work that does not fit in the budget
+/// of a single iteration is carried over to the next one. Idle work is never
+/// deferred for longer than the maximum deferral, so that continuous input
+/// (e.g. a drag) cannot starve it.
+class Scheduler
+{
+public:
+    explicit Scheduler(
+        std::shared_ptr<mir::MainLoop> const& main_loop,
+        std::chrono::microseconds idle_budget = std::chrono::microseconds(2000),
+        std::chrono::microseconds quiet_period = std::chrono::microseconds(4000),
+        std::chrono::microseconds max_deferral = std::chrono::microseconds(100000));
+    ~Scheduler();
+
+    void post(TaskPriority priority, std::function<void()> const& task);
+
+    /// Called whenever an input or window management event arrives.
+    /// Idle work is postponed until the quiet period has elapsed.
+    void advise_activity();
+
+    /// How much longer queued idle work should wait, or zero if it should run now
+    /// @param since_activity Time since the last input or window management event
+    /// @param since_queued Time since the oldest queued idle task was posted
+    static std::chrono::microseconds get_idle_delay(
+        std::chrono::microseconds since_activity,
+        std::chrono::microseconds since_queued,
+        std::chrono::microseconds quiet_period,
+        std::chrono::microseconds max_deferral);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::shared_ptr<mir::MainLoop> main_loop;
+    std::chrono::microseconds const idle_budget;
+    std::chrono::microseconds const quiet_period;
+    std::chrono::microseconds const max_deferral;
+    std::unique_ptr<mir::time::Alarm> idle_alarm;
+    std::mutex idle_mutex;
+    std::deque<std::function<void()>> idle_tasks;
+    bool is_idle_drain_scheduled = false;
+
+    /// When the oldest task in idle_tasks was posted
+    Clock::time_point first_queued;
+    std::atomic<Clock::rep> last_activity;
+
+    void schedule_idle_drain(std::chrono::microseconds delay);
+    void drain_idle_tasks();
+};
+
+} // miracle
+
+#endif // MIRACLEWM_SCHEDULER_H
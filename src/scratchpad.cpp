@@ -0,0 +1,72 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "scratchpad.h"
+
+#include <algorithm>
+
+using namespace miracle;
+
+bool Scratchpad::add(Id id)
+{
+    if (contains(id))
+        return false;
+
+    hidden.push_back(id);
+    return true;
+}
+
+bool Scratchpad::remove(Id id)
+{
+    if (!contains(id))
+        return false;
+
+    hidden.erase(std::remove(hidden.begin(), hidden.end(), id), hidden.end());
+    shown.erase(std::remove(shown.begin(), shown.end(), id), shown.end());
+    return true;
+}
+
+bool Scratchpad::contains(Id id) const
+{
+    return is_shown(id) || std::find(hidden.begin(), hidden.end(), id) != hidden.end();
+}
+
+bool Scratchpad::is_shown(Id id) const
+{
+    return std::find(shown.begin(), shown.end(), id) != shown.end();
+}
+
+auto Scratchpad::toggle(std::optional<Id> focused) -> Toggle
+{
+    if (focused && is_shown(focused.value()))
+    {
+        shown.erase(std::remove(shown.begin(), shown.end(), focused.value()), shown.end());
+        hidden.push_back(focused.value());
+        return { Toggle::Action::hide, focused.value() };
+    }
+
+    if (!shown.empty())
+        return { Toggle::Action::focus, shown.back() };
+
+    if (hidden.empty())
+        return {};
+
+    auto const id = hidden.front();
+    hidden.pop_front();
+    shown.push_back(id);
+    return { Toggle::Action::show, id };
+}
@@ -0,0 +1,82 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_SCRATCHPAD_H
+#define MIRACLEWM_SCRATCHPAD_H
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace miracle
+{
+
+/// Bookkeeping for the windows in the scratchpad, which live outside of every workspace. A window
+/// is either hidden or shown, and toggling only ever flips one window between the two, so that the
+/// window keeps its size and buffers. Windows are identified by their container id.
+class Scratchpad
+{
+public:
+    using Id = std::uint64_t;
+
+    struct Toggle
+    {
+        enum class Action
+        {
+            /// The scratchpad is empty
+            none,
+            show,
+            hide,
+
+            /// A shown window lost focus, so it is focused instead of being hidden
+            focus
+        };
+
+        Action action = Action::none;
+        Id id = 0;
+    };
+
+    /// Adds a window, which starts out hidden.
+    /// @returns false if the window was already in the scratchpad
+    bool add(Id id);
+
+    /// Forgets a window that was closed or taken out of the scratchpad.
+    /// @returns false if the window was not in the scratchpad
+    bool remove(Id id);
+
+    [[nodiscard]] bool contains(Id id) const;
+    [[nodiscard]] bool is_shown(Id id) const;
+
+    /// Decides what 'scratchpad show' does, as i3 does. A shown window that has focus is hidden, and
+    /// a shown window that does not is focused. Otherwise, the window that was hidden longest ago is
+    /// shown, so that repeated toggles cycle through the scratchpad.
+    Toggle toggle(std::optional<Id> focused);
+
+    [[nodiscard]] std::size_t hidden_count() const { return hidden.size(); }
+    [[nodiscard]] std::size_t shown_count() const { return shown.size(); }
+
+private:
+    std::deque<Id> hidden;
+
+    /// In the order that they were shown
+    std::vector<Id> shown;
+};
+
+} // miracle
+
+#endif // MIRACLEWM_SCRATCHPAD_H
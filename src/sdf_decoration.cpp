@@ -0,0 +1,157 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "sdf_decoration.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace miracle;
+
+namespace
+{
+/// Beyond three standard deviations the shadow is invisible
+float const shadow_sigma_reach = 3.f;
+}
+
+bool SdfDecoration::is_plain() const
+{
+    return radius <= 0 && (shadow_sigma <= 0 || shadow_color.a <= 0);
+}
+
+float SdfDecoration::get_extent() const
+{
+    float extent = border_width;
+    if (shadow_sigma > 0 && shadow_color.a > 0)
+    {
+        auto const offset = std::max(std::abs(shadow_offset.x), std::abs(shadow_offset.y));
+        extent += shadow_sigma * shadow_sigma_reach + offset;
+    }
+    return std::ceil(extent);
+}
+
+mir::gl::Primitive miracle::expand_rectangle(mir::gl::Primitive const& rectangle, float extent)
+{
+    if (rectangle.nvertices != 4 || extent <= 0)
+        return rectangle;
+
+    auto const& vertices = rectangle.vertices;
+    auto left = vertices[0], right = vertices[0], top = vertices[0], bottom = vertices[0];
+    for (int i = 1; i < rectangle.nvertices; i++)
+    {
+        auto const& vertex = vertices[i];
+        if (vertex.position[0] < left.position[0])
+            left = vertex;
+        if (vertex.position[0] > right.position[0])
+            right = vertex;
+        if (vertex.position[1] < top.position[1])
+            top = vertex;
+        if (vertex.position[1] > bottom.position[1])
+            bottom = vertex;
+    }
+
+    auto const width = right.position[0] - left.position[0];
+    auto const height = bottom.position[1] - top.position[1];
+    if (width <= 0 || height <= 0)
+        return rectangle;
+
+    auto const du = (right.texcoord[0] - left.texcoord[0]) / width;
+    auto const dv = (bottom.texcoord[1] - top.texcoord[1]) / height;
+    auto const centre_x = left.position[0] + width / 2.f;
+    auto const centre_y = top.position[1] + height / 2.f;
+
+    auto expanded = rectangle;
+    for (int i = 0; i < expanded.nvertices; i++)
+    {
+        auto& vertex = expanded.vertices[i];
+        auto const dx = vertex.position[0] < centre_x ? -extent : extent;
+        auto const dy = vertex.position[1] < centre_y ? -extent : extent;
+        vertex.position[0] += dx;
+        vertex.position[1] += dy;
+        vertex.texcoord[0] += dx * du;
+        vertex.texcoord[1] += dy * dv;
+    }
+    return expanded;
+}
+
+char const* const miracle::sdf_vertex_shader_src = R"(
+attribute vec3 position;
+attribute vec2 texcoord;
+uniform mat4 screen_to_gl_coords;
+uniform mat4 display_transform;
+uniform mat4 workspace_transform;
+uniform mat4 transform;
+uniform vec2 centre;
+varying vec2 v_texcoord;
+varying vec2 v_local;
+void main() {
+   vec4 mid = vec4(centre, 0.0, 0.0);
+   vec4 transformed = (transform * (vec4(position, 1.0) - mid)) + mid;
+   gl_Position = display_transform * screen_to_gl_coords * workspace_transform * transformed;
+   v_texcoord = texcoord;
+   v_local = position.xy - centre;
+}
+)";
+
+char const* const miracle::sdf_fragment_shader_src = R"(
+varying vec2 v_texcoord;
+varying vec2 v_local;
+uniform float alpha;
+uniform vec2 half_size;
+uniform vec2 shape_centre;
+uniform float radius;
+uniform float border_width;
+uniform vec4 border_color;
+uniform vec4 shadow_color;
+uniform vec2 shadow_offset;
+uniform float shadow_sigma;
+uniform float opaque_content;
+uniform float dim;
+
+// Signed distance from p to a rectangle with half size b and corners of radius r
+float rounded_box(vec2 p, vec2 b, float r) {
+    vec2 q = abs(p) - b + r;
+    return min(max(q.x, q.y), 0.0) + length(max(q, 0.0)) - r;
+}
+
+// Abramowitz and Stegun approximation of the error function
+float approx_erf(float x) {
+    float a = abs(x);
+    float t = 1.0 + (0.278393 + (0.230389 + 0.078108 * (a * a)) * a) * a;
+    t *= t;
+    return sign(x) * (1.0 - 1.0 / (t * t));
+}
+
+void main() {
+    vec2 p = v_local - shape_centre;
+    float outer_radius = radius > 0.0 ? radius + border_width : 0.0;
+    float inner = clamp(0.5 - rounded_box(p, half_size, radius), 0.0, 1.0);
+    float outer = clamp(0.5 - rounded_box(p, half_size + border_width, outer_radius), 0.0, 1.0);
+
+    // The shape convolved with a Gaussian, approximated along its distance field
+    float shadow = 0.0;
+    if (shadow_sigma > 0.0) {
+        float d = rounded_box(p - shadow_offset, half_size + border_width, outer_radius);
+        shadow = 0.5 - 0.5 * approx_erf(d / (shadow_sigma * 1.4142136));
+    }
+
+    vec4 texel = sample_to_rgba(v_texcoord);
+    texel.a = mix(texel.a, 1.0, opaque_content);
+    texel.rgb *= 1.0 - dim;
+    gl_FragColor = alpha * (texel * inner + border_color * (outer - inner) + shadow_color * (shadow * (1.0 - outer)));
+}
+)";
@@ -0,0 +1,68 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_SDF_DECORATION_H
+#define MIRACLEWM_SDF_DECORATION_H
+
+#include "primitive.h"
+#include <glm/glm.hpp>
+
+namespace miracle
+{
+
+/// Describes the rounded corners, border and shadow of a window. These are drawn in the same
+/// fragment pass as the window itself, from the signed distance to its rounded rectangle, so
+/// that decorating a window costs no extra passes, stencil work or shadow textures. Only the
+/// geometry grows, and only by the extent of the decorations.
+struct SdfDecoration
+{
+    float radius = 0;
+    float border_width = 0;
+
+    /// Premultiplied
+    glm::vec4 border_color = glm::vec4(0);
+
+    /// Premultiplied
+    glm::vec4 shadow_color = glm::vec4(0);
+    glm::vec2 shadow_offset = glm::vec2(0);
+
+    /// The standard deviation of the Gaussian that blurs the shadow
+    float shadow_sigma = 0;
+
+    /// Whether the window can be drawn as a plain textured quad instead. A border alone is
+    /// still drawn by the outline pass.
+    [[nodiscard]] bool is_plain() const;
+
+    /// How far the decorations reach past each edge of the window
+    [[nodiscard]] float get_extent() const;
+};
+
+/// Grows a rectangle that was tessellated with texture coordinates spanning the whole
+/// buffer outwards by extent on every side. The texture coordinates are extrapolated,
+/// so that the buffer keeps its place inside the larger rectangle.
+mir::gl::Primitive expand_rectangle(mir::gl::Primitive const& rectangle, float extent);
+
+/// Like the vertex shader of the renderer, but also passes the position of the
+/// fragment relative to the centre of the window
+extern char const* const sdf_vertex_shader_src;
+
+/// The body of the fragment shader. It must be preceded by a definition of sample_to_rgba.
+extern char const* const sdf_fragment_shader_src;
+
+} // miracle
+
+#endif // MIRACLEWM_SDF_DECORATION_H
@@ -0,0 +1,141 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "shm_log"
+
+#include "shm_log.h"
+
+#include <bit>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <mir/log.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace miracle;
+
+namespace
+{
+std::int64_t now_ns(clockid_t clock)
+{
+    timespec now {};
+    clock_gettime(clock, &now);
+    return static_cast<std::int64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+}
+
+/// gettid is a system call, so it is only made once per thread
+std::uint32_t get_thread_id()
+{
+    thread_local auto const id = static_cast<std::uint32_t>(syscall(SYS_gettid));
+    return id;
+}
+}
+
+ShmLog& ShmLog::instance()
+{
+    static auto* const log = new ShmLog();
+    return *log;
+}
+
+ShmLog::ShmLog(std::uint64_t slot_count)
+{
+    slot_count = std::bit_ceil(std::max<std::uint64_t>(slot_count, 1));
+    auto const header_size = sizeof(shm_log::Header);
+    auto const total_size = header_size + slot_count * sizeof(shm_log::Slot);
+
+    fd = memfd_create(shm_log::memfd_name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0)
+    {
+        mir::log_warning("Unable to create the shared memory log: %s", strerror(errno));
+        return;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(total_size)) < 0)
+    {
+        mir::log_warning("Unable to size the shared memory log: %s", strerror(errno));
+        close(fd);
+        fd = -1;
+        return;
+    }
+
+    // Readers map the log too, so it must never shrink beneath them
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    auto const data = mmap(nullptr, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        mir::log_warning("Unable to map the shared memory log: %s", strerror(errno));
+        close(fd);
+        fd = -1;
+        return;
+    }
+
+    size = total_size;
+    header = new (data) shm_log::Header {};
+    std::memcpy(header->magic, shm_log::magic, sizeof(header->magic));
+    header->version = shm_log::version;
+    header->slot_size = sizeof(shm_log::Slot);
+    header->slot_count = slot_count;
+    header->pid = getpid();
+    header->realtime_at_start_ns = now_ns(CLOCK_REALTIME);
+    header->monotonic_at_start_ns = now_ns(CLOCK_MONOTONIC);
+    header->enabled.store(1, std::memory_order_relaxed);
+
+    // The memfd is zero filled, so every slot starts with a sequence that no record matches
+    slots = reinterpret_cast<shm_log::Slot*>(static_cast<char*>(data) + header_size);
+}
+
+ShmLog::~ShmLog()
+{
+    if (header)
+        munmap(header, size);
+    if (fd >= 0)
+        close(fd);
+}
+
+void ShmLog::set_enabled(bool enabled)
+{
+    if (header)
+        header->enabled.store(enabled ? 1 : 0, std::memory_order_relaxed);
+}
+
+bool ShmLog::is_enabled() const
+{
+    return header && header->enabled.load(std::memory_order_relaxed);
+}
+
+shm_log::Slot& ShmLog::begin(std::uint64_t index, int severity)
+{
+    auto& slot = slots[index & (header->slot_count - 1)];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timestamp_ns = now_ns(CLOCK_MONOTONIC);
+    slot.thread_id = get_thread_id();
+    slot.severity = static_cast<std::uint8_t>(severity);
+    slot.flags = 0;
+    return slot;
+}
+
+void ShmLog::commit(shm_log::Slot& slot, std::uint64_t index, std::uint16_t size)
+{
+    slot.size = size;
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+}
@@ -0,0 +1,241 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_SHM_LOG_H
+#define MIRACLEWM_SHM_LOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace miracle
+{
+
+/// The layout of the log in shared memory, which miracle-wm-dump-log reads from another process
+/// or from a core file. Any change to it must bump the version.
+namespace shm_log
+{
+/// The name of the memfd, as it appears in /proc/<pid>/fd of the compositor
+inline constexpr char const* memfd_name = "miracle-wm-log";
+inline constexpr char magic[8] = { 'M', 'I', 'R', 'A', 'C', 'L', 'O', 'G' };
+inline constexpr std::uint32_t version = 1;
+inline constexpr std::uint64_t default_slot_count = 16384;
+
+enum class ArgumentType : std::uint8_t
+{
+    signed_integer,
+    unsigned_integer,
+    floating_point,
+    string,
+    pointer
+};
+
+/// Set on a slot whose payload did not fit, so that the reader can say so
+inline constexpr std::uint8_t truncated_flag = 1;
+
+struct alignas(64) Header
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t slot_size;
+    std::uint64_t slot_count;
+    std::int64_t pid;
+
+    /// CLOCK_REALTIME and CLOCK_MONOTONIC when the log was created, which turn the monotonic
+    /// timestamps of the slots into wall clock time
+    std::int64_t realtime_at_start_ns;
+    std::int64_t monotonic_at_start_ns;
+
+    /// The index of the next slot to be written. Slots are never reset, so this counts every
+    /// record since the log was created.
+    alignas(64) std::atomic<std::uint64_t> next;
+    std::atomic<std::uint32_t> enabled;
+};
+
+/// A record is written to the slot at its index modulo the slot count. The sequence is a
+/// seqlock: it is odd while the record is written and 2 * (index + 1) once it is complete.
+///
+/// The payload holds the component and the format as strings, followed by each argument as a
+/// type and a value. Strings are a 16 bit length followed by the bytes, without a terminator.
+struct Slot
+{
+    std::atomic<std::uint64_t> sequence;
+    std::int64_t timestamp_ns;
+    std::uint32_t thread_id;
+    std::uint8_t severity;
+    std::uint8_t flags;
+    std::uint16_t size;
+    char payload[232];
+};
+
+static_assert(sizeof(Slot) == 256);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The log is shared with other processes");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "The log is shared with other processes");
+
+/// Appends to the payload of a slot until it is full
+class Encoder
+{
+public:
+    explicit Encoder(Slot& slot) :
+        slot { slot }
+    {
+    }
+
+    void string(std::string_view value)
+    {
+        if (available() < 2)
+        {
+            slot.flags |= truncated_flag;
+            return;
+        }
+
+        auto const length = static_cast<std::uint16_t>(std::min(value.size(), available() - 2));
+        if (length < value.size())
+            slot.flags |= truncated_flag;
+        raw(&length, sizeof(length));
+        raw(value.data(), length);
+    }
+
+    template <typename T>
+    void argument(T const& value)
+    {
+        using Value = std::decay_t<T>;
+        if constexpr (std::is_same_v<Value, char const*> || std::is_same_v<Value, char*>)
+            string_argument(value ? value : "(null)");
+        else if constexpr (std::is_same_v<Value, std::string> || std::is_same_v<Value, std::string_view>)
+            string_argument(value);
+        else if constexpr (std::is_enum_v<Value>)
+            argument(static_cast<std::underlying_type_t<Value>>(value));
+        else if constexpr (std::is_same_v<Value, bool> || (std::is_integral_v<Value> && std::is_signed_v<Value>))
+            scalar(ArgumentType::signed_integer, static_cast<std::int64_t>(value));
+        else if constexpr (std::is_integral_v<Value>)
+            scalar(ArgumentType::unsigned_integer, static_cast<std::uint64_t>(value));
+        else if constexpr (std::is_floating_point_v<Value>)
+            scalar(ArgumentType::floating_point, static_cast<double>(value));
+        else if constexpr (std::is_pointer_v<Value>)
+            scalar(ArgumentType::pointer, reinterpret_cast<std::uint64_t>(value));
+        else
+            static_assert(!sizeof(Value), "The log cannot record arguments of this type");
+    }
+
+    [[nodiscard]] std::uint16_t size() const { return used; }
+
+private:
+    Slot& slot;
+    std::uint16_t used = 0;
+
+    [[nodiscard]] std::size_t available() const { return sizeof(slot.payload) - used; }
+
+    void raw(void const* data, std::size_t size)
+    {
+        std::memcpy(slot.payload + used, data, size);
+        used += size;
+    }
+
+    template <typename V>
+    void scalar(ArgumentType type, V value)
+    {
+        if (available() < 1 + sizeof(value))
+        {
+            slot.flags |= truncated_flag;
+            return;
+        }
+
+        raw(&type, 1);
+        raw(&value, sizeof(value));
+    }
+
+    void string_argument(std::string_view value)
+    {
+        if (available() < 1 + 2)
+        {
+            slot.flags |= truncated_flag;
+            return;
+        }
+
+        auto const type = ArgumentType::string;
+        raw(&type, 1);
+        string(value);
+    }
+};
+}
+
+/// An always-on binary log in a ring of fixed size slots, held in a memfd so that
+/// miracle-wm-dump-log can read it from a live compositor, or from its core file after a crash.
+///
+/// Writing a record does not take a lock or format anything: a writer claims the next slot with a
+/// single atomic increment and copies the format and its arguments into it, and the reader does the
+/// formatting. A writer that is lapped by the whole ring while it is writing can leave a torn record,
+/// which the reader cannot detect. With the default ring of 16384 slots, this is not a concern.
+class ShmLog
+{
+public:
+    /// The log of this process, which is created the first time that it is used. It is never
+    /// destroyed, so threads may write to it while the process exits.
+    static ShmLog& instance();
+
+    /// Creates a log in a new memfd. If the memfd cannot be created, nothing is recorded.
+    /// @param slot_count The number of records kept, which is rounded up to a power of two
+    explicit ShmLog(std::uint64_t slot_count = shm_log::default_slot_count);
+    ~ShmLog();
+
+    ShmLog(ShmLog const&) = delete;
+    ShmLog& operator=(ShmLog const&) = delete;
+
+    void set_enabled(bool enabled);
+    [[nodiscard]] bool is_enabled() const;
+
+    /// The memfd, or -1 if it could not be created
+    [[nodiscard]] int get_fd() const { return fd; }
+
+    /// The size of the memfd in bytes
+    [[nodiscard]] std::size_t get_size() const { return size; }
+
+    /// Records a printf-style message. The arguments are copied, so strings need not outlive the call.
+    template <typename... Args>
+    void write(int severity, char const* component, char const* format, Args const&... args)
+    {
+        if (!header || !header->enabled.load(std::memory_order_relaxed))
+            return;
+
+        auto const index = header->next.fetch_add(1, std::memory_order_relaxed);
+        auto& slot = begin(index, severity);
+        shm_log::Encoder encoder { slot };
+        encoder.string(component);
+        encoder.string(format);
+        (encoder.argument(args), ...);
+        commit(slot, index, encoder.size());
+    }
+
+private:
+    int fd = -1;
+    std::size_t size = 0;
+    shm_log::Header* header = nullptr;
+    shm_log::Slot* slots = nullptr;
+
+    shm_log::Slot& begin(std::uint64_t index, int severity);
+    static void commit(shm_log::Slot& slot, std::uint64_t index, std::uint16_t size);
+};
+
+}
+
+#endif // MIRACLEWM_SHM_LOG_H
@@ -0,0 +1,341 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "shm_log_reader.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+using namespace miracle;
+
+namespace
+{
+struct Argument
+{
+    shm_log::ArgumentType type;
+    std::int64_t signed_value = 0;
+    std::uint64_t unsigned_value = 0;
+    double floating_value = 0;
+    std::string string_value;
+};
+
+/// Reads the payload of a slot that was copied out of the ring
+class Decoder
+{
+public:
+    Decoder(char const* data, std::size_t size) :
+        data { data },
+        size { size }
+    {
+    }
+
+    std::optional<std::string> string()
+    {
+        std::uint16_t length = 0;
+        if (!raw(&length, sizeof(length)) || offset + length > size)
+            return std::nullopt;
+
+        std::string value(data + offset, length);
+        offset += length;
+        return value;
+    }
+
+    std::optional<Argument> argument()
+    {
+        Argument argument {};
+        if (!raw(&argument.type, 1))
+            return std::nullopt;
+
+        switch (argument.type)
+        {
+        case shm_log::ArgumentType::signed_integer:
+            if (!raw(&argument.signed_value, sizeof(argument.signed_value)))
+                return std::nullopt;
+            return argument;
+        case shm_log::ArgumentType::unsigned_integer:
+        case shm_log::ArgumentType::pointer:
+            if (!raw(&argument.unsigned_value, sizeof(argument.unsigned_value)))
+                return std::nullopt;
+            return argument;
+        case shm_log::ArgumentType::floating_point:
+            if (!raw(&argument.floating_value, sizeof(argument.floating_value)))
+                return std::nullopt;
+            return argument;
+        case shm_log::ArgumentType::string:
+        {
+            auto value = string();
+            if (!value)
+                return std::nullopt;
+            argument.string_value = std::move(value.value());
+            return argument;
+        }
+        }
+
+        return std::nullopt;
+    }
+
+private:
+    char const* data;
+    std::size_t size;
+    std::size_t offset = 0;
+
+    bool raw(void* out, std::size_t length)
+    {
+        if (offset + length > size)
+            return false;
+        std::memcpy(out, data + offset, length);
+        offset += length;
+        return true;
+    }
+};
+
+template <typename... Args>
+std::string printf_to_string(std::string const& spec, Args... args)
+{
+    char buffer[512];
+    auto const length = std::snprintf(buffer, sizeof(buffer), spec.c_str(), args...);
+    if (length < 0)
+        return spec;
+    return std::string(buffer, std::min<std::size_t>(length, sizeof(buffer) - 1));
+}
+
+std::string describe(Argument const& argument)
+{
+    switch (argument.type)
+    {
+    case shm_log::ArgumentType::signed_integer:
+        return std::to_string(argument.signed_value);
+    case shm_log::ArgumentType::unsigned_integer:
+        return std::to_string(argument.unsigned_value);
+    case shm_log::ArgumentType::floating_point:
+        return printf_to_string("%g", argument.floating_value);
+    case shm_log::ArgumentType::pointer:
+        return printf_to_string("%#llx", static_cast<unsigned long long>(argument.unsigned_value));
+    case shm_log::ArgumentType::string:
+        return argument.string_value;
+    }
+    return {};
+}
+
+long long as_signed(Argument const& argument)
+{
+    switch (argument.type)
+    {
+    case shm_log::ArgumentType::signed_integer:
+        return argument.signed_value;
+    case shm_log::ArgumentType::floating_point:
+        return static_cast<long long>(argument.floating_value);
+    default:
+        return static_cast<long long>(argument.unsigned_value);
+    }
+}
+
+/// Formats a single conversion, whose length modifiers have been removed from the spec
+std::string format_conversion(std::string spec, char conversion, Argument const& argument)
+{
+    switch (conversion)
+    {
+    case 'd':
+    case 'i':
+        if (argument.type == shm_log::ArgumentType::string)
+            return argument.string_value;
+        return printf_to_string(spec + "ll" + conversion, as_signed(argument));
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+        if (argument.type == shm_log::ArgumentType::string)
+            return argument.string_value;
+        return printf_to_string(spec + "ll" + conversion, static_cast<unsigned long long>(as_signed(argument)));
+    case 'c':
+        return printf_to_string(spec + conversion, static_cast<int>(as_signed(argument)));
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        if (argument.type == shm_log::ArgumentType::floating_point)
+            return printf_to_string(spec + conversion, argument.floating_value);
+        if (argument.type == shm_log::ArgumentType::string)
+            return argument.string_value;
+        return printf_to_string(spec + conversion, static_cast<double>(as_signed(argument)));
+    case 's':
+        return printf_to_string(spec + conversion, describe(argument).c_str());
+    case 'p':
+        return describe(argument);
+    default:
+        return describe(argument);
+    }
+}
+
+/// Formats the message as printf would have in the compositor. Arguments that did not fit in
+/// the slot are left as their conversion.
+std::string format(std::string const& format, std::vector<Argument> const& arguments)
+{
+    std::string result;
+    std::size_t next_argument = 0;
+    auto const take = [&]() -> Argument const*
+    {
+        return next_argument < arguments.size() ? &arguments[next_argument++] : nullptr;
+    };
+
+    for (std::size_t i = 0; i < format.size(); i++)
+    {
+        if (format[i] != '%')
+        {
+            result += format[i];
+            continue;
+        }
+
+        auto const start = i++;
+        if (i < format.size() && format[i] == '%')
+        {
+            result += '%';
+            continue;
+        }
+
+        // Flags, width and precision are kept, with any '*' replaced by its argument
+        std::string spec = "%";
+        bool is_complete = true;
+        while (i < format.size() && std::string_view("-+ #0").find(format[i]) != std::string_view::npos)
+            spec += format[i++];
+        for (auto const part : { 0, 1 })
+        {
+            if (part == 1)
+            {
+                if (i >= format.size() || format[i] != '.')
+                    break;
+                spec += format[i++];
+            }
+
+            if (i < format.size() && format[i] == '*')
+            {
+                i++;
+                if (auto const star = take())
+                    spec += std::to_string(as_signed(*star));
+                else
+                    is_complete = false;
+            }
+            else
+            {
+                while (i < format.size() && format[i] >= '0' && format[i] <= '9')
+                    spec += format[i++];
+            }
+        }
+
+        // Every argument was widened when it was recorded, so the length modifiers no longer apply
+        while (i < format.size() && std::string_view("hlLqjzt").find(format[i]) != std::string_view::npos)
+            i++;
+
+        if (i >= format.size())
+        {
+            result += format.substr(start);
+            break;
+        }
+
+        auto const conversion = format[i];
+        auto const argument = is_complete ? take() : nullptr;
+        if (argument)
+            result += format_conversion(spec, conversion, *argument);
+        else
+            result += format.substr(start, i - start + 1);
+    }
+
+    return result;
+}
+}
+
+ShmLogReader::ShmLogReader(void const* data, std::size_t size)
+{
+    if (!is_log(data, size))
+        throw std::runtime_error("The memory does not hold a log of version " + std::to_string(shm_log::version));
+
+    header = static_cast<shm_log::Header const*>(data);
+    slots = reinterpret_cast<shm_log::Slot const*>(static_cast<char const*>(data) + sizeof(shm_log::Header));
+}
+
+bool ShmLogReader::is_log(void const* data, std::size_t size)
+{
+    if (size < sizeof(shm_log::Header))
+        return false;
+
+    auto const* header = static_cast<shm_log::Header const*>(data);
+    return std::memcmp(header->magic, shm_log::magic, sizeof(shm_log::magic)) == 0
+        && header->version == shm_log::version
+        && header->slot_size == sizeof(shm_log::Slot)
+        && header->slot_count > 0
+        && (header->slot_count & (header->slot_count - 1)) == 0
+        && header->slot_count <= (size - sizeof(shm_log::Header)) / sizeof(shm_log::Slot);
+}
+
+std::uint64_t ShmLogReader::get_first_index() const
+{
+    auto const next = get_next_index();
+    return next > header->slot_count ? next - header->slot_count : 0;
+}
+
+std::uint64_t ShmLogReader::get_next_index() const
+{
+    return header->next.load(std::memory_order_acquire);
+}
+
+std::optional<ShmLogRecord> ShmLogReader::read(std::uint64_t index) const
+{
+    auto const& slot = slots[index & (header->slot_count - 1)];
+    auto const expected = 2 * (index + 1);
+    if (slot.sequence.load(std::memory_order_acquire) != expected)
+        return std::nullopt;
+
+    // The writer may start on the slot again while it is copied, in which case the sequence changes
+    shm_log::Slot copy;
+    std::memcpy(reinterpret_cast<char*>(&copy) + sizeof(copy.sequence),
+        reinterpret_cast<char const*>(&slot) + sizeof(slot.sequence),
+        sizeof(slot) - sizeof(slot.sequence));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != expected)
+        return std::nullopt;
+
+    Decoder decoder { copy.payload, std::min<std::size_t>(copy.size, sizeof(copy.payload)) };
+    auto component = decoder.string();
+    auto format_string = decoder.string();
+    if (!component || !format_string)
+        return std::nullopt;
+
+    std::vector<Argument> arguments;
+    while (auto argument = decoder.argument())
+        arguments.push_back(std::move(argument.value()));
+
+    auto const since_start = std::chrono::nanoseconds(copy.timestamp_ns - header->monotonic_at_start_ns);
+    auto const start = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(header->realtime_at_start_ns)));
+
+    ShmLogRecord record {
+        index,
+        start + std::chrono::duration_cast<std::chrono::system_clock::duration>(since_start),
+        copy.thread_id,
+        copy.severity,
+        std::move(component.value()),
+        format(format_string.value(), arguments)
+    };
+    if (copy.flags & shm_log::truncated_flag)
+        record.message += " [truncated]";
+    return record;
+}
@@ -0,0 +1,71 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_SHM_LOG_READER_H
+#define MIRACLEWM_SHM_LOG_READER_H
+
+#include "shm_log.h"
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace miracle
+{
+
+struct ShmLogRecord
+{
+    std::uint64_t index;
+    std::chrono::system_clock::time_point time;
+    std::uint32_t thread_id;
+    int severity;
+    std::string component;
+
+    /// The message, formatted as printf would have formatted it
+    std::string message;
+};
+
+/// Reads a ShmLog that is mapped from another process, or copied out of a core file. Nothing
+/// is written to the log, so it may be mapped read only.
+class ShmLogReader
+{
+public:
+    /// @throws std::runtime_error if the memory does not hold a log of this version
+    ShmLogReader(void const* data, std::size_t size);
+
+    /// Whether the memory could hold a log, which is used to find a log in a core file
+    static bool is_log(void const* data, std::size_t size);
+
+    [[nodiscard]] std::int64_t get_pid() const { return header->pid; }
+
+    /// The index of the oldest record that may still be in the ring
+    [[nodiscard]] std::uint64_t get_first_index() const;
+
+    /// The index that the next record will be written at
+    [[nodiscard]] std::uint64_t get_next_index() const;
+
+    /// @returns std::nullopt if the record has been overwritten or is still being written
+    [[nodiscard]] std::optional<ShmLogRecord> read(std::uint64_t index) const;
+
+private:
+    shm_log::Header const* header;
+    shm_log::Slot const* slots;
+};
+
+}
+
+#endif // MIRACLEWM_SHM_LOG_READER_H
@@ -0,0 +1,88 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "software_rendering.h"
+
+#include <algorithm>
+#include <cctype>
+
+using namespace miracle;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Substrings of the GL_RENDERER strings reported by Mesa's software drivers and by SwiftShader
+char const* const software_renderers[] = {
+    "llvmpipe",
+    "softpipe",
+    "swrast",
+    "software rasterizer",
+    "swiftshader"
+};
+
+geom::Rectangle make_rectangle(int left, int top, int right, int bottom)
+{
+    return { geom::Point { left, top }, geom::Size { right - left, bottom - top } };
+}
+}
+
+bool miracle::is_software_renderer(std::string const& gl_renderer)
+{
+    std::string lower = gl_renderer;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c)
+    {
+        return std::tolower(c);
+    });
+
+    return std::any_of(std::begin(software_renderers), std::end(software_renderers), [&](char const* name)
+    {
+        return lower.find(name) != std::string::npos;
+    });
+}
+
+std::vector<geom::Rectangle> miracle::get_border_rectangles(geom::Rectangle const& outer, geom::Rectangle const& inner)
+{
+    auto const outer_left = outer.top_left.x.as_int();
+    auto const outer_top = outer.top_left.y.as_int();
+    auto const outer_right = outer_left + outer.size.width.as_int();
+    auto const outer_bottom = outer_top + outer.size.height.as_int();
+
+    // Only the part of the inner rectangle that lies within the outer one is left uncovered
+    auto const left = std::clamp(inner.top_left.x.as_int(), outer_left, outer_right);
+    auto const top = std::clamp(inner.top_left.y.as_int(), outer_top, outer_bottom);
+    auto const right = std::clamp(inner.top_left.x.as_int() + inner.size.width.as_int(), left, outer_right);
+    auto const bottom = std::clamp(inner.top_left.y.as_int() + inner.size.height.as_int(), top, outer_bottom);
+
+    std::vector<geom::Rectangle> result;
+    if (right == left || bottom == top)
+    {
+        if (outer_right > outer_left && outer_bottom > outer_top)
+            result.push_back(outer);
+        return result;
+    }
+
+    // The top and bottom span the whole width, so that the sides never overlap them
+    if (top > outer_top)
+        result.push_back(make_rectangle(outer_left, outer_top, outer_right, top));
+    if (bottom < outer_bottom)
+        result.push_back(make_rectangle(outer_left, bottom, outer_right, outer_bottom));
+    if (left > outer_left)
+        result.push_back(make_rectangle(outer_left, top, left, bottom));
+    if (right < outer_right)
+        result.push_back(make_rectangle(right, top, outer_right, bottom));
+    return result;
+}
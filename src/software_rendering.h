@@ -0,0 +1,40 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_SOFTWARE_RENDERING_H
+#define MIRACLEWM_SOFTWARE_RENDERING_H
+
+#include <mir/geometry/rectangle.h>
+#include <string>
+#include <vector>
+
+namespace miracle
+{
+
+/// Whether the GL renderer string names a driver that rasterizes on the CPU, such as llvmpipe.
+/// Every blended pixel and stencil operation costs CPU time on these drivers.
+bool is_software_renderer(std::string const& gl_renderer);
+
+/// The rectangles that cover the outer rectangle but not the inner one, at most one for each side.
+/// This draws a border around a window without masking the window out with the stencil buffer.
+std::vector<mir::geometry::Rectangle> get_border_rectangles(
+    mir::geometry::Rectangle const& outer,
+    mir::geometry::Rectangle const& inner);
+
+} // miracle
+
+#endif // MIRACLEWM_SOFTWARE_RENDERING_H
@@ -0,0 +1,55 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_STACKING_LAYER_H
+#define MIRACLEWM_STACKING_LAYER_H
+
+#include <mir_toolkit/common.h>
+
+namespace miracle
+{
+
+/// The layers that windows are stacked in, from bottom to top. Each layer is backed by
+/// its own Mir depth layer, so Mir keeps the layers in order for us and restacking a
+/// window only ever moves it within its own layer.
+enum class StackingLayer
+{
+    /// Tiled windows never overlap, so focusing one of them does not restack anything
+    tiled,
+    floating,
+    /// Shares the layer shell's "top" layer, whose panels are hidden while a window is fullscreen.
+    /// The "overlay" layer stays above it for on-screen keyboards, notifications and lock screens.
+    fullscreen
+};
+
+inline MirDepthLayer to_depth_layer(StackingLayer layer)
+{
+    switch (layer)
+    {
+    case StackingLayer::floating:
+        return mir_depth_layer_always_on_top;
+    case StackingLayer::fullscreen:
+        return mir_depth_layer_above;
+    case StackingLayer::tiled:
+    default:
+        return mir_depth_layer_application;
+    }
+}
+
+}
+
+#endif // MIRACLEWM_STACKING_LAYER_H
@@ -17,27 +17,114 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "surface_tracker.h"
 
+#include <atomic>
+#include <mir/scene/null_surface_observer.h>
+#include <mir/scene/surface.h>
+
 using namespace miracle;
 
+/// Notified from the compositor threads whenever the surface posts a frame
+class SurfaceTracker::ContentObserver : public mir::scene::NullSurfaceObserver
+{
+public:
+    void frame_posted(mir::scene::Surface const*, mir::geometry::Rectangle const&) override
+    {
+        generation.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t get_generation() const { return generation.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> generation = 1;
+};
+
+SurfaceTracker::~SurfaceTracker()
+{
+    for (auto& [_, entry] : map)
+    {
+        auto surface = entry.window.operator std::shared_ptr<mir::scene::Surface>();
+        if (surface)
+            surface->unregister_interest(*entry.observer);
+    }
+}
+
 void SurfaceTracker::add(miral::Window const& window)
 {
     auto surface = window.operator std::shared_ptr<mir::scene::Surface>();
-    map.insert(std::pair(surface.get(), window));
+    if (!surface)
+        return;
+
+    auto observer = std::make_shared<ContentObserver>();
+    surface->register_interest(observer);
+
+    std::lock_guard lock(mutex);
+    map.insert(std::pair(surface.get(), Entry { window, observer }));
 }
 
 void SurfaceTracker::remove(miral::Window const& window)
 {
     auto surface = window.operator std::shared_ptr<mir::scene::Surface>();
+    std::lock_guard lock(mutex);
     auto it = map.find(surface.get());
-    if (it != map.end())
-        map.erase(it);
+    if (it == map.end())
+        return;
+
+    if (surface)
+        surface->unregister_interest(*it->second.observer);
+    map.erase(it);
+    frame_requests.erase(surface.get());
 }
 
 miral::Window SurfaceTracker::get(mir::scene::Surface const* surface)
 {
+    std::lock_guard lock(mutex);
     auto it = map.find(surface);
     if (it == map.end())
         return {};
 
-    return it->second;
-}
\ No newline at end of file
+    return it->second.window;
+}
+
+uint64_t SurfaceTracker::get_content_generation(mir::scene::Surface const* surface)
+{
+    std::lock_guard lock(mutex);
+    auto it = map.find(surface);
+    if (it == map.end())
+        return 0;
+
+    return it->second.observer->get_generation();
+}
+
+void SurfaceTracker::set_frame_request_handler(std::function<void()> const& handler)
+{
+    std::lock_guard lock(mutex);
+    frame_request_handler = handler;
+}
+
+void SurfaceTracker::request_frame(mir::scene::Surface const* surface)
+{
+    std::lock_guard lock(mutex);
+    if (!map.contains(surface))
+        return;
+
+    // The handler is only told once, as the requests are all taken together
+    bool const is_first = frame_requests.empty();
+    frame_requests.insert(surface);
+    if (is_first && frame_request_handler)
+        frame_request_handler();
+}
+
+std::vector<miral::Window> SurfaceTracker::take_frame_requests()
+{
+    std::lock_guard lock(mutex);
+    std::vector<miral::Window> windows;
+    for (auto const* surface : frame_requests)
+    {
+        auto it = map.find(surface);
+        if (it != map.end())
+            windows.push_back(it->second.window);
+    }
+
+    frame_requests.clear();
+    return windows;
+}
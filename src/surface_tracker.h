@@ -18,21 +18,56 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_SURFACE_TRACKER_H
 #define MIRACLEWM_SURFACE_TRACKER_H
 
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <memory>
 #include <miral/window.h>
+#include <mutex>
+#include <set>
+#include <vector>
 
 namespace miracle
 {
 
+/// Maps surfaces to their windows for the renderer. The policy adds and removes windows
+/// while the compositor threads look them up, so every method is safe to call from any thread.
 class SurfaceTracker
 {
 public:
+    ~SurfaceTracker();
+
     void add(miral::Window const&);
     void remove(miral::Window const&);
     miral::Window get(mir::scene::Surface const*);
 
+    /// Counts the frames that the surface has posted. This changes whenever the content
+    /// of the surface does, which a buffer id does not tell us as buffers are reused.
+    /// @returns zero for a surface that is not tracked
+    uint64_t get_content_generation(mir::scene::Surface const*);
+
+    /// Sets what is called when the first frame is requested after the requests were last taken
+    void set_frame_request_handler(std::function<void()> const& handler);
+
+    /// Asks for the surface to be composited again although the scene has not changed,
+    /// such as while its dim is easing. Requests are merged until they are taken.
+    void request_frame(mir::scene::Surface const*);
+
+    /// @returns the tracked windows whose frames were requested since the last call
+    std::vector<miral::Window> take_frame_requests();
+
 private:
-    std::map<mir::scene::Surface const*, miral::Window> map;
+    class ContentObserver;
+    struct Entry
+    {
+        miral::Window window;
+        std::shared_ptr<ContentObserver> observer;
+    };
+
+    std::mutex mutex;
+    std::map<mir::scene::Surface const*, Entry> map;
+    std::function<void()> frame_request_handler;
+    std::set<mir::scene::Surface const*> frame_requests;
 };
 
 } // miracle
@@ -0,0 +1,162 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "swipe_gesture.h"
+#include <cmath>
+
+using namespace miracle;
+using namespace std::chrono_literals;
+
+namespace
+{
+/// The release velocity is measured over this window, so that a finger that stops
+/// before it lifts does not fling the content
+constexpr std::chrono::nanoseconds velocity_window = 100ms;
+}
+
+SwipeGestureTracker::SwipeGestureTracker(int fingers, float threshold) :
+    fingers { fingers },
+    threshold { threshold }
+{
+}
+
+SwipeGestureTracker::Update SwipeGestureTracker::handle(
+    std::vector<TouchPoint> const& points, std::chrono::nanoseconds time)
+{
+    bool any_up = false;
+    for (auto const& point : points)
+    {
+        if (point.is_up)
+        {
+            touches.erase(point.id);
+            any_up = true;
+        }
+        else
+            touches[point.id] = point;
+    }
+
+    int const count = static_cast<int>(touches.size());
+    Update update;
+    switch (state)
+    {
+    case State::idle:
+        if (count == fingers)
+        {
+            centroid(start_x, start_y);
+            last_offset = 0.f;
+            samples.clear();
+            add_sample(time, 0.f);
+            state = State::recognizing;
+        }
+        else if (count > fingers)
+            state = State::ignoring;
+        break;
+    case State::recognizing:
+    {
+        if (count != fingers)
+        {
+            state = count == 0 ? State::idle : State::ignoring;
+            break;
+        }
+
+        float x, y;
+        centroid(x, y);
+        float const dx = x - start_x;
+        float const dy = y - start_y;
+        add_sample(time, dx);
+        if (std::abs(dx) >= threshold && std::abs(dx) > std::abs(dy))
+        {
+            state = State::swiping;
+            last_offset = dx;
+            update = { Update::Type::begin, dx, 0.f, true };
+        }
+        else if (std::abs(dy) >= threshold)
+            state = State::ignoring;
+        break;
+    }
+    case State::swiping:
+        if (count == fingers)
+        {
+            float x, y;
+            centroid(x, y);
+            last_offset = x - start_x;
+            add_sample(time, last_offset);
+            update = { Update::Type::move, last_offset, 0.f, true };
+        }
+        else if (count < fingers)
+        {
+            // Lifting any finger releases the swipe
+            update = { Update::Type::end, last_offset, velocity(), true };
+            state = count == 0 ? State::idle : State::ignoring;
+        }
+        else
+        {
+            update = { Update::Type::cancel, last_offset, 0.f, false };
+            state = State::ignoring;
+        }
+
+        // Clients saw these fingers touch down before the swipe was recognized,
+        // so they must also see them lift
+        if (any_up)
+            update.consumed = false;
+        break;
+    case State::ignoring:
+        if (count == 0)
+            state = State::idle;
+        break;
+    }
+
+    return update;
+}
+
+void SwipeGestureTracker::centroid(float& x, float& y) const
+{
+    x = 0.f;
+    y = 0.f;
+    if (touches.empty())
+        return;
+
+    for (auto const& [id, touch] : touches)
+    {
+        x += touch.x;
+        y += touch.y;
+    }
+
+    x /= static_cast<float>(touches.size());
+    y /= static_cast<float>(touches.size());
+}
+
+void SwipeGestureTracker::add_sample(std::chrono::nanoseconds time, float offset)
+{
+    samples.push_back({ time, offset });
+    while (samples.size() > 2 && time - samples.front().time > velocity_window)
+        samples.pop_front();
+}
+
+float SwipeGestureTracker::velocity() const
+{
+    if (samples.size() < 2)
+        return 0.f;
+
+    auto const& first = samples.front();
+    auto const& last = samples.back();
+    auto seconds = std::chrono::duration<float>(last.time - first.time).count();
+    if (seconds <= 0.f)
+        return 0.f;
+
+    return (last.offset - first.offset) / seconds;
+}
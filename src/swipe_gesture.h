@@ -0,0 +1,107 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_SWIPE_GESTURE_H
+#define MIRACLEWM_SWIPE_GESTURE_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace miracle
+{
+
+/// A single contact in a touch event.
+struct TouchPoint
+{
+    int32_t id;
+    bool is_up;
+    float x;
+    float y;
+};
+
+/// Recognizes horizontal multi-finger swipes from raw touch events. The tracker reports
+/// how far the fingers have travelled on every event, so the caller can move content
+/// 1:1 with the fingers, and the release velocity, so it can settle from there.
+class SwipeGestureTracker
+{
+public:
+    struct Update
+    {
+        enum class Type
+        {
+            none,
+            begin,
+            move,
+            end,
+            cancel
+        };
+
+        Type type = Type::none;
+
+        /// Horizontal distance travelled by the centroid of the fingers since they touched down, in pixels
+        float offset = 0.f;
+
+        /// Horizontal velocity at release, in pixels per second
+        float velocity = 0.f;
+
+        /// True when the touch event belongs to the gesture and should not reach clients
+        bool consumed = false;
+    };
+
+    explicit SwipeGestureTracker(int fingers = 3, float threshold = 32.f);
+
+    Update handle(std::vector<TouchPoint> const& points, std::chrono::nanoseconds time);
+
+private:
+    enum class State
+    {
+        idle,
+        recognizing,
+        swiping,
+
+        /// The touches are not a swipe, so we wait for every finger to lift
+        ignoring
+    };
+
+    struct Sample
+    {
+        std::chrono::nanoseconds time;
+        float offset;
+    };
+
+    int const fingers;
+    float const threshold;
+    State state = State::idle;
+    std::map<int32_t, TouchPoint> touches;
+    float start_x = 0.f;
+    float start_y = 0.f;
+    float last_offset = 0.f;
+
+    /// Recent positions, from which the release velocity is measured
+    std::deque<Sample> samples;
+
+    void centroid(float& x, float& y) const;
+    void add_sample(std::chrono::nanoseconds time, float offset);
+    [[nodiscard]] float velocity() const;
+};
+
+} // miracle
+
+#endif // MIRACLEWM_SWIPE_GESTURE_H
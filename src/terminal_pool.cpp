@@ -0,0 +1,113 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "terminal_pool"
+
+#include "terminal_pool.h"
+
+#include <algorithm>
+#include <mir/log.h>
+
+using namespace miracle;
+
+TerminalPool::TerminalPool(Launcher const& launcher) :
+    launcher { launcher }
+{
+}
+
+std::vector<pid_t> TerminalPool::set_capacity(int in)
+{
+    capacity = std::max(in, 0);
+
+    std::vector<pid_t> surplus;
+    while (ready.size() > static_cast<std::size_t>(capacity))
+    {
+        surplus.push_back(ready.back());
+        ready.pop_back();
+    }
+    return surplus;
+}
+
+void TerminalPool::fill(Clock::time_point now)
+{
+    // A terminal that never opened a window would otherwise hold its slot forever
+    auto const is_expired = [&](Pending const& entry)
+    {
+        return now - entry.launched_at > pending_timeout;
+    };
+    auto const expired = std::find_if(pending.begin(), pending.end(), is_expired);
+    if (expired != pending.end() && !disabled)
+    {
+        mir::log_warning(
+            "Pooled terminal %d did not open a window within %llds, so the terminal pool is disabled. "
+            "Terminals that open their window from another process cannot be pooled.",
+            expired->pid,
+            static_cast<long long>(pending_timeout.count()));
+        disabled = true;
+    }
+    pending.erase(std::remove_if(pending.begin(), pending.end(), is_expired), pending.end());
+
+    if (disabled)
+        return;
+
+    while (pending.size() + ready.size() < static_cast<std::size_t>(capacity))
+    {
+        auto pid = launcher();
+        if (!pid)
+            return;
+
+        pending.push_back({ pid.value(), now });
+    }
+}
+
+void TerminalPool::enable()
+{
+    disabled = false;
+}
+
+bool TerminalPool::is_pending(pid_t pid) const
+{
+    return std::any_of(pending.begin(), pending.end(), [&](Pending const& entry) { return entry.pid == pid; });
+}
+
+bool TerminalPool::advise_ready(pid_t pid)
+{
+    auto it = std::find_if(pending.begin(), pending.end(), [&](Pending const& entry) { return entry.pid == pid; });
+    if (it == pending.end())
+        return false;
+
+    pending.erase(it);
+    ready.push_back(pid);
+    return true;
+}
+
+std::optional<pid_t> TerminalPool::take()
+{
+    if (ready.empty())
+        return std::nullopt;
+
+    auto pid = ready.front();
+    ready.pop_front();
+    return pid;
+}
+
+void TerminalPool::remove(pid_t pid)
+{
+    pending.erase(std::remove_if(pending.begin(), pending.end(), [&](Pending const& entry) { return entry.pid == pid; }),
+        pending.end());
+    ready.erase(std::remove(ready.begin(), ready.end(), pid), ready.end());
+}
@@ -0,0 +1,96 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_TERMINAL_POOL_H
+#define MIRACLEWM_TERMINAL_POOL_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <sys/types.h>
+#include <vector>
+
+namespace miracle
+{
+
+/// Bookkeeping for terminals that are launched ahead of time and held hidden until the
+/// terminal key is pressed. Terminals are identified by the pid that the launcher returned,
+/// which is the pid of the client that later opens the window. A terminal is pending from
+/// launch until its first window arrives, after which it is ready to be taken.
+///
+/// A terminal whose window comes from another process, such as an Xwayland terminal, a
+/// terminal server or a wrapper script that does not exec, is never recognised. The first
+/// terminal to time out therefore disables the pool until it is enabled again.
+class TerminalPool
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Launches a new terminal, returning its pid or nothing if the launch failed.
+    using Launcher = std::function<std::optional<pid_t>()>;
+
+    /// A terminal that has not opened a window within this time is forgotten and disables the pool
+    static constexpr std::chrono::seconds pending_timeout { 15 };
+
+    explicit TerminalPool(Launcher const& launcher);
+
+    /// Changes the number of terminals to keep in the pool.
+    /// @returns The pids of ready terminals that no longer fit, which the caller should close
+    std::vector<pid_t> set_capacity(int capacity);
+    [[nodiscard]] int get_capacity() const { return capacity; }
+
+    /// Launches terminals until pending and ready terminals fill the pool, unless it is disabled.
+    void fill(Clock::time_point now = Clock::now());
+
+    /// Lets the pool launch terminals again, such as after the terminal command changed.
+    void enable();
+    [[nodiscard]] bool is_disabled() const { return disabled; }
+
+    /// @returns true if the pid belongs to a pool terminal that has not opened a window yet
+    [[nodiscard]] bool is_pending(pid_t pid) const;
+
+    /// Marks the pending terminal as ready now that its window exists.
+    /// @returns false if the pid was not pending
+    bool advise_ready(pid_t pid);
+
+    /// Takes the oldest ready terminal out of the pool. The pool is not refilled.
+    std::optional<pid_t> take();
+
+    /// Forgets a terminal that exited or closed its window while in the pool.
+    void remove(pid_t pid);
+
+    [[nodiscard]] std::size_t pending_count() const { return pending.size(); }
+    [[nodiscard]] std::size_t ready_count() const { return ready.size(); }
+
+private:
+    struct Pending
+    {
+        pid_t pid;
+        Clock::time_point launched_at;
+    };
+
+    Launcher launcher;
+    int capacity = 0;
+    bool disabled = false;
+    std::vector<Pending> pending;
+    std::deque<pid_t> ready;
+};
+
+} // miracle
+
+#endif // MIRACLEWM_TERMINAL_POOL_H
@@ -27,6 +27,11 @@ mgl::Primitive mgl::tessellate_renderable_into_rectangle(
 {
     auto rect = renderable.screen_position();
     rect.top_left = rect.top_left - offset;
+    return tessellate_rectangle(rect);
+}
+
+mgl::Primitive mgl::tessellate_rectangle(geom::Rectangle const& rect)
+{
     GLfloat left = rect.top_left.x.as_int();
     GLfloat right = left + rect.size.width.as_int();
     GLfloat top = rect.top_left.y.as_int();
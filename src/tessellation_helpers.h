@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIR_GL_TESSELLATION_HELPERS_H_
 #define MIR_GL_TESSELLATION_HELPERS_H_
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "primitive.h"
 
 namespace mir
@@ -32,6 +33,9 @@ namespace gl
     Primitive tessellate_renderable_into_rectangle(
         graphics::Renderable const& renderable, geometry::Displacement const& offset);
 
+    /// A rectangle whose texture coordinates span the whole texture
+    Primitive tessellate_rectangle(geometry::Rectangle const& rect);
+
 }
 }
 #endif /* MIR_GL_TESSELLATION_HELPERS_H_ */
@@ -0,0 +1,338 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "text_renderer"
+
+#include "text_renderer.h"
+#include "font_face.h"
+#include "glyph_atlas.h"
+#include "miracle_config.h"
+#include <mir/log.h>
+
+#include <cmath>
+#include <glm/gtc/type_ptr.hpp>
+#include <stdexcept>
+
+using namespace miracle;
+
+namespace
+{
+int const atlas_size = 1024;
+
+/// Space between the edge of the title bar and its text
+int const text_padding = 6;
+
+const GLchar* const vertex_shader_src = R"(
+attribute vec2 position;
+attribute vec2 texcoord;
+attribute vec4 color;
+uniform mat4 screen_to_gl_coords;
+uniform mat4 display_transform;
+varying vec2 v_texcoord;
+varying vec4 v_color;
+void main() {
+   gl_Position = display_transform * screen_to_gl_coords * vec4(position, 0.0, 1.0);
+   v_texcoord = texcoord;
+   v_color = color;
+}
+)";
+
+const GLchar* const fragment_shader_src = R"(
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+uniform sampler2D atlas;
+varying vec2 v_texcoord;
+varying vec4 v_color;
+void main() {
+    gl_FragColor = v_color * texture2D(atlas, v_texcoord).a;
+}
+)";
+
+/// The blend function expects premultiplied colors
+glm::vec4 premultiply(glm::vec4 const& color, float alpha)
+{
+    float const a = color.a * alpha;
+    return { glm::vec3(color) * a, a };
+}
+
+GLuint compile_shader(GLenum type, GLchar const* src)
+{
+    GLuint id = glCreateShader(type);
+    if (!id)
+        throw std::runtime_error("Failed to create text shader");
+
+    glShaderSource(id, 1, &src, NULL);
+    glCompileShader(id);
+    GLint ok;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        GLchar log[1024] = "(No log info)";
+        glGetShaderInfoLog(id, sizeof log, NULL, log);
+        glDeleteShader(id);
+        throw std::runtime_error(std::string("Text shader compile failed: ") + log);
+    }
+    return id;
+}
+}
+
+TextRenderer::TextRenderer() = default;
+
+TextRenderer::~TextRenderer()
+{
+    // The renderer makes its output's context current before it destroys this
+    if (texture)
+        glDeleteTextures(1, &texture);
+    if (program)
+        glDeleteProgram(program);
+}
+
+void TextRenderer::queue_title_bar(
+    void const* key,
+    std::string const& title,
+    mir::geometry::Rectangle const& area,
+    glm::mat4 const& transform,
+    glm::vec4 const& background,
+    float alpha,
+    TitleBarConfig const& config)
+{
+    if (!ensure_font(config.font))
+        return;
+
+    queued.push_back({ key, title, area, transform, background, config.text_color, alpha, config.font_size });
+}
+
+bool TextRenderer::ensure_font(std::string const& path)
+{
+    if (font && font->get_path() == path)
+        return true;
+
+    // Do not keep trying to load a font that failed on every frame
+    if (path == failed_font_path)
+        return false;
+
+    try
+    {
+        font = std::make_unique<FontFace>(path);
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_error("Title bars are disabled: %s", e.what());
+        failed_font_path = path;
+        font.reset();
+        return false;
+    }
+
+    atlas = std::make_unique<GlyphAtlas>(atlas_size, atlas_size, [this](char32_t codepoint, int pixel_size)
+    {
+        return font->rasterize(codepoint, pixel_size);
+    });
+
+    // A new atlas starts again from the first generation, so none of the old runs can be trusted
+    runs = TextRunCache();
+    texture_allocated = false;
+    return true;
+}
+
+void TextRenderer::ensure_gl_resources()
+{
+    if (program)
+        return;
+
+    GLuint const vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_src);
+    GLuint fragment_shader;
+    try
+    {
+        fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_src);
+    }
+    catch (...)
+    {
+        glDeleteShader(vertex_shader);
+        throw;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+
+    // The shaders are only marked for deletion until the program that they are linked into goes away
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint ok;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        GLchar log[1024] = "(No log info)";
+        glGetProgramInfoLog(program, sizeof log, NULL, log);
+        glDeleteProgram(program);
+        program = 0;
+        throw std::runtime_error(std::string("Linking text shader failed: ") + log);
+    }
+
+    position_attr = glGetAttribLocation(program, "position");
+    texcoord_attr = glGetAttribLocation(program, "texcoord");
+    color_attr = glGetAttribLocation(program, "color");
+    display_transform_uniform = glGetUniformLocation(program, "display_transform");
+    screen_to_gl_coords_uniform = glGetUniformLocation(program, "screen_to_gl_coords");
+    atlas_uniform = glGetUniformLocation(program, "atlas");
+
+    glGenTextures(1, &texture);
+}
+
+void TextRenderer::build_batch(long long frameno)
+{
+    batch.clear();
+
+    auto const push_vertex = [&](glm::mat4 const& transform, float x, float y, float u, float v, glm::vec4 const& color)
+    {
+        auto const position = transform * glm::vec4(x, y, 0.f, 1.f);
+        batch.push_back({ position.x, position.y, u, v, color.r, color.g, color.b, color.a });
+    };
+
+    auto const push_quad = [&](
+                               glm::mat4 const& transform,
+                               float x0, float y0, float x1, float y1,
+                               float u0, float v0, float u1, float v1,
+                               glm::vec4 const& color)
+    {
+        push_vertex(transform, x0, y0, u0, v0, color);
+        push_vertex(transform, x1, y0, u1, v0, color);
+        push_vertex(transform, x0, y1, u0, v1, color);
+        push_vertex(transform, x1, y0, u1, v0, color);
+        push_vertex(transform, x1, y1, u1, v1, color);
+        push_vertex(transform, x0, y1, u0, v1, color);
+    };
+
+    for (auto const& bar : queued)
+    {
+        auto const background = premultiply(bar.background, bar.alpha);
+        auto const text_color = premultiply(bar.text_color, bar.alpha);
+
+        float const x = bar.area.top_left.x.as_int();
+        float const y = bar.area.top_left.y.as_int();
+        float const width = bar.area.size.width.as_int();
+        float const height = bar.area.size.height.as_int();
+        float const solid_u = atlas->get_solid_u();
+        float const solid_v = atlas->get_solid_v();
+        push_quad(bar.transform, x, y, x + width, y + height, solid_u, solid_v, solid_u, solid_v, background);
+
+        auto const& run = runs.get(
+            bar.key,
+            bar.title,
+            bar.font_size,
+            bar.area.size.width.as_int() - 2 * text_padding,
+            *atlas,
+            frameno);
+
+        // Center the line vertically within the bar
+        auto const [ascender, descender] = font->get_vertical_extents(bar.font_size);
+        float const pen_x = x + text_padding;
+        float const baseline = y + std::round((height + ascender - descender) / 2.f);
+        for (auto const& vertex : run.vertices)
+            push_vertex(bar.transform, pen_x + vertex.x, baseline + vertex.y, vertex.u, vertex.v, text_color);
+    }
+}
+
+void TextRenderer::upload_atlas()
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (!texture_allocated)
+    {
+        atlas->consume_dirty_rows();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, atlas->get_width(), atlas->get_height(), 0,
+            GL_ALPHA, GL_UNSIGNED_BYTE, atlas->get_pixels());
+        texture_allocated = true;
+    }
+    else if (auto const rows = atlas->consume_dirty_rows())
+    {
+        // Only the rows that gained new glyphs are sent to the GPU
+        auto const [first, last] = rows.value();
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, atlas->get_width(), last - first,
+            GL_ALPHA, GL_UNSIGNED_BYTE, atlas->get_pixels() + static_cast<size_t>(first) * atlas->get_width());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextRenderer::flush(glm::mat4 const& display_transform, glm::mat4 const& screen_to_gl_coords, long long frameno)
+{
+    if (queued.empty() || !font)
+    {
+        queued.clear();
+        return;
+    }
+
+    try
+    {
+        ensure_gl_resources();
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_error("Unable to draw title bars: %s", e.what());
+        queued.clear();
+        return;
+    }
+
+    build_batch(frameno);
+    if (atlas->is_full())
+    {
+        // Make room by starting over with only the glyphs that are on screen right now
+        atlas->clear();
+        build_batch(frameno);
+    }
+    queued.clear();
+
+    if (batch.empty())
+        return;
+
+    upload_atlas();
+
+    glUseProgram(program);
+    glUniformMatrix4fv(display_transform_uniform, 1, GL_FALSE, glm::value_ptr(display_transform));
+    glUniformMatrix4fv(screen_to_gl_coords_uniform, 1, GL_FALSE, glm::value_ptr(screen_to_gl_coords));
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(atlas_uniform, 0);
+
+    glEnableVertexAttribArray(position_attr);
+    glEnableVertexAttribArray(texcoord_attr);
+    glEnableVertexAttribArray(color_attr);
+    glVertexAttribPointer(position_attr, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), &batch[0].x);
+    glVertexAttribPointer(texcoord_attr, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), &batch[0].u);
+    glVertexAttribPointer(color_attr, 4, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), &batch[0].r);
+
+    glDisable(GL_STENCIL_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(batch.size()));
+
+    glDisableVertexAttribArray(color_attr);
+    glDisableVertexAttribArray(texcoord_attr);
+    glDisableVertexAttribArray(position_attr);
+}
+
+void TextRenderer::evict_unused_since(long long frameno)
+{
+    runs.evict_unused_since(frameno);
+}
@@ -0,0 +1,112 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_TEXT_RENDERER_H
+#define MIRACLEWM_TEXT_RENDERER_H
+
+#include "text_run_cache.h"
+#include <GLES2/gl2.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <mir/geometry/rectangle.h>
+#include <string>
+#include <vector>
+
+namespace miracle
+{
+class FontFace;
+class GlyphAtlas;
+struct TitleBarConfig;
+
+/// Draws title bars for the renderer. Glyphs are rasterized into an atlas once per font
+/// size and titles are laid out into runs that are only rebuilt when the title changes.
+/// Everything that is queued during a frame is drawn with a single draw call.
+///
+/// All methods must be called on the rendering thread. flush must be called with a
+/// current GL context.
+class TextRenderer
+{
+public:
+    TextRenderer();
+    ~TextRenderer();
+
+    /// Queues a title bar for the next flush.
+    /// @param key identifies the owner of the title, so that its layout can be reused across frames
+    /// @param transform applied to the title bar on the CPU before it is drawn
+    void queue_title_bar(
+        void const* key,
+        std::string const& title,
+        mir::geometry::Rectangle const& area,
+        glm::mat4 const& transform,
+        glm::vec4 const& background,
+        float alpha,
+        TitleBarConfig const& config);
+
+    [[nodiscard]] bool has_queued() const { return !queued.empty(); }
+
+    /// Draws everything that has been queued since the last flush
+    void flush(glm::mat4 const& display_transform, glm::mat4 const& screen_to_gl_coords, long long frameno);
+
+    /// Forgets the layout of titles that have not been drawn since the provided frame
+    void evict_unused_since(long long frameno);
+
+private:
+    struct QueuedTitleBar
+    {
+        void const* key;
+        std::string title;
+        mir::geometry::Rectangle area;
+        glm::mat4 transform;
+        glm::vec4 background;
+        glm::vec4 text_color;
+        float alpha;
+        int font_size;
+    };
+
+    struct BatchVertex
+    {
+        float x, y;
+        float u, v;
+        float r, g, b, a;
+    };
+
+    bool ensure_font(std::string const& path);
+    void ensure_gl_resources();
+    void build_batch(long long frameno);
+    void upload_atlas();
+
+    std::unique_ptr<FontFace> font;
+    std::string failed_font_path;
+    std::unique_ptr<GlyphAtlas> atlas;
+    TextRunCache runs;
+    std::vector<QueuedTitleBar> queued;
+    std::vector<BatchVertex> batch;
+
+    GLuint program = 0;
+    GLuint texture = 0;
+    bool texture_allocated = false;
+    GLint position_attr = -1;
+    GLint texcoord_attr = -1;
+    GLint color_attr = -1;
+    GLint display_transform_uniform = -1;
+    GLint screen_to_gl_coords_uniform = -1;
+    GLint atlas_uniform = -1;
+};
+
+}
+
+#endif // MIRACLEWM_TEXT_RENDERER_H
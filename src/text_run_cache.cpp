@@ -0,0 +1,167 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "text_run_cache.h"
+#include "glyph_atlas.h"
+
+using namespace miracle;
+
+namespace
+{
+char32_t const replacement_character = 0xFFFD;
+}
+
+std::u32string miracle::decode_utf8(std::string_view in)
+{
+    std::u32string result;
+    result.reserve(in.size());
+
+    size_t i = 0;
+    while (i < in.size())
+    {
+        auto const lead = static_cast<unsigned char>(in[i]);
+        int length;
+        char32_t codepoint;
+        if (lead < 0x80)
+        {
+            length = 1;
+            codepoint = lead;
+        }
+        else if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2;
+            codepoint = lead & 0x1F;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3;
+            codepoint = lead & 0x0F;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4;
+            codepoint = lead & 0x07;
+        }
+        else
+        {
+            result.push_back(replacement_character);
+            i++;
+            continue;
+        }
+
+        if (i + length > in.size())
+        {
+            result.push_back(replacement_character);
+            break;
+        }
+
+        bool valid = true;
+        for (int j = 1; j < length; j++)
+        {
+            auto const continuation = static_cast<unsigned char>(in[i + j]);
+            if ((continuation & 0xC0) != 0x80)
+            {
+                valid = false;
+                break;
+            }
+            codepoint = (codepoint << 6) | (continuation & 0x3F);
+        }
+
+        if (!valid)
+        {
+            result.push_back(replacement_character);
+            i++;
+            continue;
+        }
+
+        result.push_back(codepoint);
+        i += length;
+    }
+
+    return result;
+}
+
+TextRun const& TextRunCache::get(
+    void const* key,
+    std::string const& text,
+    int pixel_size,
+    int max_width,
+    GlyphAtlas& atlas,
+    long long frameno)
+{
+    auto& run = runs[key];
+    run.last_used = frameno;
+    if (run.text != text
+        || run.pixel_size != pixel_size
+        || run.max_width != max_width
+        || run.atlas_generation != atlas.get_generation())
+    {
+        run.text = text;
+        run.pixel_size = pixel_size;
+        run.max_width = max_width;
+        layout(run, atlas);
+    }
+
+    return run;
+}
+
+void TextRunCache::evict_unused_since(long long frameno)
+{
+    std::erase_if(runs, [&](auto const& entry)
+    {
+        return entry.second.last_used < frameno;
+    });
+}
+
+void TextRunCache::layout(TextRun& run, GlyphAtlas& atlas)
+{
+    layout_count++;
+    run.vertices.clear();
+    run.width = 0;
+
+    float pen = 0;
+    for (auto const codepoint : decode_utf8(run.text))
+    {
+        auto const* glyph = atlas.get(codepoint, run.pixel_size);
+        if (!glyph)
+            glyph = atlas.get(replacement_character, run.pixel_size);
+        if (!glyph)
+            continue;
+
+        if (pen + glyph->bearing_x + glyph->width > run.max_width)
+            break;
+
+        if (glyph->width > 0 && glyph->height > 0)
+        {
+            float const x0 = pen + glyph->bearing_x;
+            float const y0 = -glyph->bearing_y;
+            float const x1 = x0 + glyph->width;
+            float const y1 = y0 + glyph->height;
+            run.vertices.push_back({ x0, y0, glyph->u0, glyph->v0 });
+            run.vertices.push_back({ x1, y0, glyph->u1, glyph->v0 });
+            run.vertices.push_back({ x0, y1, glyph->u0, glyph->v1 });
+            run.vertices.push_back({ x1, y0, glyph->u1, glyph->v0 });
+            run.vertices.push_back({ x1, y1, glyph->u1, glyph->v1 });
+            run.vertices.push_back({ x0, y1, glyph->u0, glyph->v1 });
+        }
+
+        pen += glyph->advance;
+        run.width = pen;
+    }
+
+    run.atlas_generation = atlas.get_generation();
+}
@@ -0,0 +1,88 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_TEXT_RUN_CACHE_H
+#define MIRACLEWM_TEXT_RUN_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace miracle
+{
+class GlyphAtlas;
+
+/// Decodes UTF-8, replacing malformed sequences with U+FFFD
+std::u32string decode_utf8(std::string_view);
+
+/// A corner of a glyph quad, relative to the pen position at the start of the baseline
+struct TextVertex
+{
+    float x, y;
+    float u, v;
+};
+
+/// A string that has been laid out against the glyph atlas
+struct TextRun
+{
+    std::string text;
+    int pixel_size = 0;
+    int max_width = 0;
+    uint64_t atlas_generation = 0;
+
+    /// Two triangles for each visible glyph
+    std::vector<TextVertex> vertices;
+    float width = 0;
+    long long last_used = 0;
+};
+
+/// Keeps laid out text runs keyed on their owner, such as a window. A run is only laid
+/// out again when its text, size or width changes, or when the atlas was cleared, so
+/// redrawing an unchanged title costs nothing but a string comparison.
+class TextRunCache
+{
+public:
+    /// Returns the run for the key, laying out the text again if it is stale. Glyphs that do
+    /// not fit into max_width are dropped.
+    TextRun const& get(
+        void const* key,
+        std::string const& text,
+        int pixel_size,
+        int max_width,
+        GlyphAtlas& atlas,
+        long long frameno);
+
+    /// Drops the runs that have not been used since the provided frame
+    void evict_unused_since(long long frameno);
+
+    [[nodiscard]] size_t size() const { return runs.size(); }
+
+    /// The number of times that a run was laid out, for diagnostics
+    [[nodiscard]] size_t get_layout_count() const { return layout_count; }
+
+private:
+    void layout(TextRun& run, GlyphAtlas& atlas);
+
+    std::unordered_map<void const*, TextRun> runs;
+    size_t layout_count = 0;
+};
+
+}
+
+#endif // MIRACLEWM_TEXT_RUN_CACHE_H
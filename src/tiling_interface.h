@@ -18,6 +18,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_TILING_INTERFACE_H
 #define MIRACLEWM_TILING_INTERFACE_H
 
+#include "stacking_layer.h"
+#include <memory>
 #include <miral/window.h>
 
 namespace geom = mir::geometry;
@@ -32,17 +34,17 @@ class TilingInterface
 {
 public:
     virtual bool is_fullscreen(miral::Window const&) = 0;
-    virtual void set_rectangle(miral::Window const&, geom::Rectangle const&, geom::Rectangle const&) = 0;
+    virtual void set_rectangle(std::shared_ptr<WindowMetadata> const&, geom::Rectangle const&, geom::Rectangle const&) = 0;
     virtual MirWindowState get_state(miral::Window const&) = 0;
     virtual void change_state(miral::Window const&, MirWindowState state) = 0;
+    virtual geom::Size get_min_size(miral::Window const&) = 0;
+    virtual geom::Size get_max_size(miral::Window const&) = 0;
     virtual void clip(miral::Window const&, geom::Rectangle const&) = 0;
     virtual void noclip(miral::Window const&) = 0;
     virtual void select_active_window(miral::Window const&) = 0;
-    virtual std::shared_ptr<WindowMetadata> get_metadata(miral::Window const&) = 0;
-    virtual std::shared_ptr<WindowMetadata> get_metadata(miral::Window const&, TilingWindowTree const*) = 0;
-    virtual void raise(miral::Window const&) = 0;
-    virtual void send_to_back(miral::Window const&) = 0;
-    virtual void open(miral::Window const&) = 0;
+    /// Moves the window into the provided layer. Nothing is restacked if it is already there.
+    virtual void set_layer(miral::Window const&, StackingLayer) = 0;
+    virtual void open(std::shared_ptr<WindowMetadata> const&) = 0;
     virtual void on_animation(miracle::AnimationStepResult const& result, std::shared_ptr<WindowMetadata> const&) = 0;
 };
 
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "leaf_node.h"
 #include "miracle_config.h"
+#include "miracle_log.h"
 #include "output_content.h"
 #include "parent_node.h"
 #include "tiling_window_tree.h"
@@ -50,7 +51,9 @@ TilingWindowTree::TilingWindowTree(
     config_handle = config->register_listener([&](auto&)
     {
         recalculate_root_node_area();
-    });
+    },
+        5,
+        config_section_gaps | config_section_title_bar);
 }
 
 TilingWindowTree::~TilingWindowTree()
@@ -62,11 +65,18 @@ miral::WindowSpecification TilingWindowTree::allocate_position(const miral::Wind
 {
     miral::WindowSpecification new_spec = requested_specification;
     new_spec.server_side_decorated() = false;
-    new_spec.min_width() = geom::Width { 0 };
-    new_spec.max_width() = geom::Width { std::numeric_limits<int>::max() };
-    new_spec.min_height() = geom::Height { 0 };
-    new_spec.max_height() = geom::Height { std::numeric_limits<int>::max() };
-    auto node = get_active_lane()->create_space_for_window();
+    std::shared_ptr<LeafNode> node = find_placeholder(requested_specification);
+    if (node)
+    {
+        pending_lane = node->get_parent().lock();
+        pending_lane->claim_placeholder(node);
+    }
+    else
+    {
+        pending_lane = get_active_lane();
+        node = pending_lane->create_space_for_window();
+    }
+
     auto rect = node->get_visible_area();
     new_spec.size() = rect.size;
     new_spec.top_left() = rect.top_left;
@@ -79,22 +89,47 @@ miral::WindowSpecification TilingWindowTree::allocate_position(const miral::Wind
     return new_spec;
 }
 
-std::shared_ptr<LeafNode> TilingWindowTree::advise_new_window(miral::WindowInfo const& window_info)
+std::shared_ptr<LeafNode> TilingWindowTree::advise_new_window(
+    miral::WindowInfo const& window_info, std::shared_ptr<WindowMetadata> const& metadata)
 {
-    auto node = get_active_lane()->confirm_window(window_info.window());
+    auto lane = pending_lane ? pending_lane : get_active_lane();
+    pending_lane = nullptr;
+    auto node = lane->confirm_window(window_info.window(), metadata);
     if (window_helpers::is_window_fullscreen(window_info.state()))
     {
         tiling_interface.select_active_window(window_info.window());
-        advise_fullscreen_window(window_info.window());
+        advise_fullscreen_window(node);
     }
     else
     {
-        tiling_interface.send_to_back(window_info.window());
+        // Windows that were floating are brought back down to the tiled layer
+        tiling_interface.set_layer(window_info.window(), StackingLayer::tiled);
     }
 
     return node;
 }
 
+void TilingWindowTree::append_layout(std::vector<LayoutDescription> const& descriptions)
+{
+    if (descriptions.empty())
+        return;
+
+    root_lane->append_layout(descriptions);
+    if (!is_hidden)
+        root_lane->commit_changes();
+}
+
+std::shared_ptr<LeafNode> TilingWindowTree::find_placeholder(miral::WindowSpecification const& spec)
+{
+    auto const app_id = spec.application_id().is_set() ? spec.application_id().value() : std::string();
+    auto const title = spec.name().is_set() ? spec.name().value() : std::string();
+    return Node::as_leaf(root_lane->find_where([&](std::shared_ptr<Node> const& node)
+    {
+        auto leaf = Node::as_leaf(node);
+        return leaf && leaf->is_placeholder() && leaf->can_swallow(app_id, title);
+    }));
+}
+
 void TilingWindowTree::toggle_resize_mode()
 {
     is_resizing = !is_resizing;
@@ -104,19 +139,19 @@ bool TilingWindowTree::try_resize_active_window(miracle::Direction direction)
 {
     if (!is_resizing)
     {
-        mir::log_warning("Unable to resize the active window: not resizing");
+        MIRACLE_LOG_WARNING("Unable to resize the active window: not resizing");
         return false;
     }
 
     if (is_active_window_fullscreen)
     {
-        mir::log_warning("Unable to resize the next window: fullscreened");
+        MIRACLE_LOG_WARNING("Unable to resize the next window: fullscreened");
         return false;
     }
 
     if (!active_window)
     {
-        mir::log_warning("Unable to resize the active window: active window is not set");
+        MIRACLE_LOG_WARNING("Unable to resize the active window: active window is not set");
         return false;
     }
 
@@ -128,26 +163,26 @@ bool TilingWindowTree::try_select_next(miracle::Direction direction)
 {
     if (is_active_window_fullscreen)
     {
-        mir::log_warning("Unable to select the next window: fullscreened");
+        MIRACLE_LOG_WARNING("Unable to select the next window: fullscreened");
         return false;
     }
 
     if (is_resizing)
     {
-        mir::log_warning("Unable to select the next window: resizing");
+        MIRACLE_LOG_WARNING("Unable to select the next window: resizing");
         return false;
     }
 
     if (!active_window)
     {
-        mir::log_warning("Unable to select the next window: active window not set");
+        MIRACLE_LOG_WARNING("Unable to select the next window: active window not set");
         return false;
     }
 
     auto node = handle_select(active_window, direction);
     if (!node)
     {
-        mir::log_warning("Unable to select the next window: handle_select failed");
+        MIRACLE_LOG_WARNING("Unable to select the next window: handle_select failed");
         return false;
     }
 
@@ -159,27 +194,33 @@ bool TilingWindowTree::try_toggle_active_fullscreen()
 {
     if (is_resizing)
     {
-        mir::log_warning("Cannot toggle fullscreen while resizing");
+        MIRACLE_LOG_WARNING("Cannot toggle fullscreen while resizing");
         return false;
     }
 
     if (!active_window)
     {
-        mir::log_warning("Active window is null while trying to toggle fullscreen");
+        MIRACLE_LOG_WARNING("Active window is null while trying to toggle fullscreen");
         return false;
     }
 
     active_window->toggle_fullscreen();
     active_window->commit_changes();
     if (is_active_window_fullscreen)
-        advise_restored_window(active_window->get_window());
+        advise_restored_window(active_window);
     else
-        advise_fullscreen_window(active_window->get_window());
+        advise_fullscreen_window(active_window);
     return true;
 }
 
 void TilingWindowTree::set_output_area(geom::Rectangle const& new_area)
 {
+    if (is_hidden)
+    {
+        pending_area = new_area;
+        return;
+    }
+
     root_lane->set_logical_area(new_area);
     root_lane->commit_changes();
 }
@@ -194,7 +235,8 @@ std::shared_ptr<LeafNode> TilingWindowTree::select_window_from_point(int x, int
 
     auto node = root_lane->find_where([&](std::shared_ptr<Node> const& node)
     {
-        return node->is_leaf() && node->get_logical_area().contains(geom::Point(x, y));
+        auto leaf = Node::as_leaf(node);
+        return leaf && !leaf->is_placeholder() && leaf->get_logical_area().contains(geom::Point(x, y));
     });
 
     return Node::as_leaf(node);
@@ -204,19 +246,19 @@ bool TilingWindowTree::try_move_active_window(miracle::Direction direction)
 {
     if (is_active_window_fullscreen)
     {
-        mir::log_warning("Unable to move active window: fullscreen");
+        MIRACLE_LOG_WARNING("Unable to move active window: fullscreen");
         return false;
     }
 
     if (is_resizing)
     {
-        mir::log_warning("Unable to move active window: resizing");
+        MIRACLE_LOG_WARNING("Unable to move active window: resizing");
         return false;
     }
 
     if (!active_window)
     {
-        mir::log_warning("Unable to move active window: active window not set");
+        MIRACLE_LOG_WARNING("Unable to move active window: active window not set");
         return false;
     }
 
@@ -228,14 +270,14 @@ bool TilingWindowTree::try_move_active_window(miracle::Direction direction)
         auto target_node = traversal_result.node;
         if (!target_node)
         {
-            mir::log_warning("Unable to move active window: target_window not found");
+            MIRACLE_LOG_WARNING("Unable to move active window: target_window not found");
             return false;
         }
 
         auto target_parent = target_node->get_parent().lock();
         if (!target_parent)
         {
-            mir::log_warning("Unable to move active window: second_window has no second_parent");
+            MIRACLE_LOG_WARNING("Unable to move active window: second_window has no second_parent");
             return false;
         }
 
@@ -294,19 +336,19 @@ void TilingWindowTree::handle_direction_change(NodeLayoutDirection direction)
 {
     if (is_active_window_fullscreen)
     {
-        mir::log_warning("Unable to handle direction request: fullscreen");
+        MIRACLE_LOG_WARNING("Unable to handle direction request: fullscreen");
         return;
     }
 
     if (is_resizing)
     {
-        mir::log_warning("Unable to handle direction request: resizing");
+        MIRACLE_LOG_WARNING("Unable to handle direction request: resizing");
         return;
     }
 
     if (!active_window)
     {
-        mir::log_warning("Unable to handle direction request: active window not set");
+        MIRACLE_LOG_WARNING("Unable to handle direction request: active window not set");
         return;
     }
 
@@ -316,42 +358,42 @@ void TilingWindowTree::handle_direction_change(NodeLayoutDirection direction)
     get_active_lane()->set_direction(direction);
 }
 
-void TilingWindowTree::advise_focus_gained(miral::Window& window)
+bool TilingWindowTree::owns(std::shared_ptr<LeafNode> const& node) const
+{
+    return node && node->get_tree() == this;
+}
+
+void TilingWindowTree::advise_focus_gained(std::shared_ptr<LeafNode> const& node)
 {
     is_resizing = false;
 
-    auto metadata = tiling_interface.get_metadata(window, this);
-    if (!metadata)
+    if (!owns(node))
     {
         active_window = nullptr;
         return;
     }
 
-    active_window = metadata->get_tiling_node();
-    if (active_window && is_active_window_fullscreen)
-        tiling_interface.raise(window);
-    else
-        tiling_interface.send_to_back(window);
+    // Tiled windows never overlap and a fullscreen window already sits in its own layer,
+    // so focus changes do not need to restack anything.
+    active_window = node;
 }
 
-void TilingWindowTree::advise_focus_lost(miral::Window& window)
+void TilingWindowTree::advise_focus_lost(std::shared_ptr<LeafNode> const& node)
 {
     is_resizing = false;
 
-    if (active_window != nullptr && active_window->get_window() == window && !is_active_window_fullscreen)
+    if (active_window != nullptr && active_window == node && !is_active_window_fullscreen)
         active_window = nullptr;
 }
 
-void TilingWindowTree::advise_delete_window(miral::Window& window)
+void TilingWindowTree::advise_delete_window(std::shared_ptr<LeafNode> const& window_node)
 {
-    auto metadata = tiling_interface.get_metadata(window, this);
-    if (!metadata)
+    if (!owns(window_node))
     {
-        mir::log_warning("Unable to delete window: cannot find node");
+        MIRACLE_LOG_WARNING("Unable to delete window: cannot find node");
         return;
     }
 
-    auto window_node = metadata->get_tiling_node();
     if (window_node == active_window)
     {
         active_window = nullptr;
@@ -401,7 +443,10 @@ std::shared_ptr<LeafNode> get_closest_window_to_select_from_node(
     // from, a seamless experience would mean that - at times - we select the _LAST_ node in that list, instead
     // of the first one. This makes it feel as though we are moving "across" the screen.
     if (node->is_leaf())
-        return Node::as_leaf(node);
+    {
+        auto leaf = Node::as_leaf(node);
+        return leaf->is_placeholder() ? nullptr : leaf;
+    }
 
     bool is_vertical = is_vertical_direction(direction);
     bool is_negative = is_negative_direction(direction);
@@ -447,7 +492,7 @@ std::shared_ptr<LeafNode> TilingWindowTree::handle_select(
     auto parent = current_node->get_parent().lock();
     if (!parent)
     {
-        mir::log_warning("Cannot handle_select the root node");
+        MIRACLE_LOG_WARNING("Cannot handle_select the root node");
         return nullptr;
     }
 
@@ -458,15 +503,22 @@ std::shared_ptr<LeafNode> TilingWindowTree::handle_select(
         if (is_vertical && grandparent_direction == NodeLayoutDirection::vertical
             || !is_vertical && grandparent_direction == NodeLayoutDirection::horizontal)
         {
+            // Placeholders cannot be selected, so we keep looking past them
             if (is_negative)
             {
-                if (index > 0)
-                    return get_closest_window_to_select_from_node(parent->at(index - 1), direction);
+                for (int i = index - 1; i >= 0; i--)
+                {
+                    if (auto retval = get_closest_window_to_select_from_node(parent->at(i), direction))
+                        return retval;
+                }
             }
             else
             {
-                if (index < parent->num_nodes() - 1)
-                    return get_closest_window_to_select_from_node(parent->at(index + 1), direction);
+                for (int i = index + 1; i < static_cast<int>(parent->num_nodes()); i++)
+                {
+                    if (auto retval = get_closest_window_to_select_from_node(parent->at(i), direction))
+                        return retval;
+                }
             }
         }
 
@@ -585,7 +637,13 @@ void TilingWindowTree::handle_resize(
 
             if (other_rect.size.height.as_int() <= other_node->get_min_height())
             {
-                mir::log_warning("Unable to resize a rectangle that would cause another to be negative");
+                MIRACLE_LOG_WARNING("Unable to resize a rectangle that would cause another to be negative");
+                return;
+            }
+
+            if (static_cast<size_t>(other_rect.size.height.as_int()) > other_node->get_max_height())
+            {
+                MIRACLE_LOG_WARNING("Unable to resize a rectangle beyond its maximum height");
                 return;
             }
 
@@ -618,7 +676,13 @@ void TilingWindowTree::handle_resize(
 
             if (other_rect.size.width.as_int() <= other_node->get_min_width())
             {
-                mir::log_warning("Unable to resize a rectangle that would cause another to be negative");
+                MIRACLE_LOG_WARNING("Unable to resize a rectangle that would cause another to be negative");
+                return;
+            }
+
+            if (static_cast<size_t>(other_rect.size.width.as_int()) > other_node->get_max_width())
+            {
+                MIRACLE_LOG_WARNING("Unable to resize a rectangle beyond its maximum width");
                 return;
             }
 
@@ -673,8 +737,22 @@ std::tuple<std::shared_ptr<ParentNode>, std::shared_ptr<ParentNode>> TilingWindo
     return { target_parent, to_update };
 }
 
+void TilingWindowTree::advise_constraints_changed()
+{
+    // Laying the root out again re-solves every lane against the new constraints
+    recalculate_root_node_area();
+}
+
 void TilingWindowTree::recalculate_root_node_area()
 {
+    if (is_hidden)
+    {
+        // Resizing a hidden tree is wasted work on large multi-output setups,
+        // so we wait until the tree is shown again.
+        needs_area_recalculation = true;
+        return;
+    }
+
     for (auto const& zone : screen->get_app_zones())
     {
         root_lane->set_logical_area(zone.extents());
@@ -683,26 +761,25 @@ void TilingWindowTree::recalculate_root_node_area()
     }
 }
 
-bool TilingWindowTree::advise_fullscreen_window(miral::Window& window)
+bool TilingWindowTree::advise_fullscreen_window(std::shared_ptr<LeafNode> const& node)
 {
-    auto node = tiling_interface.get_metadata(window, this);
-    if (!node)
+    if (!owns(node))
         return false;
 
     tiling_interface.select_active_window(node->get_window());
-    tiling_interface.raise(node->get_window());
+    tiling_interface.set_layer(node->get_window(), StackingLayer::fullscreen);
     is_active_window_fullscreen = true;
     is_resizing = false;
     return true;
 }
 
-bool TilingWindowTree::advise_restored_window(miral::Window& window)
+bool TilingWindowTree::advise_restored_window(std::shared_ptr<LeafNode> const& node)
 {
-    auto metadata = tiling_interface.get_metadata(window, this);
-    if (!metadata)
+    if (!owns(node))
         return false;
 
-    if (metadata->get_tiling_node() == active_window && is_active_window_fullscreen)
+    tiling_interface.set_layer(node->get_window(), StackingLayer::tiled);
+    if (node == active_window && is_active_window_fullscreen)
     {
         is_active_window_fullscreen = false;
         active_window->set_logical_area(active_window->get_logical_area());
@@ -712,13 +789,12 @@ bool TilingWindowTree::advise_restored_window(miral::Window& window)
     return true;
 }
 
-bool TilingWindowTree::handle_window_ready(miral::WindowInfo& window_info)
+bool TilingWindowTree::handle_window_ready(miral::WindowInfo& window_info, std::shared_ptr<LeafNode> const& node)
 {
-    auto metadata = tiling_interface.get_metadata(window_info.window(), this);
-    if (!metadata)
+    if (!owns(node))
         return false;
 
-    constrain(window_info.window());
+    constrain(node);
 
     if (is_active_window_fullscreen)
         return true;
@@ -729,10 +805,9 @@ bool TilingWindowTree::handle_window_ready(miral::WindowInfo& window_info)
     return true;
 }
 
-bool TilingWindowTree::advise_state_change(miral::Window const& window, MirWindowState state)
+bool TilingWindowTree::advise_state_change(std::shared_ptr<LeafNode> const& node, MirWindowState state)
 {
-    auto metadata = tiling_interface.get_metadata(window, this);
-    if (!metadata)
+    if (!owns(node))
         return false;
 
     if (is_hidden)
@@ -742,16 +817,14 @@ bool TilingWindowTree::advise_state_change(miral::Window const& window, MirWindo
 }
 
 bool TilingWindowTree::confirm_placement_on_display(
-    miral::Window const& window,
+    std::shared_ptr<LeafNode> const& node,
     MirWindowState new_state,
     mir::geometry::Rectangle& new_placement)
 {
-    auto metadata = tiling_interface.get_metadata(window, this);
-    if (!metadata)
+    if (!owns(node))
         return false;
 
-    auto node = metadata->get_tiling_node();
-    auto node_rectangle = node->get_visible_area();
+    auto node_rectangle = node->get_configured_area();
     switch (new_state)
     {
     case mir_window_state_restored:
@@ -764,16 +837,14 @@ bool TilingWindowTree::confirm_placement_on_display(
     return true;
 }
 
-bool TilingWindowTree::constrain(miral::Window& window)
+bool TilingWindowTree::constrain(std::shared_ptr<LeafNode> const& node)
 {
-    auto metadata = tiling_interface.get_metadata(window, this);
-    if (!metadata)
+    if (!owns(node))
         return false;
 
     if (is_hidden)
         return false;
 
-    auto node = metadata->get_tiling_node();
     if (node->get_parent().expired())
     {
         mir::log_error("Unable to constrain node without parent");
@@ -823,7 +894,7 @@ void TilingWindowTree::hide()
 {
     if (is_hidden)
     {
-        mir::log_warning("Tree is already hidden");
+        MIRACLE_LOG_WARNING("Tree is already hidden");
         return;
     }
 
@@ -843,11 +914,23 @@ void TilingWindowTree::show()
 {
     if (!is_hidden)
     {
-        mir::log_warning("Tree is already shown");
+        MIRACLE_LOG_WARNING("Tree is already shown");
         return;
     }
 
     is_hidden = false;
+    if (pending_area)
+    {
+        set_output_area(pending_area.value());
+        pending_area.reset();
+    }
+
+    if (needs_area_recalculation)
+    {
+        needs_area_recalculation = false;
+        recalculate_root_node_area();
+    }
+
     foreach_node([&](auto node)
     {
         auto leaf_node = Node::as_leaf(node);
@@ -859,7 +942,7 @@ void TilingWindowTree::show()
             if (leaf_node->is_fullscreen())
             {
                 tiling_interface.select_active_window(leaf_node->get_window());
-                tiling_interface.raise(leaf_node->get_window());
+                tiling_interface.set_layer(leaf_node->get_window(), StackingLayer::fullscreen);
             }
         }
     });
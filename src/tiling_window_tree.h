@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MIRACLE_TREE_H
 
 #include "direction.h"
+#include "layout_description.h"
 #include "node.h"
 #include "node_common.h"
 #include <memory>
@@ -27,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <miral/window_manager_tools.h>
 #include <miral/window_specification.h>
 #include <miral/zone.h>
+#include <optional>
 #include <vector>
 
 namespace geom = mir::geometry;
@@ -37,6 +39,7 @@ namespace miracle
 class OutputContent;
 class MiracleConfig;
 class TilingInterface;
+class WindowMetadata;
 
 class TilingWindowTree
 {
@@ -48,10 +51,14 @@ public:
     ~TilingWindowTree();
 
     /// Makes space for the new window and returns its specified spot in the grid. Note that the returned
-    /// position is the position WITH gaps.
+    /// position is the position WITH gaps. A window that a placeholder can swallow takes that placeholder's spot.
     miral::WindowSpecification allocate_position(const miral::WindowSpecification& requested_specification);
 
-    std::shared_ptr<LeafNode> advise_new_window(miral::WindowInfo const&);
+    /// Appends the described containers and placeholders to the root of the tree in a single layout pass.
+    void append_layout(std::vector<LayoutDescription> const&);
+
+    /// Places the window into the space allocated for it and associates the new node with the metadata
+    std::shared_ptr<LeafNode> advise_new_window(miral::WindowInfo const&, std::shared_ptr<WindowMetadata> const&);
 
     /// Places us into resize mode. Other operations are prohibited while we are in resize mode.
     void toggle_resize_mode();
@@ -70,38 +77,44 @@ public:
 
     bool has_fullscreen_window() const { return is_active_window_fullscreen; }
 
+    /// The node that is fullscreen in this tree, if any
+    std::shared_ptr<LeafNode> get_fullscreen_node() const { return is_active_window_fullscreen ? active_window : nullptr; }
+
     // Request a change to vertical window placement
     void request_vertical();
 
     // Request a change to horizontal window placement
     void request_horizontal();
 
+    // The methods below take the node of a window. They return early (or false) when the
+    // node does not belong to this tree.
+
     /// Advises us to focus the provided window.
-    void advise_focus_gained(miral::Window&);
+    void advise_focus_gained(std::shared_ptr<LeafNode> const&);
 
     /// Advises us to lose focus on the provided window.
-    void advise_focus_lost(miral::Window&);
+    void advise_focus_lost(std::shared_ptr<LeafNode> const&);
 
     /// Called when the window was deleted.
-    void advise_delete_window(miral::Window&);
+    void advise_delete_window(std::shared_ptr<LeafNode> const&);
 
     /// Called when the physical display is resized.
     void set_output_area(geom::Rectangle const& new_area);
 
     std::shared_ptr<LeafNode> select_window_from_point(int x, int y);
 
-    bool advise_fullscreen_window(miral::Window&);
-    bool advise_restored_window(miral::Window&);
-    bool handle_window_ready(miral::WindowInfo& window_info);
+    bool advise_fullscreen_window(std::shared_ptr<LeafNode> const&);
+    bool advise_restored_window(std::shared_ptr<LeafNode> const&);
+    bool handle_window_ready(miral::WindowInfo& window_info, std::shared_ptr<LeafNode> const&);
 
-    bool advise_state_change(miral::Window const& window, MirWindowState state);
+    bool advise_state_change(std::shared_ptr<LeafNode> const&, MirWindowState state);
     bool confirm_placement_on_display(
-        miral::Window const& window,
+        std::shared_ptr<LeafNode> const&,
         MirWindowState new_state,
         mir::geometry::Rectangle& new_placement);
 
     /// Constrains the window to its tile if it is in this tree.
-    bool constrain(miral::Window& window);
+    bool constrain(std::shared_ptr<LeafNode> const&);
 
     void foreach_node(std::function<void(std::shared_ptr<Node>)> const&);
 
@@ -113,6 +126,9 @@ public:
     /// Shows the entire tree
     void show();
 
+    /// Re-solves the layout after a window's size constraints have changed.
+    void advise_constraints_changed();
+
     void recalculate_root_node_area();
     bool is_empty();
 
@@ -137,12 +153,19 @@ private:
 
     // TODO: We can probably remove active_window and just resolve it efficiently now?
     std::shared_ptr<LeafNode> active_window;
+
+    /// The lane that holds the space made by allocate_position, until advise_new_window confirms it
+    std::shared_ptr<ParentNode> pending_lane;
     bool is_resizing = false;
     bool is_active_window_fullscreen = false;
     bool is_hidden = false;
+    bool needs_area_recalculation = false;
+    std::optional<geom::Rectangle> pending_area;
     int config_handle = 0;
 
     std::shared_ptr<ParentNode> get_active_lane();
+    std::shared_ptr<LeafNode> find_placeholder(miral::WindowSpecification const&);
+    [[nodiscard]] bool owns(std::shared_ptr<LeafNode> const& node) const;
     void handle_direction_change(NodeLayoutDirection direction);
     void handle_resize(std::shared_ptr<Node> const& node, Direction direction, int amount);
 
@@ -100,4 +100,41 @@ miral::WindowSpecification miracle::window_helpers::copy_from(miral::WindowInfo
     spec.focus_mode() = info.focus_mode();
     spec.visible_on_lock_screen() = info.visible_on_lock_screen();
     return spec;
-}
\ No newline at end of file
+}
+
+uint64_t miracle::window_helpers::get_container_id(miral::Window const& window)
+{
+    std::shared_ptr<mir::scene::Surface> const surface = window;
+    return reinterpret_cast<uintptr_t>(surface.get());
+}
+
+namespace
+{
+void set_depth_layer(miral::WindowInfo& info, MirDepthLayer depth_layer, miral::WindowManagerTools& tools)
+{
+    miral::WindowSpecification spec;
+    spec.depth_layer() = depth_layer;
+    tools.modify_window(info, spec);
+
+    // Dialogs and other children would otherwise be left behind in their parent's old layer
+    for (auto const& child : info.children())
+        set_depth_layer(tools.info_for(child), depth_layer, tools);
+}
+}
+
+bool miracle::window_helpers::set_layer(
+    miral::Window const& window, StackingLayer layer, miral::WindowManagerTools& tools)
+{
+    auto depth_layer = to_depth_layer(layer);
+    auto& info = tools.info_for(window);
+    if (info.depth_layer() == depth_layer)
+        return false;
+
+    set_depth_layer(info, depth_layer, tools);
+
+    // A window entering a layer lands on top of it. Within the tiled layer, where
+    // windows never overlap, the order does not matter.
+    if (layer != StackingLayer::tiled)
+        tools.raise_tree(window);
+    return true;
+}
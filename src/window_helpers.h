@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_WINDOW_HELPERS_H
 #define MIRACLEWM_WINDOW_HELPERS_H
 
+#include "stacking_layer.h"
 #include <miral/window_info.h>
 #include <miral/window_manager_tools.h>
 
@@ -59,6 +60,13 @@ namespace window_helpers
         TilingWindowTree const* tree);
 
     miral::WindowSpecification copy_from(miral::WindowInfo const&);
+
+    /// An identifier that is stable for the lifetime of the window, reported over IPC as its container id
+    uint64_t get_container_id(miral::Window const&);
+
+    /// Moves the window, along with its children, into the provided layer.
+    /// @returns false if the window was already in that layer, in which case nothing is restacked
+    bool set_layer(miral::Window const& window, StackingLayer layer, miral::WindowManagerTools& tools);
 }
 }
 
@@ -18,8 +18,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "window_manager_tools_tiling_interface.h"
 #include "animator.h"
 #include "leaf_node.h"
+#include "output_content.h"
 #include "window_helpers.h"
 #include "window_metadata.h"
+#include <algorithm>
 #include <mir/scene/surface.h>
 
 #define MIR_LOG_COMPONENT "window_manager_tools_tiling_interface"
@@ -28,6 +30,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 using namespace miracle;
 
+namespace
+{
+std::string get_output_name(WindowMetadata const& metadata)
+{
+    if (auto output = metadata.get_output())
+        return output->get_output().name();
+    return "";
+}
+}
+
 WindowManagerToolsTilingInterface::WindowManagerToolsTilingInterface(
     miral::WindowManagerTools const& tools,
     Animator& animator) :
@@ -36,12 +48,12 @@ WindowManagerToolsTilingInterface::WindowManagerToolsTilingInterface(
 {
 }
 
-void WindowManagerToolsTilingInterface::open(miral::Window const& window)
+void WindowManagerToolsTilingInterface::open(std::shared_ptr<WindowMetadata> const& metadata)
 {
-    auto metadata = get_metadata(window);
-    if (!metadata)
+    // Nothing behind a fullscreen window can be seen, so there is nothing to animate
+    if (metadata->is_suspended())
     {
-        mir::log_error("Cannot set rectangle of window that lacks metadata");
+        on_animation({ metadata->get_animation_handle(), true }, metadata);
         return;
     }
 
@@ -50,7 +62,8 @@ void WindowManagerToolsTilingInterface::open(miral::Window const& window)
         [this, metadata = metadata](miracle::AnimationStepResult const& result)
     {
         on_animation(result, metadata);
-    });
+    },
+        get_output_name(*metadata));
 }
 
 bool WindowManagerToolsTilingInterface::is_fullscreen(miral::Window const& window)
@@ -60,12 +73,21 @@ bool WindowManagerToolsTilingInterface::is_fullscreen(miral::Window const& windo
 }
 
 void WindowManagerToolsTilingInterface::set_rectangle(
-    miral::Window const& window, geom::Rectangle const& from, geom::Rectangle const& to)
+    std::shared_ptr<WindowMetadata> const& metadata, geom::Rectangle const& from, geom::Rectangle const& to)
 {
-    auto metadata = get_metadata(window);
-    if (!metadata)
+    // The window has not been opened yet, so open() will place it
+    if (metadata->get_animation_handle() == none_animation_handle)
+        return;
+
+    if (metadata->is_suspended())
     {
-        mir::log_error("Cannot set rectangle of window that lacks metadata");
+        on_animation(
+            { metadata->get_animation_handle(),
+                true,
+                glm::vec2(to.top_left.x.as_int(), to.top_left.y.as_int()),
+                glm::vec2(to.size.width.as_int(), to.size.height.as_int()),
+                glm::mat4(1.f) },
+            metadata);
         return;
     }
 
@@ -76,7 +98,8 @@ void WindowManagerToolsTilingInterface::set_rectangle(
         [this, metadata = metadata](miracle::AnimationStepResult const& result)
     {
         on_animation(result, metadata);
-    });
+    },
+        get_output_name(*metadata));
 }
 
 MirWindowState WindowManagerToolsTilingInterface::get_state(miral::Window const& window)
@@ -94,53 +117,38 @@ void WindowManagerToolsTilingInterface::change_state(miral::Window const& window
     tools.modify_window(window, spec);
 }
 
-void WindowManagerToolsTilingInterface::clip(miral::Window const& window, geom::Rectangle const& r)
+geom::Size WindowManagerToolsTilingInterface::get_min_size(miral::Window const& window)
 {
     auto& window_info = tools.info_for(window);
-    window_info.clip_area(r);
+    return { window_info.min_width(), window_info.min_height() };
 }
 
-void WindowManagerToolsTilingInterface::noclip(miral::Window const& window)
+geom::Size WindowManagerToolsTilingInterface::get_max_size(miral::Window const& window)
 {
     auto& window_info = tools.info_for(window);
-    window_info.clip_area(mir::optional_value<geom::Rectangle>());
-}
-
-void WindowManagerToolsTilingInterface::select_active_window(miral::Window const& window)
-{
-    tools.select_active_window(window);
+    return { window_info.max_width(), window_info.max_height() };
 }
 
-std::shared_ptr<WindowMetadata> WindowManagerToolsTilingInterface::get_metadata(miral::Window const& window)
+void WindowManagerToolsTilingInterface::clip(miral::Window const& window, geom::Rectangle const& r)
 {
-    auto& info = tools.info_for(window);
-    if (info.userdata())
-        return static_pointer_cast<WindowMetadata>(info.userdata());
-
-    return nullptr;
+    auto& window_info = tools.info_for(window);
+    window_info.clip_area(r);
 }
 
-std::shared_ptr<WindowMetadata> WindowManagerToolsTilingInterface::get_metadata(
-    miral::Window const& window, TilingWindowTree const* tree)
+void WindowManagerToolsTilingInterface::noclip(miral::Window const& window)
 {
-    auto node = get_metadata(window);
-    if (auto tiling_node = node->get_tiling_node())
-    {
-        if (tiling_node->get_tree() == tree)
-            return node;
-    }
-
-    return nullptr;
+    auto& window_info = tools.info_for(window);
+    window_info.clip_area(mir::optional_value<geom::Rectangle>());
 }
 
-void WindowManagerToolsTilingInterface::raise(miral::Window const& window)
+void WindowManagerToolsTilingInterface::select_active_window(miral::Window const& window)
 {
-    tools.raise_tree(window);
+    tools.select_active_window(window);
 }
 
-void WindowManagerToolsTilingInterface::send_to_back(miral::Window const& window)
+void WindowManagerToolsTilingInterface::set_layer(miral::Window const& window, StackingLayer layer)
 {
-    tools.send_tree_to_back(window);
+    window_helpers::set_layer(window, layer, tools);
 }
 
 void WindowManagerToolsTilingInterface::on_animation(
@@ -153,10 +161,12 @@ void WindowManagerToolsTilingInterface::on_animation(
 
     bool needs_modify = false;
     miral::WindowSpecification spec;
-    if (auto node = metadata->get_tiling_node())
+    auto node = metadata->get_tiling_node();
+    if (node)
     {
-        spec.top_left() = node->get_visible_area().top_left;
-        spec.size() = node->get_visible_area().size;
+        auto configured_area = node->get_configured_area();
+        spec.top_left() = configured_area.top_left;
+        spec.size() = configured_area.size;
     }
     else
     {
@@ -164,9 +174,6 @@ void WindowManagerToolsTilingInterface::on_animation(
         spec.size() = window.size();
     }
 
-    spec.min_width() = mir::geometry::Width(0);
-    spec.min_height() = mir::geometry::Height(0);
-
     if (result.position)
     {
         spec.top_left() = mir::geometry::Point(
@@ -218,6 +225,15 @@ void WindowManagerToolsTilingInterface::on_animation(
         height,
         0, 1);
 
+    // A window that is configured larger than its tile (e.g. due to its minimum size) must not
+    // spill over its neighbors.
+    if (node)
+    {
+        auto visible_area = node->get_visible_area();
+        scale.x = std::min(scale.x, static_cast<float>(visible_area.size.width.as_int()));
+        scale.y = std::min(scale.y, static_cast<float>(visible_area.size.height.as_int()));
+    }
+
     mir::geometry::Rectangle new_rectangle(
         { spec.top_left().value().x.as_int(), spec.top_left().value().y.as_int() },
         { scale.x, scale.y });
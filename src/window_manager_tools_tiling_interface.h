@@ -29,18 +29,17 @@ class WindowManagerToolsTilingInterface : public TilingInterface
 {
 public:
     WindowManagerToolsTilingInterface(miral::WindowManagerTools const&, Animator& animator);
-    void open(miral::Window const&) override;
+    void open(std::shared_ptr<WindowMetadata> const&) override;
     bool is_fullscreen(miral::Window const&) override;
-    void set_rectangle(miral::Window const&, geom::Rectangle const&, geom::Rectangle const&) override;
+    void set_rectangle(std::shared_ptr<WindowMetadata> const&, geom::Rectangle const&, geom::Rectangle const&) override;
     MirWindowState get_state(miral::Window const&) override;
     void change_state(miral::Window const&, MirWindowState state) override;
+    geom::Size get_min_size(miral::Window const&) override;
+    geom::Size get_max_size(miral::Window const&) override;
     void clip(miral::Window const&, geom::Rectangle const&) override;
     void noclip(miral::Window const&) override;
     void select_active_window(miral::Window const&) override;
-    std::shared_ptr<WindowMetadata> get_metadata(miral::Window const&) override;
-    std::shared_ptr<WindowMetadata> get_metadata(miral::Window const&, TilingWindowTree const*) override;
-    void raise(miral::Window const&) override;
-    void send_to_back(miral::Window const&) override;
+    void set_layer(miral::Window const&, StackingLayer) override;
     void on_animation(miracle::AnimationStepResult const& result, std::shared_ptr<WindowMetadata> const&) override;
 
 private:
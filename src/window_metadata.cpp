@@ -16,6 +16,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
 #include "window_metadata.h"
+#include "leaf_node.h"
 #include "output_content.h"
 
 using namespace miracle;
@@ -35,9 +36,20 @@ WindowMetadata::WindowMetadata(
 {
 }
 
+WindowMetadata::~WindowMetadata()
+{
+    if (tiling_node && tiling_node->get_metadata() == this)
+        tiling_node->associate_to_metadata(nullptr);
+}
+
 void WindowMetadata::associate_to_node(std::shared_ptr<LeafNode> const& node)
 {
+    if (tiling_node && tiling_node->get_metadata() == this)
+        tiling_node->associate_to_metadata(nullptr);
+
     tiling_node = node;
+    if (tiling_node)
+        tiling_node->associate_to_metadata(this);
 }
 
 void WindowMetadata::set_restore_state(MirWindowState state)
@@ -18,7 +18,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MIRACLEWM_WINDOW_METADATA_H
 #define MIRACLEWM_WINDOW_METADATA_H
 
+#include <atomic>
 #include <memory>
+#include <optional>
 #include <miral/window.h>
 #include <miral/window_manager_tools.h>
 #include <glm/glm.hpp>
@@ -35,15 +37,34 @@ enum class WindowType
     none,
     tiled,
     floating,
-    other
+    other,
+
+    /// A pre-launched terminal that is held hidden, outside of any workspace, until it is claimed
+    pooled,
+
+    /// Held outside of any workspace, and shown or hidden on its surface alone
+    scratchpad
+};
+
+/// Whether a window blurs the content beneath it
+enum class BlurChoice : uint8_t
+{
+    /// Decided by the app_ids in the blur configuration
+    from_config,
+    enabled,
+    disabled
 };
 
 /// Applied to WindowInfo to enable
-class WindowMetadata
+class WindowMetadata : public std::enable_shared_from_this<WindowMetadata>
 {
 public:
     WindowMetadata(WindowType type, miral::Window const& window);
     WindowMetadata(WindowType type, miral::Window const& window, std::shared_ptr<WorkspaceContent> const& workspace);
+    ~WindowMetadata();
+
+    /// Links the metadata and the node to one another, so that neither has to be looked up
+    /// through the WindowManagerTools. The node only holds a non-owning pointer back.
     void associate_to_node(std::shared_ptr<LeafNode> const&);
     miral::Window& get_window() { return window; }
     std::shared_ptr<LeafNode> get_tiling_node() const;
@@ -61,6 +82,24 @@ public:
     glm::mat4 const& get_transform() const { return transform; }
     void set_transform(glm::mat4 const& in) { transform = in; }
 
+    /// Suspended windows are hidden behind a fullscreen window. Their surfaces are hidden,
+    /// and they are neither animated nor drawn. This is read from the compositor thread.
+    bool is_suspended() const { return suspended.load(std::memory_order_relaxed); }
+    void set_is_suspended(bool in) { suspended.store(in, std::memory_order_relaxed); }
+
+    /// Chosen for the window by a command, over the configuration. This is read from the
+    /// compositor thread and takes effect the next time that the window is drawn.
+    BlurChoice get_blur_choice() const { return blur_choice.load(std::memory_order_relaxed); }
+    void set_blur_choice(BlurChoice in) { blur_choice.store(in, std::memory_order_relaxed); }
+
+    /// Chosen for the window by a command, over the opacity rules. This is read from the compositor thread.
+    std::optional<float> get_opacity() const
+    {
+        auto const value = opacity.load(std::memory_order_relaxed);
+        return value < 0.f ? std::nullopt : std::optional<float>(value);
+    }
+    void set_opacity(float in) { opacity.store(in, std::memory_order_relaxed); }
+
 private:
     WindowType type;
     miral::Window window;
@@ -70,6 +109,11 @@ private:
     bool is_pinned = false;
     uint32_t animation_handle = 0;
     glm::mat4 transform = glm::mat4(1.f);
+    std::atomic<bool> suspended = false;
+    std::atomic<BlurChoice> blur_choice = BlurChoice::from_config;
+
+    /// Negative until a command chooses the opacity
+    std::atomic<float> opacity = -1.f;
 };
 
 }
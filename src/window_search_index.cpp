@@ -0,0 +1,246 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "window_search_index.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace miracle;
+
+namespace
+{
+std::string fold(std::string_view in)
+{
+    std::string result(in.substr(0, WindowSearchIndex::max_indexed_length));
+    for (auto& c : result)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return result;
+}
+
+/// Packs a gram of up to three bytes, along with its length, into a key
+uint32_t make_gram(std::string_view text, size_t start, size_t length)
+{
+    uint32_t gram = static_cast<uint32_t>(length) << 24;
+    for (size_t i = 0; i < length; i++)
+        gram |= static_cast<uint32_t>(static_cast<unsigned char>(text[start + i])) << (8 * i);
+    return gram;
+}
+
+/// Single bytes find the candidates for a query and trigrams rank them
+void collect_grams(std::string_view text, std::unordered_set<uint32_t>& grams)
+{
+    for (size_t start = 0; start < text.size(); start++)
+    {
+        grams.insert(make_gram(text, start, 1));
+        if (start + 3 <= text.size())
+            grams.insert(make_gram(text, start, 3));
+    }
+}
+
+bool is_word_start(std::string_view text, size_t position)
+{
+    return position == 0 || !std::isalnum(static_cast<unsigned char>(text[position - 1]));
+}
+
+/// Scores a single field against the query. Prefixes beat substrings, which beat
+/// scattered matches. Returns zero if the query is not a subsequence of the field.
+float score_field(std::string_view field, std::string_view query)
+{
+    if (auto const position = field.find(query); position != std::string_view::npos)
+    {
+        if (position == 0)
+            return 100.f;
+
+        float score = 80.f - std::min<float>(position, 20.f) * 0.5f;
+        if (is_word_start(field, position))
+            score += 10.f;
+        return score;
+    }
+
+    // Walk the field once, preferring characters that continue a run or start a word
+    size_t matched = 0;
+    size_t adjacent = 0;
+    size_t word_starts = 0;
+    size_t previous = std::string_view::npos;
+    for (size_t i = 0; i < field.size() && matched < query.size(); i++)
+    {
+        if (field[i] != query[matched])
+            continue;
+
+        if (previous != std::string_view::npos && previous + 1 == i)
+            adjacent++;
+        if (is_word_start(field, i))
+            word_starts++;
+        previous = i;
+        matched++;
+    }
+
+    if (matched < query.size())
+        return 0.f;
+
+    return 20.f + 30.f * (adjacent + word_starts) / (2.f * query.size());
+}
+}
+
+void WindowSearchIndex::update(uint64_t id, std::string const& title, std::string const& app_id)
+{
+    Entry next;
+    next.title = title;
+    next.app_id = app_id;
+    next.folded_title = fold(title);
+    next.folded_app_id = fold(app_id);
+    collect_grams(next.folded_title, next.grams);
+    collect_grams(next.folded_app_id, next.grams);
+
+    std::lock_guard lock(mutex);
+    auto it = entries.find(id);
+    if (it == entries.end())
+    {
+        add_grams(id, next);
+        entries.emplace(id, std::move(next));
+        return;
+    }
+
+    auto& previous = it->second;
+    if (previous.title == title && previous.app_id == app_id)
+        return;
+
+    // Titles change all of the time, so only the grams that changed are touched
+    for (auto const gram : previous.grams)
+    {
+        if (!next.grams.contains(gram))
+        {
+            auto posting = postings.find(gram);
+            posting->second.erase(id);
+            if (posting->second.empty())
+                postings.erase(posting);
+        }
+    }
+
+    for (auto const gram : next.grams)
+    {
+        if (!previous.grams.contains(gram))
+            postings[gram].insert(id);
+    }
+
+    previous = std::move(next);
+}
+
+void WindowSearchIndex::remove(uint64_t id)
+{
+    std::lock_guard lock(mutex);
+    auto it = entries.find(id);
+    if (it == entries.end())
+        return;
+
+    remove_grams(id, it->second);
+    entries.erase(it);
+}
+
+std::vector<WindowSearchMatch> WindowSearchIndex::search(std::string_view query, size_t limit) const
+{
+    auto const folded_query = fold(query);
+    std::vector<WindowSearchMatch> matches;
+
+    std::lock_guard lock(mutex);
+    if (folded_query.empty())
+    {
+        for (auto const& [id, entry] : entries)
+            matches.push_back({ id, entry.title, entry.app_id, 0.f });
+    }
+    else
+    {
+        // Every match contains each character of the query, so the candidates can be
+        // limited to the windows that contain its rarest character
+        std::unordered_set<uint64_t> const* candidates = nullptr;
+        for (size_t i = 0; i < folded_query.size(); i++)
+        {
+            auto posting = postings.find(make_gram(folded_query, i, 1));
+            if (posting == postings.end())
+                return {};
+
+            if (!candidates || posting->second.size() < candidates->size())
+                candidates = &posting->second;
+        }
+
+        std::unordered_set<uint32_t> query_trigrams;
+        for (size_t start = 0; start + 3 <= folded_query.size(); start++)
+            query_trigrams.insert(make_gram(folded_query, start, 3));
+
+        for (auto const id : *candidates)
+        {
+            auto const& entry = entries.at(id);
+            float score = std::max(
+                score_field(entry.folded_title, folded_query),
+                0.9f * score_field(entry.folded_app_id, folded_query));
+            if (score <= 0.f)
+                continue;
+
+            // Reward windows that share more of the query's runs of characters
+            if (!query_trigrams.empty())
+            {
+                size_t shared = 0;
+                for (auto const gram : query_trigrams)
+                {
+                    if (entry.grams.contains(gram))
+                        shared++;
+                }
+                score += 10.f * shared / query_trigrams.size();
+            }
+
+            // Between equally good matches, prefer the shorter title
+            score -= 0.01f * std::min<size_t>(entry.folded_title.size(), max_indexed_length);
+            matches.push_back({ id, entry.title, entry.app_id, score });
+        }
+    }
+
+    auto const count = std::min(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + count, matches.end(), [](auto const& a, auto const& b)
+    {
+        if (a.score != b.score)
+            return a.score > b.score;
+        return a.id < b.id;
+    });
+    matches.resize(count);
+    return matches;
+}
+
+size_t WindowSearchIndex::size() const
+{
+    std::lock_guard lock(mutex);
+    return entries.size();
+}
+
+void WindowSearchIndex::add_grams(uint64_t id, Entry const& entry)
+{
+    for (auto const gram : entry.grams)
+        postings[gram].insert(id);
+}
+
+void WindowSearchIndex::remove_grams(uint64_t id, Entry const& entry)
+{
+    for (auto const gram : entry.grams)
+    {
+        auto posting = postings.find(gram);
+        if (posting == postings.end())
+            continue;
+
+        posting->second.erase(id);
+        if (posting->second.empty())
+            postings.erase(posting);
+    }
+}
@@ -0,0 +1,86 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_WINDOW_SEARCH_INDEX_H
+#define MIRACLEWM_WINDOW_SEARCH_INDEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace miracle
+{
+
+struct WindowSearchMatch
+{
+    uint64_t id;
+    std::string title;
+    std::string app_id;
+    float score;
+};
+
+/// Fuzzy search over the titles and app ids of every window.
+///
+/// Each window is indexed by the bytes and trigrams of its lowercased title and app id.
+/// A query only visits the windows that contain its rarest character, and an update only
+/// touches the grams that were added or removed, so neither depends on the total number
+/// of windows.
+///
+/// The index is updated from the window manager and queried from IPC, so every method
+/// is safe to call from any thread.
+class WindowSearchIndex
+{
+public:
+    /// Adds the window, or updates it if it is already indexed
+    void update(uint64_t id, std::string const& title, std::string const& app_id);
+    void remove(uint64_t id);
+
+    /// Returns up to limit windows that match the query, best first. An empty query
+    /// matches every window.
+    std::vector<WindowSearchMatch> search(std::string_view query, size_t limit) const;
+
+    [[nodiscard]] size_t size() const;
+
+    /// Only this many bytes of each title and app id are indexed
+    static constexpr size_t max_indexed_length = 256;
+
+private:
+    struct Entry
+    {
+        std::string title;
+        std::string app_id;
+
+        std::string folded_title;
+        std::string folded_app_id;
+        std::unordered_set<uint32_t> grams;
+    };
+
+    void add_grams(uint64_t id, Entry const& entry);
+    void remove_grams(uint64_t id, Entry const& entry);
+
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::unordered_map<uint32_t, std::unordered_set<uint64_t>> postings;
+};
+
+}
+
+#endif // MIRACLEWM_WINDOW_SEARCH_INDEX_H
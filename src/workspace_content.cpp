@@ -86,9 +86,8 @@ void WorkspaceContent::for_each_window(std::function<void(std::shared_ptr<Window
     {
         if (auto leaf = Node::as_leaf(node))
         {
-            auto metadata = window_helpers::get_metadata(leaf->get_window(), tools);
-            if (metadata)
-                f(metadata);
+            if (auto metadata = leaf->get_metadata())
+                f(metadata->shared_from_this());
         }
     });
 }
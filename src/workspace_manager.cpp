@@ -17,6 +17,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define MIR_LOG_COMPONENT "workspace_manager"
 #include "workspace_manager.h"
+#include "miracle_log.h"
 #include "output_content.h"
 #include "window_helpers.h"
 #include <mir/log.h>
@@ -43,7 +44,7 @@ std::shared_ptr<OutputContent> WorkspaceManager::request_workspace(std::shared_p
         auto active_workspace = workspace->get_active_workspace_num();
         if (active_workspace == key)
         {
-            mir::log_warning("Same workspace selected twice in a row");
+            MIRACLE_LOG_WARNING("Same workspace selected twice in a row");
             return workspace;
         }
 
@@ -98,8 +99,7 @@ bool WorkspaceManager::move_active_to_workspace(std::shared_ptr<OutputContent> c
     case WindowType::tiled:
     {
         auto original_tree = screen->get_active_tree();
-        auto window_node = window_helpers::get_node_for_window(window, tools_);
-        original_tree->advise_delete_window(window);
+        original_tree->advise_delete_window(metadata->get_tiling_node());
 
         auto screen_to_move_to = request_workspace(screen, workspace);
         auto& prev_info = tools_.info_for(window);
@@ -111,14 +111,13 @@ bool WorkspaceManager::move_active_to_workspace(std::shared_ptr<OutputContent> c
         spec = screen_to_move_to->get_active_tree()->allocate_position(spec);
         tools_.modify_window(window, spec);
 
-        auto new_node = screen_to_move_to->get_active_tree()->advise_new_window(prev_info);
         metadata->set_workspace(screen_to_move_to->get_active_workspace());
-        metadata->associate_to_node(new_node);
+        screen_to_move_to->get_active_tree()->advise_new_window(prev_info, metadata);
         miral::WindowSpecification next_spec;
         next_spec.userdata() = metadata;
         tools_.modify_window(window, next_spec);
 
-        screen_to_move_to->get_active_tree()->handle_window_ready(prev_info);
+        screen_to_move_to->get_active_tree()->handle_window_ready(prev_info, metadata->get_tiling_node());
         break;
     }
     default:
@@ -14,6 +14,7 @@ namespace
 int argc = 1;
 char const* argv[] = { "miracle-wm-tests" };
 const std::string path = std::filesystem::current_path() / "test.yaml";
+const std::string drop_in_path = std::filesystem::current_path() / "test.d";
 }
 
 class MiracleConfigTest : public testing::Test
@@ -34,6 +35,7 @@ public:
     void TearDown() override
     {
         std::filesystem::remove(path.c_str());
+        std::filesystem::remove_all(drop_in_path.c_str());
     }
 
     void write_kvp(std::string key, std::string value)
@@ -48,6 +50,13 @@ public:
         file << node;
     }
 
+    void write_drop_in(std::string const& name, YAML::Node const& node)
+    {
+        std::filesystem::create_directories(drop_in_path);
+        std::fstream file(drop_in_path + "/" + name, std::ios::out | std::ios::trunc);
+        file << node;
+    }
+
     miral::MirRunner runner;
 };
 
@@ -431,6 +440,46 @@ TEST_F(MiracleConfigTest, BorderCanbeParsedWithHexColor)
     EXPECT_EQ(config.get_border_config().color.a, 1.f);
 }
 
+TEST_F(MiracleConfigTest, BorderDecorationsAreDisabledByDefault)
+{
+    YAML::Node border;
+    border["size"] = 2;
+    border["color"] = "0xDD89DDFF";
+    border["focus_color"] = "0xFFFFFFFF";
+
+    YAML::Node node;
+    node["border"] = border;
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    EXPECT_EQ(config.get_border_config().radius, 0);
+    EXPECT_EQ(config.get_border_config().shadow.size, 0);
+}
+
+TEST_F(MiracleConfigTest, BorderDecorationsCanBeParsed)
+{
+    YAML::Node border;
+    border["size"] = 2;
+    border["color"] = "0xDD89DDFF";
+    border["focus_color"] = "0xFFFFFFFF";
+    border["radius"] = 8;
+    border["shadow"]["size"] = 12;
+    border["shadow"]["offset_y"] = 4;
+    border["shadow"]["color"] = "0x00000080";
+
+    YAML::Node node;
+    node["border"] = border;
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    auto const& border_config = config.get_border_config();
+    EXPECT_EQ(border_config.radius, 8);
+    EXPECT_EQ(border_config.shadow.size, 12);
+    EXPECT_EQ(border_config.shadow.offset.x, 0.f);
+    EXPECT_EQ(border_config.shadow.offset.y, 4.f);
+    EXPECT_EQ(border_config.shadow.color.a, 128.f / 255.f);
+}
+
 TEST_F(MiracleConfigTest, BorderCanbeParsedObjectColor)
 {
     YAML::Node border;
@@ -458,3 +507,309 @@ TEST_F(MiracleConfigTest, BorderCanbeParsedObjectColor)
     EXPECT_EQ(config.get_border_config().color.b, 30.f / 255.f);
     EXPECT_EQ(config.get_border_config().color.a, 55.f / 255.f);
 }
+
+TEST_F(MiracleConfigTest, DropInFilesOverrideTheMainFile)
+{
+    write_kvp("resize_jump", "10");
+
+    YAML::Node node;
+    node["resize_jump"] = 20;
+    write_drop_in("10-resize.yaml", node);
+
+    MiracleConfig config(runner, path);
+    EXPECT_EQ(config.get_resize_jump(), 20);
+}
+
+TEST_F(MiracleConfigTest, DropInFilesAreAppliedInLexicalOrder)
+{
+    YAML::Node first;
+    first["resize_jump"] = 30;
+    write_drop_in("20-second.yaml", first);
+
+    YAML::Node second;
+    second["resize_jump"] = 40;
+    write_drop_in("10-first.yaml", second);
+
+    MiracleConfig config(runner, path);
+    EXPECT_EQ(config.get_resize_jump(), 30);
+}
+
+TEST_F(MiracleConfigTest, DropInListsAreAppendedToTheMainFile)
+{
+    YAML::Node startup_app;
+    startup_app["command"] = "echo Main";
+    YAML::Node node;
+    node["startup_apps"].push_back(startup_app);
+    write_yaml_node(node);
+
+    YAML::Node drop_in_app;
+    drop_in_app["command"] = "echo Drop In";
+    YAML::Node drop_in;
+    drop_in["startup_apps"].push_back(drop_in_app);
+    write_drop_in("10-apps.yaml", drop_in);
+
+    MiracleConfig config(runner, path);
+    ASSERT_EQ(config.get_startup_apps().size(), 2);
+    EXPECT_EQ(config.get_startup_apps()[0].command, "echo Main");
+    EXPECT_EQ(config.get_startup_apps()[1].command, "echo Drop In");
+}
+
+TEST_F(MiracleConfigTest, HiddenAndNonYamlDropInFilesAreIgnored)
+{
+    YAML::Node node;
+    node["resize_jump"] = 99;
+    write_drop_in(".10-hidden.yaml", node);
+    write_drop_in("10-backup.yaml~", node);
+
+    MiracleConfig config(runner, path);
+    EXPECT_EQ(config.get_resize_jump(), 50);
+}
+
+TEST_F(MiracleConfigTest, PowerProfilesCanBeParsed)
+{
+    YAML::Node profile;
+    profile["name"] = "remote";
+    profile["animations"] = false;
+    profile["borders"] = false;
+    profile["animation_frame_rate"] = 20;
+    YAML::Node output;
+    output["output"] = "Virtual-1";
+    output["profile"] = "remote";
+    YAML::Node node;
+    node["power"]["profile"] = "low-power";
+    node["power"]["profiles"].push_back(profile);
+    node["power"]["outputs"].push_back(output);
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    EXPECT_EQ(config.get_power_profile().name, "low-power");
+    auto const remote = config.get_power_profile("Virtual-1");
+    EXPECT_EQ(remote.name, "remote");
+    EXPECT_FALSE(remote.animations);
+    EXPECT_FALSE(remote.borders);
+    EXPECT_EQ(remote.animation_frame_rate, 20);
+}
+
+TEST_F(MiracleConfigTest, UnknownPowerProfileFallsBackToBalanced)
+{
+    YAML::Node node;
+    node["power"]["profile"] = "turbo";
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    EXPECT_EQ(config.get_power_profile().name, "balanced");
+    EXPECT_FALSE(config.select_power_profile("turbo"));
+}
+
+TEST_F(MiracleConfigTest, ConfiguredSoftwareProfileAppliesWhenRenderingInSoftware)
+{
+    YAML::Node profile;
+    profile["name"] = "thin-client";
+    profile["simple_animations"] = true;
+    YAML::Node node;
+    node["power"]["profiles"].push_back(profile);
+    node["power"]["software_profile"] = "thin-client";
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    EXPECT_EQ(config.get_power_profile().name, "balanced");
+
+    config.set_software_rendering(true);
+    EXPECT_EQ(config.get_power_profile().name, "thin-client");
+    EXPECT_TRUE(config.get_power_profile().simple_animations);
+}
+
+TEST_F(MiracleConfigTest, TitleBarsAreDisabledByDefault)
+{
+    YAML::Node node;
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    EXPECT_FALSE(config.get_title_bar_config().enabled);
+    EXPECT_EQ(config.get_title_bar_height(), 0);
+}
+
+TEST_F(MiracleConfigTest, TitleBarCanBeParsed)
+{
+    YAML::Node node;
+    node["title_bar"]["enabled"] = true;
+    node["title_bar"]["height"] = 30;
+    node["title_bar"]["font_size"] = 16;
+    node["title_bar"]["text_color"] = "0xFF0000FF";
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    auto const title_bar = config.get_title_bar_config();
+    EXPECT_TRUE(title_bar.enabled);
+    EXPECT_EQ(title_bar.font_size, 16);
+    EXPECT_EQ(title_bar.text_color, glm::vec4(1, 0, 0, 1));
+    EXPECT_EQ(config.get_title_bar_height(), 30);
+}
+
+TEST_F(MiracleConfigTest, TerminalPoolIsDisabledByDefault)
+{
+    YAML::Node node;
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    EXPECT_EQ(config.get_terminal_pool_size(), 0);
+}
+
+TEST_F(MiracleConfigTest, TerminalPoolOutOfRangeIsIgnored)
+{
+    write_kvp("terminal_pool", "-1");
+    MiracleConfig config(runner, path);
+    EXPECT_EQ(config.get_terminal_pool_size(), 0);
+}
+
+TEST_F(MiracleConfigTest, TerminalPoolCanBeParsed)
+{
+    write_kvp("terminal_pool", "2");
+    MiracleConfig config(runner, path);
+    EXPECT_EQ(config.get_terminal_pool_size(), 2);
+}
+
+TEST_F(MiracleConfigTest, BlurAppliesToNoWindowsByDefault)
+{
+    YAML::Node node;
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    EXPECT_TRUE(config.get_blur_config().app_ids.empty());
+}
+
+TEST_F(MiracleConfigTest, BlurCanBeParsed)
+{
+    YAML::Node node;
+    node["blur"]["passes"] = 20;
+    node["blur"]["offset"] = 3.5;
+    node["blur"]["app_ids"].push_back("foot");
+    node["blur"]["app_ids"].push_back("kitty");
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    auto const blur = config.get_blur_config();
+    EXPECT_EQ(blur.passes, 6);
+    EXPECT_FLOAT_EQ(blur.offset, 3.5f);
+    ASSERT_EQ(blur.app_ids.size(), 2);
+    EXPECT_EQ(blur.app_ids[1], "kitty");
+}
+
+TEST_F(MiracleConfigTest, WindowsAreNotDimmedByDefault)
+{
+    YAML::Node node;
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    auto const opacity = config.get_opacity_config();
+    EXPECT_EQ(opacity.inactive_dim, 0.f);
+    EXPECT_EQ(opacity.get_opacity("foot"), 1.f);
+}
+
+TEST_F(MiracleConfigTest, DimAndOpacityRulesCanBeParsed)
+{
+    YAML::Node node;
+    node["dim"]["inactive"] = 0.3;
+    node["dim"]["duration"] = 0.5;
+    YAML::Node rule;
+    rule["app_id"] = "foot";
+    rule["opacity"] = 0.9;
+    node["opacity"].push_back(rule);
+    YAML::Node invalid;
+    invalid["app_id"] = "kitty";
+    node["opacity"].push_back(invalid);
+    write_yaml_node(node);
+
+    MiracleConfig config(runner, path);
+    auto const opacity = config.get_opacity_config();
+    EXPECT_FLOAT_EQ(opacity.inactive_dim, 0.3f);
+    EXPECT_FLOAT_EQ(opacity.dim_duration_seconds, 0.5f);
+    ASSERT_EQ(opacity.rules.size(), 1);
+    EXPECT_FLOAT_EQ(opacity.get_opacity("foot"), 0.9f);
+    EXPECT_EQ(opacity.get_opacity("kitty"), 1.f);
+}
+
+TEST_F(MiracleConfigTest, ReloadingADropInFileOnlyParsesThatFile)
+{
+    YAML::Node gaps;
+    gaps["inner_gaps"]["x"] = 1;
+    gaps["inner_gaps"]["y"] = 1;
+    write_drop_in("10-gaps.yaml", gaps);
+
+    YAML::Node resize;
+    resize["resize_jump"] = 20;
+    write_drop_in("20-resize.yaml", resize);
+
+    MiracleConfig config(runner, path);
+
+    gaps["inner_gaps"]["x"] = 2;
+    gaps["inner_gaps"]["y"] = 2;
+    write_drop_in("10-gaps.yaml", gaps);
+    resize["resize_jump"] = 30;
+    write_drop_in("20-resize.yaml", resize);
+
+    // Only the file that the watcher reported is read again
+    config.reload_file("10-gaps.yaml");
+    EXPECT_EQ(config.get_inner_gaps_x(), 2);
+    EXPECT_EQ(config.get_resize_jump(), 20);
+}
+
+TEST_F(MiracleConfigTest, ListenersToOtherSectionsAreNotNotifiedOfAChange)
+{
+    MiracleConfig config(runner, path);
+    int gaps_changes = 0;
+    int border_changes = 0;
+    config.register_listener([&](MiracleConfig&) { gaps_changes++; }, 5, config_section_gaps);
+    config.register_listener([&](MiracleConfig&) { border_changes++; }, 5, config_section_border);
+
+    YAML::Node gaps;
+    gaps["inner_gaps"]["x"] = 3;
+    gaps["inner_gaps"]["y"] = 3;
+    write_drop_in("10-gaps.yaml", gaps);
+    config.reload_file("10-gaps.yaml");
+    config.try_process_change();
+
+    EXPECT_EQ(gaps_changes, 1);
+    EXPECT_EQ(border_changes, 0);
+}
+
+TEST_F(MiracleConfigTest, UnchangedFilesNotifyNoListeners)
+{
+    YAML::Node resize;
+    resize["resize_jump"] = 20;
+    write_drop_in("10-resize.yaml", resize);
+
+    MiracleConfig config(runner, path);
+    int changes = 0;
+    config.register_listener([&](MiracleConfig&) { changes++; });
+
+    write_drop_in("10-resize.yaml", resize);
+    config.reload_file("10-resize.yaml");
+    config.try_process_change();
+    EXPECT_EQ(changes, 0);
+}
+
+TEST_F(MiracleConfigTest, EditingACachedFileAppliesTheChange)
+{
+    YAML::Node gaps;
+    gaps["inner_gaps"]["x"] = 1;
+    gaps["inner_gaps"]["y"] = 1;
+    write_drop_in("10-gaps.yaml", gaps);
+
+    MiracleConfig config(runner, path);
+    int changes = 0;
+    config.register_listener([&](MiracleConfig&) { changes++; }, 5, config_section_gaps);
+    ASSERT_EQ(config.get_inner_gaps_x(), 1);
+
+    gaps["inner_gaps"]["x"] = 4;
+    write_drop_in("10-gaps.yaml", gaps);
+    config.reload_file("10-gaps.yaml");
+    config.try_process_change();
+    EXPECT_EQ(config.get_inner_gaps_x(), 4);
+    EXPECT_EQ(changes, 1);
+
+    // The main file is cached in the same way
+    write_kvp("resize_jump", "40");
+    config.reload_file("");
+    EXPECT_EQ(config.get_resize_jump(), 40);
+}
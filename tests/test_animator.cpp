@@ -49,6 +49,33 @@ class ImmediateServerActionQueue : public mir::ServerActionQueue
     void resume_processing_for(void const* owner) override { };
 };
 
+class DeferredServerActionQueue : public mir::ServerActionQueue
+{
+public:
+    void enqueue(void const* owner, mir::ServerAction const& action) override
+    {
+        actions.push_back(action);
+    }
+
+    void enqueue_with_guaranteed_execution(mir::ServerAction const& action) override
+    {
+        actions.push_back(action);
+    }
+
+    void pause_processing_for(void const* owner) override { };
+    void resume_processing_for(void const* owner) override { };
+
+    void run_all()
+    {
+        auto to_run = std::move(actions);
+        actions.clear();
+        for (auto const& action : to_run)
+            action();
+    }
+
+    std::vector<mir::ServerAction> actions;
+};
+
 class AnimatorTest : public testing::Test
 {
 public:
@@ -123,4 +150,78 @@ TEST_F(AnimatorTest, LinearSlideResultsInCorrectNewPoint)
             EXPECT_EQ(asr.position.value().x, 600 * Animator::timestep_seconds);
     });
     animator.step();
-}
\ No newline at end of file
+}
+TEST_F(AnimatorTest, AtMostOneFrameIsPendingOnTheMainLoop)
+{
+    YAML::Node node;
+    YAML::Node item;
+    item["event"] = "window_move";
+    item["type"] = "slide";
+    item["function"] = "linear";
+    item["duration"] = 1;
+    node["animations"].push_back(item);
+    std::fstream file(path, std::ios::app);
+    file << node;
+
+    auto deferred_queue = std::make_shared<DeferredServerActionQueue>();
+    Animator animator(deferred_queue, config);
+    auto handle = animator.register_animateable();
+    animator.window_move(
+        handle,
+        mir::geometry::Rectangle(
+            mir::geometry::Point(0, 0),
+            mir::geometry::Size(0, 0)),
+        mir::geometry::Rectangle(
+            mir::geometry::Point(600, 0),
+            mir::geometry::Size(0, 0)),
+        [&](AnimationStepResult const&) { });
+
+    // A busy main loop sees a single frame no matter how many steps were taken
+    animator.step();
+    animator.step();
+    animator.step();
+    EXPECT_EQ(deferred_queue->actions.size(), 1);
+
+    deferred_queue->run_all();
+    animator.step();
+    EXPECT_EQ(deferred_queue->actions.size(), 1);
+}
+
+TEST_F(AnimatorTest, SimpleAnimationsOnlyMoveTheWindow)
+{
+    config->set_software_rendering(true);
+
+    Animator animator(queue, config);
+    auto handle = animator.register_animateable();
+    std::optional<glm::mat4> transform;
+    animator.window_move(
+        handle,
+        mir::geometry::Rectangle(
+            mir::geometry::Point(0, 0),
+            mir::geometry::Size(100, 100)),
+        mir::geometry::Rectangle(
+            mir::geometry::Point(600, 0),
+            mir::geometry::Size(200, 200)),
+        [&](AnimationStepResult const& asr)
+    {
+        if (asr.transform)
+            transform = asr.transform;
+    });
+    animator.step();
+    ASSERT_TRUE(transform.has_value());
+    EXPECT_EQ(transform.value(), glm::mat4(1.f));
+}
+
+TEST_F(AnimatorTest, SimpleAnimationsSkipGrowingWindows)
+{
+    config->set_software_rendering(true);
+
+    Animator animator(queue, config);
+    auto handle = animator.register_animateable();
+    bool is_complete = false;
+    animator.window_open(handle, [&](AnimationStepResult const& asr)
+    {
+        is_complete = asr.is_complete;
+    });
+    EXPECT_TRUE(is_complete);
+}
@@ -0,0 +1,118 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "blur_cache.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Rectangle const output { geom::Point { 0, 0 }, geom::Size { 1920, 1080 } };
+geom::Rectangle const terminal { geom::Point { 100, 100 }, geom::Size { 800, 600 } };
+geom::Rectangle const elsewhere { geom::Point { 1200, 100 }, geom::Size { 400, 400 } };
+int const terminal_key = 0;
+
+/// Draws a frame with a wallpaper beneath a blurred terminal, followed by another window
+bool draw_frame(BlurCache& cache, long long frameno, std::size_t wallpaper, std::size_t other_area_content, std::size_t terminal_content)
+{
+    cache.begin_frame(frameno);
+    cache.add_drawn(output, wallpaper);
+    cache.add_drawn(elsewhere, other_area_content);
+    auto const updated = cache.needs_update(&terminal_key, cache.signature_beneath(terminal, 0));
+    cache.add_drawn(terminal, terminal_content);
+    return updated;
+}
+}
+
+TEST(BlurCacheTest, FirstBlurIsComputed)
+{
+    BlurCache cache;
+    EXPECT_TRUE(draw_frame(cache, 1, 1, 1, 1));
+}
+
+TEST(BlurCacheTest, TypingIntoBlurredWindowDoesNotBlurAgain)
+{
+    BlurCache cache;
+    draw_frame(cache, 1, 1, 1, 1);
+    EXPECT_FALSE(draw_frame(cache, 2, 1, 1, 2));
+    EXPECT_FALSE(draw_frame(cache, 3, 1, 1, 3));
+}
+
+TEST(BlurCacheTest, ChangesOutsideOfTheRegionDoNotBlurAgain)
+{
+    BlurCache cache;
+    draw_frame(cache, 1, 1, 1, 1);
+    EXPECT_FALSE(draw_frame(cache, 2, 1, 2, 1));
+}
+
+TEST(BlurCacheTest, ChangesBeneathBlurAgain)
+{
+    BlurCache cache;
+    draw_frame(cache, 1, 1, 1, 1);
+    EXPECT_TRUE(draw_frame(cache, 2, 2, 1, 1));
+    EXPECT_FALSE(draw_frame(cache, 3, 2, 1, 1));
+}
+
+TEST(BlurCacheTest, DrawingOrderChangesTheSignature)
+{
+    BlurCache cache;
+    cache.begin_frame(1);
+    cache.add_drawn(output, 1);
+    cache.add_drawn(terminal, 2);
+    auto const first = cache.signature_beneath(terminal, 0);
+
+    cache.begin_frame(2);
+    cache.add_drawn(terminal, 2);
+    cache.add_drawn(output, 1);
+    EXPECT_NE(cache.signature_beneath(terminal, 0), first);
+}
+
+TEST(BlurCacheTest, MovingTheRegionChangesTheSignature)
+{
+    BlurCache cache;
+    cache.begin_frame(1);
+    cache.add_drawn(output, 1);
+    auto moved = terminal;
+    moved.top_left = { 101, 100 };
+    EXPECT_NE(cache.signature_beneath(terminal, 0), cache.signature_beneath(moved, 0));
+    EXPECT_NE(cache.signature_beneath(terminal, 0), cache.signature_beneath(terminal, 1));
+}
+
+TEST(BlurCacheTest, UnusedKeysAreEvicted)
+{
+    BlurCache cache;
+    int other_key = 0;
+    cache.begin_frame(1);
+    cache.needs_update(&terminal_key, 1);
+    cache.needs_update(&other_key, 1);
+    cache.begin_frame(2);
+    cache.needs_update(&terminal_key, 1);
+
+    auto const evicted = cache.evict_unused_since(2);
+    ASSERT_EQ(evicted.size(), 1);
+    EXPECT_EQ(evicted[0], &other_key);
+    EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(BlurCacheTest, MarginGrowsWithPassesAndIsBounded)
+{
+    EXPECT_LT(get_blur_margin(1, 2.f), get_blur_margin(3, 2.f));
+    EXPECT_LT(get_blur_margin(3, 1.f), get_blur_margin(3, 2.f));
+    EXPECT_EQ(get_blur_margin(6, 16.f), 256);
+}
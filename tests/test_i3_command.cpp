@@ -77,6 +77,15 @@ TEST_F(I3CommandTest, TestFloatingParsing)
     ASSERT_EQ(scope[0].type, I3ScopeType::floating);
 }
 
+TEST_F(I3CommandTest, TestConIdParsing)
+{
+    std::string v = "[con_id=\"94823091\"]";
+    int ptr;
+    auto scope = I3Scope::parse(v, ptr);
+    ASSERT_EQ(scope[0].type, I3ScopeType::con_id);
+    ASSERT_EQ(scope[0].regex.value(), "94823091");
+}
+
 TEST_F(I3CommandTest, CanParseSingleI3Command)
 {
     std::string v = "exec gedit";
@@ -84,4 +93,73 @@ TEST_F(I3CommandTest, CanParseSingleI3Command)
     ASSERT_EQ(commands[0].commands.size(), 1);
     ASSERT_EQ(commands[0].commands[0].type, I3CommandType::exec);
     ASSERT_EQ(commands[0].commands[0].arguments[0], "gedit");
-}
\ No newline at end of file
+}
+
+TEST_F(I3CommandTest, CanParseMultipleArguments)
+{
+    std::string v = "workspace number 3";
+    auto commands = I3ScopedCommandList::parse(v);
+    ASSERT_EQ(commands[0].commands[0].type, I3CommandType::workspace);
+    ASSERT_EQ(commands[0].commands[0].arguments.size(), 2);
+    ASSERT_EQ(commands[0].commands[0].arguments[0], "number");
+    ASSERT_EQ(commands[0].commands[0].arguments[1], "3");
+}
+
+TEST_F(I3CommandTest, CanParseAppendLayout)
+{
+    std::string v = "append_layout /home/user/layouts/workspace-1.json";
+    auto commands = I3ScopedCommandList::parse(v);
+    ASSERT_EQ(commands[0].commands[0].type, I3CommandType::append_layout);
+    ASSERT_EQ(commands[0].commands[0].arguments[0], "/home/user/layouts/workspace-1.json");
+}
+
+TEST_F(I3CommandTest, CanParsePowerProfileForOutput)
+{
+    std::string v = "power_profile low-power output HDMI-A-1";
+    auto commands = I3ScopedCommandList::parse(v);
+    ASSERT_EQ(commands[0].commands[0].type, I3CommandType::power_profile);
+    ASSERT_EQ(commands[0].commands[0].arguments.size(), 3);
+    ASSERT_EQ(commands[0].commands[0].arguments[0], "low-power");
+    ASSERT_EQ(commands[0].commands[0].arguments[2], "HDMI-A-1");
+}
+
+TEST_F(I3CommandTest, CanParseBlurForAppId)
+{
+    std::string v = "[app_id=\"foot\"] blur enable";
+    auto commands = I3ScopedCommandList::parse(v);
+    ASSERT_EQ(commands[0].scope.size(), 1);
+    ASSERT_EQ(commands[0].scope[0].type, I3ScopeType::app_id);
+    ASSERT_EQ(commands[0].scope[0].regex.value(), "foot");
+    ASSERT_EQ(commands[0].commands[0].type, I3CommandType::blur);
+    ASSERT_EQ(commands[0].commands[0].arguments[0], "enable");
+}
+
+TEST_F(I3CommandTest, CanParseOpacity)
+{
+    std::string v = "[app_id=\"foot\"] opacity minus 0.1";
+    auto commands = I3ScopedCommandList::parse(v);
+    ASSERT_EQ(commands[0].commands[0].type, I3CommandType::opacity);
+    ASSERT_EQ(commands[0].commands[0].arguments.size(), 2);
+    ASSERT_EQ(commands[0].commands[0].arguments[0], "minus");
+    ASSERT_EQ(commands[0].commands[0].arguments[1], "0.1");
+}
+
+TEST_F(I3CommandTest, CanParseShmLog)
+{
+    std::string v = "shm_log toggle";
+    auto commands = I3ScopedCommandList::parse(v);
+    ASSERT_EQ(commands[0].commands[0].type, I3CommandType::shm_log);
+    ASSERT_EQ(commands[0].commands[0].arguments.size(), 1);
+    ASSERT_EQ(commands[0].commands[0].arguments[0], "toggle");
+}
+
+TEST_F(I3CommandTest, CanParseMoveToScratchpad)
+{
+    std::string v = "[app_id=\"foot\"] move scratchpad; scratchpad show";
+    auto commands = I3ScopedCommandList::parse(v);
+    ASSERT_EQ(commands[0].commands[0].type, I3CommandType::move);
+    ASSERT_EQ(commands[0].commands[0].arguments.size(), 1);
+    ASSERT_EQ(commands[0].commands[0].arguments[0], "scratchpad");
+    ASSERT_EQ(commands[1].commands[0].type, I3CommandType::scratchpad);
+    ASSERT_EQ(commands[1].commands[0].arguments[0], "show");
+}
@@ -0,0 +1,92 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "inactive_dim.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+using namespace std::chrono_literals;
+
+namespace
+{
+int const terminal_key = 0;
+int const browser_key = 0;
+std::chrono::duration<float> const duration = 100ms;
+InactiveDim::Clock::time_point const start;
+}
+
+TEST(InactiveDimTest, NewWindowStartsAtItsTarget)
+{
+    InactiveDim dim;
+    auto const sample = dim.sample(&terminal_key, 0.3f, duration, start, 1);
+    EXPECT_FLOAT_EQ(sample.dim, 0.3f);
+    EXPECT_FALSE(sample.is_animating);
+}
+
+TEST(InactiveDimTest, FocusChangeEasesTowardsTheTarget)
+{
+    InactiveDim dim;
+    dim.sample(&terminal_key, 0.f, duration, start, 1);
+
+    auto const first = dim.sample(&terminal_key, 0.4f, duration, start, 2);
+    EXPECT_FLOAT_EQ(first.dim, 0.f);
+    EXPECT_TRUE(first.is_animating);
+
+    auto const halfway = dim.sample(&terminal_key, 0.4f, duration, start + 50ms, 3);
+    EXPECT_GT(halfway.dim, 0.2f);
+    EXPECT_LT(halfway.dim, 0.4f);
+    EXPECT_TRUE(halfway.is_animating);
+
+    auto const done = dim.sample(&terminal_key, 0.4f, duration, start + 100ms, 4);
+    EXPECT_FLOAT_EQ(done.dim, 0.4f);
+    EXPECT_FALSE(done.is_animating);
+}
+
+TEST(InactiveDimTest, FocusChangeDuringAnimationEasesFromTheCurrentValue)
+{
+    InactiveDim dim;
+    dim.sample(&terminal_key, 0.f, duration, start, 1);
+    dim.sample(&terminal_key, 0.4f, duration, start, 2);
+    auto const halfway = dim.sample(&terminal_key, 0.4f, duration, start + 50ms, 3);
+
+    auto const reversed = dim.sample(&terminal_key, 0.f, duration, start + 50ms, 4);
+    EXPECT_FLOAT_EQ(reversed.dim, halfway.dim);
+    EXPECT_TRUE(reversed.is_animating);
+
+    auto const done = dim.sample(&terminal_key, 0.f, duration, start + 150ms, 5);
+    EXPECT_FLOAT_EQ(done.dim, 0.f);
+    EXPECT_FALSE(done.is_animating);
+}
+
+TEST(InactiveDimTest, ZeroDurationJumpsToTheTarget)
+{
+    InactiveDim dim;
+    dim.sample(&terminal_key, 0.f, 0ms, start, 1);
+    auto const sample = dim.sample(&terminal_key, 0.5f, 0ms, start, 2);
+    EXPECT_FLOAT_EQ(sample.dim, 0.5f);
+    EXPECT_FALSE(sample.is_animating);
+}
+
+TEST(InactiveDimTest, WindowsThatAreNoLongerDrawnAreEvicted)
+{
+    InactiveDim dim;
+    dim.sample(&terminal_key, 0.f, duration, start, 1);
+    dim.sample(&browser_key, 0.f, duration, start, 1);
+    dim.sample(&terminal_key, 0.f, duration, start, 2);
+    dim.evict_unused_since(2);
+    EXPECT_EQ(dim.size(), 1);
+}
@@ -0,0 +1,122 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "ipc_frame_reader.h"
+#include <cstring>
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+class IpcFrameReaderTest : public testing::Test
+{
+public:
+    void append(std::string const& data)
+    {
+        reader.append(data.data(), data.size());
+    }
+
+    IpcFrameReader reader;
+};
+
+TEST_F(IpcFrameReaderTest, ReadsACompleteMessage)
+{
+    append(IpcFrameReader::encode(4, "payload"));
+
+    auto frame = reader.next();
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(frame->type, 4u);
+    EXPECT_EQ(frame->payload, "payload");
+    EXPECT_FALSE(reader.next());
+    EXPECT_EQ(reader.buffered(), 0u);
+}
+
+TEST_F(IpcFrameReaderTest, WaitsForTheRestOfAPartialHeader)
+{
+    auto const message = IpcFrameReader::encode(1, "[]");
+    append(message.substr(0, 3));
+    EXPECT_FALSE(reader.next());
+
+    append(message.substr(3, IpcFrameReader::header_size - 4));
+    EXPECT_FALSE(reader.next());
+
+    append(message.substr(IpcFrameReader::header_size - 1));
+    auto frame = reader.next();
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(frame->type, 1u);
+    EXPECT_EQ(frame->payload, "[]");
+    EXPECT_EQ(reader.get_error(), IpcFrameReader::Error::none);
+}
+
+TEST_F(IpcFrameReaderTest, WaitsForTheRestOfASplitPayload)
+{
+    auto const message = IpcFrameReader::encode(0, "workspace number 3");
+    append(message.substr(0, IpcFrameReader::header_size + 5));
+    EXPECT_FALSE(reader.next());
+
+    append(message.substr(IpcFrameReader::header_size + 5));
+    auto frame = reader.next();
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(frame->payload, "workspace number 3");
+}
+
+TEST_F(IpcFrameReaderTest, ReadsEveryMessageInOneReceive)
+{
+    append(IpcFrameReader::encode(1, "") + IpcFrameReader::encode(2, "[\"window\"]") + IpcFrameReader::encode(3, "").substr(0, 7));
+
+    auto first = reader.next();
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first->type, 1u);
+    EXPECT_EQ(first->payload, "");
+
+    auto second = reader.next();
+    ASSERT_TRUE(second);
+    EXPECT_EQ(second->type, 2u);
+    EXPECT_EQ(second->payload, "[\"window\"]");
+
+    EXPECT_FALSE(reader.next());
+    EXPECT_EQ(reader.buffered(), 7u);
+
+    append(IpcFrameReader::encode(3, "").substr(7));
+    auto third = reader.next();
+    ASSERT_TRUE(third);
+    EXPECT_EQ(third->type, 3u);
+}
+
+TEST_F(IpcFrameReaderTest, RejectsABadMagic)
+{
+    auto message = IpcFrameReader::encode(1, "");
+    message[0] = 'x';
+    append(message + IpcFrameReader::encode(1, ""));
+
+    EXPECT_FALSE(reader.next());
+    EXPECT_EQ(reader.get_error(), IpcFrameReader::Error::bad_magic);
+
+    // The stream cannot be trusted once broken, so later messages are not read either
+    append(IpcFrameReader::encode(1, ""));
+    EXPECT_FALSE(reader.next());
+}
+
+TEST_F(IpcFrameReaderTest, RejectsAPayloadThatIsTooBig)
+{
+    auto message = IpcFrameReader::encode(1, "");
+    uint32_t const length = IpcFrameReader::max_payload_length + 1;
+    memcpy(message.data() + sizeof(IpcFrameReader::magic), &length, sizeof(length));
+    append(message);
+
+    EXPECT_FALSE(reader.next());
+    EXPECT_EQ(reader.get_error(), IpcFrameReader::Error::payload_too_big);
+}
@@ -0,0 +1,161 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "ipc_ring.h"
+#include <chrono>
+#include <fcntl.h>
+#include <functional>
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace miracle;
+using namespace std::chrono_literals;
+
+class IpcRingTest : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        ring = IpcRing::create({ [this](int, char const* data, size_t size)
+        {
+            received.append(data, size);
+        },
+            [this](int fd, size_t written)
+        {
+            // Continue from where the kernel stopped, as Ipc does
+            sent_offset += written;
+            send_completions++;
+            if (sent_offset < sending->size())
+                ring->send(fd, sending, sent_offset);
+        },
+            [this](int, int error)
+        {
+            closed_errors.push_back(error);
+        } });
+        if (!ring)
+            GTEST_SKIP() << "io_uring is unavailable";
+
+        // The server end is nonblocking, as the sockets of IPC clients are
+        int sockets[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, sockets), 0);
+        server = mir::Fd { sockets[0] };
+        client = mir::Fd { sockets[1] };
+        ring->add(server);
+        ring->submit();
+    }
+
+    /// Handles completions until the condition holds, reading whatever the server sent if the client is reading
+    bool process_until(std::function<bool()> const& condition, std::chrono::milliseconds timeout = 5s)
+    {
+        auto const deadline = std::chrono::steady_clock::now() + timeout;
+        while (!condition())
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+
+            if (is_client_reading)
+            {
+                char buffer[4096];
+                ssize_t count;
+                while ((count = read(client, buffer, sizeof(buffer))) > 0)
+                    client_received.append(buffer, count);
+            }
+
+            pollfd event { ring->get_fd(), POLLIN, 0 };
+            if (poll(&event, 1, 10) > 0)
+                ring->process();
+        }
+        return true;
+    }
+
+    void send(std::string const& message)
+    {
+        sending = std::make_shared<std::string const>(message);
+        sent_offset = 0;
+        ring->send(server, sending, 0);
+        ring->submit();
+    }
+
+    std::unique_ptr<IpcRing> ring;
+    mir::Fd server;
+    mir::Fd client;
+    std::string received;
+    std::string client_received;
+    std::shared_ptr<std::string const> sending;
+    size_t sent_offset = 0;
+    int send_completions = 0;
+    bool is_client_reading = true;
+    std::vector<int> closed_errors;
+};
+
+TEST_F(IpcRingTest, ReceivesWhatTheClientWrites)
+{
+    ASSERT_EQ(write(client, "i3-ipc", 6), 6);
+    ASSERT_TRUE(process_until([&]() { return received.size() == 6; }));
+
+    ASSERT_EQ(write(client, "more", 4), 4);
+    ASSERT_TRUE(process_until([&]() { return received.size() == 10; }));
+    EXPECT_EQ(received, "i3-ipcmore");
+    EXPECT_TRUE(closed_errors.empty());
+}
+
+TEST_F(IpcRingTest, ReportsAClientThatHangsUp)
+{
+    client = mir::Fd {};
+    ASSERT_TRUE(process_until([&]() { return !closed_errors.empty(); }));
+    EXPECT_EQ(closed_errors[0], 0);
+}
+
+TEST_F(IpcRingTest, PartialSendsArriveInOrder)
+{
+    // A small send buffer makes the kernel write the message in many parts
+    int const buffer_size = 4096;
+    ASSERT_EQ(setsockopt(server, SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size)), 0);
+
+    std::string message(256 * 1024, '\0');
+    for (size_t i = 0; i < message.size(); i++)
+        message[i] = static_cast<char>(i * 31 % 251);
+
+    send(message);
+    ASSERT_TRUE(process_until([&]() { return client_received.size() == message.size(); }));
+    EXPECT_EQ(client_received, message);
+    EXPECT_EQ(sent_offset, message.size());
+    EXPECT_GT(send_completions, 1);
+    EXPECT_TRUE(closed_errors.empty());
+}
+
+TEST_F(IpcRingTest, RemovingAClientWithASendInFlightReleasesTheMessage)
+{
+    // The client does not read, so the send cannot finish
+    is_client_reading = false;
+    send(std::string(1024 * 1024, 'x'));
+    process_until([]() { return false; }, 100ms);
+    ASSERT_LT(sent_offset, 1024u * 1024u);
+
+    // The ring keeps the message alive until the kernel is done with it
+    std::weak_ptr<std::string const> const message = sending;
+    sending.reset();
+    ring->remove(server);
+    ring->submit();
+    EXPECT_FALSE(message.expired());
+
+    server = mir::Fd {};
+    ASSERT_TRUE(process_until([&]() { return message.expired(); }));
+    EXPECT_TRUE(closed_errors.empty());
+}
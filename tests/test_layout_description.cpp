@@ -0,0 +1,121 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "layout_description.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+class LayoutDescriptionTest : public testing::Test
+{
+};
+
+TEST_F(LayoutDescriptionTest, ParsesNestedContainers)
+{
+    auto result = LayoutDescription::parse(R"({
+        "layout": "splith",
+        "nodes": [
+            { "percent": 0.7, "swallows": [ { "app_id": "^firefox$" } ] },
+            {
+                "layout": "splitv",
+                "percent": 0.3,
+                "nodes": [
+                    { "swallows": [ { "app_id": "^foot$", "title": "^build$" } ] },
+                    { "swallows": [ { "app_id": "^foot$" } ] }
+                ]
+            }
+        ]
+    })");
+
+    ASSERT_EQ(result.size(), 1);
+    auto const& root = result[0];
+    EXPECT_EQ(root.direction, NodeLayoutDirection::horizontal);
+    ASSERT_EQ(root.nodes.size(), 2);
+    EXPECT_TRUE(root.nodes[0].is_placeholder());
+    EXPECT_DOUBLE_EQ(root.nodes[0].weight, 0.7);
+
+    auto const& column = root.nodes[1];
+    EXPECT_FALSE(column.is_placeholder());
+    EXPECT_EQ(column.direction, NodeLayoutDirection::vertical);
+    ASSERT_EQ(column.nodes.size(), 2);
+    EXPECT_DOUBLE_EQ(column.nodes[0].weight, 0.5);
+    EXPECT_EQ(column.nodes[0].swallows[0].title.value(), "^build$");
+}
+
+TEST_F(LayoutDescriptionTest, ParsesSaveTreeOutput)
+{
+    // i3-save-tree writes one container after another and comments out criteria
+    auto result = LayoutDescription::parse(R"(// vim:ts=4:sw=4:et
+{
+    "swallows": [
+        {
+        // "title": "^Terminal$",
+            "class": "^Alacritty$"
+        }
+    ]
+}
+
+{
+    "swallows": [ { "title": "{braces} \"in\" titles" } ]
+})");
+
+    ASSERT_EQ(result.size(), 2);
+    ASSERT_EQ(result[0].swallows.size(), 1);
+    EXPECT_EQ(result[0].swallows[0].app_id.value(), "^Alacritty$");
+    EXPECT_FALSE(result[0].swallows[0].title.has_value());
+    EXPECT_EQ(result[1].swallows[0].title.value(), "{braces} \"in\" titles");
+}
+
+TEST_F(LayoutDescriptionTest, DropsPlaceholdersThatCannotSwallow)
+{
+    auto result = LayoutDescription::parse(R"([
+        { "nodes": [ { "swallows": [ { "window_role": "^browser$" } ] } ] },
+        { "type": "floating_con", "swallows": [ { "app_id": "^pavucontrol$" } ] },
+        { "swallows": [ { "app_id": "^foot$" } ] }
+    ])");
+
+    ASSERT_EQ(result.size(), 1);
+    EXPECT_EQ(result[0].swallows[0].app_id.value(), "^foot$");
+}
+
+TEST_F(LayoutDescriptionTest, MalformedLayoutIsEmpty)
+{
+    EXPECT_TRUE(LayoutDescription::parse(R"({ "nodes": [ )").empty());
+    EXPECT_TRUE(LayoutDescription::parse(R"({ "nodes": ] })").empty());
+}
+
+TEST_F(LayoutDescriptionTest, CriteriaMustAllMatch)
+{
+    LayoutSwallowCriteria criteria { "^foot$", "^build" };
+    EXPECT_TRUE(criteria.matches("foot", "build: make"));
+    EXPECT_FALSE(criteria.matches("foot", "editor"));
+    EXPECT_FALSE(criteria.matches("footclient", "build: make"));
+
+    LayoutSwallowCriteria any_title { "^foot$", std::nullopt };
+    EXPECT_TRUE(any_title.matches("foot", "anything"));
+}
+
+TEST_F(LayoutDescriptionTest, CopiedCriteriaStillMatch)
+{
+    auto result = LayoutDescription::parse(R"({ "swallows": [ { "app_id": "^foot$" } ] })");
+    ASSERT_EQ(result.size(), 1);
+
+    auto const copy = result[0].swallows;
+    result.clear();
+    EXPECT_TRUE(copy[0].matches("foot", ""));
+    EXPECT_FALSE(copy[0].matches("footclient", ""));
+}
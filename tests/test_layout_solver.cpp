@@ -0,0 +1,112 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "layout_solver.h"
+#include <gtest/gtest.h>
+#include <limits>
+#include <numeric>
+
+using namespace miracle;
+
+namespace
+{
+int const unbounded = std::numeric_limits<int>::max();
+
+int sum(std::vector<int> const& sizes)
+{
+    return std::accumulate(sizes.begin(), sizes.end(), 0);
+}
+}
+
+class LayoutSolverTest : public testing::Test
+{
+};
+
+TEST_F(LayoutSolverTest, SharesSpaceProportionallyWithoutConstraints)
+{
+    auto result = solve_layout(900, {
+                                        { 300, 0, unbounded },
+                                        { 600, 0, unbounded }
+    });
+    ASSERT_EQ(result, (std::vector<int> { 300, 600 }));
+}
+
+TEST_F(LayoutSolverTest, ResultAlwaysSumsToAvailableSpace)
+{
+    auto result = solve_layout(1000, {
+                                         { 1, 0, unbounded },
+                                         { 1, 0, unbounded },
+                                         { 1, 0, unbounded }
+    });
+    ASSERT_EQ(sum(result), 1000);
+}
+
+TEST_F(LayoutSolverTest, HonorsMinimumByTakingFromOthers)
+{
+    auto result = solve_layout(1000, {
+                                         { 500, 700, unbounded },
+                                         { 500, 0, unbounded }
+    });
+    ASSERT_EQ(result, (std::vector<int> { 700, 300 }));
+}
+
+TEST_F(LayoutSolverTest, HonorsMaximumByGivingToOthers)
+{
+    auto result = solve_layout(1000, {
+                                         { 1, 0, 200 },
+                                         { 1, 0, unbounded },
+                                         { 1, 0, unbounded }
+    });
+    ASSERT_EQ(result[0], 200);
+    ASSERT_EQ(result[1] + result[2], 800);
+    ASSERT_LE(std::abs(result[1] - result[2]), 1);
+}
+
+TEST_F(LayoutSolverTest, ResolvesMinimumAndMaximumTogether)
+{
+    auto result = solve_layout(1200, {
+                                         { 1, 600, unbounded },
+                                         { 1, 0, 100 },
+                                         { 1, 0, unbounded }
+    });
+    ASSERT_EQ(result[0], 600);
+    ASSERT_EQ(result[1], 100);
+    ASSERT_EQ(result[2], 500);
+}
+
+TEST_F(LayoutSolverTest, ShrinksProportionallyToMinimumsOnOverflow)
+{
+    auto result = solve_layout(600, {
+                                        { 1, 400, unbounded },
+                                        { 1, 800, unbounded }
+    });
+    ASSERT_EQ(result, (std::vector<int> { 200, 400 }));
+}
+
+TEST_F(LayoutSolverTest, SharesSurplusEvenlyWhenMaximumsDoNotFill)
+{
+    auto result = solve_layout(1000, {
+                                         { 1, 0, 100 },
+                                         { 1, 0, 300 }
+    });
+    ASSERT_EQ(result, (std::vector<int> { 400, 600 }));
+}
+
+TEST_F(LayoutSolverTest, ReturnsEmptyForNoItems)
+{
+    ASSERT_TRUE(solve_layout(1000, {}).empty());
+}
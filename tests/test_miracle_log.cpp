@@ -0,0 +1,107 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#define MIR_LOG_COMPONENT "test_miracle_log"
+
+#include "miracle_log.h"
+#include "shm_log_reader.h"
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <thread>
+
+using namespace miracle::log;
+
+TEST(MiracleLogTest, EmitsUpToTheBurstThenSuppresses)
+{
+    CallSite site { __FILE__, __LINE__, 3, std::chrono::hours(1) };
+    EXPECT_TRUE(site.should_emit());
+    EXPECT_TRUE(site.should_emit());
+    EXPECT_TRUE(site.should_emit());
+    EXPECT_FALSE(site.should_emit());
+    EXPECT_FALSE(site.should_emit());
+    EXPECT_EQ(site.take_suppressed(), 2);
+    EXPECT_EQ(site.take_suppressed(), 0);
+}
+
+TEST(MiracleLogTest, EmitsAgainOnceThePeriodHasElapsed)
+{
+    CallSite site { __FILE__, __LINE__, 1, std::chrono::milliseconds(5) };
+    EXPECT_TRUE(site.should_emit());
+    EXPECT_FALSE(site.should_emit());
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_TRUE(site.should_emit());
+}
+
+TEST(MiracleLogTest, DestroyedCallSitesAreNotReported)
+{
+    {
+        CallSite site { __FILE__, __LINE__, 1, std::chrono::hours(1) };
+        EXPECT_TRUE(site.should_emit());
+        EXPECT_FALSE(site.should_emit());
+    }
+
+    // The site registered itself when it suppressed a message, so this would read a dangling pointer
+    report_suppressed();
+}
+
+TEST(MiracleLogTest, ArgumentsAreNotEvaluatedWhenSuppressed)
+{
+    // Suppressed messages are still recorded while the shared memory log is enabled
+    miracle::ShmLog::instance().set_enabled(false);
+
+    int evaluations = 0;
+    auto const evaluate = [&]()
+    {
+        return ++evaluations;
+    };
+
+    for (int i = 0; i < 20; i++)
+        MIRACLE_LOG_ERROR("Evaluation %d", evaluate());
+
+    miracle::ShmLog::instance().set_enabled(true);
+    EXPECT_EQ(evaluations, 5);
+}
+
+TEST(MiracleLogTest, ArgumentsAreEvaluatedOnceWhileRecording)
+{
+    int evaluations = 0;
+    auto const evaluate = [&]()
+    {
+        return ++evaluations;
+    };
+
+    for (int i = 0; i < 20; i++)
+        MIRACLE_LOG_ERROR("Evaluation %d", evaluate());
+
+    EXPECT_EQ(evaluations, 20);
+}
+
+TEST(MiracleLogTest, SuppressedMessagesAreRecorded)
+{
+    auto& shm_log = miracle::ShmLog::instance();
+    auto const data = mmap(nullptr, shm_log.get_size(), PROT_READ, MAP_SHARED, shm_log.get_fd(), 0);
+    ASSERT_NE(data, MAP_FAILED);
+    miracle::ShmLogReader reader(data, shm_log.get_size());
+
+    auto const first = reader.get_next_index();
+    for (int i = 0; i < 20; i++)
+        MIRACLE_LOG_ERROR("Recorded %d", i);
+
+    ASSERT_EQ(reader.get_next_index(), first + 20);
+    EXPECT_EQ(reader.read(first + 19)->message, "Recorded 19");
+    munmap(data, shm_log.get_size());
+}
@@ -0,0 +1,107 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "output_index.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+namespace
+{
+const int output_width = 1920;
+const int output_height = 1080;
+
+/// Lays out a video wall of num_outputs displays, eight per row
+void add_video_wall(OutputIndex& index, int num_outputs)
+{
+    for (int i = 0; i < num_outputs; i++)
+    {
+        auto column = i % 8;
+        auto row = i / 8;
+        index.insert(i, geom::Rectangle(
+                            geom::Point(column * output_width, row * output_height),
+                            geom::Size(output_width, output_height)));
+    }
+}
+}
+
+class OutputIndexTest : public testing::Test
+{
+public:
+    OutputIndex index;
+};
+
+TEST_F(OutputIndexTest, FindsOutputContainingPoint)
+{
+    add_video_wall(index, 16);
+    ASSERT_EQ(index.find_at(geom::Point(0, 0)), 0);
+    ASSERT_EQ(index.find_at(geom::Point(output_width, 0)), 1);
+    ASSERT_EQ(index.find_at(geom::Point(output_width * 7 + 10, output_height + 10)), 15);
+}
+
+TEST_F(OutputIndexTest, ReturnsNulloptOutsideOfLayout)
+{
+    add_video_wall(index, 4);
+    ASSERT_EQ(index.find_at(geom::Point(-1, 0)), std::nullopt);
+    ASSERT_EQ(index.find_at(geom::Point(output_width * 4, 0)), std::nullopt);
+    ASSERT_EQ(index.find_at(geom::Point(0, output_height)), std::nullopt);
+}
+
+TEST_F(OutputIndexTest, ReturnsNulloptInGapsBetweenOutputs)
+{
+    index.insert(0, geom::Rectangle(geom::Point(0, 0), geom::Size(100, 100)));
+    index.insert(1, geom::Rectangle(geom::Point(200, 0), geom::Size(100, 100)));
+    ASSERT_EQ(index.find_at(geom::Point(150, 50)), std::nullopt);
+    ASSERT_EQ(index.find_at(geom::Point(250, 50)), 1);
+}
+
+TEST_F(OutputIndexTest, UpdateMovesOutput)
+{
+    add_video_wall(index, 2);
+    index.update(1, geom::Rectangle(geom::Point(0, output_height), geom::Size(output_width, output_height)));
+    ASSERT_EQ(index.find_at(geom::Point(output_width + 10, 10)), std::nullopt);
+    ASSERT_EQ(index.find_at(geom::Point(10, output_height + 10)), 1);
+}
+
+TEST_F(OutputIndexTest, EraseRemovesOutput)
+{
+    add_video_wall(index, 2);
+    ASSERT_EQ(index.find_at(geom::Point(10, 10)), 0);
+    index.erase(0);
+    ASSERT_EQ(index.size(), 1);
+    ASSERT_EQ(index.find_at(geom::Point(10, 10)), std::nullopt);
+}
+
+TEST_F(OutputIndexTest, FindIntersectingOnlyReturnsAffectedOutputs)
+{
+    add_video_wall(index, 16);
+    auto result = index.find_intersecting(geom::Rectangle(
+        geom::Point(output_width - 10, 0),
+        geom::Size(20, 20)));
+    std::sort(result.begin(), result.end());
+    ASSERT_EQ(result, (std::vector<int> { 0, 1 }));
+}
+
+TEST_F(OutputIndexTest, FindIntersectingIncludesOverlappingOutputs)
+{
+    index.insert(0, geom::Rectangle(geom::Point(0, 0), geom::Size(100, 100)));
+    index.insert(1, geom::Rectangle(geom::Point(0, 0), geom::Size(100, 100)));
+    auto result = index.find_intersecting(geom::Rectangle(geom::Point(0, 0), geom::Size(100, 100)));
+    std::sort(result.begin(), result.end());
+    ASSERT_EQ(result, (std::vector<int> { 0, 1 }));
+}
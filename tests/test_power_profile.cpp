@@ -0,0 +1,138 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "power_profile.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+class PowerProfileTest : public testing::Test
+{
+public:
+    PowerProfiles profiles;
+};
+
+TEST_F(PowerProfileTest, BalancedAppliesByDefault)
+{
+    EXPECT_EQ(profiles.resolve().name, PowerProfiles::balanced);
+    EXPECT_EQ(profiles.resolve("HDMI-A-1").name, PowerProfiles::balanced);
+    EXPECT_TRUE(profiles.resolve().animations);
+}
+
+TEST_F(PowerProfileTest, LowPowerDisablesAnimations)
+{
+    ASSERT_TRUE(profiles.select(PowerProfiles::low_power));
+    EXPECT_FALSE(profiles.resolve().animations);
+    EXPECT_FALSE(profiles.resolve("HDMI-A-1").animations);
+}
+
+TEST_F(PowerProfileTest, UnknownProfilesCannotBeSelected)
+{
+    EXPECT_FALSE(profiles.select("turbo"));
+    EXPECT_EQ(profiles.resolve().name, PowerProfiles::balanced);
+}
+
+TEST_F(PowerProfileTest, OutputSelectionOnlyAppliesToThatOutput)
+{
+    ASSERT_TRUE(profiles.select(PowerProfiles::low_power, "Virtual-1"));
+    EXPECT_EQ(profiles.resolve("Virtual-1").name, PowerProfiles::low_power);
+    EXPECT_EQ(profiles.resolve("eDP-1").name, PowerProfiles::balanced);
+    EXPECT_EQ(profiles.resolve().name, PowerProfiles::balanced);
+}
+
+TEST_F(PowerProfileTest, RuntimeSelectionWinsOverConfiguredOutputProfile)
+{
+    profiles.configure({}, PowerProfiles::balanced, std::nullopt, { { "Virtual-1", PowerProfiles::low_power } });
+    EXPECT_EQ(profiles.resolve("Virtual-1").name, PowerProfiles::low_power);
+
+    profiles.select(PowerProfiles::balanced);
+    EXPECT_EQ(profiles.resolve("Virtual-1").name, PowerProfiles::balanced);
+
+    profiles.select(PowerProfiles::automatic);
+    EXPECT_EQ(profiles.resolve("Virtual-1").name, PowerProfiles::low_power);
+}
+
+TEST_F(PowerProfileTest, BatteryProfileAppliesOnBattery)
+{
+    profiles.configure({}, PowerProfiles::balanced, PowerProfiles::low_power, {});
+    EXPECT_EQ(profiles.resolve().name, PowerProfiles::balanced);
+
+    EXPECT_TRUE(profiles.set_on_battery(true));
+    EXPECT_FALSE(profiles.set_on_battery(true));
+    EXPECT_EQ(profiles.resolve().name, PowerProfiles::low_power);
+
+    EXPECT_TRUE(profiles.set_on_battery(false));
+    EXPECT_EQ(profiles.resolve().name, PowerProfiles::balanced);
+}
+
+TEST_F(PowerProfileTest, SoftwareProfileAppliesWhenRenderingInSoftware)
+{
+    profiles.configure({}, PowerProfiles::balanced, PowerProfiles::low_power, {});
+    profiles.set_on_battery(true);
+
+    EXPECT_TRUE(profiles.set_software_rendering(true));
+    EXPECT_FALSE(profiles.set_software_rendering(true));
+    EXPECT_EQ(profiles.resolve().name, PowerProfiles::software);
+    EXPECT_TRUE(profiles.resolve().simple_animations);
+    EXPECT_FALSE(profiles.resolve().blur);
+}
+
+TEST_F(PowerProfileTest, OutputProfilesWinOverSoftwareProfile)
+{
+    profiles.configure({}, PowerProfiles::balanced, std::nullopt, { { "Virtual-1", PowerProfiles::low_power } });
+    profiles.set_software_rendering(true);
+    EXPECT_EQ(profiles.resolve("Virtual-1").name, PowerProfiles::low_power);
+    EXPECT_EQ(profiles.resolve("eDP-1").name, PowerProfiles::software);
+
+    profiles.select(PowerProfiles::balanced);
+    EXPECT_EQ(profiles.resolve("eDP-1").name, PowerProfiles::balanced);
+}
+
+TEST_F(PowerProfileTest, SoftwareProfileCanBeConfigured)
+{
+    profiles.configure({}, PowerProfiles::balanced, std::nullopt, {}, PowerProfiles::low_power);
+    profiles.set_software_rendering(true);
+    EXPECT_EQ(profiles.resolve().name, PowerProfiles::low_power);
+}
+
+TEST_F(PowerProfileTest, ConfiguredProfileReplacesBuiltInProfileOfTheSameName)
+{
+    PowerProfile custom { .name = PowerProfiles::low_power, .animations = true, .animation_frame_rate = 15 };
+    profiles.configure({ custom }, PowerProfiles::low_power, std::nullopt, {});
+    EXPECT_TRUE(profiles.resolve().animations);
+    EXPECT_EQ(profiles.resolve().animation_frame_rate, 15);
+}
+
+TEST_F(PowerProfileTest, SelectionOfRemovedProfileIsDropped)
+{
+    PowerProfile custom { .name = "remote" };
+    profiles.configure({ custom }, PowerProfiles::balanced, std::nullopt, {});
+    ASSERT_TRUE(profiles.select("remote"));
+
+    profiles.configure({}, PowerProfiles::balanced, std::nullopt, {});
+    EXPECT_EQ(profiles.resolve().name, PowerProfiles::balanced);
+}
+
+TEST_F(PowerProfileTest, PowerSupplyContentsCanBeParsed)
+{
+    EXPECT_EQ(PowerProfiles::parse_is_on_battery("0\n"), true);
+    EXPECT_EQ(PowerProfiles::parse_is_on_battery("1\n"), false);
+    EXPECT_EQ(PowerProfiles::parse_is_on_battery("Discharging\n"), true);
+    EXPECT_EQ(PowerProfiles::parse_is_on_battery("Charging"), false);
+    EXPECT_EQ(PowerProfiles::parse_is_on_battery("Full"), false);
+    EXPECT_EQ(PowerProfiles::parse_is_on_battery("Unknown"), std::nullopt);
+}
@@ -0,0 +1,121 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "render_cost_tracker.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+using namespace std::chrono_literals;
+
+class RenderCostTrackerTest : public testing::Test
+{
+public:
+    RenderCostTracker tracker;
+    RenderCostTracker::Clock::time_point now = RenderCostTracker::Clock::now();
+};
+
+TEST_F(RenderCostTrackerTest, NothingIsRecordedWhileDisabled)
+{
+    tracker.record("foot", RenderCostPart::surface, 1ms, RenderCostSource::gpu_timer);
+    EXPECT_TRUE(tracker.ranked(10).empty());
+    EXPECT_EQ(tracker.get_elapsed(now), 0ns);
+}
+
+TEST_F(RenderCostTrackerTest, CostsAreAccumulatedPerApplication)
+{
+    tracker.set_enabled(true, now);
+    tracker.record("foot", RenderCostPart::surface, 2ms, RenderCostSource::gpu_timer);
+    tracker.record("foot", RenderCostPart::surface, 3ms, RenderCostSource::gpu_timer);
+    tracker.record("foot", RenderCostPart::outline, 1ms, RenderCostSource::gpu_timer);
+
+    auto const costs = tracker.ranked(10);
+    ASSERT_EQ(costs.size(), 1);
+    EXPECT_EQ(costs[0].application_id, "foot");
+    EXPECT_EQ(costs[0].source, RenderCostSource::gpu_timer);
+    EXPECT_EQ(costs[0].draws, 2);
+    EXPECT_EQ(costs[0].surface_time, 5ms);
+    EXPECT_EQ(costs[0].outline_time, 1ms);
+    EXPECT_EQ(costs[0].max_draw_time, 3ms);
+    EXPECT_EQ(costs[0].total_time(), 6ms);
+}
+
+TEST_F(RenderCostTrackerTest, ApplicationsAreRankedByTotalCost)
+{
+    tracker.set_enabled(true, now);
+    tracker.record("cheap", RenderCostPart::surface, 1ms, RenderCostSource::cpu_submit);
+    tracker.record("expensive", RenderCostPart::surface, 5ms, RenderCostSource::cpu_submit);
+    tracker.record("middle", RenderCostPart::surface, 2ms, RenderCostSource::cpu_submit);
+    tracker.record("middle", RenderCostPart::outline, 2ms, RenderCostSource::cpu_submit);
+
+    auto const costs = tracker.ranked(10);
+    ASSERT_EQ(costs.size(), 3);
+    EXPECT_EQ(costs[0].application_id, "expensive");
+    EXPECT_EQ(costs[1].application_id, "middle");
+    EXPECT_EQ(costs[2].application_id, "cheap");
+}
+
+TEST_F(RenderCostTrackerTest, RankingIsLimited)
+{
+    tracker.set_enabled(true, now);
+    tracker.record("a", RenderCostPart::surface, 1ms, RenderCostSource::cpu_submit);
+    tracker.record("b", RenderCostPart::surface, 3ms, RenderCostSource::cpu_submit);
+    tracker.record("c", RenderCostPart::surface, 2ms, RenderCostSource::cpu_submit);
+
+    auto const costs = tracker.ranked(2);
+    ASSERT_EQ(costs.size(), 2);
+    EXPECT_EQ(costs[0].application_id, "b");
+    EXPECT_EQ(costs[1].application_id, "c");
+}
+
+TEST_F(RenderCostTrackerTest, EnablingStartsAFreshMeasurement)
+{
+    tracker.set_enabled(true, now);
+    tracker.record("foot", RenderCostPart::surface, 1ms, RenderCostSource::gpu_timer);
+    tracker.set_enabled(false, now);
+    tracker.set_enabled(true, now + 10s);
+
+    EXPECT_TRUE(tracker.ranked(10).empty());
+    EXPECT_EQ(tracker.get_elapsed(now + 12s), 2s);
+}
+
+TEST_F(RenderCostTrackerTest, EnablingTwiceKeepsTheMeasurement)
+{
+    tracker.set_enabled(true, now);
+    tracker.record("foot", RenderCostPart::surface, 1ms, RenderCostSource::gpu_timer);
+    tracker.set_enabled(true, now + 10s);
+
+    EXPECT_EQ(tracker.ranked(10).size(), 1);
+    EXPECT_EQ(tracker.get_elapsed(now + 10s), 10s);
+}
+
+TEST_F(RenderCostTrackerTest, BlurIsPartOfTheTotalCost)
+{
+    tracker.set_enabled(true, now);
+    tracker.record("foot", RenderCostPart::surface, 1ms, RenderCostSource::gpu_timer);
+    tracker.record("foot", RenderCostPart::blur, 2ms, RenderCostSource::gpu_timer);
+    tracker.record_blur("foot", true);
+    tracker.record_blur("foot", false);
+    tracker.record_blur("foot", false);
+
+    auto const costs = tracker.ranked(10);
+    ASSERT_EQ(costs.size(), 1);
+    EXPECT_EQ(costs[0].draws, 1);
+    EXPECT_EQ(costs[0].blur_time, 2ms);
+    EXPECT_EQ(costs[0].total_time(), 3ms);
+    EXPECT_EQ(costs[0].blur_updates, 1);
+    EXPECT_EQ(costs[0].blur_reuses, 2);
+}
@@ -0,0 +1,51 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "scheduler.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+using namespace std::chrono_literals;
+
+namespace
+{
+std::chrono::microseconds const quiet_period = 4ms;
+std::chrono::microseconds const max_deferral = 100ms;
+}
+
+TEST(SchedulerTest, IdleWorkRunsOnceQuiet)
+{
+    EXPECT_EQ(Scheduler::get_idle_delay(4ms, 4ms, quiet_period, max_deferral), 0us);
+    EXPECT_EQ(Scheduler::get_idle_delay(50ms, 0us, quiet_period, max_deferral), 0us);
+}
+
+TEST(SchedulerTest, IdleWorkWaitsOutTheQuietPeriod)
+{
+    EXPECT_EQ(Scheduler::get_idle_delay(1ms, 1ms, quiet_period, max_deferral), 3ms);
+}
+
+TEST(SchedulerTest, IdleWorkRunsOnceDeferredForTooLong)
+{
+    // Input that never stops still lets idle work through
+    EXPECT_EQ(Scheduler::get_idle_delay(0us, 100ms, quiet_period, max_deferral), 0us);
+    EXPECT_EQ(Scheduler::get_idle_delay(0us, 250ms, quiet_period, max_deferral), 0us);
+}
+
+TEST(SchedulerTest, IdleWorkIsNotDelayedPastTheDeadline)
+{
+    EXPECT_EQ(Scheduler::get_idle_delay(1ms, 98ms, quiet_period, max_deferral), 2ms);
+}
@@ -0,0 +1,96 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "scratchpad.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+namespace
+{
+Scratchpad::Id const terminal = 1;
+Scratchpad::Id const notes = 2;
+}
+
+TEST(ScratchpadTest, EmptyScratchpadDoesNothing)
+{
+    Scratchpad scratchpad;
+    EXPECT_EQ(scratchpad.toggle(std::nullopt).action, Scratchpad::Toggle::Action::none);
+}
+
+TEST(ScratchpadTest, AddedWindowsStartHidden)
+{
+    Scratchpad scratchpad;
+    EXPECT_TRUE(scratchpad.add(terminal));
+    EXPECT_FALSE(scratchpad.add(terminal));
+    EXPECT_TRUE(scratchpad.contains(terminal));
+    EXPECT_FALSE(scratchpad.is_shown(terminal));
+    EXPECT_EQ(scratchpad.hidden_count(), 1);
+}
+
+TEST(ScratchpadTest, ToggleShowsAndThenHidesTheFocusedWindow)
+{
+    Scratchpad scratchpad;
+    scratchpad.add(terminal);
+
+    auto const show = scratchpad.toggle(std::nullopt);
+    EXPECT_EQ(show.action, Scratchpad::Toggle::Action::show);
+    EXPECT_EQ(show.id, terminal);
+    EXPECT_TRUE(scratchpad.is_shown(terminal));
+
+    auto const hide = scratchpad.toggle(terminal);
+    EXPECT_EQ(hide.action, Scratchpad::Toggle::Action::hide);
+    EXPECT_EQ(hide.id, terminal);
+    EXPECT_FALSE(scratchpad.is_shown(terminal));
+}
+
+TEST(ScratchpadTest, ShownWindowWithoutFocusIsFocused)
+{
+    Scratchpad scratchpad;
+    scratchpad.add(terminal);
+    scratchpad.toggle(std::nullopt);
+
+    auto const toggle = scratchpad.toggle(std::nullopt);
+    EXPECT_EQ(toggle.action, Scratchpad::Toggle::Action::focus);
+    EXPECT_EQ(toggle.id, terminal);
+    EXPECT_TRUE(scratchpad.is_shown(terminal));
+}
+
+TEST(ScratchpadTest, TogglesCycleThroughHiddenWindows)
+{
+    Scratchpad scratchpad;
+    scratchpad.add(terminal);
+    scratchpad.add(notes);
+
+    EXPECT_EQ(scratchpad.toggle(std::nullopt).id, terminal);
+    EXPECT_EQ(scratchpad.toggle(terminal).action, Scratchpad::Toggle::Action::hide);
+    EXPECT_EQ(scratchpad.toggle(std::nullopt).id, notes);
+    EXPECT_EQ(scratchpad.toggle(notes).action, Scratchpad::Toggle::Action::hide);
+    EXPECT_EQ(scratchpad.toggle(std::nullopt).id, terminal);
+}
+
+TEST(ScratchpadTest, RemovedWindowIsForgotten)
+{
+    Scratchpad scratchpad;
+    scratchpad.add(terminal);
+    scratchpad.toggle(std::nullopt);
+
+    EXPECT_TRUE(scratchpad.remove(terminal));
+    EXPECT_FALSE(scratchpad.remove(terminal));
+    EXPECT_FALSE(scratchpad.contains(terminal));
+    EXPECT_EQ(scratchpad.toggle(std::nullopt).action, Scratchpad::Toggle::Action::none);
+}
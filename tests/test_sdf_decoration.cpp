@@ -0,0 +1,117 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "sdf_decoration.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+namespace
+{
+mir::gl::Primitive make_rectangle(float left, float top, float width, float height)
+{
+    mir::gl::Primitive rectangle;
+    rectangle.type = GL_TRIANGLE_STRIP;
+    rectangle.vertices[0] = { { left, top, 0.f }, { 0.f, 0.f } };
+    rectangle.vertices[1] = { { left, top + height, 0.f }, { 0.f, 1.f } };
+    rectangle.vertices[2] = { { left + width, top, 0.f }, { 1.f, 0.f } };
+    rectangle.vertices[3] = { { left + width, top + height, 0.f }, { 1.f, 1.f } };
+    return rectangle;
+}
+}
+
+TEST(SdfDecorationTest, UndecoratedWindowIsPlain)
+{
+    SdfDecoration decoration;
+    EXPECT_TRUE(decoration.is_plain());
+    EXPECT_EQ(decoration.get_extent(), 0.f);
+}
+
+TEST(SdfDecorationTest, BorderAloneIsPlain)
+{
+    SdfDecoration decoration;
+    decoration.border_width = 4;
+    EXPECT_TRUE(decoration.is_plain());
+    EXPECT_EQ(decoration.get_extent(), 4.f);
+}
+
+TEST(SdfDecorationTest, RoundedCornersAreNotPlain)
+{
+    SdfDecoration decoration;
+    decoration.radius = 8;
+    EXPECT_FALSE(decoration.is_plain());
+    EXPECT_EQ(decoration.get_extent(), 0.f);
+}
+
+TEST(SdfDecorationTest, TransparentShadowIsIgnored)
+{
+    SdfDecoration decoration;
+    decoration.shadow_sigma = 10;
+    EXPECT_TRUE(decoration.is_plain());
+    EXPECT_EQ(decoration.get_extent(), 0.f);
+}
+
+TEST(SdfDecorationTest, ShadowExtentCoversItsBlurAndOffset)
+{
+    SdfDecoration decoration;
+    decoration.border_width = 2;
+    decoration.shadow_sigma = 4;
+    decoration.shadow_offset = glm::vec2(3, -5);
+    decoration.shadow_color = glm::vec4(0, 0, 0, 0.5f);
+    EXPECT_FALSE(decoration.is_plain());
+    EXPECT_EQ(decoration.get_extent(), 2.f + 12.f + 5.f);
+}
+
+TEST(SdfDecorationTest, ExpandingGrowsEveryEdge)
+{
+    auto const expanded = expand_rectangle(make_rectangle(100, 50, 200, 100), 10);
+    EXPECT_EQ(expanded.vertices[0].position[0], 90.f);
+    EXPECT_EQ(expanded.vertices[0].position[1], 40.f);
+    EXPECT_EQ(expanded.vertices[3].position[0], 310.f);
+    EXPECT_EQ(expanded.vertices[3].position[1], 160.f);
+}
+
+TEST(SdfDecorationTest, ExpandingKeepsTheBufferInPlace)
+{
+    auto const expanded = expand_rectangle(make_rectangle(100, 50, 200, 100), 10);
+    EXPECT_FLOAT_EQ(expanded.vertices[0].texcoord[0], -0.05f);
+    EXPECT_FLOAT_EQ(expanded.vertices[0].texcoord[1], -0.1f);
+    EXPECT_FLOAT_EQ(expanded.vertices[3].texcoord[0], 1.05f);
+    EXPECT_FLOAT_EQ(expanded.vertices[3].texcoord[1], 1.1f);
+}
+
+TEST(SdfDecorationTest, ExpandingFollowsFlippedTextures)
+{
+    auto rectangle = make_rectangle(0, 0, 100, 100);
+    for (auto& vertex : rectangle.vertices)
+        vertex.texcoord[1] = 1.f - vertex.texcoord[1];
+
+    auto const expanded = expand_rectangle(rectangle, 10);
+    EXPECT_FLOAT_EQ(expanded.vertices[0].texcoord[1], 1.1f);
+    EXPECT_FLOAT_EQ(expanded.vertices[1].texcoord[1], -0.1f);
+}
+
+TEST(SdfDecorationTest, ExpandingByNothingChangesNothing)
+{
+    auto const rectangle = make_rectangle(100, 50, 200, 100);
+    auto const expanded = expand_rectangle(rectangle, 0);
+    for (int i = 0; i < rectangle.nvertices; i++)
+    {
+        EXPECT_EQ(expanded.vertices[i].position[0], rectangle.vertices[i].position[0]);
+        EXPECT_EQ(expanded.vertices[i].texcoord[0], rectangle.vertices[i].texcoord[0]);
+    }
+}
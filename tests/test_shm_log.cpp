@@ -0,0 +1,168 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "shm_log.h"
+#include "shm_log_reader.h"
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <thread>
+#include <vector>
+
+using namespace miracle;
+
+namespace
+{
+/// Maps the log as miracle-wm-dump-log does, read only through its memfd
+class MappedLog
+{
+public:
+    explicit MappedLog(ShmLog const& log) :
+        size { log.get_size() },
+        data { mmap(nullptr, size, PROT_READ, MAP_SHARED, log.get_fd(), 0) },
+        reader { data, size }
+    {
+    }
+
+    ~MappedLog()
+    {
+        munmap(data, size);
+    }
+
+    std::size_t const size;
+    void* const data;
+    ShmLogReader const reader;
+};
+
+int const info = 3;
+}
+
+TEST(ShmLogTest, RecordsAreFormattedByTheReader)
+{
+    ShmLog log(16);
+    log.write(info, "test", "Window %d of %s is %.1f wide", 4, std::string("foot"), 1.5);
+
+    MappedLog mapped(log);
+    auto const record = mapped.reader.read(0);
+    ASSERT_TRUE(record);
+    EXPECT_EQ(record->component, "test");
+    EXPECT_EQ(record->severity, info);
+    EXPECT_EQ(record->message, "Window 4 of foot is 1.5 wide");
+    EXPECT_EQ(mapped.reader.get_next_index(), 1);
+}
+
+TEST(ShmLogTest, LengthModifiersFlagsAndWidthsAreApplied)
+{
+    ShmLog log(16);
+    log.write(info, "test", "%5zu|%-3d|%lld|%#x|%c|%*d|%%", std::size_t { 7 }, -2, 1234567890123ll, 255u, 'a', 4, 9);
+
+    MappedLog mapped(log);
+    EXPECT_EQ(mapped.reader.read(0)->message, "    7|-2 |1234567890123|0xff|a|   9|%");
+}
+
+TEST(ShmLogTest, MissingArgumentsAreLeftAsTheirConversion)
+{
+    ShmLog log(16);
+    log.write(info, "test", "%d and %s", 1);
+
+    MappedLog mapped(log);
+    EXPECT_EQ(mapped.reader.read(0)->message, "1 and %s");
+}
+
+TEST(ShmLogTest, LongMessagesAreTruncated)
+{
+    ShmLog log(16);
+    std::string const title(500, 'x');
+    log.write(info, "test", "Title is %s", title.c_str());
+
+    MappedLog mapped(log);
+    auto const message = mapped.reader.read(0)->message;
+    EXPECT_TRUE(message.starts_with("Title is xxx"));
+    EXPECT_TRUE(message.ends_with(" [truncated]"));
+}
+
+TEST(ShmLogTest, OldRecordsAreOverwritten)
+{
+    ShmLog log(4);
+    for (int i = 0; i < 6; i++)
+        log.write(info, "test", "Record %d", i);
+
+    MappedLog mapped(log);
+    EXPECT_EQ(mapped.reader.get_first_index(), 2);
+    EXPECT_EQ(mapped.reader.get_next_index(), 6);
+    EXPECT_FALSE(mapped.reader.read(1));
+    EXPECT_EQ(mapped.reader.read(2)->message, "Record 2");
+    EXPECT_EQ(mapped.reader.read(5)->message, "Record 5");
+}
+
+TEST(ShmLogTest, SlotCountIsRoundedUpToAPowerOfTwo)
+{
+    ShmLog log(5);
+    for (int i = 0; i < 8; i++)
+        log.write(info, "test", "Record %d", i);
+
+    MappedLog mapped(log);
+    EXPECT_EQ(mapped.reader.get_first_index(), 0);
+    EXPECT_EQ(mapped.reader.read(0)->message, "Record 0");
+}
+
+TEST(ShmLogTest, DisabledLogRecordsNothing)
+{
+    ShmLog log(16);
+    log.set_enabled(false);
+    log.write(info, "test", "Hidden");
+    EXPECT_FALSE(log.is_enabled());
+
+    log.set_enabled(true);
+    log.write(info, "test", "Shown");
+
+    MappedLog mapped(log);
+    EXPECT_EQ(mapped.reader.get_next_index(), 1);
+    EXPECT_EQ(mapped.reader.read(0)->message, "Shown");
+}
+
+TEST(ShmLogTest, ConcurrentWritersDoNotLoseRecords)
+{
+    int const thread_count = 4;
+    int const records_per_thread = 1000;
+    ShmLog log(thread_count * records_per_thread);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back([&log, t]
+        {
+            for (int i = 0; i < records_per_thread; i++)
+                log.write(info, "test", "%d:%d", t, i);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    MappedLog mapped(log);
+    ASSERT_EQ(mapped.reader.get_next_index(), thread_count * records_per_thread);
+
+    std::vector<int> next_per_thread(thread_count, 0);
+    for (std::uint64_t index = 0; index < mapped.reader.get_next_index(); index++)
+    {
+        auto const record = mapped.reader.read(index);
+        ASSERT_TRUE(record);
+
+        int t = 0, i = 0;
+        ASSERT_EQ(std::sscanf(record->message.c_str(), "%d:%d", &t, &i), 2);
+        EXPECT_EQ(i, next_per_thread[t]++);
+    }
+}
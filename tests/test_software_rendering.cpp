@@ -0,0 +1,77 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "software_rendering.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Rectangle const window { geom::Point { 100, 100 }, geom::Size { 800, 600 } };
+geom::Rectangle const outline { geom::Point { 98, 98 }, geom::Size { 804, 604 } };
+
+int get_area(std::vector<geom::Rectangle> const& rectangles)
+{
+    int area = 0;
+    for (auto const& rectangle : rectangles)
+        area += rectangle.size.width.as_int() * rectangle.size.height.as_int();
+    return area;
+}
+}
+
+TEST(SoftwareRenderingTest, SoftwareRenderersAreDetected)
+{
+    EXPECT_TRUE(is_software_renderer("llvmpipe (LLVM 15.0.7, 256 bits)"));
+    EXPECT_TRUE(is_software_renderer("zink Vulkan 1.3(llvmpipe (LLVM 17.0.6, 256 bits) (MESA_LLVMPIPE))"));
+    EXPECT_TRUE(is_software_renderer("softpipe"));
+    EXPECT_TRUE(is_software_renderer("Software Rasterizer"));
+    EXPECT_TRUE(is_software_renderer("Google SwiftShader"));
+}
+
+TEST(SoftwareRenderingTest, HardwareRenderersAreNotDetected)
+{
+    EXPECT_FALSE(is_software_renderer("AMD Radeon RX 6600 (radeonsi, navi23, LLVM 17.0.6, DRM 3.57)"));
+    EXPECT_FALSE(is_software_renderer("Mesa Intel(R) UHD Graphics 620 (KBL GT2)"));
+    EXPECT_FALSE(is_software_renderer(""));
+}
+
+TEST(SoftwareRenderingTest, BorderCoversOnlyTheOutline)
+{
+    auto const rectangles = get_border_rectangles(outline, window);
+    ASSERT_EQ(rectangles.size(), 4);
+    EXPECT_EQ(get_area(rectangles), 804 * 604 - 800 * 600);
+    for (auto const& rectangle : rectangles)
+        EXPECT_FALSE(rectangle.overlaps(window));
+}
+
+TEST(SoftwareRenderingTest, BorderSkipsSidesThatTheWindowReaches)
+{
+    geom::Rectangle const clipped { geom::Point { 98, 100 }, geom::Size { 804, 602 } };
+    auto const rectangles = get_border_rectangles(outline, clipped);
+    ASSERT_EQ(rectangles.size(), 1);
+    EXPECT_EQ(rectangles[0], (geom::Rectangle { geom::Point { 98, 98 }, geom::Size { 804, 2 } }));
+}
+
+TEST(SoftwareRenderingTest, BorderAroundNothingCoversEverything)
+{
+    geom::Rectangle const elsewhere { geom::Point { 2000, 2000 }, geom::Size { 10, 10 } };
+    auto const rectangles = get_border_rectangles(outline, elsewhere);
+    ASSERT_EQ(rectangles.size(), 1);
+    EXPECT_EQ(rectangles[0], outline);
+}
@@ -0,0 +1,99 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "swipe_gesture.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+using namespace std::chrono_literals;
+
+namespace
+{
+std::vector<TouchPoint> three_fingers(float x, float y, bool is_up = false)
+{
+    return {
+        { 0, is_up, x,         y },
+        { 1, is_up, x + 50.f,  y },
+        { 2, is_up, x + 100.f, y }
+    };
+}
+}
+
+class SwipeGestureTest : public testing::Test
+{
+public:
+    SwipeGestureTracker tracker { 3, 32.f };
+};
+
+TEST_F(SwipeGestureTest, TracksFingersAfterThreshold)
+{
+    EXPECT_EQ(tracker.handle(three_fingers(500, 500), 0ms).type, SwipeGestureTracker::Update::Type::none);
+    EXPECT_EQ(tracker.handle(three_fingers(490, 500), 8ms).type, SwipeGestureTracker::Update::Type::none);
+
+    auto begin = tracker.handle(three_fingers(460, 502), 16ms);
+    EXPECT_EQ(begin.type, SwipeGestureTracker::Update::Type::begin);
+    EXPECT_FLOAT_EQ(begin.offset, -40.f);
+    EXPECT_TRUE(begin.consumed);
+
+    auto move = tracker.handle(three_fingers(300, 510), 24ms);
+    EXPECT_EQ(move.type, SwipeGestureTracker::Update::Type::move);
+    EXPECT_FLOAT_EQ(move.offset, -200.f);
+}
+
+TEST_F(SwipeGestureTest, ReleaseReportsVelocity)
+{
+    tracker.handle(three_fingers(500, 500), 0ms);
+    tracker.handle(three_fingers(400, 500), 100ms);
+    tracker.handle(three_fingers(300, 500), 200ms);
+
+    auto end = tracker.handle(three_fingers(300, 500, true), 210ms);
+    EXPECT_EQ(end.type, SwipeGestureTracker::Update::Type::end);
+    EXPECT_FLOAT_EQ(end.offset, -200.f);
+    EXPECT_NEAR(end.velocity, -1000.f, 1.f);
+
+    // The lift must still reach clients
+    EXPECT_FALSE(end.consumed);
+}
+
+TEST_F(SwipeGestureTest, VerticalMovementIsNotASwipe)
+{
+    tracker.handle(three_fingers(500, 500), 0ms);
+    EXPECT_EQ(tracker.handle(three_fingers(510, 400), 16ms).type, SwipeGestureTracker::Update::Type::none);
+    EXPECT_EQ(tracker.handle(three_fingers(300, 400), 32ms).type, SwipeGestureTracker::Update::Type::none);
+}
+
+TEST_F(SwipeGestureTest, ExtraFingerCancelsTheSwipe)
+{
+    tracker.handle(three_fingers(500, 500), 0ms);
+    tracker.handle(three_fingers(400, 500), 16ms);
+
+    auto points = three_fingers(380, 500);
+    points.push_back({ 3, false, 600, 500 });
+    EXPECT_EQ(tracker.handle(points, 32ms).type, SwipeGestureTracker::Update::Type::cancel);
+}
+
+TEST_F(SwipeGestureTest, TwoFingersAreIgnored)
+{
+    std::vector<TouchPoint> points = {
+        { 0, false, 500, 500 },
+        { 1, false, 550, 500 }
+    };
+    tracker.handle(points, 0ms);
+    points[0].x = 300;
+    points[1].x = 350;
+    EXPECT_EQ(tracker.handle(points, 16ms).type, SwipeGestureTracker::Update::Type::none);
+}
@@ -0,0 +1,174 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "terminal_pool.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+class TerminalPoolTest : public testing::Test
+{
+public:
+    TerminalPoolTest() :
+        pool([this]() -> std::optional<pid_t>
+    {
+        if (fail_launches)
+            return std::nullopt;
+        return next_pid++;
+    })
+    {
+    }
+
+    pid_t next_pid = 100;
+    bool fail_launches = false;
+    TerminalPool pool;
+    TerminalPool::Clock::time_point now = TerminalPool::Clock::now();
+};
+
+TEST_F(TerminalPoolTest, FillLaunchesUpToCapacity)
+{
+    pool.set_capacity(2);
+    pool.fill(now);
+    EXPECT_EQ(pool.pending_count(), 2);
+    EXPECT_TRUE(pool.is_pending(100));
+    EXPECT_TRUE(pool.is_pending(101));
+
+    pool.fill(now);
+    EXPECT_EQ(pool.pending_count(), 2);
+}
+
+TEST_F(TerminalPoolTest, EmptyPoolLaunchesNothing)
+{
+    pool.fill(now);
+    EXPECT_EQ(pool.pending_count(), 0);
+    EXPECT_EQ(next_pid, 100);
+}
+
+TEST_F(TerminalPoolTest, ReadyTerminalsCanBeTakenInOrder)
+{
+    pool.set_capacity(2);
+    pool.fill(now);
+    EXPECT_TRUE(pool.advise_ready(101));
+    EXPECT_TRUE(pool.advise_ready(100));
+    EXPECT_FALSE(pool.is_pending(100));
+
+    EXPECT_EQ(pool.take(), 101);
+    EXPECT_EQ(pool.take(), 100);
+    EXPECT_EQ(pool.take(), std::nullopt);
+}
+
+TEST_F(TerminalPoolTest, UnknownPidIsNotMadeReady)
+{
+    pool.set_capacity(1);
+    pool.fill(now);
+    EXPECT_FALSE(pool.advise_ready(42));
+    EXPECT_EQ(pool.ready_count(), 0);
+}
+
+TEST_F(TerminalPoolTest, TakingMakesRoomForAReplacement)
+{
+    pool.set_capacity(1);
+    pool.fill(now);
+    pool.advise_ready(100);
+    pool.fill(now);
+    EXPECT_EQ(pool.pending_count(), 0);
+
+    EXPECT_EQ(pool.take(), 100);
+    pool.fill(now);
+    EXPECT_TRUE(pool.is_pending(101));
+}
+
+TEST_F(TerminalPoolTest, RemovedTerminalsAreReplaced)
+{
+    pool.set_capacity(1);
+    pool.fill(now);
+    pool.advise_ready(100);
+    pool.remove(100);
+    EXPECT_EQ(pool.ready_count(), 0);
+
+    pool.fill(now);
+    EXPECT_TRUE(pool.is_pending(101));
+}
+
+TEST_F(TerminalPoolTest, PendingTerminalsExpire)
+{
+    pool.set_capacity(1);
+    pool.fill(now);
+    pool.fill(now + TerminalPool::pending_timeout);
+    EXPECT_TRUE(pool.is_pending(100));
+    EXPECT_FALSE(pool.is_disabled());
+
+    pool.fill(now + TerminalPool::pending_timeout + std::chrono::seconds(1));
+    EXPECT_FALSE(pool.is_pending(100));
+}
+
+TEST_F(TerminalPoolTest, ExpiredTerminalDisablesThePool)
+{
+    pool.set_capacity(2);
+    pool.fill(now);
+    pool.advise_ready(100);
+
+    auto const later = now + TerminalPool::pending_timeout + std::chrono::seconds(1);
+    pool.fill(later);
+    EXPECT_TRUE(pool.is_disabled());
+    EXPECT_EQ(pool.pending_count(), 0);
+    EXPECT_EQ(next_pid, 102);
+
+    // Taking a terminal does not launch a replacement either
+    EXPECT_EQ(pool.take(), 100);
+    pool.fill(later);
+    EXPECT_EQ(pool.pending_count(), 0);
+    EXPECT_EQ(next_pid, 102);
+}
+
+TEST_F(TerminalPoolTest, EnablingTheDisabledPoolFillsItAgain)
+{
+    pool.set_capacity(1);
+    pool.fill(now);
+
+    auto const later = now + TerminalPool::pending_timeout + std::chrono::seconds(1);
+    pool.fill(later);
+    ASSERT_TRUE(pool.is_disabled());
+
+    pool.enable();
+    pool.fill(later);
+    EXPECT_FALSE(pool.is_disabled());
+    EXPECT_TRUE(pool.is_pending(101));
+}
+
+TEST_F(TerminalPoolTest, ShrinkingReturnsSurplusReadyTerminals)
+{
+    pool.set_capacity(3);
+    pool.fill(now);
+    pool.advise_ready(100);
+    pool.advise_ready(101);
+    pool.advise_ready(102);
+
+    auto surplus = pool.set_capacity(1);
+    ASSERT_EQ(surplus.size(), 2);
+    EXPECT_EQ(surplus[0], 102);
+    EXPECT_EQ(surplus[1], 101);
+    EXPECT_EQ(pool.take(), 100);
+}
+
+TEST_F(TerminalPoolTest, FailedLaunchesStopTheFill)
+{
+    fail_launches = true;
+    pool.set_capacity(2);
+    pool.fill(now);
+    EXPECT_EQ(pool.pending_count(), 0);
+}
@@ -0,0 +1,145 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "glyph_atlas.h"
+#include "text_run_cache.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+class TextRunCacheTest : public testing::Test
+{
+public:
+    TextRunCacheTest() :
+        atlas(64, 64, [&](char32_t codepoint, int pixel_size) -> std::optional<RasterizedGlyph>
+    {
+        rasterized++;
+        if (codepoint == U'\n')
+            return std::nullopt;
+
+        RasterizedGlyph glyph;
+        glyph.advance = pixel_size;
+        if (codepoint == U' ')
+            return glyph;
+
+        glyph.width = pixel_size - 2;
+        glyph.height = pixel_size;
+        glyph.bearing_x = 1;
+        glyph.bearing_y = pixel_size;
+        glyph.coverage.assign(glyph.width * glyph.height, 255);
+        return glyph;
+    })
+    {
+    }
+
+    int rasterized = 0;
+    int key = 0;
+    GlyphAtlas atlas;
+    TextRunCache cache;
+};
+
+TEST_F(TextRunCacheTest, DecodesUtf8)
+{
+    EXPECT_EQ(decode_utf8("a\xC3\xA9\xE2\x9C\x93\xF0\x9F\x98\x80"), std::u32string(U"aé✓\U0001F600"));
+}
+
+TEST_F(TextRunCacheTest, ReplacesMalformedUtf8)
+{
+    EXPECT_EQ(decode_utf8("a\xC3z"), std::u32string(U"a�z"));
+    EXPECT_EQ(decode_utf8("\xE2\x9C"), std::u32string(U"�"));
+}
+
+TEST_F(TextRunCacheTest, GlyphsAreRasterizedOncePerSize)
+{
+    atlas.get(U'a', 8);
+    atlas.get(U'a', 8);
+    EXPECT_EQ(rasterized, 1);
+
+    atlas.get(U'a', 10);
+    EXPECT_EQ(rasterized, 2);
+}
+
+TEST_F(TextRunCacheTest, GlyphsThatTheFontLacksAreNotRequestedAgain)
+{
+    EXPECT_EQ(atlas.get(U'\n', 8), nullptr);
+    EXPECT_EQ(atlas.get(U'\n', 8), nullptr);
+    EXPECT_EQ(rasterized, 1);
+}
+
+TEST_F(TextRunCacheTest, UnchangedTitlesAreNotLaidOutAgain)
+{
+    cache.get(&key, "abc", 8, 1000, atlas, 1);
+    cache.get(&key, "abc", 8, 1000, atlas, 2);
+    EXPECT_EQ(cache.get_layout_count(), 1u);
+
+    auto const& run = cache.get(&key, "abd", 8, 1000, atlas, 3);
+    EXPECT_EQ(cache.get_layout_count(), 2u);
+    EXPECT_EQ(run.vertices.size(), 18u);
+    EXPECT_EQ(rasterized, 4);
+}
+
+TEST_F(TextRunCacheTest, WhitespaceAdvancesWithoutVertices)
+{
+    auto const& run = cache.get(&key, "a b", 8, 1000, atlas, 1);
+    EXPECT_EQ(run.vertices.size(), 12u);
+    EXPECT_FLOAT_EQ(run.width, 24.f);
+}
+
+TEST_F(TextRunCacheTest, TextIsCutAtTheMaximumWidth)
+{
+    auto const& run = cache.get(&key, "abcdef", 8, 20, atlas, 1);
+    EXPECT_EQ(run.vertices.size(), 12u);
+}
+
+TEST_F(TextRunCacheTest, ClearingTheAtlasInvalidatesRuns)
+{
+    cache.get(&key, "abc", 8, 1000, atlas, 1);
+    atlas.clear();
+    cache.get(&key, "abc", 8, 1000, atlas, 2);
+    EXPECT_EQ(cache.get_layout_count(), 2u);
+}
+
+TEST_F(TextRunCacheTest, AtlasReportsWhenItIsFull)
+{
+    for (char32_t c = U'a'; c <= U'z' && !atlas.is_full(); c++)
+        atlas.get(c, 20);
+    EXPECT_TRUE(atlas.is_full());
+
+    atlas.clear();
+    EXPECT_FALSE(atlas.is_full());
+    EXPECT_NE(atlas.get(U'a', 20), nullptr);
+}
+
+TEST_F(TextRunCacheTest, OnlyNewRowsAreDirty)
+{
+    atlas.consume_dirty_rows();
+    auto const* glyph = atlas.get(U'a', 8);
+    auto const rows = atlas.consume_dirty_rows();
+    ASSERT_TRUE(rows);
+    EXPECT_EQ(rows->first, static_cast<int>(glyph->v0 * atlas.get_height()));
+    EXPECT_EQ(rows->second, rows->first + 8);
+    EXPECT_FALSE(atlas.consume_dirty_rows());
+}
+
+TEST_F(TextRunCacheTest, UnusedRunsAreEvicted)
+{
+    int other_key = 0;
+    cache.get(&key, "abc", 8, 1000, atlas, 1);
+    cache.get(&other_key, "abc", 8, 1000, atlas, 2);
+    cache.evict_unused_since(2);
+    EXPECT_EQ(cache.size(), 1u);
+}
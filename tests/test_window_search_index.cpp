@@ -0,0 +1,115 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "window_search_index.h"
+#include <gtest/gtest.h>
+
+using namespace miracle;
+
+class WindowSearchIndexTest : public testing::Test
+{
+public:
+    WindowSearchIndex index;
+};
+
+TEST_F(WindowSearchIndexTest, FindsWindowsByTitle)
+{
+    index.update(1, "Mozilla Firefox", "firefox");
+    index.update(2, "~/src/miracle-wm", "kitty");
+
+    auto const matches = index.search("miracle", 10);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].id, 2u);
+    EXPECT_EQ(matches[0].app_id, "kitty");
+}
+
+TEST_F(WindowSearchIndexTest, FindsWindowsByAppId)
+{
+    index.update(1, "Inbox", "org.gnome.Evolution");
+    auto const matches = index.search("evolution", 10);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].id, 1u);
+}
+
+TEST_F(WindowSearchIndexTest, SearchIsCaseInsensitive)
+{
+    index.update(1, "Mozilla Firefox", "firefox");
+    EXPECT_EQ(index.search("FIREFOX", 10).size(), 1u);
+}
+
+TEST_F(WindowSearchIndexTest, MatchesScatteredCharacters)
+{
+    index.update(1, "Visual Studio Code", "code");
+    auto const matches = index.search("vsc", 10);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].id, 1u);
+}
+
+TEST_F(WindowSearchIndexTest, PrefixesRankAboveScatteredMatches)
+{
+    index.update(1, "a terminal window", "kitty");
+    index.update(2, "terminal", "foot");
+    index.update(3, "the remote machine", "ssh");
+
+    auto const matches = index.search("term", 10);
+    ASSERT_EQ(matches.size(), 3u);
+    EXPECT_EQ(matches[0].id, 2u);
+    EXPECT_EQ(matches[1].id, 1u);
+    EXPECT_EQ(matches[2].id, 3u);
+}
+
+TEST_F(WindowSearchIndexTest, ReturnsAtMostTheLimit)
+{
+    for (uint64_t id = 0; id < 20; id++)
+        index.update(id, "terminal " + std::to_string(id), "foot");
+
+    EXPECT_EQ(index.search("term", 5).size(), 5u);
+}
+
+TEST_F(WindowSearchIndexTest, TitleChangesReplaceTheOldTitle)
+{
+    index.update(1, "vim main.cpp", "kitty");
+    index.update(1, "htop", "kitty");
+
+    EXPECT_TRUE(index.search("main", 10).empty());
+    EXPECT_EQ(index.search("htop", 10).size(), 1u);
+    EXPECT_EQ(index.size(), 1u);
+}
+
+TEST_F(WindowSearchIndexTest, RemovedWindowsAreNotFound)
+{
+    index.update(1, "Mozilla Firefox", "firefox");
+    index.remove(1);
+
+    EXPECT_TRUE(index.search("fire", 10).empty());
+    EXPECT_TRUE(index.search("", 10).empty());
+    EXPECT_EQ(index.size(), 0u);
+}
+
+TEST_F(WindowSearchIndexTest, EmptyQueryMatchesEveryWindow)
+{
+    index.update(1, "one", "a");
+    index.update(2, "two", "b");
+    EXPECT_EQ(index.search("", 10).size(), 2u);
+}
+
+TEST_F(WindowSearchIndexTest, UnmatchedQueryReturnsNothing)
+{
+    index.update(1, "Mozilla Firefox", "firefox");
+    EXPECT_TRUE(index.search("xyzzy", 10).empty());
+    EXPECT_TRUE(index.search("foxfire", 10).empty());
+}
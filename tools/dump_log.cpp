@@ -0,0 +1,300 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+// Prints the shared memory log of miracle-wm, like i3-dump-log does for i3.
+//
+//   miracle-wm-dump-log [-p <pid>] [-f]
+//   miracle-wm-dump-log -c <core file>
+//
+// The log of a live compositor is read through its memfd in /proc/<pid>/fd. The compositor is
+// found through $I3SOCK or $SWAYSOCK, or else by looking for the memfd in every process of the user.
+// With -f, new records are printed as they are written. The log stays mapped when the compositor
+// exits, so the records that it wrote before crashing are printed too.
+//
+// The log of a crashed compositor can also be found in its core file, as long as the core includes
+// anonymous shared memory (bit 1 of /proc/<pid>/coredump_filter, which is set by default).
+
+#include "shm_log_reader.h"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace miracle;
+
+namespace
+{
+struct Options
+{
+    std::optional<pid_t> pid;
+    std::optional<std::string> core_file;
+    bool follow = false;
+};
+
+void usage(char const* name)
+{
+    std::fprintf(stderr, "Usage: %s [-p <pid>] [-f]\n       %s -c <core file>\n", name, name);
+}
+
+Options parse_options(int argc, char* argv[])
+{
+    Options options;
+    int option;
+    while ((option = getopt(argc, argv, "p:c:fh")) != -1)
+    {
+        switch (option)
+        {
+        case 'p':
+            options.pid = std::atoi(optarg);
+            break;
+        case 'c':
+            options.core_file = optarg;
+            break;
+        case 'f':
+            options.follow = true;
+            break;
+        default:
+            usage(argv[0]);
+            std::exit(option == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+    }
+
+    if (options.core_file && (options.pid || options.follow))
+    {
+        usage(argv[0]);
+        std::exit(EXIT_FAILURE);
+    }
+    return options;
+}
+
+/// The IPC socket is named miracle-wm-ipc.<uid>.<pid>.sock
+std::optional<pid_t> pid_from_socket()
+{
+    for (auto const variable : { "I3SOCK", "SWAYSOCK" })
+    {
+        auto const path = std::getenv(variable);
+        if (!path)
+            continue;
+
+        unsigned int uid = 0;
+        int pid = 0;
+        auto const name = std::strrchr(path, '/');
+        if (std::sscanf(name ? name + 1 : path, "miracle-wm-ipc.%u.%d.sock", &uid, &pid) == 2)
+            return pid;
+    }
+
+    return std::nullopt;
+}
+
+/// @returns the path of the log memfd in /proc/<pid>/fd, if the process has one
+std::optional<std::string> find_memfd(pid_t pid)
+{
+    auto const directory = "/proc/" + std::to_string(pid) + "/fd";
+    auto const dir = opendir(directory.c_str());
+    if (!dir)
+        return std::nullopt;
+
+    auto const expected = std::string("/memfd:") + shm_log::memfd_name;
+    std::optional<std::string> result;
+    while (auto const entry = readdir(dir))
+    {
+        auto const path = directory + "/" + entry->d_name;
+        char target[256];
+        auto const length = readlink(path.c_str(), target, sizeof(target) - 1);
+        if (length <= 0)
+            continue;
+
+        target[length] = '\0';
+        if (std::strncmp(target, expected.c_str(), expected.size()) == 0)
+        {
+            result = path;
+            break;
+        }
+    }
+
+    closedir(dir);
+    return result;
+}
+
+std::optional<pid_t> find_compositor()
+{
+    if (auto const pid = pid_from_socket())
+        return pid;
+
+    auto const dir = opendir("/proc");
+    if (!dir)
+        return std::nullopt;
+
+    std::optional<pid_t> result;
+    while (auto const entry = readdir(dir))
+    {
+        char* end = nullptr;
+        auto const pid = static_cast<pid_t>(std::strtol(entry->d_name, &end, 10));
+        if (*end == '\0' && pid != getpid() && find_memfd(pid))
+        {
+            result = pid;
+            break;
+        }
+    }
+
+    closedir(dir);
+    return result;
+}
+
+struct Mapping
+{
+    void const* data = nullptr;
+    std::size_t size = 0;
+};
+
+Mapping map_file(std::string const& path)
+{
+    auto const fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("Unable to open " + path + ": " + std::strerror(errno));
+
+    struct stat info {};
+    fstat(fd, &info);
+    auto const size = static_cast<std::size_t>(info.st_size);
+    auto const data = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data == MAP_FAILED)
+        throw std::runtime_error("Unable to map " + path);
+
+    return { data, size };
+}
+
+/// Mappings in a core file start on a page boundary, so only those are searched
+ShmLogReader find_in_core(Mapping const& core)
+{
+    auto const page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    auto const* bytes = static_cast<char const*>(core.data);
+    for (std::size_t offset = 0; offset < core.size; offset += page_size)
+    {
+        if (ShmLogReader::is_log(bytes + offset, core.size - offset))
+            return ShmLogReader(bytes + offset, core.size - offset);
+    }
+
+    throw std::runtime_error("The core file does not hold a log. Were shared mappings left out of it?");
+}
+
+void print(ShmLogRecord const& record)
+{
+    static char const* const severities[] = { "critical", "error", "warning", "info", "debug" };
+    auto const severity = record.severity >= 0 && record.severity < 5 ? severities[record.severity] : "unknown";
+
+    auto const time = std::chrono::system_clock::to_time_t(record.time);
+    auto const microseconds = std::chrono::duration_cast<std::chrono::microseconds>(
+        record.time.time_since_epoch()).count() % 1'000'000;
+    tm local {};
+    localtime_r(&time, &local);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%F %T", &local);
+
+    std::printf("%s.%06lld [%u] %s %s: %s\n",
+        stamp, static_cast<long long>(microseconds), record.thread_id, severity,
+        record.component.c_str(), record.message.c_str());
+}
+
+/// Prints every record from the index onwards that has been written so far
+/// @param wait_for_writers Stop at a record that is still being written, so that it is printed next time
+/// @returns the index of the first record that was not printed
+std::uint64_t print_from(ShmLogReader const& reader, std::uint64_t index, bool wait_for_writers)
+{
+    auto const first = reader.get_first_index();
+    if (index < first)
+    {
+        if (index > 0)
+            std::printf("... %llu records were overwritten before they were read\n",
+                static_cast<unsigned long long>(first - index));
+        index = first;
+    }
+
+    auto const next = reader.get_next_index();
+    for (; index < next; index++)
+    {
+        if (auto const record = reader.read(index))
+            print(record.value());
+        else if (wait_for_writers && index >= reader.get_first_index())
+            break;
+    }
+    std::fflush(stdout);
+    return index;
+}
+
+bool is_alive(pid_t pid)
+{
+    return kill(pid, 0) == 0 || errno != ESRCH;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    auto const options = parse_options(argc, argv);
+    try
+    {
+        if (options.core_file)
+        {
+            auto const core = map_file(options.core_file.value());
+            print_from(find_in_core(core), 0, false);
+            return EXIT_SUCCESS;
+        }
+
+        auto const pid = options.pid ? options.pid : find_compositor();
+        if (!pid)
+            throw std::runtime_error("Unable to find a running miracle-wm. Pass its pid with -p.");
+
+        auto const memfd = find_memfd(pid.value());
+        if (!memfd)
+            throw std::runtime_error("Process " + std::to_string(pid.value()) + " has no log");
+
+        auto const mapping = map_file(memfd.value());
+        ShmLogReader const reader(mapping.data, mapping.size);
+        auto index = print_from(reader, 0, options.follow);
+        while (options.follow)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            auto const has_exited = !is_alive(pid.value());
+            index = print_from(reader, index, !has_exited);
+            if (has_exited)
+            {
+                std::printf("... miracle-wm (pid %d) has exited\n", pid.value());
+                break;
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "headless_gl.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdexcept>
+#include <vector>
+
+namespace miracle::benchmark
+{
+
+char const* const plain_vertex_shader_src = R"(
+attribute vec3 position;
+attribute vec2 texcoord;
+uniform mat4 screen_to_gl_coords;
+uniform mat4 display_transform;
+uniform mat4 workspace_transform;
+uniform mat4 transform;
+uniform vec2 centre;
+varying vec2 v_texcoord;
+void main() {
+   vec4 mid = vec4(centre, 0.0, 0.0);
+   vec4 transformed = (transform * (vec4(position, 1.0) - mid)) + mid;
+   gl_Position = display_transform * screen_to_gl_coords * workspace_transform * transformed;
+   v_texcoord = texcoord;
+}
+)";
+
+char const* const plain_fragment_main_src = R"(
+varying vec2 v_texcoord;
+uniform float alpha;
+void main() {
+    gl_FragColor = alpha * sample_to_rgba(v_texcoord);
+}
+)";
+
+namespace
+{
+// The same fragment that Mir provides for RGBA buffers
+char const* const sample_to_rgba_src = R"(
+uniform sampler2D tex;
+vec4 sample_to_rgba(in vec2 texcoord) {
+    return texture2D(tex, texcoord);
+}
+)";
+
+GLuint compile_shader(GLenum type, std::string const& src)
+{
+    auto const id = glCreateShader(type);
+    auto const* source = src.c_str();
+    glShaderSource(id, 1, &source, nullptr);
+    glCompileShader(id);
+    GLint ok = GL_FALSE;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        GLchar log[1024] = "(No log info)";
+        glGetShaderInfoLog(id, sizeof log, nullptr, log);
+        throw std::runtime_error(std::string("Compile failed: ") + log);
+    }
+    return id;
+}
+}
+
+void make_context_current()
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+    auto const get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display)
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+        throw std::runtime_error("Unable to initialize an EGL display");
+
+    EGLint const config_attributes[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(display, config_attributes, &config, 1, &config_count) || config_count == 0)
+        throw std::runtime_error("No EGL config supports GLES2");
+
+    eglBindAPI(EGL_OPENGL_ES_API);
+    EGLint const context_attributes[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    auto const context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    if (context == EGL_NO_CONTEXT)
+        throw std::runtime_error("Unable to create a GLES2 context");
+
+    // Everything is drawn into a framebuffer object, so no surface is needed
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        throw std::runtime_error("Unable to make the context current");
+}
+
+GLuint link_program(std::string const& vertex_src, std::string const& fragment_src)
+{
+    auto const program = glCreateProgram();
+    glAttachShader(program, compile_shader(GL_VERTEX_SHADER, vertex_src));
+    glAttachShader(program, compile_shader(GL_FRAGMENT_SHADER, fragment_src));
+    glLinkProgram(program);
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        GLchar log[1024] = "(No log info)";
+        glGetProgramInfoLog(program, sizeof log, nullptr, log);
+        throw std::runtime_error(std::string("Link failed: ") + log);
+    }
+    return program;
+}
+
+std::string make_fragment_shader(char const* main_src)
+{
+    return std::string("#ifdef GL_ES\n"
+                       "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+                       "precision highp float;\n"
+                       "#else\n"
+                       "precision mediump float;\n"
+                       "#endif\n"
+                       "#endif\n")
+        + sample_to_rgba_src + main_src;
+}
+
+GLuint create_output_framebuffer(bool with_stencil)
+{
+    GLuint target = 0;
+    glGenTextures(1, &target);
+    glBindTexture(GL_TEXTURE_2D, target);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, output_width, output_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    if (with_stencil)
+    {
+        GLuint stencil = 0;
+        glGenRenderbuffers(1, &stencil);
+        glBindRenderbuffer(GL_RENDERBUFFER, stencil);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, output_width, output_height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, stencil);
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Offscreen framebuffer is incomplete");
+    glViewport(0, 0, output_width, output_height);
+    return framebuffer;
+}
+
+GLuint create_noise_texture(int width, int height)
+{
+    std::vector<unsigned char> pixels(width * height * 4);
+    unsigned int seed = 1;
+    for (auto& pixel : pixels)
+    {
+        seed = seed * 1103515245 + 12345;
+        pixel = static_cast<unsigned char>(seed >> 16);
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return texture;
+}
+
+void set_output_uniforms(GLuint program)
+{
+    // Maps the output onto normalized device coordinates with y pointing down
+    GLfloat const screen_to_gl_coords[16] = {
+        2.f / output_width, 0, 0, 0,
+        0, -2.f / output_height, 0, 0,
+        0, 0, 1, 0,
+        -1, 1, 0, 1
+    };
+    GLfloat const identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    glUniformMatrix4fv(glGetUniformLocation(program, "screen_to_gl_coords"), 1, GL_FALSE, screen_to_gl_coords);
+    glUniformMatrix4fv(glGetUniformLocation(program, "display_transform"), 1, GL_FALSE, identity);
+    glUniformMatrix4fv(glGetUniformLocation(program, "workspace_transform"), 1, GL_FALSE, identity);
+    glUniformMatrix4fv(glGetUniformLocation(program, "transform"), 1, GL_FALSE, identity);
+    glUniform1i(glGetUniformLocation(program, "tex"), 0);
+    glUniform1f(glGetUniformLocation(program, "alpha"), 1.f);
+}
+
+mir::gl::Primitive make_window(float left, float top, float width, float height)
+{
+    mir::gl::Primitive rectangle;
+    rectangle.type = GL_TRIANGLE_STRIP;
+    rectangle.vertices[0] = { { left, top, 0.f }, { 0.f, 0.f } };
+    rectangle.vertices[1] = { { left, top + height, 0.f }, { 0.f, 1.f } };
+    rectangle.vertices[2] = { { left + width, top, 0.f }, { 1.f, 0.f } };
+    rectangle.vertices[3] = { { left + width, top + height, 0.f }, { 1.f, 1.f } };
+    return rectangle;
+}
+
+}
@@ -0,0 +1,62 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef MIRACLEWM_HEADLESS_GL_H
+#define MIRACLEWM_HEADLESS_GL_H
+
+#include "primitive.h"
+
+#include <GLES2/gl2.h>
+#include <string>
+
+// Helpers for the rendering benchmarks, which draw offscreen on a surfaceless EGL display
+// so that they run on llvmpipe without a seat or a running compositor.
+namespace miracle::benchmark
+{
+
+int const output_width = 1920;
+int const output_height = 1080;
+
+/// The vertex shader of the renderer
+extern char const* const plain_vertex_shader_src;
+
+/// The fragment of the renderer for translucent windows
+extern char const* const plain_fragment_main_src;
+
+/// Makes a GLES2 context current on a surfaceless EGL display
+/// @throws std::runtime_error if no context could be made
+void make_context_current();
+
+GLuint link_program(std::string const& vertex_src, std::string const& fragment_src);
+
+/// Prepends the precision qualifiers and the fragment that Mir provides for RGBA buffers
+std::string make_fragment_shader(char const* main_src);
+
+/// Creates and binds a framebuffer the size of the output, optionally with a stencil buffer
+GLuint create_output_framebuffer(bool with_stencil);
+
+/// Creates a texture of random pixels, so that no sampling shortcut applies
+GLuint create_noise_texture(int width, int height);
+
+/// Sets the uniforms that map the output onto normalized device coordinates, without any transform
+void set_output_uniforms(GLuint program);
+
+mir::gl::Primitive make_window(float left, float top, float width, float height);
+
+}
+
+#endif // MIRACLEWM_HEADLESS_GL_H
@@ -0,0 +1,304 @@
+#!/usr/bin/env python3
+#
+# Generates i3 IPC load against a running (or freshly launched, headless) miracle-wm
+# and reports request latency, event delivery latency, throughput and compositor CPU.
+#
+# Examples:
+#   # Against the compositor that owns $I3SOCK
+#   ./tools/ipc_load.py --pollers 32 --subscribers 64 --duration 20
+#
+#   # Launch a headless compositor on a virtual output and benchmark it
+#   ./tools/ipc_load.py --launch build/bin/miracle-wm --pollers 16 --subscribers 16
+
+import argparse
+import asyncio
+import glob
+import json
+import os
+import random
+import shutil
+import signal
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+IPC_MAGIC = b"i3-ipc"
+IPC_HEADER = struct.Struct("=6sII")
+
+IPC_COMMAND = 0
+IPC_GET_WORKSPACES = 1
+IPC_SUBSCRIBE = 2
+IPC_GET_TREE = 4
+IPC_SEARCH_WINDOWS = 201
+IPC_EVENT_WORKSPACE = (1 << 31) | 0
+
+REQUESTS = {
+    "tree": IPC_GET_TREE,
+    "workspaces": IPC_GET_WORKSPACES,
+    "command": IPC_COMMAND,
+    "search": IPC_SEARCH_WINDOWS,
+}
+
+PAYLOADS = {
+    "command": "nop",
+    "search": json.dumps({"query": "term", "limit": 10}),
+}
+
+
+class Connection:
+    def __init__(self, reader, writer):
+        self.reader = reader
+        self.writer = writer
+
+    @staticmethod
+    async def open(path):
+        reader, writer = await asyncio.open_unix_connection(path, limit=64 * 1024 * 1024)
+        return Connection(reader, writer)
+
+    async def send(self, message_type, payload=b""):
+        if isinstance(payload, str):
+            payload = payload.encode()
+        self.writer.write(IPC_HEADER.pack(IPC_MAGIC, len(payload), message_type) + payload)
+        await self.writer.drain()
+
+    async def receive(self):
+        header = await self.reader.readexactly(IPC_HEADER.size)
+        magic, length, message_type = IPC_HEADER.unpack(header)
+        if magic != IPC_MAGIC:
+            raise RuntimeError("Invalid IPC magic")
+        payload = await self.reader.readexactly(length)
+        return message_type, payload
+
+    def close(self):
+        self.writer.close()
+
+
+class Stats:
+    def __init__(self):
+        self.request_latencies = {name: [] for name in REQUESTS}
+        self.event_latencies = []
+        self.events_expected = 0
+        self.errors = 0
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(p / 100.0 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def parse_mix(mix):
+    weights = {}
+    for part in mix.split(","):
+        name, _, weight = part.partition("=")
+        if name not in REQUESTS:
+            raise argparse.ArgumentTypeError(f"Unknown request type '{name}', expected one of {list(REQUESTS)}")
+        weights[name] = float(weight or 1)
+    return weights
+
+
+def read_cpu_seconds(pid):
+    if pid is None:
+        return None
+    try:
+        with open(f"/proc/{pid}/stat") as f:
+            fields = f.read().rsplit(")", 1)[1].split()
+        # utime and stime are fields 14 and 15 in proc(5), counted from after the command name
+        return (int(fields[11]) + int(fields[12])) / os.sysconf("SC_CLK_TCK")
+    except (OSError, IndexError, ValueError):
+        return None
+
+
+async def poller(path, weights, deadline, stats):
+    connection = await Connection.open(path)
+    names = list(weights)
+    name_weights = [weights[name] for name in names]
+    try:
+        while time.monotonic() < deadline:
+            name = random.choices(names, weights=name_weights)[0]
+            payload = PAYLOADS.get(name, "")
+            start = time.perf_counter()
+            await connection.send(REQUESTS[name], payload)
+            message_type, _ = await connection.receive()
+            if message_type != REQUESTS[name]:
+                stats.errors += 1
+                continue
+            stats.request_latencies[name].append(time.perf_counter() - start)
+    except (ConnectionError, asyncio.IncompleteReadError):
+        stats.errors += 1
+    finally:
+        connection.close()
+
+
+async def subscriber(path, deadline, sent_at, stats):
+    connection = await Connection.open(path)
+    try:
+        await connection.send(IPC_SUBSCRIBE, json.dumps(["workspace"]))
+        await connection.receive()
+        while True:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                break
+            try:
+                message_type, payload = await asyncio.wait_for(connection.receive(), remaining)
+            except asyncio.TimeoutError:
+                break
+            now = time.perf_counter()
+            if message_type != IPC_EVENT_WORKSPACE:
+                continue
+            event = json.loads(payload)
+            if event.get("change") != "focus":
+                continue
+            num = event.get("current", {}).get("num")
+            if num in sent_at:
+                stats.event_latencies.append(now - sent_at[num])
+    except (ConnectionError, asyncio.IncompleteReadError):
+        stats.errors += 1
+    finally:
+        connection.close()
+
+
+async def workspace_driver(path, deadline, interval, sent_at, num_subscribers, stats):
+    connection = await Connection.open(path)
+    workspaces = [1, 2, 3]
+    index = 0
+    try:
+        while time.monotonic() < deadline:
+            workspace = workspaces[index % len(workspaces)]
+            index += 1
+            sent_at[workspace] = time.perf_counter()
+            await connection.send(IPC_COMMAND, f"workspace number {workspace}")
+            await connection.receive()
+            stats.events_expected += num_subscribers
+            await asyncio.sleep(interval)
+    except (ConnectionError, asyncio.IncompleteReadError):
+        stats.errors += 1
+    finally:
+        connection.close()
+
+
+async def run(args, path):
+    stats = Stats()
+    sent_at = {}
+    start = time.monotonic()
+    deadline = start + args.duration
+    tasks = [poller(path, args.mix, deadline, stats) for _ in range(args.pollers)]
+    tasks += [subscriber(path, deadline + 1, sent_at, stats) for _ in range(args.subscribers)]
+    if args.workspace_interval > 0:
+        tasks.append(workspace_driver(path, deadline, args.workspace_interval / 1000.0, sent_at, args.subscribers, stats))
+    await asyncio.gather(*tasks)
+    # Subscribers linger briefly to collect late events, which should not count towards throughput
+    return stats, min(time.monotonic() - start, args.duration)
+
+
+def wait_for_socket(pid, timeout):
+    runtime_dir = os.environ.get("XDG_RUNTIME_DIR", "/tmp")
+    pattern = os.path.join(runtime_dir, f"miracle-wm-ipc.{os.getuid()}.{pid}.sock")
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        matches = glob.glob(pattern)
+        if matches:
+            return matches[0]
+        time.sleep(0.1)
+    raise RuntimeError(f"Timed out waiting for {pattern}")
+
+
+def launch_headless(executable, output_size):
+    # Run on Mir's virtual platform so that no GPU or seat is required
+    env = dict(os.environ)
+    env.pop("SWAYSOCK", None)
+    env.pop("I3SOCK", None)
+    env["WAYLAND_DISPLAY"] = f"miracle-wm-ipc-load-{os.getpid()}"
+    config_dir = tempfile.mkdtemp(prefix="miracle-wm-ipc-load-")
+    env["XDG_CONFIG_HOME"] = config_dir
+    process = subprocess.Popen(
+        [executable, "--platform-display-libs", "mir:virtual", "--virtual-output", output_size],
+        env=env,
+        stdout=subprocess.DEVNULL,
+        stderr=subprocess.DEVNULL)
+    return process, config_dir
+
+
+def report(args, stats, elapsed, cpu_seconds):
+    print(f"connections: {args.pollers} pollers, {args.subscribers} subscribers, {elapsed:.1f}s")
+    total = 0
+    print(f"{'request':<12}{'count':>10}{'req/s':>10}{'p50 ms':>10}{'p90 ms':>10}{'p99 ms':>10}{'max ms':>10}")
+    for name, latencies in stats.request_latencies.items():
+        if not latencies:
+            continue
+        total += len(latencies)
+        print(f"{name:<12}{len(latencies):>10}{len(latencies) / elapsed:>10.0f}"
+              f"{percentile(latencies, 50) * 1000:>10.2f}{percentile(latencies, 90) * 1000:>10.2f}"
+              f"{percentile(latencies, 99) * 1000:>10.2f}{max(latencies) * 1000:>10.2f}")
+    print(f"throughput: {total / elapsed:.0f} requests/s")
+
+    if stats.events_expected:
+        events = stats.event_latencies
+        print(f"events: {len(events)}/{stats.events_expected} delivered, "
+              f"p50 {percentile(events, 50) * 1000:.2f} ms, "
+              f"p99 {percentile(events, 99) * 1000:.2f} ms")
+
+    if cpu_seconds is not None:
+        print(f"compositor cpu: {cpu_seconds:.2f}s ({cpu_seconds / elapsed * 100:.1f}% of one core)")
+    if stats.errors:
+        print(f"errors: {stats.errors}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark the miracle-wm i3 IPC server under load")
+    parser.add_argument("--socket", default=os.environ.get("I3SOCK") or os.environ.get("SWAYSOCK"),
+                        help="Path to the IPC socket (defaults to $I3SOCK)")
+    parser.add_argument("--pid", type=int, help="Compositor pid used to measure CPU usage")
+    parser.add_argument("--launch", metavar="MIRACLE_WM",
+                        help="Launch this miracle-wm binary headless on a virtual output and benchmark it")
+    parser.add_argument("--virtual-output", default="1920x1080", help="Size of the virtual output when launching")
+    parser.add_argument("--pollers", type=int, default=8, help="Connections issuing requests in a loop")
+    parser.add_argument("--subscribers", type=int, default=8, help="Connections subscribed to workspace events")
+    parser.add_argument("--mix", type=parse_mix, default=parse_mix("tree=1,workspaces=1,command=1"),
+                        help="Weighted request mix for pollers, e.g. tree=2,workspaces=1,command=1")
+    parser.add_argument("--workspace-interval", type=float, default=100,
+                        help="Milliseconds between workspace switches, or 0 to disable")
+    parser.add_argument("--duration", type=float, default=10, help="Seconds to run for")
+    args = parser.parse_args()
+
+    process = None
+    config_dir = None
+    if args.launch:
+        process, config_dir = launch_headless(args.launch, args.virtual_output)
+        args.pid = process.pid
+        args.socket = wait_for_socket(process.pid, 10)
+    elif args.pid is None and args.socket:
+        # The socket path embeds the pid of the compositor
+        try:
+            args.pid = int(os.path.basename(args.socket).split(".")[2])
+        except (IndexError, ValueError):
+            pass
+
+    if not args.socket:
+        parser.error("No IPC socket found, pass --socket or --launch")
+
+    try:
+        cpu_before = read_cpu_seconds(args.pid)
+        stats, elapsed = asyncio.run(run(args, args.socket))
+        cpu_after = read_cpu_seconds(args.pid)
+        cpu_seconds = cpu_after - cpu_before if cpu_before is not None and cpu_after is not None else None
+        report(args, stats, elapsed, cpu_seconds)
+    finally:
+        if process:
+            process.send_signal(signal.SIGTERM)
+            try:
+                process.wait(5)
+            except subprocess.TimeoutExpired:
+                process.kill()
+        if config_dir:
+            shutil.rmtree(config_dir, ignore_errors=True)
+
+    return 0 if stats.errors == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,128 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+// Measures how long a pointer lookup in the output index takes on a video wall, as during a
+// pointer motion storm. The pointer is swept across every output of walls laid out eight
+// outputs to a row.
+//
+//   miracle-wm-output-index-benchmark [--iterations N] [--outputs N]...
+//
+// Without --outputs, walls of 16 and 32 outputs are measured.
+
+#include "output_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace miracle;
+
+namespace
+{
+int const output_width = 1920;
+int const output_height = 1080;
+int const outputs_per_row = 8;
+
+struct Options
+{
+    int iterations = 1000000;
+    std::vector<int> outputs;
+};
+
+Options parse_options(int argc, char const* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string const arg = argv[i];
+        auto const next = [&]() -> char const*
+        {
+            if (i + 1 >= argc)
+                throw std::runtime_error("Missing value for " + arg);
+            return argv[++i];
+        };
+
+        if (arg == "--iterations")
+            options.iterations = std::atoi(next());
+        else if (arg == "--outputs")
+            options.outputs.push_back(std::atoi(next()));
+        else
+            throw std::runtime_error("Unknown option: " + arg);
+    }
+
+    if (options.outputs.empty())
+        options.outputs = { 16, 32 };
+    return options;
+}
+
+/// @returns the number of lookups that found an output
+int sweep(OutputIndex const& index, int num_outputs, int iterations)
+{
+    auto const rows = (num_outputs + outputs_per_row - 1) / outputs_per_row;
+    auto const total_width = output_width * std::min(num_outputs, outputs_per_row);
+    auto const total_height = output_height * rows;
+    int found = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto const x = static_cast<int>((static_cast<int64_t>(i) * 7919) % total_width);
+        auto const y = static_cast<int>((static_cast<int64_t>(i) * 104729) % total_height);
+        if (index.find_at(geom::Point(x, y)))
+            found++;
+    }
+    return found;
+}
+}
+
+int main(int argc, char const* argv[])
+{
+    try
+    {
+        auto const options = parse_options(argc, argv);
+        for (auto const num_outputs : options.outputs)
+        {
+            OutputIndex index;
+            for (int i = 0; i < num_outputs; i++)
+            {
+                index.insert(i, geom::Rectangle(
+                                    geom::Point((i % outputs_per_row) * output_width, (i / outputs_per_row) * output_height),
+                                    geom::Size(output_width, output_height)));
+            }
+
+            auto const start = std::chrono::steady_clock::now();
+            auto const found = sweep(index, num_outputs, options.iterations);
+            auto const elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+
+            std::printf("%d outputs: %.2f ns per lookup\n", num_outputs, elapsed.count() / options.iterations);
+            if (found != options.iterations)
+            {
+                std::fprintf(stderr, "%d lookups inside the wall found no output\n", options.iterations - found);
+                return EXIT_FAILURE;
+            }
+        }
+        return EXIT_SUCCESS;
+    }
+    catch (std::exception const& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
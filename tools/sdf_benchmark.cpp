@@ -0,0 +1,217 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+// Compares the cost of drawing a window as a plain textured quad with the cost of drawing it
+// with rounded corners, a border and a shadow through the SDF decoration shader. The scene is
+// rendered offscreen on a surfaceless EGL display, so this also runs on llvmpipe without a seat.
+//
+//   miracle-wm-sdf-benchmark [--windows N] [--frames N] [--size WxH] [--max-ratio R]
+//
+// Exits with a failure when a decorated window costs more than R times a plain one.
+
+#include "headless_gl.h"
+#include "sdf_decoration.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace miracle;
+using namespace miracle::benchmark;
+
+namespace
+{
+struct Options
+{
+    int windows = 16;
+    int frames = 120;
+    int window_width = 800;
+    int window_height = 600;
+    double max_ratio = 3.0;
+};
+
+Options parse_options(int argc, char const* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string const arg = argv[i];
+        auto const next = [&]() -> char const*
+        {
+            if (i + 1 >= argc)
+                throw std::runtime_error("Missing value for " + arg);
+            return argv[++i];
+        };
+
+        if (arg == "--windows")
+            options.windows = std::atoi(next());
+        else if (arg == "--frames")
+            options.frames = std::atoi(next());
+        else if (arg == "--size")
+        {
+            if (std::sscanf(next(), "%dx%d", &options.window_width, &options.window_height) != 2)
+                throw std::runtime_error("--size must look like 800x600");
+        }
+        else if (arg == "--max-ratio")
+            options.max_ratio = std::atof(next());
+        else
+            throw std::runtime_error("Unknown argument " + arg);
+    }
+
+    if (options.windows <= 0 || options.frames <= 0 || options.window_width <= 0 || options.window_height <= 0)
+        throw std::runtime_error("Arguments must be positive");
+    return options;
+}
+
+class Scene
+{
+public:
+    explicit Scene(Options const& options) :
+        options { options }
+    {
+        framebuffer = create_output_framebuffer(false);
+
+        // A noisy, translucent buffer so that no sampling shortcut applies
+        buffer = create_noise_texture(options.window_width, options.window_height);
+
+        plain = link_program(plain_vertex_shader_src, make_fragment_shader(plain_fragment_main_src));
+        decorated = link_program(sdf_vertex_shader_src, make_fragment_shader(sdf_fragment_shader_src));
+
+        // Cascade the windows across the output, as they would be when floating
+        for (int i = 0; i < options.windows; i++)
+        {
+            auto const x = static_cast<float>((i * 67) % std::max(1, output_width - options.window_width));
+            auto const y = static_cast<float>((i * 43) % std::max(1, output_height - options.window_height));
+            windows.push_back(make_window(x, y, options.window_width, options.window_height));
+        }
+
+        decoration.radius = 12;
+        decoration.border_width = 2;
+        decoration.border_color = glm::vec4(0.2f, 0.4f, 0.8f, 1.f);
+        decoration.shadow_sigma = 10;
+        decoration.shadow_offset = glm::vec2(0, 4);
+        decoration.shadow_color = glm::vec4(0, 0, 0, 0.5f);
+    }
+
+    /// @returns The average time to draw one window, in microseconds
+    double measure(bool is_decorated)
+    {
+        auto const program = is_decorated ? decorated : plain;
+        glUseProgram(program);
+        set_output_uniforms(program);
+        if (is_decorated)
+            set_decoration_uniforms(program);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        glBindTexture(GL_TEXTURE_2D, buffer);
+
+        // Warm up, so that shader compilation and texture upload are not measured
+        draw_frame(program, is_decorated);
+        glFinish();
+
+        auto const start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < options.frames; frame++)
+            draw_frame(program, is_decorated);
+        glFinish();
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+
+        if (auto const error = glGetError())
+            throw std::runtime_error("GL error " + std::to_string(error));
+
+        return std::chrono::duration<double, std::micro>(elapsed).count() / (options.frames * options.windows);
+    }
+
+private:
+    void set_decoration_uniforms(GLuint program)
+    {
+        glUniform2f(glGetUniformLocation(program, "half_size"), options.window_width / 2.f, options.window_height / 2.f);
+        glUniform2f(glGetUniformLocation(program, "shape_centre"), 0.f, 0.f);
+        glUniform1f(glGetUniformLocation(program, "radius"), decoration.radius);
+        glUniform1f(glGetUniformLocation(program, "border_width"), decoration.border_width);
+        glUniform4f(glGetUniformLocation(program, "border_color"),
+            decoration.border_color.r, decoration.border_color.g, decoration.border_color.b, decoration.border_color.a);
+        glUniform4f(glGetUniformLocation(program, "shadow_color"),
+            decoration.shadow_color.r, decoration.shadow_color.g, decoration.shadow_color.b, decoration.shadow_color.a);
+        glUniform2f(glGetUniformLocation(program, "shadow_offset"), decoration.shadow_offset.x, decoration.shadow_offset.y);
+        glUniform1f(glGetUniformLocation(program, "shadow_sigma"), decoration.shadow_sigma);
+        glUniform1f(glGetUniformLocation(program, "opaque_content"), 0.f);
+    }
+
+    void draw_frame(GLuint program, bool is_decorated)
+    {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        auto const position = glGetAttribLocation(program, "position");
+        auto const texcoord = glGetAttribLocation(program, "texcoord");
+        auto const centre = glGetUniformLocation(program, "centre");
+        glEnableVertexAttribArray(position);
+        glEnableVertexAttribArray(texcoord);
+        for (auto const& window : windows)
+        {
+            auto const primitive = is_decorated ? expand_rectangle(window, decoration.get_extent()) : window;
+            glUniform2f(centre,
+                window.vertices[0].position[0] + options.window_width / 2.f,
+                window.vertices[0].position[1] + options.window_height / 2.f);
+            glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, sizeof(mir::gl::Vertex), &primitive.vertices[0].position);
+            glVertexAttribPointer(texcoord, 2, GL_FLOAT, GL_FALSE, sizeof(mir::gl::Vertex), &primitive.vertices[0].texcoord);
+            glDrawArrays(primitive.type, 0, primitive.nvertices);
+        }
+        glDisableVertexAttribArray(texcoord);
+        glDisableVertexAttribArray(position);
+    }
+
+    Options options;
+    GLuint framebuffer = 0;
+    GLuint buffer = 0;
+    GLuint plain = 0;
+    GLuint decorated = 0;
+    std::vector<mir::gl::Primitive> windows;
+    SdfDecoration decoration;
+};
+}
+
+int main(int argc, char const* argv[])
+{
+    try
+    {
+        auto const options = parse_options(argc, argv);
+        make_context_current();
+        std::printf("GL renderer: %s\n", reinterpret_cast<char const*>(glGetString(GL_RENDERER)));
+        std::printf("%d windows of %dx%d, %d frames\n",
+            options.windows, options.window_width, options.window_height, options.frames);
+
+        Scene scene(options);
+        auto const plain = scene.measure(false);
+        auto const decorated = scene.measure(true);
+        auto const ratio = decorated / plain;
+        std::printf("plain:     %8.1f us per window\n", plain);
+        std::printf("decorated: %8.1f us per window\n", decorated);
+        std::printf("ratio:     %8.2f (limit %.2f)\n", ratio, options.max_ratio);
+        return ratio <= options.max_ratio ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception const& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,336 @@
+/**
+Copyright (C) 2024  Matthew Kosarek
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+// Compares the CPU time that a frame of tiled windows with borders costs on the default render
+// path with the cost on the software render path, which the renderer selects on drivers such
+// as llvmpipe. The default path masks each border with the stencil buffer, while the software
+// path draws the border as rectangles around the window, never blends a solid border and
+// scissors every draw to what can be seen of it. The scene is rendered offscreen on a
+// surfaceless EGL display, so this runs without a seat.
+//
+//   miracle-wm-software-render-benchmark [--columns N] [--rows N] [--frames N] [--border N] [--max-ratio R]
+//
+// Exits with a failure when the two paths draw different pixels, or when the software path
+// costs more than R times the CPU time of the default path.
+
+#include "headless_gl.h"
+#include "software_rendering.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace miracle;
+using namespace miracle::benchmark;
+namespace geom = mir::geometry;
+
+namespace
+{
+char const* const outline_fragment_main_src = R"(
+uniform vec4 outline_color;
+void main() {
+    gl_FragColor = outline_color;
+}
+)";
+
+int const gap = 10;
+
+struct Options
+{
+    int columns = 3;
+    int rows = 2;
+    int frames = 60;
+    int border = 3;
+    double max_ratio = 1.0;
+};
+
+Options parse_options(int argc, char const* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string const arg = argv[i];
+        auto const next = [&]() -> char const*
+        {
+            if (i + 1 >= argc)
+                throw std::runtime_error("Missing value for " + arg);
+            return argv[++i];
+        };
+
+        if (arg == "--columns")
+            options.columns = std::atoi(next());
+        else if (arg == "--rows")
+            options.rows = std::atoi(next());
+        else if (arg == "--frames")
+            options.frames = std::atoi(next());
+        else if (arg == "--border")
+            options.border = std::atoi(next());
+        else if (arg == "--max-ratio")
+            options.max_ratio = std::atof(next());
+        else
+            throw std::runtime_error("Unknown argument " + arg);
+    }
+
+    if (options.columns <= 0 || options.rows <= 0 || options.frames <= 0 || options.border <= 0)
+        throw std::runtime_error("Arguments must be positive");
+    if (2 * options.border > gap)
+        throw std::runtime_error("Borders must fit in the gaps between windows");
+    return options;
+}
+
+/// Includes the time spent by the threads that llvmpipe rasterizes on
+double get_cpu_seconds()
+{
+    timespec now {};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+struct Window
+{
+    geom::Rectangle area;
+
+    /// Whether the buffer has an alpha channel, which has to be blended
+    bool shaped;
+};
+
+struct Cost
+{
+    double cpu_ms;
+    double wall_ms;
+};
+
+class Scene
+{
+public:
+    explicit Scene(Options const& options) :
+        options { options }
+    {
+        create_output_framebuffer(true);
+
+        // Tile the output, as the windows of a workspace are by default
+        auto const width = (output_width - gap * (options.columns + 1)) / options.columns;
+        auto const height = (output_height - gap * (options.rows + 1)) / options.rows;
+        if (width <= 0 || height <= 0)
+            throw std::runtime_error("Too many windows to tile the output");
+
+        for (int row = 0; row < options.rows; row++)
+        {
+            for (int column = 0; column < options.columns; column++)
+            {
+                geom::Rectangle const area {
+                    geom::Point { gap + column * (width + gap), gap + row * (height + gap) },
+                    geom::Size { width, height }
+                };
+                windows.push_back({ area, (row + column) % 2 == 0 });
+            }
+        }
+
+        buffer = create_noise_texture(width, height);
+        plain = link_program(plain_vertex_shader_src, make_fragment_shader(plain_fragment_main_src));
+        outline = link_program(plain_vertex_shader_src, make_fragment_shader(outline_fragment_main_src));
+        for (auto const program : { plain, outline })
+        {
+            glUseProgram(program);
+            set_output_uniforms(program);
+        }
+        glUniform4f(glGetUniformLocation(outline, "outline_color"), 0.2f, 0.4f, 0.8f, 1.f);
+    }
+
+    Cost measure(bool is_software)
+    {
+        // Warm up, so that shader compilation and texture upload are not measured
+        draw_frame(is_software);
+        glFinish();
+
+        auto const cpu_start = get_cpu_seconds();
+        auto const wall_start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < options.frames; frame++)
+            draw_frame(is_software);
+        glFinish();
+        auto const wall = std::chrono::steady_clock::now() - wall_start;
+        auto const cpu = get_cpu_seconds() - cpu_start;
+
+        if (auto const error = glGetError())
+            throw std::runtime_error("GL error " + std::to_string(error));
+
+        return {
+            cpu * 1000.0 / options.frames,
+            std::chrono::duration<double, std::milli>(wall).count() / options.frames
+        };
+    }
+
+    std::vector<unsigned char> capture(bool is_software)
+    {
+        draw_frame(is_software);
+        std::vector<unsigned char> pixels(output_width * output_height * 4);
+        glReadPixels(0, 0, output_width, output_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        return pixels;
+    }
+
+private:
+    void draw_frame(bool is_software)
+    {
+        glClearColor(0.1f, 0.1f, 0.1f, 1.f);
+        if (is_software)
+            glClear(GL_COLOR_BUFFER_BIT);
+        else
+        {
+            glClearStencil(0);
+            glStencilMask(0xFF);
+            glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, buffer);
+        for (auto const& window : windows)
+        {
+            geom::Rectangle const outer {
+                geom::Point { window.area.top_left.x.as_int() - options.border, window.area.top_left.y.as_int() - options.border },
+                geom::Size { window.area.size.width.as_int() + 2 * options.border, window.area.size.height.as_int() + 2 * options.border }
+            };
+
+            if (is_software)
+            {
+                // The same decisions as Renderer::draw makes on its software path
+                glDisable(GL_STENCIL_TEST);
+                glEnable(GL_SCISSOR_TEST);
+                scissor(window.area);
+                draw(plain, { window.area }, window.area, window.shaped);
+
+                scissor(outer);
+                draw(outline, get_border_rectangles(outer, window.area), window.area, false);
+                glDisable(GL_SCISSOR_TEST);
+            }
+            else
+            {
+                // The window marks the stencil, so that its outline is only drawn around it
+                glEnable(GL_STENCIL_TEST);
+                glStencilFunc(GL_ALWAYS, 1, 0xFF);
+                glStencilMask(0xFF);
+                glStencilOp(GL_REPLACE, GL_REPLACE, GL_REPLACE);
+                draw(plain, { window.area }, window.area, window.shaped);
+
+                glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+                glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+                draw(outline, { outer }, window.area, window.shaped);
+            }
+        }
+    }
+
+    void draw(GLuint program, std::vector<geom::Rectangle> const& areas, geom::Rectangle const& window, bool blend)
+    {
+        glUseProgram(program);
+        glUniform2f(glGetUniformLocation(program, "centre"),
+            window.top_left.x.as_int() + window.size.width.as_int() / 2.f,
+            window.top_left.y.as_int() + window.size.height.as_int() / 2.f);
+
+        if (blend)
+        {
+            glEnable(GL_BLEND);
+            glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        else
+            glDisable(GL_BLEND);
+
+        auto const position = glGetAttribLocation(program, "position");
+        // The outline never samples, so its texcoord attribute may be compiled out
+        auto const texcoord = glGetAttribLocation(program, "texcoord");
+        glEnableVertexAttribArray(position);
+        if (texcoord >= 0)
+            glEnableVertexAttribArray(texcoord);
+        for (auto const& area : areas)
+        {
+            auto const primitive = make_window(
+                area.top_left.x.as_int(),
+                area.top_left.y.as_int(),
+                area.size.width.as_int(),
+                area.size.height.as_int());
+            glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, sizeof(mir::gl::Vertex), &primitive.vertices[0].position);
+            if (texcoord >= 0)
+                glVertexAttribPointer(texcoord, 2, GL_FLOAT, GL_FALSE, sizeof(mir::gl::Vertex), &primitive.vertices[0].texcoord);
+            glDrawArrays(primitive.type, 0, primitive.nvertices);
+        }
+        if (texcoord >= 0)
+            glDisableVertexAttribArray(texcoord);
+        glDisableVertexAttribArray(position);
+    }
+
+    /// The output is not transformed, so the scissor only has to be flipped to count from the bottom
+    static void scissor(geom::Rectangle const& area)
+    {
+        glScissor(
+            area.top_left.x.as_int(),
+            output_height - area.top_left.y.as_int() - area.size.height.as_int(),
+            area.size.width.as_int(),
+            area.size.height.as_int());
+    }
+
+    Options options;
+    GLuint buffer = 0;
+    GLuint plain = 0;
+    GLuint outline = 0;
+    std::vector<Window> windows;
+};
+}
+
+int main(int argc, char const* argv[])
+{
+    try
+    {
+        auto const options = parse_options(argc, argv);
+        make_context_current();
+        auto const gl_renderer = reinterpret_cast<char const*>(glGetString(GL_RENDERER));
+        std::printf("GL renderer: %s%s\n", gl_renderer,
+            is_software_renderer(gl_renderer) ? "" : " (not a software renderer, results will not be representative)");
+        std::printf("%dx%d tiled windows with %dpx borders, %d frames\n",
+            options.columns, options.rows, options.border, options.frames);
+
+        Scene scene(options);
+        auto const expected = scene.capture(false);
+        auto const actual = scene.capture(true);
+        auto const mismatches = std::count_if(
+            expected.begin(), expected.end(), [&, i = 0](unsigned char value) mutable
+        {
+            return value != actual[i++];
+        });
+
+        auto const default_cost = scene.measure(false);
+        auto const software_cost = scene.measure(true);
+        auto const ratio = software_cost.cpu_ms / default_cost.cpu_ms;
+        std::printf("default:  %8.2f ms CPU per frame (%.2f ms wall)\n", default_cost.cpu_ms, default_cost.wall_ms);
+        std::printf("software: %8.2f ms CPU per frame (%.2f ms wall)\n", software_cost.cpu_ms, software_cost.wall_ms);
+        std::printf("ratio:    %8.2f (limit %.2f)\n", ratio, options.max_ratio);
+
+        if (mismatches > 0)
+        {
+            std::fprintf(stderr, "The software path drew %ld bytes differently from the default path\n",
+                static_cast<long>(mismatches));
+            return EXIT_FAILURE;
+        }
+        return ratio <= options.max_ratio ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception const& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}